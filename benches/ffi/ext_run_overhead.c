@@ -0,0 +1,84 @@
+// Per-call overhead of the C ABI: config handling, runtime hand-off and settings/language
+// loading inside llm_ext_run, without a provider round-trip (the calls only list styles).
+//
+//   cargo build --release
+//   cc -O2 -Iext benches/ffi/ext_run_overhead.c -Ltarget/release -lllm_translator_rust \
+//      -Wl,-rpath,target/release -o target/ext_run_overhead
+//   target/ext_run_overhead [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "llm_translator_rust.h"
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int report_error(const char *what) {
+    char *message = llm_ext_last_error_message();
+    fprintf(stderr, "%s failed: %s\n", what, message ? message : "(no message)");
+    llm_ext_free_string(message);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : 1000;
+    if (iterations <= 0) {
+        iterations = 1000;
+    }
+
+    ExtConfig *config = llm_ext_config_new();
+    ExtSettings *settings = llm_ext_settings_new();
+    if (!config || !settings) {
+        return report_error("setup");
+    }
+    llm_ext_config_set_show_enabled_styles(config, true);
+
+    // Warm-up: the first call starts the runtime and compiles prompts.
+    char *output = llm_ext_run(config, "");
+    if (!output) {
+        return report_error("llm_ext_run");
+    }
+    llm_ext_free_string(output);
+
+    double start = now_us();
+    for (long i = 0; i < iterations; i++) {
+        output = llm_ext_run(config, "");
+        if (!output) {
+            return report_error("llm_ext_run");
+        }
+        llm_ext_free_string(output);
+    }
+    double run_us = (now_us() - start) / iterations;
+
+    start = now_us();
+    for (long i = 0; i < iterations; i++) {
+        output = llm_ext_run_with_settings(config, settings, "");
+        if (!output) {
+            return report_error("llm_ext_run_with_settings");
+        }
+        llm_ext_free_string(output);
+    }
+    double run_with_settings_us = (now_us() - start) / iterations;
+
+    start = now_us();
+    for (long i = 0; i < iterations; i++) {
+        ExtConfig *scratch = llm_ext_config_new();
+        llm_ext_config_set_lang(scratch, "ja");
+        llm_ext_config_free(scratch);
+    }
+    double config_us = (now_us() - start) / iterations;
+
+    printf("iterations: %ld\n", iterations);
+    printf("llm_ext_run:                %10.2f us/call\n", run_us);
+    printf("llm_ext_run_with_settings:  %10.2f us/call\n", run_with_settings_us);
+    printf("config new/set/free:        %10.2f us/call\n", config_us);
+
+    llm_ext_settings_free(settings);
+    llm_ext_config_free(config);
+    return 0;
+}
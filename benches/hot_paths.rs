@@ -0,0 +1,365 @@
+use criterion::{BenchmarkId, Criterion, Throughput, criterion_group, criterion_main};
+use std::io::{Cursor, Write};
+use std::path::Path;
+use std::time::Duration;
+
+use llm_translator_rust::attachments::translate_attachment;
+use llm_translator_rust::bench_support::{
+    self, MockProvider, mock_translator, parse_hocr, parse_tsv, translate_directory,
+    translation_cache_round,
+};
+use llm_translator_rust::data::{self, DataAttachment};
+use llm_translator_rust::ocr::{BBoxPx, OverlayStyle, TranslatedLine, render_svg};
+
+/// Distinct strings per document; each appears several times so the cache has work to do.
+const PHRASES: usize = 200;
+const REPEATS: usize = 3;
+
+fn runtime() -> tokio::runtime::Runtime {
+    tokio::runtime::Builder::new_multi_thread()
+        .enable_all()
+        .build()
+        .expect("tokio runtime")
+}
+
+fn phrases() -> Vec<String> {
+    (0..PHRASES * REPEATS)
+        .map(|index| {
+            format!(
+                "Sentence number {} about the quarterly report.",
+                index % PHRASES
+            )
+        })
+        .collect()
+}
+
+fn html_fixture() -> Vec<u8> {
+    let mut out = String::from("<html><head><title>Report</title></head><body>");
+    for phrase in phrases() {
+        out.push_str(&format!("<p class=\"body\">{}</p>", phrase));
+    }
+    out.push_str("</body></html>");
+    out.into_bytes()
+}
+
+fn markdown_fixture() -> Vec<u8> {
+    let mut out = String::from("# Report\n\n");
+    for (index, phrase) in phrases().iter().enumerate() {
+        if index % 10 == 0 {
+            out.push_str(&format!("## Section {}\n\n", index / 10));
+        }
+        out.push_str(&format!("- {} `code_{}`\n", phrase, index));
+    }
+    out.into_bytes()
+}
+
+fn xml_fixture() -> Vec<u8> {
+    let mut out = String::from("<?xml version=\"1.0\" encoding=\"UTF-8\"?><items>");
+    for (index, phrase) in phrases().iter().enumerate() {
+        out.push_str(&format!(
+            "<item id=\"{}\"><title>{}</title></item>",
+            index, phrase
+        ));
+    }
+    out.push_str("</items>");
+    out.into_bytes()
+}
+
+fn json_fixture() -> Vec<u8> {
+    let items = phrases()
+        .iter()
+        .enumerate()
+        .map(|(index, phrase)| serde_json::json!({ "id": index, "label": phrase }))
+        .collect::<Vec<_>>();
+    serde_json::to_vec(&serde_json::json!({ "items": items })).expect("json fixture")
+}
+
+fn yaml_fixture() -> Vec<u8> {
+    let mut out = String::from("items:\n");
+    for (index, phrase) in phrases().iter().enumerate() {
+        out.push_str(&format!("  - id: {}\n    label: \"{}\"\n", index, phrase));
+    }
+    out.into_bytes()
+}
+
+fn po_fixture() -> Vec<u8> {
+    let mut out = String::from("msgid \"\"\nmsgstr \"\"\n\n");
+    for (index, phrase) in phrases().iter().enumerate() {
+        out.push_str(&format!(
+            "#: src/report.c:{}\nmsgid \"{} ({})\"\nmsgstr \"\"\n\n",
+            index, phrase, index
+        ));
+    }
+    out.into_bytes()
+}
+
+fn javascript_fixture() -> Vec<u8> {
+    let mut out = String::new();
+    for (index, phrase) in phrases().iter().enumerate() {
+        out.push_str(&format!(
+            "// {}\nexport const message{} = \"{}\";\n",
+            phrase, index, phrase
+        ));
+    }
+    out.into_bytes()
+}
+
+fn tsx_fixture() -> Vec<u8> {
+    let mut out = String::from("export function Report() {\n  return (\n    <div>\n");
+    for phrase in phrases() {
+        out.push_str(&format!("      <p title=\"{}\">{}</p>\n", phrase, phrase));
+    }
+    out.push_str("    </div>\n  );\n}\n");
+    out.into_bytes()
+}
+
+fn docx_fixture() -> Vec<u8> {
+    let mut document = String::from(
+        "<w:document xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\"><w:body>",
+    );
+    for phrase in phrases() {
+        document.push_str(&format!("<w:p><w:r><w:t>{}</w:t></w:r></w:p>", phrase));
+    }
+    document.push_str("</w:body></w:document>");
+    let mut writer = zip::ZipWriter::new(Cursor::new(Vec::new()));
+    let options = zip::write::FileOptions::default();
+    writer
+        .start_file("word/document.xml", options)
+        .expect("docx entry");
+    writer
+        .write_all(document.as_bytes())
+        .expect("docx document");
+    writer
+        .start_file("word/media/image1.png", options)
+        .expect("docx entry");
+    writer.write_all(&vec![7u8; 64 * 1024]).expect("docx media");
+    writer.finish().expect("docx zip").into_inner()
+}
+
+fn hocr_fixture(lines: usize) -> String {
+    let mut out = String::from("<div class='ocr_page' title='bbox 0 0 2000 4000'>");
+    for line in 0..lines {
+        let y = line as u32 * 30;
+        out.push_str(&format!(
+            "<span class='ocr_line' title='bbox 10 {} 900 {}; x_size 24'>",
+            y,
+            y + 24
+        ));
+        for word in 0..8u32 {
+            let x = 10 + word * 110;
+            out.push_str(&format!(
+                "<span class='ocrx_word' title='bbox {} {} {} {}; x_wconf 91'>word{}</span> ",
+                x,
+                y,
+                x + 100,
+                y + 24,
+                word
+            ));
+        }
+        out.push_str("</span>");
+    }
+    out.push_str("</div>");
+    out
+}
+
+fn tsv_fixture(lines: usize) -> String {
+    let mut out = String::from(
+        "level\tpage_num\tblock_num\tpar_num\tline_num\tword_num\tleft\ttop\twidth\theight\tconf\ttext\n",
+    );
+    for line in 0..lines {
+        let y = line * 30;
+        for word in 0..8 {
+            out.push_str(&format!(
+                "5\t1\t1\t1\t{}\t{}\t{}\t{}\t100\t24\t91\tword{}\n",
+                line,
+                word,
+                10 + word * 110,
+                y,
+                word
+            ));
+        }
+    }
+    out
+}
+
+fn bench_translation_cache(c: &mut Criterion) {
+    let runtime = runtime();
+    let translator = mock_translator(MockProvider::new()).expect("translator");
+    let options = bench_support::options();
+    let texts = phrases();
+    let mut group = c.benchmark_group("translation_cache");
+    group.throughput(Throughput::Elements(texts.len() as u64));
+    group.bench_function("collect_flush_replay", |b| {
+        b.to_async(&runtime).iter(|| async {
+            translation_cache_round(&texts, &translator, &options)
+                .await
+                .expect("cache round")
+        })
+    });
+    group.finish();
+}
+
+fn bench_attachments(c: &mut Criterion) {
+    let runtime = runtime();
+    let translator = mock_translator(MockProvider::new()).expect("translator");
+    let options = bench_support::options();
+    let fixtures = [
+        ("html", data::HTML_MIME, html_fixture()),
+        ("markdown", data::MARKDOWN_MIME, markdown_fixture()),
+        ("xml", data::XML_MIME, xml_fixture()),
+        ("json", data::JSON_MIME, json_fixture()),
+        ("yaml", data::YAML_MIME, yaml_fixture()),
+        ("po", data::PO_MIME, po_fixture()),
+        ("javascript", data::JS_MIME, javascript_fixture()),
+        ("tsx", data::TSX_MIME, tsx_fixture()),
+        ("docx", data::DOCX_MIME, docx_fixture()),
+    ];
+    let mut group = c.benchmark_group("attachments");
+    for (name, mime, bytes) in fixtures {
+        let attachment = DataAttachment {
+            bytes,
+            mime: mime.to_string(),
+            name: None,
+        };
+        group.throughput(Throughput::Bytes(attachment.bytes.len() as u64));
+        group.bench_with_input(BenchmarkId::from_parameter(name), &attachment, |b, data| {
+            b.to_async(&runtime).iter(|| async {
+                translate_attachment(
+                    data,
+                    "eng",
+                    &translator,
+                    &options,
+                    false,
+                    false,
+                    false,
+                    None,
+                )
+                .await
+                .expect("translate attachment")
+                .expect("supported mime")
+            })
+        });
+    }
+    group.finish();
+}
+
+fn bench_ocr_parse(c: &mut Criterion) {
+    let mut group = c.benchmark_group("ocr_parse");
+    for lines in [50usize, 500] {
+        let hocr = hocr_fixture(lines);
+        let tsv = tsv_fixture(lines);
+        group.throughput(Throughput::Bytes(hocr.len() as u64));
+        group.bench_with_input(BenchmarkId::new("hocr", lines), &hocr, |b, hocr| {
+            b.iter(|| parse_hocr(hocr).expect("hocr"))
+        });
+        group.throughput(Throughput::Bytes(tsv.len() as u64));
+        group.bench_with_input(BenchmarkId::new("tsv", lines), &tsv, |b, tsv| {
+            b.iter(|| parse_tsv(tsv).expect("tsv"))
+        });
+    }
+    group.finish();
+}
+
+fn bench_layout(c: &mut Criterion) {
+    let (width, height) = (1600u32, 2400u32);
+    let mut png = Vec::new();
+    image::DynamicImage::new_rgb8(width, height)
+        .write_to(&mut Cursor::new(&mut png), image::ImageFormat::Png)
+        .expect("png fixture");
+    let style = OverlayStyle {
+        text_color: "#111111".to_string(),
+        stroke_color: "#ffffff".to_string(),
+        fill_color: "#ffffffcc".to_string(),
+        font_size: None,
+        font_family: Some("sans-serif".to_string()),
+        font_metrics: None,
+    };
+    let mut group = c.benchmark_group("layout");
+    for count in [20u32, 120] {
+        // Dense rows of boxes make resolve_overlap search for free space.
+        let lines = (0..count)
+            .map(|index| TranslatedLine {
+                text: format!("Translated line {} with a few more words to wrap", index),
+                bbox: BBoxPx {
+                    x: 40 + (index % 3) * 500,
+                    y: 40 + (index / 3) * 40,
+                    w: 460,
+                    h: 28,
+                },
+                font_size: 22.0,
+            })
+            .collect::<Vec<_>>();
+        group.bench_with_input(BenchmarkId::new("render_svg", count), &lines, |b, lines| {
+            b.iter(|| {
+                render_svg(&png, "image/png", width, height, lines, &style, None)
+                    .expect("render svg")
+            })
+        });
+    }
+    group.finish();
+}
+
+fn write_directory_fixture(root: &Path, files: usize) {
+    let phrases = phrases();
+    for index in 0..files {
+        let dir = root.join(format!("section{}", index % 4));
+        std::fs::create_dir_all(&dir).expect("fixture dir");
+        std::fs::write(
+            dir.join(format!("page{}.md", index)),
+            format!("# Page {}\n\n{}\n", index, phrases[index % PHRASES]),
+        )
+        .expect("fixture file");
+    }
+}
+
+fn bench_directory(c: &mut Criterion) {
+    let runtime = runtime();
+    let workspace = tempfile::tempdir().expect("tempdir");
+    // History and backups go to a throwaway data directory, not the user's.
+    unsafe {
+        std::env::set_var("LLM_TRANSLATOR_RUST_DIR", workspace.path().join("data"));
+    }
+    let src = workspace.path().join("src");
+    write_directory_fixture(&src, 48);
+    let latency = Duration::from_millis(5);
+    let translator =
+        mock_translator(MockProvider::with_latency(latency, latency / 2)).expect("translator");
+
+    let mut group = c.benchmark_group("directory");
+    group.sample_size(10);
+    for threads in [1usize, 4, 16] {
+        group.bench_with_input(
+            BenchmarkId::new("threads", threads),
+            &threads,
+            |b, &threads| {
+                b.to_async(&runtime).iter_batched(
+                    // A fresh output dir each time, so the manifest never marks files unchanged.
+                    || tempfile::tempdir_in(workspace.path()).expect("out dir"),
+                    |out| {
+                        let src = src.clone();
+                        let translator = translator.clone();
+                        async move {
+                            translate_directory(&src, out.path().join("out"), threads, &translator)
+                                .await
+                                .expect("translate directory");
+                            // Returned so the cleanup happens outside the measurement.
+                            out
+                        }
+                    },
+                    criterion::BatchSize::PerIteration,
+                )
+            },
+        );
+    }
+    group.finish();
+}
+
+criterion_group!(
+    benches,
+    bench_translation_cache,
+    bench_attachments,
+    bench_ocr_parse,
+    bench_layout,
+    bench_directory
+);
+criterion_main!(benches);
@@ -11,11 +11,44 @@ extern "C" {
 
 typedef struct ExtConfig ExtConfig;
 typedef struct ExtSettings ExtSettings;
+typedef struct ExtJob ExtJob;
+typedef struct ExtBatch ExtBatch;
+typedef struct ExtBuffer ExtBuffer;
+typedef struct ExtEngine ExtEngine;
+
+// Async job status values
+enum {
+    LLM_EXT_JOB_PENDING = 0,
+    LLM_EXT_JOB_SUCCEEDED = 1,
+    LLM_EXT_JOB_FAILED = 2,
+    LLM_EXT_JOB_CANCELLED = 3,
+};
+
+// Fired exactly once when a job settles (from a worker thread, or from the cancelling thread)
+typedef void (*LlmExtJobCallback)(void *user_data, int32_t status);
+
+// Receives translated UTF-8 text as it streams in (not NUL-terminated; valid only during the call)
+typedef void (*LlmExtStreamCallback)(void *user_data, const char *text, size_t len);
 
 // Error and memory helpers
 char *llm_ext_last_error_message(void);
 void llm_ext_free_string(char *value);
 
+// Translation memory counters for this process (hits/misses since start-up)
+uint64_t llm_ext_translation_memory_hits(void);
+uint64_t llm_ext_translation_memory_misses(void);
+
+// In-process response cache counters (coalesced = requests that shared an identical in-flight call)
+uint64_t llm_ext_response_cache_hits(void);
+uint64_t llm_ext_response_cache_misses(void);
+uint64_t llm_ext_response_cache_coalesced(void);
+
+// Process metrics as JSON (same series as the server's /metrics); free with llm_ext_free_string
+char *llm_ext_metrics_snapshot(void);
+
+// Prompt templates are compiled once per process; re-read them from disk after editing
+bool llm_ext_reload_prompts(void);
+
 // Config lifecycle
 ExtConfig *llm_ext_config_new(void);
 void llm_ext_config_free(ExtConfig *config);
@@ -78,6 +111,14 @@ bool llm_ext_config_set_verbose(ExtConfig *config, bool value);
 bool llm_ext_config_get_verbose(const ExtConfig *config);
 bool llm_ext_config_set_whisper_model(ExtConfig *config, const char *value);
 char *llm_ext_config_get_whisper_model(const ExtConfig *config);
+bool llm_ext_config_set_skip_history_tags(ExtConfig *config, bool value);
+bool llm_ext_config_get_skip_history_tags(const ExtConfig *config);
+
+// Config extra target languages (translated alongside lang from one extraction; requires data)
+bool llm_ext_config_clear_extra_langs(ExtConfig *config);
+bool llm_ext_config_add_lang(ExtConfig *config, const char *value);
+size_t llm_ext_config_extra_langs_len(const ExtConfig *config);
+char *llm_ext_config_get_extra_lang(const ExtConfig *config, size_t index);
 
 // Config ignore list
 bool llm_ext_config_clear_ignore_translation_files(ExtConfig *config);
@@ -118,6 +159,50 @@ bool llm_ext_settings_set_server_port(ExtSettings *settings, uint16_t value);
 uint16_t llm_ext_settings_get_server_port(const ExtSettings *settings);
 bool llm_ext_settings_set_server_tmp_dir(ExtSettings *settings, const char *value);
 char *llm_ext_settings_get_server_tmp_dir(const ExtSettings *settings);
+bool llm_ext_settings_set_server_max_upload_mb(ExtSettings *settings, uint64_t value);
+uint64_t llm_ext_settings_get_server_max_upload_mb(const ExtSettings *settings);
+
+// HTTP client pool (0 disables read timeout, idle timeout and TCP keepalive)
+bool llm_ext_settings_set_http_pool_max_idle_per_host(ExtSettings *settings, size_t value);
+size_t llm_ext_settings_get_http_pool_max_idle_per_host(const ExtSettings *settings);
+bool llm_ext_settings_set_http_pool_idle_timeout_secs(ExtSettings *settings, uint64_t value);
+uint64_t llm_ext_settings_get_http_pool_idle_timeout_secs(const ExtSettings *settings);
+bool llm_ext_settings_set_http_connect_timeout_secs(ExtSettings *settings, uint64_t value);
+uint64_t llm_ext_settings_get_http_connect_timeout_secs(const ExtSettings *settings);
+bool llm_ext_settings_set_http_read_timeout_secs(ExtSettings *settings, uint64_t value);
+uint64_t llm_ext_settings_get_http_read_timeout_secs(const ExtSettings *settings);
+bool llm_ext_settings_set_http_tcp_keepalive_secs(ExtSettings *settings, uint64_t value);
+uint64_t llm_ext_settings_get_http_tcp_keepalive_secs(const ExtSettings *settings);
+
+// Persistent translation memory (max_mb 0 disables the size cap)
+bool llm_ext_settings_set_translation_memory_enabled(ExtSettings *settings, bool value);
+bool llm_ext_settings_get_translation_memory_enabled(const ExtSettings *settings);
+bool llm_ext_settings_set_translation_memory_max_mb(ExtSettings *settings, uint64_t value);
+uint64_t llm_ext_settings_get_translation_memory_max_mb(const ExtSettings *settings);
+bool llm_ext_settings_set_response_cache_entries(ExtSettings *settings, size_t value);
+size_t llm_ext_settings_get_response_cache_entries(const ExtSettings *settings);
+bool llm_ext_settings_set_response_cache_ttl_secs(ExtSettings *settings, uint64_t value);
+uint64_t llm_ext_settings_get_response_cache_ttl_secs(const ExtSettings *settings);
+
+// PDF page pipeline (workers 0 = one per core, max_inflight_mb 0 disables the cap)
+bool llm_ext_settings_set_pdf_page_workers(ExtSettings *settings, size_t value);
+size_t llm_ext_settings_get_pdf_page_workers(const ExtSettings *settings);
+bool llm_ext_settings_set_pdf_max_inflight_mb(ExtSettings *settings, uint64_t value);
+uint64_t llm_ext_settings_get_pdf_max_inflight_mb(const ExtSettings *settings);
+
+// Whisper context pool (threads_per_job 0 splits the cores between pool_size jobs)
+bool llm_ext_settings_set_whisper_pool_size(ExtSettings *settings, size_t value);
+size_t llm_ext_settings_get_whisper_pool_size(const ExtSettings *settings);
+bool llm_ext_settings_set_whisper_threads_per_job(ExtSettings *settings, size_t value);
+size_t llm_ext_settings_get_whisper_threads_per_job(const ExtSettings *settings);
+
+// Provider rate limits (per provider/model; 0 disables a per-minute budget)
+bool llm_ext_settings_set_rate_limit_max_concurrency(ExtSettings *settings, size_t value);
+size_t llm_ext_settings_get_rate_limit_max_concurrency(const ExtSettings *settings);
+bool llm_ext_settings_set_rate_limit_requests_per_minute(ExtSettings *settings, uint64_t value);
+uint64_t llm_ext_settings_get_rate_limit_requests_per_minute(const ExtSettings *settings);
+bool llm_ext_settings_set_rate_limit_tokens_per_minute(ExtSettings *settings, uint64_t value);
+uint64_t llm_ext_settings_get_rate_limit_tokens_per_minute(const ExtSettings *settings);
 
 // Settings language list
 bool llm_ext_settings_clear_system_languages(ExtSettings *settings);
@@ -135,6 +220,47 @@ size_t llm_ext_settings_formal_len(const ExtSettings *settings);
 char *llm_ext_run(const ExtConfig *config, const char *input);
 char *llm_ext_run_with_settings(const ExtConfig *config, const ExtSettings *settings, const char *input);
 
+// History tags are generated in the background after a run returns (unless
+// llm_ext_config_set_skip_history_tags); wait for pending ones, e.g. before unloading
+void llm_ext_flush_history_tags(void);
+
+// Async run (settings may be NULL; callback may be NULL; a job that cannot be started is returned already failed)
+ExtJob *llm_ext_run_async(const ExtConfig *config, const ExtSettings *settings, const char *input, LlmExtJobCallback callback, void *user_data);
+int32_t llm_ext_job_status(const ExtJob *job);
+int32_t llm_ext_job_wait(const ExtJob *job, int64_t timeout_ms);
+char *llm_ext_job_take_output(ExtJob *job);
+char *llm_ext_job_error_message(const ExtJob *job);
+bool llm_ext_job_cancel(ExtJob *job);
+int32_t llm_ext_job_fd(const ExtJob *job);
+void llm_ext_job_free(ExtJob *job);
+
+// Batch run (settings may be NULL; per-item output/error are NULL when not applicable)
+ExtBatch *llm_ext_run_batch(const ExtConfig *config, const ExtSettings *settings, const char *const *inputs, size_t len);
+size_t llm_ext_batch_len(const ExtBatch *batch);
+char *llm_ext_batch_get_output(const ExtBatch *batch, size_t index);
+char *llm_ext_batch_get_error(const ExtBatch *batch, size_t index);
+char *llm_ext_batch_get_model(const ExtBatch *batch);
+void llm_ext_batch_free(ExtBatch *batch);
+
+// Engine (settings may be NULL; resolves settings, languages, provider and prompt once)
+ExtEngine *llm_ext_engine_new(const ExtConfig *config, const ExtSettings *settings);
+void llm_ext_engine_free(ExtEngine *engine);
+char *llm_ext_engine_translate(const ExtEngine *engine, const char *input);
+ExtJob *llm_ext_engine_translate_async(const ExtEngine *engine, const char *input, LlmExtJobCallback callback, void *user_data);
+char *llm_ext_engine_get_model(const ExtEngine *engine);
+
+// Streaming run (settings may be NULL; callback runs on the calling thread; returns the full output)
+char *llm_ext_run_streaming(const ExtConfig *config, const ExtSettings *settings, const char *input, LlmExtStreamCallback callback, void *user_data);
+char *llm_ext_engine_translate_streaming(const ExtEngine *engine, const char *input, LlmExtStreamCallback callback, void *user_data);
+
+// In-memory attachments (settings, mime and name may be NULL; mime NULL means "auto")
+ExtBuffer *llm_ext_run_bytes(const ExtConfig *config, const ExtSettings *settings, const uint8_t *data, size_t len, const char *mime, const char *name);
+const uint8_t *llm_ext_buffer_data(const ExtBuffer *buffer);
+size_t llm_ext_buffer_len(const ExtBuffer *buffer);
+char *llm_ext_buffer_get_mime(const ExtBuffer *buffer);
+char *llm_ext_buffer_get_model(const ExtBuffer *buffer);
+void llm_ext_buffer_free(ExtBuffer *buffer);
+
 #ifdef __cplusplus
 }
 #endif
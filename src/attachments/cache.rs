@@ -1,17 +1,23 @@
 use anyhow::Result;
 use std::collections::HashMap;
 
-use crate::providers::{Provider, ProviderUsage};
+use crate::providers::{Provider, ProviderUsage, merge_usage};
 use crate::{TranslateOptions, Translator};
 
 use super::AttachmentTranslation;
 use super::util::{collapse_whitespace, is_numeric_like, sanitize_ocr_text, split_text_bounds};
 
+/// Collected misses that trigger an early batch, so collecting a very large document keeps
+/// a bounded pending list and starts translating before the walk is done.
+const FLUSH_PENDING_AT: usize = 1_000;
+
 pub(crate) struct TranslationCache {
     map: HashMap<String, String>,
     model: Option<String>,
     usage: ProviderUsage,
     used: bool,
+    /// Cache misses seen while collecting; `None` once the cache translates directly.
+    pending: Option<Vec<String>>,
 }
 
 impl TranslationCache {
@@ -25,9 +31,59 @@ impl TranslationCache {
                 total_tokens: Some(0),
             },
             used: false,
+            pending: None,
+        }
+    }
+
+    /// Returns a cache in collect mode: `translate` records each miss and echoes its input
+    /// back until `flush` sends them all through `Translator::exec_batch`.
+    ///
+    /// Callers walk the document once to collect, flush, then walk it again; the second
+    /// pass is served from the cache, with any stragglers falling back to `exec`.
+    pub(crate) fn collecting() -> Self {
+        Self {
+            pending: Some(Vec::new()),
+            ..Self::new()
         }
     }
 
+    /// Translates every collected string in batches and switches to direct translation.
+    /// Items the batch could not translate are left out, so they are retried one by one.
+    pub(crate) async fn flush<P: Provider + Clone>(
+        &mut self,
+        translator: &Translator<P>,
+        options: &TranslateOptions,
+    ) -> Result<()> {
+        let Some(pending) = self.pending.take() else {
+            return Ok(());
+        };
+        self.translate_pending(pending, translator, options).await?;
+        Ok(())
+    }
+
+    /// Batch-translates `pending` into the map. Returns the strings that were not sent: a
+    /// lone string is cheaper as a plain request on the next pass.
+    async fn translate_pending<P: Provider + Clone>(
+        &mut self,
+        mut pending: Vec<String>,
+        translator: &Translator<P>,
+        options: &TranslateOptions,
+    ) -> Result<Vec<String>> {
+        pending.sort_unstable();
+        pending.dedup();
+        if pending.len() < 2 {
+            return Ok(pending);
+        }
+        let output = translator.exec_batch(&pending, options.clone()).await?;
+        self.record_usage(output.model, output.usage);
+        for (text, item) in pending.into_iter().zip(output.items) {
+            if let Ok(translated) = item {
+                self.map.insert(text, translated);
+            }
+        }
+        Ok(Vec::new())
+    }
+
     pub(crate) fn record_usage(&mut self, model: Option<String>, usage: Option<ProviderUsage>) {
         if self.model.is_none() {
             self.model = model;
@@ -83,6 +139,15 @@ impl TranslationCache {
         if let Some(existing) = self.map.get(text) {
             return Ok(existing.clone());
         }
+        if let Some(pending) = self.pending.as_mut() {
+            pending.push(text.to_string());
+            if pending.len() >= FLUSH_PENDING_AT {
+                let pending = std::mem::take(pending);
+                let unsent = self.translate_pending(pending, translator, options).await?;
+                self.pending = Some(unsent);
+            }
+            return Ok(text.to_string());
+        }
         let exec = translator.exec(text, options.clone()).await?;
         if self.model.is_none() {
             self.model = exec.model.clone();
@@ -103,15 +168,73 @@ impl TranslationCache {
     }
 }
 
-pub(crate) fn merge_usage(total: ProviderUsage, next: Option<ProviderUsage>) -> ProviderUsage {
-    let Some(next) = next else {
-        return total;
-    };
-    ProviderUsage {
-        prompt_tokens: Some(total.prompt_tokens.unwrap_or(0) + next.prompt_tokens.unwrap_or(0)),
-        completion_tokens: Some(
-            total.completion_tokens.unwrap_or(0) + next.completion_tokens.unwrap_or(0),
-        ),
-        total_tokens: Some(total.total_tokens.unwrap_or(0) + next.total_tokens.unwrap_or(0)),
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::bench_support::{MockProvider, mock_translator, options};
+
+    #[tokio::test]
+    async fn collecting_cache_translates_in_one_batch() {
+        let provider = MockProvider::new();
+        let translator = mock_translator(provider.clone()).expect("translator");
+        let options = options();
+        let texts = [" Hello ", "World", "Hello"];
+
+        let mut cache = TranslationCache::collecting();
+        for text in texts {
+            let echoed = cache
+                .translate_preserve_whitespace(text, &translator, &options)
+                .await
+                .expect("collect");
+            assert_eq!(echoed, text);
+        }
+        cache.flush(&translator, &options).await.expect("flush");
+        assert_eq!(provider.calls(), 1);
+
+        let mut translated = Vec::new();
+        for text in texts {
+            translated.push(
+                cache
+                    .translate_preserve_whitespace(text, &translator, &options)
+                    .await
+                    .expect("translate"),
+            );
+        }
+        assert_eq!(translated, vec![" tr:Hello ", "tr:World", "tr:Hello"]);
+        assert_eq!(provider.calls(), 1);
+        assert_eq!(cache.model.as_deref(), Some("mock"));
+    }
+
+    #[tokio::test]
+    async fn collecting_cache_sends_early_batches_for_large_documents() {
+        let provider = MockProvider::new();
+        let translator = mock_translator(provider.clone()).expect("translator");
+        let options = options();
+        let texts = (0..FLUSH_PENDING_AT + 1)
+            .map(|index| format!("line {}", index))
+            .collect::<Vec<_>>();
+
+        let mut cache = TranslationCache::collecting();
+        for text in &texts {
+            let echoed = cache
+                .translate(text, &translator, &options)
+                .await
+                .expect("collect");
+            assert_eq!(&echoed, text);
+        }
+        let early_calls = provider.calls();
+        assert!(early_calls > 0);
+        assert_eq!(cache.pending.as_ref().map(Vec::len), Some(1));
+
+        cache.flush(&translator, &options).await.expect("flush");
+        for text in &texts {
+            let translated = cache
+                .translate(text, &translator, &options)
+                .await
+                .expect("translate");
+            assert_eq!(translated, format!("tr:{}", text));
+        }
+        // Only the lone string left after the early batch needed its own request.
+        assert_eq!(provider.calls(), early_calls + 1);
     }
 }
@@ -33,13 +33,24 @@ pub(crate) async fn translate_tsx<P: Provider + Clone>(
     options: &TranslateOptions,
 ) -> Result<AttachmentTranslation> {
     let input = std::str::from_utf8(bytes).with_context(|| "failed to decode tsx as UTF-8")?;
-    let mut cache = TranslationCache::new();
-    let script =
-        translate_script_text(input, with_commentout, &mut cache, translator, options).await?;
-    let output = translate_jsx_text(&script, &mut cache, translator, options).await?;
+    let mut cache = TranslationCache::collecting();
+    rewrite_tsx(input, with_commentout, &mut cache, translator, options).await?;
+    cache.flush(translator, options).await?;
+    let output = rewrite_tsx(input, with_commentout, &mut cache, translator, options).await?;
     Ok(cache.finish(data::TSX_MIME.to_string(), output.into_bytes()))
 }
 
+async fn rewrite_tsx<P: Provider + Clone>(
+    input: &str,
+    with_commentout: bool,
+    cache: &mut TranslationCache,
+    translator: &Translator<P>,
+    options: &TranslateOptions,
+) -> Result<String> {
+    let script = translate_script_text(input, with_commentout, cache, translator, options).await?;
+    translate_jsx_text(&script, cache, translator, options).await
+}
+
 pub(crate) async fn translate_mermaid<P: Provider + Clone>(
     bytes: &[u8],
     with_commentout: bool,
@@ -47,22 +58,33 @@ pub(crate) async fn translate_mermaid<P: Provider + Clone>(
     options: &TranslateOptions,
 ) -> Result<AttachmentTranslation> {
     let input = std::str::from_utf8(bytes).with_context(|| "failed to decode mermaid as UTF-8")?;
-    let mut cache = TranslationCache::new();
+    let mut cache = TranslationCache::collecting();
+    rewrite_mermaid(input, with_commentout, &mut cache, translator, options).await?;
+    cache.flush(translator, options).await?;
+    let output = rewrite_mermaid(input, with_commentout, &mut cache, translator, options).await?;
+    Ok(cache.finish(data::MERMAID_MIME.to_string(), output.into_bytes()))
+}
+
+async fn rewrite_mermaid<P: Provider + Clone>(
+    input: &str,
+    with_commentout: bool,
+    cache: &mut TranslationCache,
+    translator: &Translator<P>,
+    options: &TranslateOptions,
+) -> Result<String> {
     let mut out_lines = Vec::new();
     for line in input.split('\n') {
         if line.trim_start().starts_with("%%") {
             if with_commentout {
-                out_lines
-                    .push(translate_mermaid_comment(line, &mut cache, translator, options).await?);
+                out_lines.push(translate_mermaid_comment(line, cache, translator, options).await?);
             } else {
                 out_lines.push(line.to_string());
             }
         } else {
-            out_lines.push(translate_mermaid_line(line, &mut cache, translator, options).await?);
+            out_lines.push(translate_mermaid_line(line, cache, translator, options).await?);
         }
     }
-    let output = out_lines.join("\n");
-    Ok(cache.finish(data::MERMAID_MIME.to_string(), output.into_bytes()))
+    Ok(out_lines.join("\n"))
 }
 
 async fn translate_script<P: Provider + Clone>(
@@ -73,7 +95,9 @@ async fn translate_script<P: Provider + Clone>(
     options: &TranslateOptions,
 ) -> Result<AttachmentTranslation> {
     let input = std::str::from_utf8(bytes).with_context(|| "failed to decode script as UTF-8")?;
-    let mut cache = TranslationCache::new();
+    let mut cache = TranslationCache::collecting();
+    translate_script_text(input, with_commentout, &mut cache, translator, options).await?;
+    cache.flush(translator, options).await?;
     let output =
         translate_script_text(input, with_commentout, &mut cache, translator, options).await?;
     Ok(cache.finish(mime.to_string(), output.into_bytes()))
@@ -1,22 +1,30 @@
+mod pool;
+mod vad;
+
 use anyhow::{Context, Result, anyhow};
+use futures_util::stream::{self, StreamExt};
 use std::env;
 use std::fs;
 use std::path::{Path, PathBuf};
 use std::process::{Command, Stdio};
+use std::sync::Arc;
+use std::time::Instant;
 use tempfile::tempdir;
 use tracing::info;
-use whisper_rs::{
-    FullParams, SamplingStrategy, WhisperContext, WhisperContextParameters, get_lang_str,
-};
+use whisper_rs::{FullParams, SamplingStrategy, get_lang_str};
 
 use crate::build_env;
 use crate::data;
 use crate::languages::{map_lang_for_espeak, map_lang_for_whisper};
-use crate::providers::Provider;
+use crate::providers::{Provider, ProviderUsage, merge_usage};
 use crate::{TranslateOptions, Translator};
 
 use crate::attachments::AttachmentTranslation;
 
+use super::shared;
+use pool::{PooledState, WhisperBudget};
+use vad::{SpeechChunks, open_wav_mono};
+
 pub(crate) async fn translate_audio<P: Provider + Clone>(
     data: &data::DataAttachment,
     translator: &Translator<P>,
@@ -43,27 +51,64 @@ pub(crate) async fn translate_audio<P: Provider + Clone>(
     ])
     .with_context(|| "failed to decode audio with ffmpeg")?;
 
-    let transcript = transcribe_audio(
-        &wav_path,
-        &options.source_lang,
-        translator.settings().whisper_model.as_deref(),
-    )
-    .await?;
-    let transcript = transcript.trim();
-    if transcript.is_empty() {
-        return Err(anyhow!("no speech detected in audio"));
+    let settings = translator.settings();
+    let whisper_model = whisper_model_path(settings.whisper_model.as_deref()).await?;
+    let budget = WhisperBudget::from_settings(settings);
+    let forced_lang = resolve_forced_lang(&options.source_lang);
+
+    // Each chunk is transcribed, translated and spoken as soon as a pooled state is free,
+    // so translation and TTS of early chunks overlap transcription of later ones. Chunks do
+    // not see each other's text: a sentence split at a pause is translated as two parts.
+    let chunks = SpeechChunks::new(open_wav_mono(&wav_path)?).enumerate();
+    let spoken: Vec<Result<Option<SpokenSegment>>> = stream::iter(chunks)
+        .map(|(index, samples)| {
+            translate_chunk(
+                index,
+                samples,
+                dir.path(),
+                &whisper_model,
+                budget,
+                forced_lang.as_deref(),
+                translator,
+                options,
+            )
+        })
+        .buffered(budget.concurrency())
+        .collect()
+        .await;
+    let mut segments = Vec::new();
+    for segment in spoken {
+        segments.extend(segment?);
     }
 
-    info!("audio: transcribed {} chars", transcript.chars().count());
-    let exec = translator.exec(transcript, options.clone()).await?;
-    let translated = exec.text.trim();
-    if translated.is_empty() {
+    if segments.is_empty() {
+        // Nothing usable per chunk (typically very quiet audio): retry the whole file with
+        // normalization and gain.
+        let transcript =
+            transcribe_normalized(&wav_path, forced_lang.as_deref(), &whisper_model, budget)
+                .await?;
+        let transcript = transcript.trim();
+        if transcript.is_empty() {
+            return Err(anyhow!("no speech detected in audio"));
+        }
+        segments.extend(speak_translation(transcript, 0, dir.path(), translator, options).await?);
+    }
+    if segments.is_empty() {
         return Err(anyhow!("translation returned empty text"));
     }
 
-    let tts_wav = dir.path().join("tts.wav");
-    info!("audio: synthesizing speech");
-    synthesize_speech(translated, &options.lang, &tts_wav)?;
+    let mut model = None;
+    let mut usage: Option<ProviderUsage> = None;
+    for segment in &segments {
+        if model.is_none() {
+            model = segment.model.clone();
+        }
+        usage = match usage {
+            Some(total) => Some(merge_usage(total, segment.usage.clone())),
+            None => segment.usage.clone(),
+        };
+    }
+    let tts_wav = concat_segments(&segments, dir.path())?;
 
     let out_ext = data::extension_from_mime(&data.mime).unwrap_or("mp3");
     let output_path = dir.path().join(format!("output.{}", out_ext));
@@ -80,38 +125,110 @@ pub(crate) async fn translate_audio<P: Provider + Clone>(
     Ok(AttachmentTranslation {
         bytes,
         mime: data.mime.clone(),
-        model: exec.model,
-        usage: exec.usage,
+        model,
+        usage,
     })
 }
 
-async fn transcribe_audio(
-    wav_path: &Path,
-    source_lang: &str,
-    whisper_model_override: Option<&str>,
-) -> Result<String> {
-    let forced_lang = resolve_forced_lang(source_lang);
-    let outcome = transcribe_audio_with_params(
-        wav_path,
-        forced_lang.as_deref(),
-        whisper_model_override,
-        false,
-    )
-    .await?;
-    if !outcome.text.trim().is_empty() {
-        return Ok(outcome.text);
-    }
-    if forced_lang.is_none()
+struct SpokenSegment {
+    wav: PathBuf,
+    model: Option<String>,
+    usage: Option<ProviderUsage>,
+}
+
+#[allow(clippy::too_many_arguments)]
+async fn translate_chunk<P: Provider + Clone>(
+    index: usize,
+    samples: Result<Vec<f32>>,
+    dir: &Path,
+    model: &Path,
+    budget: WhisperBudget,
+    forced_lang: Option<&str>,
+    translator: &Translator<P>,
+    options: &TranslateOptions,
+) -> Result<Option<SpokenSegment>> {
+    let samples: Arc<[f32]> = samples?.into();
+    let mut outcome =
+        transcribe_samples(samples.clone(), forced_lang, model, budget, false).await?;
+    if outcome.text.trim().is_empty()
+        && forced_lang.is_none()
         && let Some(detected) = outcome.detected_lang.as_deref()
     {
-        let retry =
-            transcribe_audio_with_params(wav_path, Some(detected), whisper_model_override, true)
-                .await?;
-        if !retry.text.trim().is_empty() {
-            return Ok(retry.text);
-        }
+        outcome = transcribe_samples(samples, Some(detected), model, budget, true).await?;
     }
+    let transcript = outcome.text.trim();
+    if transcript.is_empty() {
+        return Ok(None);
+    }
+    info!(
+        "audio: chunk {} transcribed {} chars",
+        index,
+        transcript.chars().count()
+    );
+    speak_translation(transcript, index, dir, translator, options).await
+}
+
+async fn speak_translation<P: Provider + Clone>(
+    transcript: &str,
+    index: usize,
+    dir: &Path,
+    translator: &Translator<P>,
+    options: &TranslateOptions,
+) -> Result<Option<SpokenSegment>> {
+    let exec = translator.exec(transcript, options.clone()).await?;
+    let translated = exec.text.trim().to_string();
+    if translated.is_empty() {
+        return Ok(None);
+    }
+
+    let wav = dir.join(format!("tts_{:05}.wav", index));
+    let target_lang = options.lang.clone();
+    let out_wav = wav.clone();
+    tokio::task::spawn_blocking(move || synthesize_speech(&translated, &target_lang, &out_wav))
+        .await
+        .with_context(|| "speech synthesis worker panicked")??;
+    Ok(Some(SpokenSegment {
+        wav,
+        model: exec.model,
+        usage: exec.usage,
+    }))
+}
 
+fn concat_segments(segments: &[SpokenSegment], dir: &Path) -> Result<PathBuf> {
+    if let [segment] = segments {
+        return Ok(segment.wav.clone());
+    }
+    info!("audio: joining {} synthesized segments", segments.len());
+    let list_path = dir.join("tts_segments.txt");
+    let list = segments
+        .iter()
+        .map(|segment| {
+            let path = segment.wav.to_string_lossy().replace('\'', "'\\''");
+            format!("file '{}'\n", path)
+        })
+        .collect::<String>();
+    fs::write(&list_path, list).with_context(|| "failed to write tts segment list")?;
+    let joined = dir.join("tts.wav");
+    run_ffmpeg(&[
+        "-y",
+        "-f",
+        "concat",
+        "-safe",
+        "0",
+        "-i",
+        list_path.to_string_lossy().as_ref(),
+        joined.to_string_lossy().as_ref(),
+    ])
+    .with_context(|| "failed to join synthesized audio")?;
+    Ok(joined)
+}
+
+async fn transcribe_normalized(
+    wav_path: &Path,
+    forced_lang: Option<&str>,
+    model: &Path,
+    budget: WhisperBudget,
+) -> Result<String> {
     info!("audio: no speech detected, retrying with normalization");
     let dir = wav_path
         .parent()
@@ -127,26 +244,17 @@ async fn transcribe_audio(
     ])
     .with_context(|| "failed to normalize audio")?;
 
-    let outcome = transcribe_audio_with_params(
-        &normalized_path,
-        forced_lang.as_deref(),
-        whisper_model_override,
-        true,
-    )
-    .await?;
+    let outcome =
+        transcribe_audio_with_params(&normalized_path, forced_lang, model, budget, true).await?;
     if !outcome.text.trim().is_empty() {
         return Ok(outcome.text);
     }
     if forced_lang.is_none()
         && let Some(detected) = outcome.detected_lang.as_deref()
     {
-        let retry = transcribe_audio_with_params(
-            &normalized_path,
-            Some(detected),
-            whisper_model_override,
-            true,
-        )
-        .await?;
+        let retry =
+            transcribe_audio_with_params(&normalized_path, Some(detected), model, budget, true)
+                .await?;
         if !retry.text.trim().is_empty() {
             return Ok(retry.text);
         }
@@ -164,26 +272,17 @@ async fn transcribe_audio(
     ])
     .with_context(|| "failed to normalize audio with gain")?;
 
-    let outcome = transcribe_audio_with_params(
-        &boosted_path,
-        forced_lang.as_deref(),
-        whisper_model_override,
-        true,
-    )
-    .await?;
+    let outcome =
+        transcribe_audio_with_params(&boosted_path, forced_lang, model, budget, true).await?;
     if !outcome.text.trim().is_empty() {
         return Ok(outcome.text);
     }
     if forced_lang.is_none()
         && let Some(detected) = outcome.detected_lang.as_deref()
     {
-        let retry = transcribe_audio_with_params(
-            &boosted_path,
-            Some(detected),
-            whisper_model_override,
-            true,
-        )
-        .await?;
+        let retry =
+            transcribe_audio_with_params(&boosted_path, Some(detected), model, budget, true)
+                .await?;
         if !retry.text.trim().is_empty() {
             return Ok(retry.text);
         }
@@ -192,29 +291,77 @@ async fn transcribe_audio(
     Ok(outcome.text)
 }
 
-struct TranscribeOutcome {
-    text: String,
-    detected_lang: Option<String>,
+#[derive(Clone)]
+pub(super) struct TranscribeOutcome {
+    pub(super) text: String,
+    pub(super) detected_lang: Option<String>,
 }
 
 async fn transcribe_audio_with_params(
     wav_path: &Path,
     forced_lang: Option<&str>,
-    whisper_model_override: Option<&str>,
+    model: &Path,
+    budget: WhisperBudget,
     relaxed: bool,
 ) -> Result<TranscribeOutcome> {
-    let model = whisper_model_path(whisper_model_override).await?;
     let audio = read_wav_mono_f32(wav_path)?;
+    transcribe_samples(audio.into(), forced_lang, model, budget, relaxed).await
+}
+
+async fn transcribe_samples(
+    audio: Arc<[f32]>,
+    forced_lang: Option<&str>,
+    model: &Path,
+    budget: WhisperBudget,
+    relaxed: bool,
+) -> Result<TranscribeOutcome> {
+    let Some(memo) = shared::current() else {
+        return run_transcription(audio, forced_lang, model, budget, relaxed).await;
+    };
+    let samples = audio
+        .iter()
+        .flat_map(|sample| sample.to_le_bytes())
+        .collect::<Vec<u8>>();
+    let key = shared::digest(&[
+        &samples,
+        forced_lang.unwrap_or("").as_bytes(),
+        model.as_os_str().as_encoded_bytes(),
+        &[relaxed as u8],
+    ]);
+    drop(samples);
+    memo.transcript(
+        key,
+        run_transcription(audio, forced_lang, model, budget, relaxed),
+    )
+    .await
+}
 
-    let model_path = model.to_string_lossy();
-    let ctx =
-        WhisperContext::new_with_params(model_path.as_ref(), WhisperContextParameters::default())
-            .with_context(|| "failed to load whisper model")?;
-    let mut state = ctx
-        .create_state()
-        .with_context(|| "failed to init whisper state")?;
+async fn run_transcription(
+    audio: Arc<[f32]>,
+    forced_lang: Option<&str>,
+    model: &Path,
+    budget: WhisperBudget,
+    relaxed: bool,
+) -> Result<TranscribeOutcome> {
+    let mut pooled = pool::checkout(model, budget).await?;
+    let forced_lang = forced_lang.map(str::to_string);
+    tokio::task::spawn_blocking(move || {
+        run_whisper(&mut pooled, &audio, forced_lang.as_deref(), relaxed)
+    })
+    .await
+    .with_context(|| "whisper worker panicked")?
+}
+
+fn run_whisper(
+    pooled: &mut PooledState,
+    audio: &[f32],
+    forced_lang: Option<&str>,
+    relaxed: bool,
+) -> Result<TranscribeOutcome> {
+    let threads = pooled.threads();
+    let state = pooled.state()?;
     let mut params = FullParams::new(SamplingStrategy::Greedy { best_of: 1 });
-    params.set_n_threads(num_cpus::get() as i32);
+    params.set_n_threads(threads);
     params.set_translate(false);
     if relaxed {
         params.set_suppress_blank(false);
@@ -232,9 +379,18 @@ async fn transcribe_audio_with_params(
         params.set_detect_language(true);
     }
 
+    let started = Instant::now();
     state
-        .full(params, &audio[..])
+        .full(params, audio)
         .with_context(|| "whisper transcription failed")?;
+    let audio_secs = audio.len() as f64 / vad::SAMPLE_RATE as f64;
+    if audio_secs > 0.0 {
+        crate::metrics::observe(
+            &crate::metrics::WHISPER_REALTIME,
+            &[],
+            started.elapsed().as_secs_f64() / audio_secs,
+        );
+    }
 
     let detected_lang = state
         .full_lang_id_from_state()
@@ -532,41 +688,5 @@ async fn download_whisper_model(url: &str, dest: &Path) -> Result<()> {
 }
 
 fn read_wav_mono_f32(path: &Path) -> Result<Vec<f32>> {
-    let mut reader = hound::WavReader::open(path)
-        .with_context(|| format!("failed to open wav: {}", path.display()))?;
-    let spec = reader.spec();
-    let channels = spec.channels as usize;
-    if channels == 0 {
-        return Err(anyhow!("wav has no channels"));
-    }
-
-    let samples: Vec<f32> = match spec.sample_format {
-        hound::SampleFormat::Float => reader.samples::<f32>().map(|s| s.unwrap_or(0.0)).collect(),
-        hound::SampleFormat::Int => {
-            let bits = spec.bits_per_sample;
-            let max = (1i64 << (bits - 1)) as f32;
-            if bits <= 16 {
-                reader
-                    .samples::<i16>()
-                    .map(|s| s.unwrap_or(0) as f32 / max)
-                    .collect()
-            } else {
-                reader
-                    .samples::<i32>()
-                    .map(|s| s.unwrap_or(0) as f32 / max)
-                    .collect()
-            }
-        }
-    };
-
-    if channels == 1 {
-        return Ok(samples);
-    }
-
-    let mut mono = Vec::with_capacity(samples.len() / channels);
-    for chunk in samples.chunks(channels) {
-        let sum: f32 = chunk.iter().sum();
-        mono.push(sum / channels as f32);
-    }
-    Ok(mono)
+    open_wav_mono(path)?.collect()
 }
@@ -0,0 +1,253 @@
+use anyhow::{Context, Result, anyhow};
+use std::collections::HashMap;
+use std::path::{Path, PathBuf};
+use std::sync::{Arc, Mutex};
+use tokio::sync::{OwnedSemaphorePermit, Semaphore};
+use tracing::info;
+use whisper_rs::{WhisperContext, WhisperContextParameters, WhisperState};
+
+use crate::settings::Settings;
+use crate::util::lock;
+
+/// How many transcriptions may run at once per model and how many threads each one gets
+/// (see `[whisper]` in settings.toml).
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(super) struct WhisperBudget {
+    pool_size: usize,
+    threads_per_job: usize,
+}
+
+impl WhisperBudget {
+    pub(super) fn from_settings(settings: &Settings) -> Self {
+        Self {
+            pool_size: settings.whisper_pool_size.max(1),
+            threads_per_job: settings.whisper_threads_per_job,
+        }
+    }
+
+    /// Transcriptions that may run at once for one model.
+    pub(super) fn concurrency(&self) -> usize {
+        self.pool_size
+    }
+
+    /// Threads for one `full` call. With `threads_per_job = 0` the cores are split evenly
+    /// between the jobs the pool lets run concurrently.
+    pub(super) fn threads(&self) -> i32 {
+        let threads = if self.threads_per_job > 0 {
+            self.threads_per_job
+        } else {
+            num_cpus::get() / self.pool_size
+        };
+        i32::try_from(threads.max(1)).unwrap_or(i32::MAX)
+    }
+}
+
+/// One loaded model. The context is shared; states are handed to a single job at a time.
+struct ModelSlot {
+    context: WhisperContext,
+    idle: Mutex<Vec<WhisperState>>,
+    permits: PoolPermits,
+}
+
+/// Concurrent jobs on one model. The model is loaded once whatever the caller's budget, so
+/// the limit follows the budget of the latest checkout: settings reloaded with another
+/// `pool_size` resize the pool instead of loading the model a second time.
+struct PoolPermits {
+    semaphore: Arc<Semaphore>,
+    limit: Mutex<PoolLimit>,
+}
+
+#[derive(Debug)]
+struct PoolLimit {
+    size: usize,
+    /// Permits held by running jobs that are retired instead of released after a shrink.
+    excess: usize,
+}
+
+impl PoolPermits {
+    fn new(size: usize) -> Self {
+        Self {
+            semaphore: Arc::new(Semaphore::new(size)),
+            limit: Mutex::new(PoolLimit { size, excess: 0 }),
+        }
+    }
+
+    fn resize(&self, size: usize) {
+        let mut limit = lock(&self.limit);
+        if size > limit.size {
+            let grow = size - limit.size;
+            let kept = grow.min(limit.excess);
+            limit.excess -= kept;
+            self.semaphore.add_permits(grow - kept);
+        } else if size < limit.size {
+            let shrink = limit.size - size;
+            let forgotten = self.semaphore.forget_permits(shrink);
+            limit.excess += shrink - forgotten;
+        }
+        limit.size = size;
+    }
+
+    async fn acquire(&self) -> Result<OwnedSemaphorePermit> {
+        self.semaphore
+            .clone()
+            .acquire_owned()
+            .await
+            .map_err(|_| anyhow!("whisper pool closed"))
+    }
+
+    fn size(&self) -> usize {
+        lock(&self.limit).size
+    }
+
+    /// Gives `permit` back, or retires it while the pool is above its size.
+    fn release(&self, permit: OwnedSemaphorePermit) {
+        let mut limit = lock(&self.limit);
+        if limit.excess > 0 {
+            limit.excess -= 1;
+            permit.forget();
+        }
+    }
+}
+
+static MODELS: Mutex<Option<HashMap<PathBuf, Arc<ModelSlot>>>> = Mutex::new(None);
+
+/// A warm `WhisperState` borrowed from the pool; it goes back to the pool when dropped.
+pub(super) struct PooledState {
+    slot: Arc<ModelSlot>,
+    state: Option<WhisperState>,
+    threads: i32,
+    permit: Option<OwnedSemaphorePermit>,
+}
+
+impl PooledState {
+    pub(super) fn state(&mut self) -> Result<&mut WhisperState> {
+        self.state
+            .as_mut()
+            .ok_or_else(|| anyhow!("whisper state already released"))
+    }
+
+    pub(super) fn threads(&self) -> i32 {
+        self.threads
+    }
+}
+
+impl Drop for PooledState {
+    fn drop(&mut self) {
+        // The state goes back before the permit, so the next job finds it idle.
+        if let Some(state) = self.state.take() {
+            let size = self.slot.permits.size();
+            let mut idle = lock(&self.slot.idle);
+            if idle.len() < size {
+                idle.push(state);
+            }
+        }
+        if let Some(permit) = self.permit.take() {
+            self.slot.permits.release(permit);
+        }
+    }
+}
+
+/// Waits for a free slot on `model_path` and returns a state for it. The model is loaded
+/// once per process; later jobs reuse the context and, when one is idle, its state.
+pub(super) async fn checkout(model_path: &Path, budget: WhisperBudget) -> Result<PooledState> {
+    let slot = model_slot(model_path, budget).await?;
+    slot.permits.resize(budget.pool_size);
+    let permit = slot.permits.acquire().await?;
+    let idle = lock(&slot.idle).pop();
+    let state = match idle {
+        Some(state) => state,
+        None => {
+            let slot = slot.clone();
+            tokio::task::spawn_blocking(move || slot.context.create_state())
+                .await
+                .with_context(|| "whisper state worker panicked")?
+                .with_context(|| "failed to init whisper state")?
+        }
+    };
+    Ok(PooledState {
+        slot,
+        state: Some(state),
+        threads: budget.threads(),
+        permit: Some(permit),
+    })
+}
+
+async fn model_slot(model_path: &Path, budget: WhisperBudget) -> Result<Arc<ModelSlot>> {
+    if let Some(slot) = lock(&MODELS)
+        .as_ref()
+        .and_then(|models| models.get(model_path))
+    {
+        return Ok(slot.clone());
+    }
+
+    info!("audio: loading whisper model {}", model_path.display());
+    let path = model_path.to_path_buf();
+    let context = tokio::task::spawn_blocking(move || {
+        WhisperContext::new_with_params(
+            path.to_string_lossy().as_ref(),
+            WhisperContextParameters::default(),
+        )
+    })
+    .await
+    .with_context(|| "whisper loader panicked")?
+    .with_context(|| "failed to load whisper model")?;
+    let slot = Arc::new(ModelSlot {
+        context,
+        idle: Mutex::new(Vec::new()),
+        permits: PoolPermits::new(budget.pool_size),
+    });
+
+    // Two jobs may race to load the same model; the first one inserted wins.
+    let mut models = lock(&MODELS);
+    Ok(models
+        .get_or_insert_with(HashMap::new)
+        .entry(model_path.to_path_buf())
+        .or_insert(slot)
+        .clone())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn budget_splits_cores_between_concurrent_jobs() {
+        let auto = WhisperBudget::from_settings(&Settings {
+            whisper_pool_size: 0,
+            whisper_threads_per_job: 0,
+            ..Settings::default()
+        });
+        assert_eq!(auto.pool_size, 1);
+        assert_eq!(auto.threads(), num_cpus::get().max(1) as i32);
+
+        let split = WhisperBudget::from_settings(&Settings {
+            whisper_pool_size: num_cpus::get() * 2,
+            whisper_threads_per_job: 0,
+            ..Settings::default()
+        });
+        assert_eq!(split.threads(), 1);
+
+        let fixed = WhisperBudget::from_settings(&Settings {
+            whisper_threads_per_job: 3,
+            ..Settings::default()
+        });
+        assert_eq!(fixed.threads(), 3);
+    }
+
+    #[tokio::test]
+    async fn pool_follows_the_latest_budget() {
+        let permits = PoolPermits::new(2);
+        let first = permits.acquire().await.expect("permit");
+        let second = permits.acquire().await.expect("permit");
+
+        permits.resize(1);
+        assert_eq!(permits.size(), 1);
+        permits.release(first);
+        assert_eq!(permits.semaphore.available_permits(), 0);
+        permits.release(second);
+        assert_eq!(permits.semaphore.available_permits(), 1);
+
+        permits.resize(3);
+        assert_eq!(permits.semaphore.available_permits(), 3);
+    }
+}
@@ -0,0 +1,194 @@
+use anyhow::{Context, Result, anyhow};
+use std::path::Path;
+
+pub(super) const SAMPLE_RATE: usize = 16_000;
+const FRAME_SAMPLES: usize = SAMPLE_RATE * 30 / 1000;
+const MIN_CHUNK_SAMPLES: usize = SAMPLE_RATE * 15;
+// whisper decodes 30 s windows; longer chunks only add a second window.
+const MAX_CHUNK_SAMPLES: usize = SAMPLE_RATE * 30;
+const SILENCE_FRAMES: usize = 10;
+const SILENCE_RMS: f32 = 0.01;
+
+/// Splits a 16 kHz mono sample stream into chunks that end in silence where possible.
+///
+/// Samples are pulled lazily, so only the chunk being filled is held in memory. Once a
+/// chunk is `MIN_CHUNK_SAMPLES` long it is cut after the first run of quiet frames; chunks
+/// without a pause are cut at `MAX_CHUNK_SAMPLES`. A decode error is returned in place of
+/// the chunk it interrupted and ends the stream.
+pub(super) struct SpeechChunks<I> {
+    samples: I,
+    failed: bool,
+}
+
+impl<I: Iterator<Item = Result<f32>>> SpeechChunks<I> {
+    pub(super) fn new(samples: I) -> Self {
+        Self {
+            samples,
+            failed: false,
+        }
+    }
+}
+
+impl<I: Iterator<Item = Result<f32>>> Iterator for SpeechChunks<I> {
+    type Item = Result<Vec<f32>>;
+
+    fn next(&mut self) -> Option<Result<Vec<f32>>> {
+        if self.failed {
+            return None;
+        }
+        let mut chunk = Vec::with_capacity(MAX_CHUNK_SAMPLES);
+        let mut quiet_frames = 0usize;
+        loop {
+            let start = chunk.len();
+            for sample in self.samples.by_ref().take(FRAME_SAMPLES) {
+                match sample {
+                    Ok(sample) => chunk.push(sample),
+                    Err(err) => {
+                        self.failed = true;
+                        return Some(Err(err));
+                    }
+                }
+            }
+            let frame = &chunk[start..];
+            if frame.is_empty() {
+                break;
+            }
+            if rms(frame) < SILENCE_RMS {
+                quiet_frames += 1;
+            } else {
+                quiet_frames = 0;
+            }
+            if frame.len() < FRAME_SAMPLES
+                || chunk.len() >= MAX_CHUNK_SAMPLES
+                || (chunk.len() >= MIN_CHUNK_SAMPLES && quiet_frames >= SILENCE_FRAMES)
+            {
+                break;
+            }
+        }
+        (!chunk.is_empty()).then_some(Ok(chunk))
+    }
+}
+
+fn rms(frame: &[f32]) -> f32 {
+    let sum: f32 = frame.iter().map(|sample| sample * sample).sum();
+    (sum / frame.len() as f32).sqrt()
+}
+
+/// Streams a wav file as mono f32 samples, averaging interleaved channels. Samples that fail
+/// to decode come through as errors rather than silence.
+pub(super) fn open_wav_mono(path: &Path) -> Result<Box<dyn Iterator<Item = Result<f32>> + Send>> {
+    let reader = hound::WavReader::open(path)
+        .with_context(|| format!("failed to open wav: {}", path.display()))?;
+    let spec = reader.spec();
+    let channels = spec.channels as usize;
+    if channels == 0 {
+        return Err(anyhow!("wav has no channels"));
+    }
+
+    let samples: Box<dyn Iterator<Item = Result<f32>> + Send> = match spec.sample_format {
+        hound::SampleFormat::Float => Box::new(reader.into_samples::<f32>().map(decoded)),
+        hound::SampleFormat::Int => {
+            let bits = spec.bits_per_sample;
+            let max = (1i64 << (bits - 1)) as f32;
+            if bits <= 16 {
+                Box::new(
+                    reader
+                        .into_samples::<i16>()
+                        .map(move |s| decoded(s).map(|s| s as f32 / max)),
+                )
+            } else {
+                Box::new(
+                    reader
+                        .into_samples::<i32>()
+                        .map(move |s| decoded(s).map(|s| s as f32 / max)),
+                )
+            }
+        }
+    };
+
+    if channels == 1 {
+        return Ok(samples);
+    }
+
+    let mut samples = samples;
+    Ok(Box::new(std::iter::from_fn(move || {
+        let mut sum = 0.0f32;
+        let mut count = 0usize;
+        for sample in samples.by_ref().take(channels) {
+            match sample {
+                Ok(sample) => sum += sample,
+                Err(err) => return Some(Err(err)),
+            }
+            count += 1;
+        }
+        (count > 0).then(|| Ok(sum / channels as f32))
+    })))
+}
+
+fn decoded<T>(sample: hound::Result<T>) -> Result<T> {
+    sample.with_context(|| "failed to decode wav sample")
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn tone(seconds: usize) -> impl Iterator<Item = Result<f32>> {
+        (0..SAMPLE_RATE * seconds).map(|i| Ok(if i % 2 == 0 { 0.5 } else { -0.5 }))
+    }
+
+    fn silence(millis: usize) -> impl Iterator<Item = Result<f32>> {
+        std::iter::repeat_n(0.0, SAMPLE_RATE * millis / 1000).map(Ok)
+    }
+
+    fn lengths(samples: impl Iterator<Item = Result<f32>>) -> Vec<usize> {
+        SpeechChunks::new(samples)
+            .map(|chunk| chunk.expect("chunk").len())
+            .collect()
+    }
+
+    #[test]
+    fn cuts_at_the_first_pause_after_the_minimum_length() {
+        let samples = tone(10)
+            .chain(silence(600))
+            .chain(tone(10))
+            .chain(silence(600))
+            .chain(tone(3));
+        let chunks = lengths(samples);
+        assert_eq!(chunks.len(), 2);
+        let first_seconds = chunks[0] as f32 / SAMPLE_RATE as f32;
+        assert!(
+            first_seconds > 20.0 && first_seconds < 21.5,
+            "{first_seconds}"
+        );
+        assert_eq!(
+            chunks.iter().sum::<usize>(),
+            SAMPLE_RATE * 23 + SAMPLE_RATE * 1200 / 1000
+        );
+    }
+
+    #[test]
+    fn hard_cuts_speech_without_pauses() {
+        let chunks = lengths(tone(70));
+        assert_eq!(
+            chunks,
+            vec![MAX_CHUNK_SAMPLES, MAX_CHUNK_SAMPLES, SAMPLE_RATE * 10]
+        );
+        assert_eq!(SpeechChunks::new(std::iter::empty()).count(), 0);
+    }
+
+    #[test]
+    fn decode_errors_end_the_stream() {
+        let samples = tone(35)
+            .chain(std::iter::once(Err(anyhow!("truncated"))))
+            .chain(tone(5));
+        let mut chunks = SpeechChunks::new(samples);
+        assert_eq!(
+            chunks.next().expect("chunk").expect("ok").len(),
+            MAX_CHUNK_SAMPLES
+        );
+        let err = chunks.next().expect("error").expect_err("decode error");
+        assert!(err.to_string().contains("truncated"));
+        assert!(chunks.next().is_none());
+    }
+}
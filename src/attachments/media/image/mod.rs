@@ -1,6 +1,7 @@
 use anyhow::{Context, Result, anyhow};
 use std::collections::HashMap;
 use std::path::Path;
+use std::sync::Arc;
 
 use crate::providers::Provider;
 use crate::{TranslateOptions, Translator};
@@ -16,6 +17,7 @@ use super::ocr::{
     OcrDebugConfig, OcrNormalizeRequest, contains_non_latin_script, is_latin_reading,
     normalize_ocr_lines_with_llm, romanize_lines_with_llm,
 };
+use super::shared::{self, ExtractionMemo};
 
 pub(crate) struct ImageTranslateRequest<'a> {
     pub(crate) image_bytes: &'a [u8],
@@ -55,13 +57,58 @@ pub(crate) async fn translate_image_with_cache<P: Provider + Clone>(
     translator: &Translator<P>,
     options: &TranslateOptions,
 ) -> Result<Vec<u8>> {
-    let mut ocr_result = ocr::extract_lines(request.image_bytes, request.ocr_languages)?;
-    let mut reading_map: HashMap<usize, String> = HashMap::new();
-    if should_filter_by_source_lang(&options.source_lang) {
+    let ocr_result = extract_image_lines(
+        Arc::from(request.image_bytes),
+        request.ocr_languages,
+        &options.source_lang,
+        shared::current().as_deref(),
+    )
+    .await?;
+    translate_extracted_image(request, ocr_result, cache, translator, options).await
+}
+
+/// Runs OCR on an image on a blocking worker and drops lines the source language filter
+/// rejects. This is the CPU-bound half of image translation and needs no translator, so
+/// callers may run it ahead of `translate_extracted_image`. With a `memo`, an image already
+/// recognized for another target language is not recognized again.
+pub(crate) async fn extract_image_lines(
+    image_bytes: Arc<[u8]>,
+    ocr_languages: &str,
+    source_lang: &str,
+    memo: Option<&ExtractionMemo>,
+) -> Result<ocr::OcrResult> {
+    let extract = {
+        let image_bytes = image_bytes.clone();
+        let languages = ocr_languages.to_string();
+        async move {
+            tokio::task::spawn_blocking(move || ocr::extract_lines(&image_bytes, &languages))
+                .await
+                .with_context(|| "ocr worker panicked")?
+        }
+    };
+    let mut ocr_result = match memo {
+        Some(memo) => {
+            let key = shared::digest(&[&image_bytes[..], ocr_languages.as_bytes()]);
+            memo.ocr(key, extract).await?
+        }
+        None => extract.await?,
+    };
+    if should_filter_by_source_lang(source_lang) {
         ocr_result
             .lines
             .retain(|line| should_keep_cjk_line(&line.text));
     }
+    Ok(ocr_result)
+}
+
+pub(crate) async fn translate_extracted_image<P: Provider + Clone>(
+    request: ImageTranslateRequest<'_>,
+    mut ocr_result: ocr::OcrResult,
+    cache: &mut TranslationCache,
+    translator: &Translator<P>,
+    options: &TranslateOptions,
+) -> Result<Vec<u8>> {
+    let mut reading_map: HashMap<usize, String> = HashMap::new();
     if ocr_result.lines.is_empty() {
         if request.allow_empty {
             return Ok(request.image_bytes.to_vec());
@@ -213,7 +260,7 @@ pub(crate) async fn translate_image_with_cache<P: Provider + Clone>(
     let bytes = ocr::render_svg_bytes(
         &outcome.svg,
         request.output_mime,
-        overlay.font_metrics.as_ref().map(|metrics| metrics.data()),
+        overlay.font_metrics.as_ref(),
     )?;
     Ok(bytes)
 }
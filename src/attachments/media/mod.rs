@@ -2,8 +2,10 @@ pub mod audio;
 pub mod image;
 pub mod ocr;
 pub mod pdf;
+mod shared;
 
 pub(crate) use audio::translate_audio;
 pub(crate) use image::{ImageTranslateRequest, translate_image_with_cache};
 pub(crate) use ocr::build_ocr_debug_config;
 pub(crate) use pdf::translate_pdf;
+pub(crate) use shared::share_extraction;
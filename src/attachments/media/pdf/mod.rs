@@ -1,9 +1,14 @@
 use anyhow::{Context, Result, anyhow};
+use std::collections::VecDeque;
 use std::fs;
+use std::path::PathBuf;
 use std::process::Command;
+use std::sync::{Arc, OnceLock};
 use tempfile::tempdir;
+use tokio::task::JoinHandle;
 
 use crate::data;
+use crate::ocr::OcrResult;
 use crate::providers::Provider;
 use crate::{TranslateOptions, Translator};
 
@@ -11,8 +16,9 @@ use super::audio::command_exists;
 use crate::attachments::AttachmentTranslation;
 use crate::attachments::cache::TranslationCache;
 
-use super::image::{ImageTranslateRequest, translate_image_with_cache};
+use super::image::{ImageTranslateRequest, extract_image_lines, translate_extracted_image};
 use super::ocr::OcrDebugConfig;
+use super::shared;
 
 pub(crate) async fn translate_pdf<P: Provider + Clone>(
     pdf_bytes: &[u8],
@@ -21,16 +27,52 @@ pub(crate) async fn translate_pdf<P: Provider + Clone>(
     options: &TranslateOptions,
     debug: Option<OcrDebugConfig>,
 ) -> Result<AttachmentTranslation> {
-    let pages = render_pdf_pages(pdf_bytes)?;
-    if pages.is_empty() {
+    let dir = tempdir().with_context(|| "failed to create temp dir for pdf")?;
+    let input_path = dir.path().join("input.pdf");
+    fs::write(&input_path, pdf_bytes).with_context(|| "failed to write temp pdf")?;
+    let render_dir = dir.path().to_path_buf();
+    let renderer = tokio::task::spawn_blocking(move || PageRenderer::open(input_path, render_dir))
+        .await
+        .with_context(|| "pdf render worker panicked")??;
+    let page_count = renderer.page_count;
+    if page_count == 0 {
         return Err(anyhow!("no pages found in pdf"));
     }
 
+    let settings = translator.settings();
+    let workers = match settings.pdf_page_workers {
+        0 => num_cpus::get().max(1),
+        value => value,
+    };
+    let max_inflight_bytes = usize::try_from(settings.pdf_max_inflight_mb)
+        .unwrap_or(usize::MAX)
+        .saturating_mul(1024 * 1024);
+
+    // Pages are rendered and OCR'd on blocking workers ahead of the translation of earlier
+    // pages. The look-ahead is capped by the worker count and by how many rasters of the
+    // largest page seen so far fit into the in-flight budget.
+    let renderer = Arc::new(renderer);
+    let languages: Arc<str> = Arc::from(ocr_languages);
+    let source_lang: Arc<str> = Arc::from(options.source_lang.as_str());
+    let mut pending = VecDeque::from([spawn_page(&renderer, &languages, &source_lang, 0)]);
+    let mut next_page = 1usize;
+    let mut page_bytes = 0usize;
     let mut cache = TranslationCache::new();
-    let mut translated_images = Vec::new();
-    for (index, page) in pages.into_iter().enumerate() {
+    let mut translated_images = Vec::with_capacity(page_count);
+    for index in 0..page_count {
+        let task = pending
+            .pop_front()
+            .ok_or_else(|| anyhow!("pdf page {} was not scheduled", index + 1))?;
+        let (page, lines) = task.await.with_context(|| "pdf page worker panicked")??;
+        page_bytes = page_bytes.max(raster_bytes(&lines));
+        let window = lookahead(workers, max_inflight_bytes, page_bytes);
+        while next_page < page_count && pending.len() < window {
+            pending.push_back(spawn_page(&renderer, &languages, &source_lang, next_page));
+            next_page += 1;
+        }
+
         let debug_page = debug.as_ref().map(|config| config.for_page(index));
-        let output = translate_image_with_cache(
+        let output = translate_extracted_image(
             ImageTranslateRequest {
                 image_bytes: &page,
                 image_mime: "image/png",
@@ -39,6 +81,7 @@ pub(crate) async fn translate_pdf<P: Provider + Clone>(
                 allow_empty: true,
                 debug: debug_page,
             },
+            lines,
             &mut cache,
             translator,
             options,
@@ -51,100 +94,268 @@ pub(crate) async fn translate_pdf<P: Provider + Clone>(
     Ok(cache.finish(data::PDF_MIME.to_string(), pdf))
 }
 
-fn render_pdf_pages(pdf_bytes: &[u8]) -> Result<Vec<Vec<u8>>> {
-    let dir = tempdir().with_context(|| "failed to create temp dir for pdf")?;
-    let input_path = dir.path().join("input.pdf");
-    fs::write(&input_path, pdf_bytes).with_context(|| "failed to write temp pdf")?;
+type RenderedPage = (Arc<[u8]>, OcrResult);
+
+fn spawn_page(
+    renderer: &Arc<PageRenderer>,
+    languages: &Arc<str>,
+    source_lang: &Arc<str>,
+    page: usize,
+) -> JoinHandle<Result<RenderedPage>> {
+    let renderer = renderer.clone();
+    let languages = languages.clone();
+    let source_lang = source_lang.clone();
+    let memo = shared::current();
+    tokio::spawn(async move {
+        let image: Arc<[u8]> = tokio::task::spawn_blocking(move || renderer.render(page))
+            .await
+            .with_context(|| "pdf render worker panicked")??
+            .into();
+        let lines =
+            extract_image_lines(image.clone(), &languages, &source_lang, memo.as_deref()).await?;
+        Ok((image, lines))
+    })
+}
+
+/// Number of pages to keep rendered or rendering ahead of translation. Until the first
+/// page is known only one is scheduled; a zero budget disables the memory cap.
+fn lookahead(workers: usize, max_inflight_bytes: usize, page_bytes: usize) -> usize {
+    if max_inflight_bytes == 0 {
+        return workers.max(1);
+    }
+    if page_bytes == 0 {
+        return 1;
+    }
+    (max_inflight_bytes / page_bytes).clamp(1, workers.max(1))
+}
+
+/// Decoded size of one page; OCR, overlay rendering and the PNG encoder each hold a copy
+/// of roughly this many bytes.
+fn raster_bytes(lines: &OcrResult) -> usize {
+    (lines.width as usize)
+        .saturating_mul(lines.height as usize)
+        .saturating_mul(4)
+}
+
+enum RenderTool {
+    Mutool,
+    Pdftoppm,
+}
+
+impl RenderTool {
+    fn name(&self) -> &'static str {
+        match self {
+            RenderTool::Mutool => "mutool",
+            RenderTool::Pdftoppm => "pdftoppm",
+        }
+    }
+}
+
+/// Pages rendered per tool run. Pages of a batch wait on disk until they are asked for, so
+/// only the pages in flight exist as rasters in memory.
+const RENDER_BATCH: usize = 8;
+
+/// Renders pages on demand, `batch_pages` per tool run rather than one process per page.
+struct PageRenderer {
+    tool: RenderTool,
+    input_path: PathBuf,
+    dir: PathBuf,
+    page_count: usize,
+    batch_pages: usize,
+    /// One entry per batch, set once its pages have been rendered.
+    batches: Vec<OnceLock<Result<(), String>>>,
+}
+
+impl PageRenderer {
+    /// Picks a renderer and reads the page count. Without pdfinfo the page count is not
+    /// known up front, so pdftoppm renders the whole document at once as it used to.
+    fn open(input_path: PathBuf, dir: PathBuf) -> Result<Self> {
+        let tool = if command_exists("mutool") {
+            RenderTool::Mutool
+        } else if command_exists("pdftoppm") {
+            RenderTool::Pdftoppm
+        } else {
+            return Err(anyhow!(
+                "pdf rendering requires mutool or pdftoppm (install mupdf or poppler)"
+            ));
+        };
+        let mut renderer = Self {
+            tool,
+            input_path,
+            dir,
+            page_count: 0,
+            batch_pages: RENDER_BATCH,
+            batches: Vec::new(),
+        };
+        match renderer.read_page_count()? {
+            Some(count) => {
+                renderer.page_count = count;
+                renderer.batches = (0..count.div_ceil(RENDER_BATCH))
+                    .map(|_| OnceLock::new())
+                    .collect();
+            }
+            None => {
+                let count = renderer.render_range(1, None)?;
+                renderer.page_count = count;
+                renderer.batch_pages = count.max(1);
+                renderer.batches = vec![OnceLock::from(Ok(()))];
+            }
+        }
+        Ok(renderer)
+    }
 
-    if command_exists("mutool") {
-        let output = Command::new("mutool")
-            .arg("draw")
-            .arg("-r")
-            .arg("200")
-            .arg("-o")
-            .arg(dir.path().join("page-%03d.png"))
-            .arg(&input_path)
-            .output()
-            .with_context(|| "failed to run mutool")?;
+    /// The page count from `mutool info` or `pdfinfo`, or `None` when pdfinfo is missing.
+    fn read_page_count(&self) -> Result<Option<usize>> {
+        let output = match self.tool {
+            RenderTool::Mutool => Command::new("mutool")
+                .arg("info")
+                .arg(&self.input_path)
+                .output()
+                .with_context(|| "failed to run mutool")?,
+            RenderTool::Pdftoppm if command_exists("pdfinfo") => Command::new("pdfinfo")
+                .arg(&self.input_path)
+                .output()
+                .with_context(|| "failed to run pdfinfo")?,
+            RenderTool::Pdftoppm => return Ok(None),
+        };
         if !output.status.success() {
             let stderr = String::from_utf8_lossy(&output.stderr);
-            return Err(anyhow!("mutool failed: {}", stderr.trim()));
+            return Err(anyhow!("failed to read pdf page count: {}", stderr.trim()));
         }
-    } else if command_exists("pdftoppm") {
-        let output = Command::new("pdftoppm")
-            .arg("-png")
-            .arg("-r")
-            .arg("200")
-            .arg(&input_path)
-            .arg(dir.path().join("page"))
-            .output()
-            .with_context(|| "failed to run pdftoppm")?;
+        parse_page_count(&String::from_utf8_lossy(&output.stdout))
+            .map(Some)
+            .ok_or_else(|| anyhow!("failed to read pdf page count"))
+    }
+
+    /// Returns the zero-based `page` as PNG bytes, rendering its batch first if no other
+    /// page of the batch has, and removes the temporary file.
+    fn render(&self, page: usize) -> Result<Vec<u8>> {
+        let batch = page / self.batch_pages;
+        let rendered = self
+            .batches
+            .get(batch)
+            .ok_or_else(|| anyhow!("pdf page {} is out of range", page + 1))?;
+        rendered
+            .get_or_init(|| {
+                let first = batch * self.batch_pages + 1;
+                let last = (first + self.batch_pages - 1).min(self.page_count);
+                self.render_range(first, Some(last))
+                    .map(|_| ())
+                    .map_err(|err| format!("{:#}", err))
+            })
+            .as_ref()
+            .map_err(|err| anyhow!("{}", err))?;
+        let path = self.page_path(page);
+        let bytes = fs::read(&path).with_context(|| "failed to read rendered pdf page")?;
+        let _ = fs::remove_file(&path);
+        Ok(bytes)
+    }
+
+    /// Renders one-based pages `first..=last` (to the end without `last`) in one run and
+    /// returns how many page files were written.
+    fn render_range(&self, first: usize, last: Option<usize>) -> Result<usize> {
+        let prefix = format!("r{}", first);
+        let output = match self.tool {
+            RenderTool::Mutool => {
+                let mut command = Command::new("mutool");
+                command
+                    .arg("draw")
+                    .arg("-r")
+                    .arg("200")
+                    .arg("-o")
+                    .arg(self.dir.join(format!("{}-%d.png", prefix)))
+                    .arg(&self.input_path);
+                if let Some(last) = last {
+                    command.arg(format!("{}-{}", first, last));
+                }
+                command.output().with_context(|| "failed to run mutool")?
+            }
+            RenderTool::Pdftoppm => {
+                let mut command = Command::new("pdftoppm");
+                command
+                    .arg("-png")
+                    .arg("-r")
+                    .arg("200")
+                    .arg("-f")
+                    .arg(first.to_string());
+                if let Some(last) = last {
+                    command.arg("-l").arg(last.to_string());
+                }
+                command
+                    .arg(&self.input_path)
+                    .arg(self.dir.join(&prefix))
+                    .output()
+                    .with_context(|| "failed to run pdftoppm")?
+            }
+        };
         if !output.status.success() {
             let stderr = String::from_utf8_lossy(&output.stderr);
-            return Err(anyhow!("pdftoppm failed: {}", stderr.trim()));
+            return Err(anyhow!("{} failed: {}", self.tool.name(), stderr.trim()));
         }
-    } else {
-        return Err(anyhow!(
-            "pdf rendering requires mutool or pdftoppm (install mupdf or poppler)"
-        ));
-    }
 
-    let mut pages = Vec::new();
-    let mut entries: Vec<_> = fs::read_dir(dir.path())
-        .with_context(|| "failed to read temp pdf directory")?
-        .filter_map(|entry| entry.ok())
-        .collect();
-    entries.sort_by_key(|entry| entry.path());
-
-    for entry in entries {
-        let path = entry.path();
-        if path
-            .file_name()
-            .and_then(|name| name.to_str())
-            .map(|name| name.starts_with("page-") || name.starts_with("page"))
-            .unwrap_or(false)
-            && path
-                .extension()
-                .and_then(|ext| ext.to_str())
-                .map(|ext| ext.eq_ignore_ascii_case("png"))
-                .unwrap_or(false)
-        {
-            let bytes = fs::read(&path).with_context(|| "failed to read rendered pdf page")?;
-            pages.push(bytes);
+        // The tools number files differently (pdftoppm pads to the page count's width), so
+        // the pages are renamed to a fixed scheme once they are on disk.
+        let mut count = 0usize;
+        let entries =
+            fs::read_dir(&self.dir).with_context(|| "failed to read temp pdf directory")?;
+        for entry in entries.filter_map(|entry| entry.ok()) {
+            let name = entry.file_name();
+            let Some(number) = name
+                .to_str()
+                .and_then(|name| rendered_page_number(name, &prefix))
+                .filter(|number| *number > 0)
+            else {
+                continue;
+            };
+            fs::rename(entry.path(), self.page_path(number - 1))
+                .with_context(|| "failed to move rendered pdf page")?;
+            count += 1;
         }
+        Ok(count)
+    }
+
+    fn page_path(&self, page: usize) -> PathBuf {
+        self.dir.join(format!("page-{:05}.png", page + 1))
     }
-    Ok(pages)
+}
+
+/// The one-based page number of a file named `<prefix>-<number>.png`.
+fn rendered_page_number(name: &str, prefix: &str) -> Option<usize> {
+    name.strip_prefix(prefix)?
+        .strip_prefix('-')?
+        .strip_suffix(".png")?
+        .parse()
+        .ok()
+}
+
+fn parse_page_count(info: &str) -> Option<usize> {
+    info.lines().find_map(|line| {
+        line.trim()
+            .strip_prefix("Pages:")
+            .and_then(|value| value.trim().parse().ok())
+    })
 }
 
 fn images_to_pdf(pages: &[Vec<u8>]) -> Result<Vec<u8>> {
     use printpdf::{Image, ImageTransform, Mm, PdfDocument};
 
+    // Each page is decoded, embedded and dropped before the next one is decoded.
     let mut doc = None;
-    let mut layers = Vec::new();
-
     for (idx, bytes) in pages.iter().enumerate() {
         let image = printpdf::image_crate::load_from_memory(bytes)
             .with_context(|| "failed to decode rendered pdf page")?;
-        let width = image.width();
-        let height = image.height();
-        let width_mm = px_to_mm(width);
-        let height_mm = px_to_mm(height);
-
-        if idx == 0 {
-            let (doc_handle, page, layer) =
-                PdfDocument::new("translated", Mm(width_mm), Mm(height_mm), "Layer 1");
-            doc = Some(doc_handle);
-            layers.push((page, layer, image));
-        } else if let Some(doc_handle) = doc.as_mut() {
-            let (page, layer) =
-                doc_handle.add_page(Mm(width_mm), Mm(height_mm), format!("Layer {}", idx + 1));
-            layers.push((page, layer, image));
-        }
-    }
+        let width_mm = px_to_mm(image.width());
+        let height_mm = px_to_mm(image.height());
 
-    let doc = doc.ok_or_else(|| anyhow!("no pages to render"))?;
-    for (page, layer, image) in layers.into_iter() {
-        let current_layer = doc.get_page(page).get_layer(layer);
+        let (doc_handle, page, layer) = match doc.take() {
+            None => PdfDocument::new("translated", Mm(width_mm), Mm(height_mm), "Layer 1"),
+            Some(doc_handle) => {
+                let (page, layer) =
+                    doc_handle.add_page(Mm(width_mm), Mm(height_mm), format!("Layer {}", idx + 1));
+                (doc_handle, page, layer)
+            }
+        };
+        let current_layer = doc_handle.get_page(page).get_layer(layer);
         let pdf_image = Image::from_dynamic_image(&image);
         let transform = ImageTransform {
             translate_x: Some(Mm(0.0)),
@@ -155,8 +366,10 @@ fn images_to_pdf(pages: &[Vec<u8>]) -> Result<Vec<u8>> {
             dpi: Some(72.0),
         };
         pdf_image.add_to_layer(current_layer, transform);
+        doc = Some(doc_handle);
     }
 
+    let doc = doc.ok_or_else(|| anyhow!("no pages to render"))?;
     let mut buffer = Vec::new();
     {
         let mut writer = std::io::BufWriter::new(&mut buffer);
@@ -170,3 +383,37 @@ fn px_to_mm(px: u32) -> f32 {
     let inches = px as f32 / 72.0;
     inches * 25.4
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn lookahead_fits_pages_into_the_inflight_budget() {
+        let mb = 1024 * 1024;
+        assert_eq!(lookahead(8, 512 * mb, 0), 1);
+        assert_eq!(lookahead(8, 512 * mb, 100 * mb), 5);
+        assert_eq!(lookahead(8, 512 * mb, mb), 8);
+        assert_eq!(lookahead(8, 10 * mb, 100 * mb), 1);
+        assert_eq!(lookahead(8, 0, 100 * mb), 8);
+    }
+
+    #[test]
+    fn parses_page_count_from_mutool_and_pdfinfo() {
+        let mutool = "input.pdf:\n\nPDF-1.7\nInfo object (1 0 R):\nPages: 12\n";
+        assert_eq!(parse_page_count(mutool), Some(12));
+        let pdfinfo = "Producer:       test\nPages:          300\nEncrypted:      no\n";
+        assert_eq!(parse_page_count(pdfinfo), Some(300));
+        assert_eq!(parse_page_count("Title: x\n"), None);
+    }
+
+    #[test]
+    fn reads_page_numbers_from_rendered_file_names() {
+        // mutool writes the bare page number; pdftoppm pads it to the page count's width.
+        assert_eq!(rendered_page_number("r9-12.png", "r9"), Some(12));
+        assert_eq!(rendered_page_number("r9-012.png", "r9"), Some(12));
+        assert_eq!(rendered_page_number("r1-3.png", "r17"), None);
+        assert_eq!(rendered_page_number("r17-3.png", "r1"), None);
+        assert_eq!(rendered_page_number("page-00003.png", "r1"), None);
+    }
+}
@@ -0,0 +1,140 @@
+use anyhow::Result;
+use std::collections::HashMap;
+use std::future::Future;
+use std::sync::{Arc, Mutex};
+use tokio::sync::OnceCell;
+
+use crate::ocr::OcrResult;
+use crate::util::lock;
+
+use super::audio::TranscribeOutcome;
+
+tokio::task_local! {
+    static SHARED: Arc<ExtractionMemo>;
+}
+
+/// OCR and transcription results keyed by a digest of their input. One memo is shared by
+/// the translations of a single source into several target languages, so each page or
+/// speech chunk is recognized once however many languages are requested.
+#[derive(Default)]
+pub(crate) struct ExtractionMemo {
+    ocr: Mutex<HashMap<[u8; 16], Arc<OnceCell<OcrResult>>>>,
+    transcripts: Mutex<HashMap<[u8; 16], Arc<OnceCell<TranscribeOutcome>>>>,
+}
+
+/// Runs `future` with one extraction memo shared by everything it awaits. Outside this
+/// scope every OCR and transcription call runs on its own.
+pub(crate) async fn share_extraction<F: Future>(future: F) -> F::Output {
+    SHARED
+        .scope(Arc::new(ExtractionMemo::default()), future)
+        .await
+}
+
+/// The memo in scope, if any. Blocking workers do not see task locals, so callers capture
+/// this before moving work onto them.
+pub(super) fn current() -> Option<Arc<ExtractionMemo>> {
+    SHARED.try_with(Arc::clone).ok()
+}
+
+/// Length-prefixed digest of `parts`.
+pub(super) fn digest(parts: &[&[u8]]) -> [u8; 16] {
+    let mut context = md5::Context::new();
+    for part in parts {
+        context.consume((part.len() as u64).to_le_bytes());
+        context.consume(part);
+    }
+    context.compute().0
+}
+
+impl ExtractionMemo {
+    /// Awaits `extract` for the first caller with `key`; callers racing on the same key wait
+    /// for it without holding a thread. Failures are not remembered, the next caller tries
+    /// again.
+    pub(super) async fn ocr<F>(&self, key: [u8; 16], extract: F) -> Result<OcrResult>
+    where
+        F: Future<Output = Result<OcrResult>>,
+    {
+        let cell = lock(&self.ocr).entry(key).or_default().clone();
+        cell.get_or_try_init(|| extract).await.cloned()
+    }
+
+    pub(super) async fn transcript<F>(
+        &self,
+        key: [u8; 16],
+        transcribe: F,
+    ) -> Result<TranscribeOutcome>
+    where
+        F: Future<Output = Result<TranscribeOutcome>>,
+    {
+        let cell = lock(&self.transcripts).entry(key).or_default().clone();
+        cell.get_or_try_init(|| transcribe).await.cloned()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use anyhow::anyhow;
+    use std::sync::atomic::{AtomicUsize, Ordering};
+
+    fn page() -> OcrResult {
+        OcrResult {
+            width: 10,
+            height: 20,
+            lines: Vec::new(),
+        }
+    }
+
+    #[tokio::test]
+    async fn ocr_runs_once_per_key_and_retries_failures() {
+        let memo = ExtractionMemo::default();
+        let runs = AtomicUsize::new(0);
+        let key = digest(&[b"image", b"eng"]);
+        let failed = memo
+            .ocr(key, async {
+                runs.fetch_add(1, Ordering::Relaxed);
+                Err(anyhow!("tesseract failed"))
+            })
+            .await;
+        assert!(failed.is_err());
+        let results = futures_util::future::join_all((0..3).map(|_| {
+            memo.ocr(key, async {
+                runs.fetch_add(1, Ordering::Relaxed);
+                tokio::task::yield_now().await;
+                Ok(page())
+            })
+        }))
+        .await;
+        for result in results {
+            assert_eq!(result.expect("ocr").height, 20);
+        }
+        assert_eq!(runs.load(Ordering::Relaxed), 2);
+        assert_ne!(key, digest(&[b"imageeng"]));
+    }
+
+    #[tokio::test]
+    async fn concurrent_transcriptions_share_one_run() {
+        let runs = Arc::new(AtomicUsize::new(0));
+        let texts = share_extraction(futures_util::future::join_all((0..3).map(|_| {
+            let runs = runs.clone();
+            async move {
+                let memo = current().expect("memo in scope");
+                memo.transcript(digest(&[b"chunk"]), async {
+                    runs.fetch_add(1, Ordering::Relaxed);
+                    tokio::task::yield_now().await;
+                    Ok(TranscribeOutcome {
+                        text: "hello".to_string(),
+                        detected_lang: None,
+                    })
+                })
+                .await
+                .expect("transcript")
+                .text
+            }
+        })))
+        .await;
+        assert_eq!(texts, vec!["hello"; 3]);
+        assert_eq!(runs.load(Ordering::Relaxed), 1);
+        assert!(current().is_none());
+    }
+}
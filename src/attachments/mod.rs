@@ -14,8 +14,9 @@ use crate::data;
 use crate::providers::{Provider, ProviderUsage};
 use crate::{TranslateOptions, Translator};
 
-use cache::TranslationCache;
+pub(crate) use cache::TranslationCache;
 use code::{translate_javascript, translate_mermaid, translate_tsx, translate_typescript};
+pub(crate) use media::share_extraction;
 use media::{
     ImageTranslateRequest, build_ocr_debug_config, translate_audio, translate_image_with_cache,
     translate_pdf,
@@ -33,6 +34,30 @@ pub struct AttachmentTranslation {
     pub usage: Option<ProviderUsage>,
 }
 
+/// Whether `translate_attachment` has a translator for `mime`; other files are only copied.
+pub fn supports_mime(mime: &str) -> bool {
+    mime.starts_with("image/")
+        || mime.starts_with("audio/")
+        || matches!(
+            mime,
+            data::DOCX_MIME
+                | data::PPTX_MIME
+                | data::XLSX_MIME
+                | data::PDF_MIME
+                | data::MARKDOWN_MIME
+                | data::HTML_MIME
+                | data::JSON_MIME
+                | data::YAML_MIME
+                | data::PO_MIME
+                | data::XML_MIME
+                | data::JS_MIME
+                | data::TS_MIME
+                | data::TSX_MIME
+                | data::MERMAID_MIME
+                | data::TEXT_MIME
+        )
+}
+
 #[allow(clippy::too_many_arguments)]
 pub async fn translate_attachment<P: Provider + Clone>(
     data: &data::DataAttachment,
@@ -1,7 +1,7 @@
 use anyhow::{Context, Result, anyhow};
+use quick_xml::Reader;
 use quick_xml::events::{BytesText, Event};
-use quick_xml::{Reader, Writer};
-use std::io::{Cursor, Read, Write};
+use std::io::{BufWriter, Cursor, Read, Seek, Write};
 use zip::write::FileOptions;
 use zip::{ZipArchive, ZipWriter};
 
@@ -11,6 +11,7 @@ use crate::{TranslateOptions, Translator};
 
 use super::AttachmentTranslation;
 use super::cache::TranslationCache;
+use super::util::XmlSink;
 
 #[derive(Debug, Clone, Copy)]
 pub(crate) enum OfficeKind {
@@ -19,64 +20,132 @@ pub(crate) enum OfficeKind {
     Xlsx,
 }
 
+/// Translates every part in two passes: strings from all parts are collected and translated
+/// in one deduplicated batch, then the archive is rewritten from that cache.
+///
+/// The rewritten archive is buffered in memory, since `AttachmentTranslation` carries the
+/// output bytes, and parts are rewritten one after another. The provider calls all happen
+/// in the batch flush; the rewrite that follows is XML serialization only.
 pub(crate) async fn translate_office_zip<P: Provider + Clone>(
     bytes: &[u8],
     kind: OfficeKind,
     translator: &Translator<P>,
     options: &TranslateOptions,
 ) -> Result<AttachmentTranslation> {
+    let mut cache = TranslationCache::collecting();
+    collect_office_strings(bytes, kind, &mut cache, translator, options).await?;
+    cache.flush(translator, options).await?;
+    let sink = Cursor::new(Vec::with_capacity(bytes.len()));
+    let output = write_office_zip(bytes, kind, sink, &mut cache, translator, options).await?;
+    Ok(cache.finish(kind.mime().to_string(), output.into_inner()))
+}
+
+/// Walks only the translatable parts so every string from every slide, sheet and part
+/// lands in one deduplicated batch. Nothing is written on this pass.
+async fn collect_office_strings<P: Provider + Clone>(
+    bytes: &[u8],
+    kind: OfficeKind,
+    cache: &mut TranslationCache,
+    translator: &Translator<P>,
+    options: &TranslateOptions,
+) -> Result<()> {
+    let mut archive =
+        ZipArchive::new(Cursor::new(bytes)).with_context(|| "failed to read zip archive")?;
+    for i in 0..archive.len() {
+        let Some(data) = read_translatable_entry(&mut archive, i, kind)? else {
+            continue;
+        };
+        let mut sink = XmlSink::<std::io::Sink>::discard();
+        translate_office_entry(kind, &data, &mut sink, cache, translator, options).await?;
+    }
+    Ok(())
+}
+
+/// Writes the translated archive to `sink`. Translated parts are serialized straight into
+/// the zip entry as they are rewritten; parts that are not translated (media, fonts,
+/// relationships) are copied as stored bytes without being decompressed.
+async fn write_office_zip<W: Write + Seek, P: Provider + Clone>(
+    bytes: &[u8],
+    kind: OfficeKind,
+    sink: W,
+    cache: &mut TranslationCache,
+    translator: &Translator<P>,
+    options: &TranslateOptions,
+) -> Result<W> {
     let mut archive =
         ZipArchive::new(Cursor::new(bytes)).with_context(|| "failed to read zip archive")?;
-    let mut writer = ZipWriter::new(Cursor::new(Vec::new()));
-    let mut cache = TranslationCache::new();
+    let mut writer = ZipWriter::new(sink);
 
     for i in 0..archive.len() {
-        let mut file = archive
-            .by_index(i)
+        let Some(data) = read_translatable_entry(&mut archive, i, kind)? else {
+            let file = archive
+                .by_index_raw(i)
+                .with_context(|| "failed to read zip entry")?;
+            writer
+                .raw_copy_file(file)
+                .with_context(|| "failed to copy zip entry")?;
+            continue;
+        };
+        let file = archive
+            .by_index_raw(i)
             .with_context(|| "failed to read zip entry")?;
         let name = file.name().to_string();
         let file_options = FileOptions::default().compression_method(file.compression());
-        if file.is_dir() {
-            writer
-                .add_directory(name, file_options)
-                .with_context(|| "failed to write zip directory")?;
-            continue;
-        }
-
-        let mut data = Vec::new();
-        file.read_to_end(&mut data)
-            .with_context(|| "failed to read zip entry content")?;
         drop(file);
 
-        let output = if should_translate_office_entry(kind, &name) {
-            match kind {
-                OfficeKind::Docx => {
-                    translate_docx_xml(&data, &mut cache, translator, options).await?
-                }
-                OfficeKind::Pptx => {
-                    translate_pptx_xml(&data, &mut cache, translator, options).await?
-                }
-                OfficeKind::Xlsx => {
-                    translate_xlsx_xml(&data, &mut cache, translator, options).await?
-                }
-            }
-        } else {
-            data
-        };
-
         writer
             .start_file(name, file_options)
             .with_context(|| "failed to write zip entry")?;
-        writer
-            .write_all(&output)
-            .with_context(|| "failed to write zip content")?;
+        let mut entry = XmlSink::new(BufWriter::new(&mut writer));
+        translate_office_entry(kind, &data, &mut entry, cache, translator, options).await?;
+        if let Some(mut buffered) = entry.into_inner() {
+            buffered
+                .flush()
+                .with_context(|| "failed to write zip content")?;
+        }
     }
 
-    let bytes = writer
+    writer
         .finish()
-        .with_context(|| "failed to finalize zip output")?
-        .into_inner();
-    Ok(cache.finish(kind.mime().to_string(), bytes))
+        .with_context(|| "failed to finalize zip output")
+}
+
+/// Returns the decompressed content of entry `index` when it is a part that gets
+/// translated, or `None` for directories and everything else.
+fn read_translatable_entry(
+    archive: &mut ZipArchive<Cursor<&[u8]>>,
+    index: usize,
+    kind: OfficeKind,
+) -> Result<Option<Vec<u8>>> {
+    let mut file = archive
+        .by_index(index)
+        .with_context(|| "failed to read zip entry")?;
+    if file.is_dir() || !should_translate_office_entry(kind, file.name()) {
+        return Ok(None);
+    }
+    let mut data = Vec::new();
+    file.read_to_end(&mut data)
+        .with_context(|| "failed to read zip entry content")?;
+    Ok(Some(data))
+}
+
+async fn translate_office_entry<W: Write, P: Provider + Clone>(
+    kind: OfficeKind,
+    data: &[u8],
+    sink: &mut XmlSink<W>,
+    cache: &mut TranslationCache,
+    translator: &Translator<P>,
+    options: &TranslateOptions,
+) -> Result<()> {
+    match kind {
+        OfficeKind::Docx => {
+            translate_xml_simple(data, sink, cache, translator, options, b"w:t").await
+        }
+        OfficeKind::Pptx => {
+            translate_xml_simple(data, sink, cache, translator, options, b"a:t").await
+        }
+        OfficeKind::Xlsx => translate_xlsx_xml(data, sink, cache, translator, options).await,
+    }
 }
 
 fn should_translate_office_entry(kind: OfficeKind, name: &str) -> bool {
@@ -100,40 +169,21 @@ impl OfficeKind {
     }
 }
 
-async fn translate_docx_xml<P: Provider + Clone>(
-    xml: &[u8],
-    cache: &mut TranslationCache,
-    translator: &Translator<P>,
-    options: &TranslateOptions,
-) -> Result<Vec<u8>> {
-    translate_xml_simple(xml, cache, translator, options, b"w:t").await
-}
-
-async fn translate_pptx_xml<P: Provider + Clone>(
+async fn translate_xlsx_xml<W: Write, P: Provider + Clone>(
     xml: &[u8],
+    sink: &mut XmlSink<W>,
     cache: &mut TranslationCache,
     translator: &Translator<P>,
     options: &TranslateOptions,
-) -> Result<Vec<u8>> {
-    translate_xml_simple(xml, cache, translator, options, b"a:t").await
-}
-
-async fn translate_xlsx_xml<P: Provider + Clone>(
-    xml: &[u8],
-    cache: &mut TranslationCache,
-    translator: &Translator<P>,
-    options: &TranslateOptions,
-) -> Result<Vec<u8>> {
-    let mut reader = Reader::from_reader(Cursor::new(xml));
+) -> Result<()> {
+    let mut reader = Reader::from_reader(xml);
     reader.trim_text(false);
-    let mut writer = Writer::new(Vec::new());
-    let mut buf = Vec::new();
     let mut in_text = false;
     let mut in_si = 0usize;
     let mut in_is = 0usize;
 
     loop {
-        match reader.read_event_into(&mut buf) {
+        match reader.read_event() {
             Ok(Event::Start(e)) => {
                 if e.name().as_ref() == b"si" {
                     in_si += 1;
@@ -142,7 +192,7 @@ async fn translate_xlsx_xml<P: Provider + Clone>(
                 } else if e.name().as_ref() == b"t" && (in_si > 0 || in_is > 0) {
                     in_text = true;
                 }
-                writer.write_event(Event::Start(e.to_owned()))?;
+                sink.write(Event::Start(e))?;
             }
             Ok(Event::End(e)) => {
                 if e.name().as_ref() == b"t" {
@@ -152,107 +202,135 @@ async fn translate_xlsx_xml<P: Provider + Clone>(
                 } else if e.name().as_ref() == b"is" {
                     in_is = in_is.saturating_sub(1);
                 }
-                writer.write_event(Event::End(e.to_owned()))?;
-            }
-            Ok(Event::Text(e)) => {
-                if in_text {
-                    let text = e.unescape()?.into_owned();
-                    let translated = cache
-                        .translate_preserve_whitespace(&text, translator, options)
-                        .await?;
-                    let output = BytesText::new(&translated);
-                    writer.write_event(Event::Text(output))?;
-                } else {
-                    writer.write_event(Event::Text(e))?;
-                }
-            }
-            Ok(Event::CData(e)) => {
-                if in_text {
-                    let raw = e.into_inner();
-                    let text = String::from_utf8_lossy(raw.as_ref()).into_owned();
-                    let translated = cache
-                        .translate_preserve_whitespace(&text, translator, options)
-                        .await?;
-                    let output = BytesText::new(&translated);
-                    writer.write_event(Event::Text(output))?;
-                } else {
-                    writer.write_event(Event::CData(e))?;
-                }
+                sink.write(Event::End(e))?;
             }
             Ok(Event::Eof) => break,
-            Ok(event) => {
-                writer.write_event(event)?;
-            }
+            Ok(event) => write_text_event(event, in_text, sink, cache, translator, options).await?,
             Err(err) => {
                 return Err(anyhow!("failed to parse xlsx xml: {}", err));
             }
         }
-        buf.clear();
     }
-    Ok(writer.into_inner())
+    Ok(())
 }
 
-async fn translate_xml_simple<P: Provider + Clone>(
+/// Streams the events of one part into `sink`, translating the text of `tag_name` elements.
+async fn translate_xml_simple<W: Write, P: Provider + Clone>(
     xml: &[u8],
+    sink: &mut XmlSink<W>,
     cache: &mut TranslationCache,
     translator: &Translator<P>,
     options: &TranslateOptions,
     tag_name: &[u8],
-) -> Result<Vec<u8>> {
-    let mut reader = Reader::from_reader(Cursor::new(xml));
+) -> Result<()> {
+    let mut reader = Reader::from_reader(xml);
     reader.trim_text(false);
-    let mut writer = Writer::new(Vec::new());
-    let mut buf = Vec::new();
     let mut in_text = false;
 
     loop {
-        match reader.read_event_into(&mut buf) {
+        match reader.read_event() {
             Ok(Event::Start(e)) => {
                 if e.name().as_ref() == tag_name {
                     in_text = true;
                 }
-                writer.write_event(Event::Start(e.to_owned()))?;
+                sink.write(Event::Start(e))?;
             }
             Ok(Event::End(e)) => {
                 if e.name().as_ref() == tag_name {
                     in_text = false;
                 }
-                writer.write_event(Event::End(e.to_owned()))?;
-            }
-            Ok(Event::Text(e)) => {
-                if in_text {
-                    let text = e.unescape()?.into_owned();
-                    let translated = cache
-                        .translate_preserve_whitespace(&text, translator, options)
-                        .await?;
-                    let output = BytesText::new(&translated);
-                    writer.write_event(Event::Text(output))?;
-                } else {
-                    writer.write_event(Event::Text(e))?;
-                }
-            }
-            Ok(Event::CData(e)) => {
-                if in_text {
-                    let raw = e.into_inner();
-                    let text = String::from_utf8_lossy(raw.as_ref()).into_owned();
-                    let translated = cache
-                        .translate_preserve_whitespace(&text, translator, options)
-                        .await?;
-                    let output = BytesText::new(&translated);
-                    writer.write_event(Event::Text(output))?;
-                } else {
-                    writer.write_event(Event::CData(e))?;
-                }
+                sink.write(Event::End(e))?;
             }
             Ok(Event::Eof) => break,
-            Ok(event) => {
-                writer.write_event(event)?;
-            }
+            Ok(event) => write_text_event(event, in_text, sink, cache, translator, options).await?,
             Err(err) => {
                 return Err(anyhow!("failed to parse xml: {}", err));
             }
         }
-        buf.clear();
     }
-    Ok(writer.into_inner())
+    Ok(())
+}
+
+/// Writes a non-tag event, translating text and CDATA inside a text element.
+async fn write_text_event<W: Write, P: Provider + Clone>(
+    event: Event<'_>,
+    in_text: bool,
+    sink: &mut XmlSink<W>,
+    cache: &mut TranslationCache,
+    translator: &Translator<P>,
+    options: &TranslateOptions,
+) -> Result<()> {
+    let text = match &event {
+        Event::Text(e) if in_text => e.unescape()?,
+        Event::CData(e) if in_text => String::from_utf8_lossy(e.as_ref()),
+        _ => return sink.write(event),
+    };
+    let translated = cache
+        .translate_preserve_whitespace(&text, translator, options)
+        .await?;
+    sink.write(Event::Text(BytesText::new(&translated)))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::bench_support::{MockProvider, mock_translator, options};
+    use zip::CompressionMethod;
+
+    fn slide(text: &str) -> String {
+        format!(
+            r#"<p:sld><p:txBody><a:p><a:r><a:t>{}</a:t></a:r></a:p></p:txBody></p:sld>"#,
+            text
+        )
+    }
+
+    #[tokio::test]
+    async fn translates_all_slides_in_one_batch_and_copies_media_raw() {
+        let media = vec![7u8; 4096];
+        let mut writer = ZipWriter::new(Cursor::new(Vec::new()));
+        let deflated = FileOptions::default().compression_method(CompressionMethod::Deflated);
+        let stored = FileOptions::default().compression_method(CompressionMethod::Stored);
+        writer.add_directory("ppt/", stored).expect("dir");
+        for (name, text) in [
+            ("ppt/slides/slide1.xml", slide("Hello")),
+            ("ppt/slides/slide2.xml", slide("World")),
+            ("ppt/slides/slide3.xml", slide("Hello")),
+        ] {
+            writer.start_file(name, deflated).expect("slide");
+            writer.write_all(text.as_bytes()).expect("slide");
+        }
+        writer
+            .start_file("ppt/media/video1.mp4", stored)
+            .expect("media");
+        writer.write_all(&media).expect("media");
+        let input = writer.finish().expect("zip").into_inner();
+
+        let provider = MockProvider::new();
+        let translator = mock_translator(provider.clone()).expect("translator");
+
+        let output = translate_office_zip(&input, OfficeKind::Pptx, &translator, &options())
+            .await
+            .expect("translate");
+        assert_eq!(provider.calls(), 1);
+
+        let mut archive = ZipArchive::new(Cursor::new(output.bytes)).expect("output zip");
+        assert_eq!(archive.len(), 5);
+        let mut read = |name: &str| {
+            let mut file = archive.by_name(name).expect("entry");
+            let method = file.compression();
+            let mut data = Vec::new();
+            file.read_to_end(&mut data).expect("read");
+            (method, data)
+        };
+        let (method, slide3) = read("ppt/slides/slide3.xml");
+        assert_eq!(method, CompressionMethod::Deflated);
+        assert_eq!(String::from_utf8(slide3).expect("utf8"), slide("tr:Hello"));
+        assert_eq!(
+            read("ppt/slides/slide2.xml").1,
+            slide("tr:World").into_bytes()
+        );
+        let (method, copied) = read("ppt/media/video1.mp4");
+        assert_eq!(method, CompressionMethod::Stored);
+        assert_eq!(copied, media);
+    }
 }
@@ -4,13 +4,15 @@ use crate::{TranslateOptions, Translator};
 use anyhow::{Context, Result, anyhow};
 use futures_util::FutureExt;
 use futures_util::future::BoxFuture;
+use quick_xml::Reader;
 use quick_xml::events::{BytesCData, BytesText, Event};
-use quick_xml::{Reader, Writer};
-use std::io::Cursor;
+use std::io::Write;
 
 use super::AttachmentTranslation;
 use super::cache::TranslationCache;
-use super::util::{is_numeric_like, looks_like_code, should_translate_text, split_text_bounds};
+use super::util::{
+    XmlSink, is_numeric_like, looks_like_code, should_translate_text, split_text_bounds,
+};
 pub(crate) async fn translate_html<P: Provider + Clone>(
     bytes: &[u8],
     with_commentout: bool,
@@ -20,9 +22,14 @@ pub(crate) async fn translate_html<P: Provider + Clone>(
     use kuchiki::traits::*;
 
     let html = std::str::from_utf8(bytes).with_context(|| "failed to decode html as UTF-8")?;
+    let mut cache = TranslationCache::collecting();
+
+    // The collect pass may rewrite the tree (e.g. comment-out nodes), so each pass parses afresh.
     let document = kuchiki::parse_html().one(html);
-    let mut cache = TranslationCache::new();
+    translate_html_document(&document, with_commentout, translator, options, &mut cache).await?;
+    cache.flush(translator, options).await?;
 
+    let document = kuchiki::parse_html().one(html);
     translate_html_document(&document, with_commentout, translator, options, &mut cache).await?;
 
     let output = document.to_string();
@@ -36,7 +43,9 @@ pub(crate) async fn translate_markdown<P: Provider + Clone>(
 ) -> Result<AttachmentTranslation> {
     let markdown =
         std::str::from_utf8(bytes).with_context(|| "failed to decode markdown as UTF-8")?;
-    let mut cache = TranslationCache::new();
+    let mut cache = TranslationCache::collecting();
+    translate_markdown_text(markdown, &mut cache, translator, options).await?;
+    cache.flush(translator, options).await?;
     let output = translate_markdown_text(markdown, &mut cache, translator, options).await?;
     Ok(cache.finish(data::MARKDOWN_MIME.to_string(), output.into_bytes()))
 }
@@ -47,14 +56,47 @@ pub(crate) async fn translate_xml<P: Provider + Clone>(
     translator: &Translator<P>,
     options: &TranslateOptions,
 ) -> Result<AttachmentTranslation> {
-    let mut reader = Reader::from_reader(Cursor::new(bytes));
+    let mut cache = TranslationCache::collecting();
+    let mut collect = XmlSink::<std::io::Sink>::discard();
+    rewrite_xml(
+        bytes,
+        with_commentout,
+        &mut collect,
+        &mut cache,
+        translator,
+        options,
+    )
+    .await?;
+    cache.flush(translator, options).await?;
+    let mut sink = XmlSink::new(Vec::with_capacity(bytes.len()));
+    rewrite_xml(
+        bytes,
+        with_commentout,
+        &mut sink,
+        &mut cache,
+        translator,
+        options,
+    )
+    .await?;
+    let output = sink.into_inner().unwrap_or_default();
+    Ok(cache.finish(data::XML_MIME.to_string(), output))
+}
+
+/// One streaming pass over the events of `bytes`. Events borrow from the input and go
+/// straight to `sink`; only translated nodes allocate.
+async fn rewrite_xml<W: Write, P: Provider + Clone>(
+    bytes: &[u8],
+    with_commentout: bool,
+    sink: &mut XmlSink<W>,
+    cache: &mut TranslationCache,
+    translator: &Translator<P>,
+    options: &TranslateOptions,
+) -> Result<()> {
+    let mut reader = Reader::from_reader(bytes);
     reader.trim_text(false);
-    let mut writer = Writer::new(Vec::new());
-    let mut cache = TranslationCache::new();
-    let mut buf = Vec::new();
 
     loop {
-        match reader.read_event_into(&mut buf) {
+        match reader.read_event() {
             Ok(Event::Eof) => break,
             Ok(Event::Text(text)) => {
                 let decoded = text
@@ -64,31 +106,24 @@ pub(crate) async fn translate_xml<P: Provider + Clone>(
                     let translated = cache
                         .translate_preserve_whitespace(decoded.as_ref(), translator, options)
                         .await?;
-                    writer
-                        .write_event(Event::Text(BytesText::new(&translated)))
+                    sink.write(Event::Text(BytesText::new(&translated)))
                         .with_context(|| "failed to write xml text")?;
                 } else {
-                    writer
-                        .write_event(Event::Text(text.into_owned()))
+                    sink.write(Event::Text(text))
                         .with_context(|| "failed to write xml text")?;
                 }
             }
             Ok(Event::CData(cdata)) => {
-                let mut wrote = false;
                 if let Ok(text) = std::str::from_utf8(cdata.as_ref())
                     && should_translate_text(text)
                 {
                     let translated = cache
                         .translate_preserve_whitespace(text, translator, options)
                         .await?;
-                    writer
-                        .write_event(Event::CData(BytesCData::new(&translated)))
+                    sink.write(Event::CData(BytesCData::new(&translated)))
                         .with_context(|| "failed to write xml cdata")?;
-                    wrote = true;
-                }
-                if !wrote {
-                    writer
-                        .write_event(Event::CData(cdata.into_owned()))
+                } else {
+                    sink.write(Event::CData(cdata))
                         .with_context(|| "failed to write xml cdata")?;
                 }
             }
@@ -101,28 +136,22 @@ pub(crate) async fn translate_xml<P: Provider + Clone>(
                         let translated = cache
                             .translate_preserve_whitespace(decoded.as_ref(), translator, options)
                             .await?;
-                        writer
-                            .write_event(Event::Comment(BytesText::new(&translated)))
+                        sink.write(Event::Comment(BytesText::new(&translated)))
                             .with_context(|| "failed to write xml comment")?;
-                        buf.clear();
                         continue;
                     }
                 }
-                writer
-                    .write_event(Event::Comment(comment.into_owned()))
+                sink.write(Event::Comment(comment))
                     .with_context(|| "failed to write xml comment")?;
             }
             Ok(event) => {
-                writer
-                    .write_event(event.into_owned())
-                    .with_context(|| "failed to write xml event")?;
+                sink.write(event)?;
             }
             Err(err) => return Err(anyhow!("failed to parse xml: {}", err)),
         }
-        buf.clear();
     }
 
-    Ok(cache.finish(data::XML_MIME.to_string(), writer.into_inner()))
+    Ok(())
 }
 
 #[cfg(test)]
@@ -379,7 +408,9 @@ pub(crate) async fn translate_json<P: Provider + Clone>(
 ) -> Result<AttachmentTranslation> {
     let value: serde_json::Value =
         serde_json::from_slice(bytes).with_context(|| "failed to parse json")?;
-    let mut cache = TranslationCache::new();
+    let mut cache = TranslationCache::collecting();
+    translate_json_value(value.clone(), &mut cache, translator, options).await?;
+    cache.flush(translator, options).await?;
     let translated = translate_json_value(value, &mut cache, translator, options).await?;
     let output =
         serde_json::to_string_pretty(&translated).with_context(|| "failed to write json")?;
@@ -434,8 +465,21 @@ pub(crate) async fn translate_yaml<P: Provider + Clone>(
     options: &TranslateOptions,
 ) -> Result<AttachmentTranslation> {
     let input = std::str::from_utf8(bytes).with_context(|| "failed to decode yaml as UTF-8")?;
+    let mut cache = TranslationCache::collecting();
+    rewrite_yaml(input, with_commentout, &mut cache, translator, options).await?;
+    cache.flush(translator, options).await?;
+    let output = rewrite_yaml(input, with_commentout, &mut cache, translator, options).await?;
+    Ok(cache.finish(data::YAML_MIME.to_string(), output.into_bytes()))
+}
+
+async fn rewrite_yaml<P: Provider + Clone>(
+    input: &str,
+    with_commentout: bool,
+    cache: &mut TranslationCache,
+    translator: &Translator<P>,
+    options: &TranslateOptions,
+) -> Result<String> {
     let lines: Vec<&str> = input.lines().collect();
-    let mut cache = TranslationCache::new();
     let mut out_lines = Vec::new();
     let mut idx = 0usize;
 
@@ -447,7 +491,7 @@ pub(crate) async fn translate_yaml<P: Provider + Clone>(
                 &prefix,
                 comment.as_deref(),
                 with_commentout,
-                &mut cache,
+                cache,
                 translator,
                 options,
             )
@@ -490,7 +534,7 @@ pub(crate) async fn translate_yaml<P: Provider + Clone>(
             if !block_lines.is_empty() {
                 let block_text = block_lines.join("\n");
                 let translated =
-                    translate_markdown_text(&block_text, &mut cache, translator, options).await?;
+                    translate_markdown_text(&block_text, cache, translator, options).await?;
                 for line in translated.split('\n') {
                     out_lines.push(format!("{:indent$}{}", "", line, indent = block_indent));
                 }
@@ -504,7 +548,7 @@ pub(crate) async fn translate_yaml<P: Provider + Clone>(
             &prefix,
             comment.as_deref(),
             with_commentout,
-            &mut cache,
+            cache,
             translator,
             options,
         )
@@ -513,8 +557,7 @@ pub(crate) async fn translate_yaml<P: Provider + Clone>(
         idx += 1;
     }
 
-    let output = out_lines.join("\n");
-    Ok(cache.finish(data::YAML_MIME.to_string(), output.into_bytes()))
+    Ok(out_lines.join("\n"))
 }
 
 async fn translate_yaml_line<P: Provider + Clone>(
@@ -831,7 +874,20 @@ pub(crate) async fn translate_po<P: Provider + Clone>(
     options: &TranslateOptions,
 ) -> Result<AttachmentTranslation> {
     let input = std::str::from_utf8(bytes).with_context(|| "failed to decode po as UTF-8")?;
-    let mut cache = TranslationCache::new();
+    let mut cache = TranslationCache::collecting();
+    rewrite_po(input, with_commentout, &mut cache, translator, options).await?;
+    cache.flush(translator, options).await?;
+    let output = rewrite_po(input, with_commentout, &mut cache, translator, options).await?;
+    Ok(cache.finish(data::PO_MIME.to_string(), output.into_bytes()))
+}
+
+async fn rewrite_po<P: Provider + Clone>(
+    input: &str,
+    with_commentout: bool,
+    cache: &mut TranslationCache,
+    translator: &Translator<P>,
+    options: &TranslateOptions,
+) -> Result<String> {
     let mut out_lines = Vec::new();
     let mut entry = Vec::new();
 
@@ -839,8 +895,7 @@ pub(crate) async fn translate_po<P: Provider + Clone>(
         if line.trim().is_empty() {
             if !entry.is_empty() {
                 let translated =
-                    translate_po_entry(&entry, with_commentout, &mut cache, translator, options)
-                        .await?;
+                    translate_po_entry(&entry, with_commentout, cache, translator, options).await?;
                 out_lines.extend(translated);
                 entry.clear();
             }
@@ -851,12 +906,11 @@ pub(crate) async fn translate_po<P: Provider + Clone>(
     }
     if !entry.is_empty() {
         let translated =
-            translate_po_entry(&entry, with_commentout, &mut cache, translator, options).await?;
+            translate_po_entry(&entry, with_commentout, cache, translator, options).await?;
         out_lines.extend(translated);
     }
 
-    let output = out_lines.join("\n");
-    Ok(cache.finish(data::PO_MIME.to_string(), output.into_bytes()))
+    Ok(out_lines.join("\n"))
 }
 
 async fn translate_po_entry<P: Provider + Clone>(
@@ -1,3 +1,8 @@
+use anyhow::{Context, Result};
+use quick_xml::Writer;
+use quick_xml::events::Event;
+use std::io::Write;
+
 pub(crate) fn collapse_whitespace(value: &str) -> String {
     let mut out = String::new();
     let mut last_space = false;
@@ -465,3 +470,34 @@ pub(crate) fn split_text_bounds(text: &str) -> Option<(usize, usize)> {
         _ => None,
     }
 }
+
+/// Where an XML rewrite sends its events. Collect passes use `discard`, so they only read
+/// the input and never serialize anything.
+pub(crate) struct XmlSink<W: Write> {
+    writer: Option<Writer<W>>,
+}
+
+impl<W: Write> XmlSink<W> {
+    pub(crate) fn new(inner: W) -> Self {
+        Self {
+            writer: Some(Writer::new(inner)),
+        }
+    }
+
+    pub(crate) fn discard() -> Self {
+        Self { writer: None }
+    }
+
+    pub(crate) fn write(&mut self, event: Event<'_>) -> Result<()> {
+        if let Some(writer) = self.writer.as_mut() {
+            writer
+                .write_event(event)
+                .with_context(|| "failed to write xml event")?;
+        }
+        Ok(())
+    }
+
+    pub(crate) fn into_inner(self) -> Option<W> {
+        self.writer.map(Writer::into_inner)
+    }
+}
@@ -0,0 +1,244 @@
+use anyhow::{Result, anyhow};
+use serde_json::{Value, json};
+use std::collections::HashMap;
+use std::path::{Path, PathBuf};
+use std::sync::Arc;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::Duration;
+
+use crate::attachments::TranslationCache;
+use crate::data::DataAttachment;
+use crate::languages::LanguageRegistry;
+use crate::ocr::{OcrLine, parse_hocr_lines, parse_tsv_lines};
+use crate::providers::{Provider, ProviderFuture, ProviderKind, ProviderResponse, ToolSpec};
+use crate::settings::Settings;
+use crate::{DirTranslateConfig, TranslateOptions, Translator};
+
+/// Provider that answers every call locally after a configurable delay.
+///
+/// Single requests come back as `tr:<input>` and batch requests with every item echoed the
+/// same way, so output depends only on input. The jitter sequence is seeded, not random, so
+/// two runs with the same settings see the same delays. Unit tests use it too, with
+/// `answering`, `skipping` and `failing` for the cases the echo does not cover.
+#[derive(Clone)]
+pub struct MockProvider {
+    latency: Duration,
+    jitter: Duration,
+    last_user_input: Option<String>,
+    calls: Arc<AtomicU64>,
+    answers: Arc<HashMap<String, Value>>,
+    skipped: Option<Arc<str>>,
+    failing: Option<Arc<str>>,
+}
+
+impl MockProvider {
+    pub fn new() -> Self {
+        Self::with_latency(Duration::ZERO, Duration::ZERO)
+    }
+
+    /// Each call sleeps `latency` plus up to `jitter` before answering.
+    pub fn with_latency(latency: Duration, jitter: Duration) -> Self {
+        Self {
+            latency,
+            jitter,
+            last_user_input: None,
+            calls: Arc::new(AtomicU64::new(0)),
+            answers: Arc::default(),
+            skipped: None,
+            failing: None,
+        }
+    }
+
+    /// Calls to `tool` answer with `args` instead of the echo.
+    pub fn answering(mut self, tool: &str, args: Value) -> Self {
+        Arc::make_mut(&mut self.answers).insert(tool.to_string(), args);
+        self
+    }
+
+    /// Batch answers leave out items whose text is `text`, like a model that dropped them.
+    pub fn skipping(mut self, text: &str) -> Self {
+        self.skipped = Some(Arc::from(text));
+        self
+    }
+
+    /// Calls whose user input contains `text` fail.
+    pub fn failing(mut self, text: &str) -> Self {
+        self.failing = Some(Arc::from(text));
+        self
+    }
+
+    /// Provider calls made through this mock and its clones.
+    pub fn calls(&self) -> u64 {
+        self.calls.load(Ordering::Relaxed)
+    }
+
+    fn delay(&self, call: u64) -> Duration {
+        if self.jitter.is_zero() {
+            return self.latency;
+        }
+        let fraction = (splitmix64(call) >> 11) as f64 / (1u64 << 53) as f64;
+        self.latency + self.jitter.mul_f64(fraction)
+    }
+}
+
+impl Default for MockProvider {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Provider for MockProvider {
+    fn append_system_input(self, _input: String) -> Self {
+        self
+    }
+
+    fn append_user_input(mut self, input: String) -> Self {
+        self.last_user_input = Some(input);
+        self
+    }
+
+    fn append_user_data(self, _data: DataAttachment) -> Self {
+        self
+    }
+
+    fn register_tool(self, _tool: ToolSpec) -> Self {
+        self
+    }
+
+    fn call_tool(self, tool_name: &str) -> ProviderFuture {
+        let call = self.calls.fetch_add(1, Ordering::Relaxed);
+        let delay = self.delay(call);
+        let input = self.last_user_input.unwrap_or_default();
+        if let Some(text) = self.failing.as_deref()
+            && input.contains(text)
+        {
+            let message = format!("mock failure for {}", text);
+            return Box::pin(async move { Err(anyhow!(message)) });
+        }
+        let args = match self.answers.get(tool_name) {
+            Some(args) => args.clone(),
+            None => echo(&input, self.skipped.as_deref()),
+        };
+        Box::pin(async move {
+            if !delay.is_zero() {
+                tokio::time::sleep(delay).await;
+            }
+            Ok(ProviderResponse {
+                args,
+                model: Some("mock".to_string()),
+                usage: None,
+            })
+        })
+    }
+}
+
+fn echo(input: &str, skipped: Option<&str>) -> Value {
+    let mut args = json!({
+        "translation": format!("tr:{}", input),
+        "source_language": "en",
+        "target_language": "ja",
+        "style": "formal",
+        "slang": false
+    });
+    if let Ok(batch) = serde_json::from_str::<Value>(input)
+        && let Some(items) = batch["items"].as_array()
+    {
+        let items = items
+            .iter()
+            .filter(|item| skipped.is_none_or(|text| item["text"] != text))
+            .map(|item| {
+                json!({
+                    "id": item["id"],
+                    "translated": format!("tr:{}", item["text"].as_str().unwrap_or(""))
+                })
+            })
+            .collect::<Vec<_>>();
+        args["translation"] = json!("");
+        args["items"] = json!(items);
+    }
+    args
+}
+
+fn splitmix64(seed: u64) -> u64 {
+    let mut value = seed.wrapping_add(0x9E37_79B9_7F4A_7C15);
+    value = (value ^ (value >> 30)).wrapping_mul(0xBF58_476D_1CE4_E5B9);
+    value = (value ^ (value >> 27)).wrapping_mul(0x94D0_49BB_1331_11EB);
+    value ^ (value >> 31)
+}
+
+/// Translator over `provider` with default settings, translation memory off.
+pub fn mock_translator(provider: MockProvider) -> Result<Translator<MockProvider>> {
+    let mut settings = Settings::default();
+    settings
+        .formally
+        .insert("formal".to_string(), "Use formal style.".to_string());
+    settings.translation_memory_enabled = false;
+    Ok(Translator::new(
+        provider,
+        settings,
+        LanguageRegistry::load()?,
+    ))
+}
+
+pub fn options() -> TranslateOptions {
+    TranslateOptions {
+        lang: "ja".to_string(),
+        formality: "formal".to_string(),
+        source_lang: "en".to_string(),
+        slang: false,
+    }
+}
+
+/// One collect, flush and replay cycle of the attachment translation cache over `texts`,
+/// the way the document walkers drive it. Returns the number of strings served.
+pub async fn translation_cache_round<P: Provider + Clone>(
+    texts: &[String],
+    translator: &Translator<P>,
+    options: &TranslateOptions,
+) -> Result<usize> {
+    let mut cache = TranslationCache::collecting();
+    for text in texts {
+        cache.translate(text, translator, options).await?;
+    }
+    cache.flush(translator, options).await?;
+    for text in texts {
+        cache.translate(text, translator, options).await?;
+    }
+    Ok(texts.len())
+}
+
+pub fn parse_hocr(hocr: &str) -> Result<Vec<OcrLine>> {
+    parse_hocr_lines(hocr)
+}
+
+pub fn parse_tsv(tsv: &str) -> Result<Vec<OcrLine>> {
+    parse_tsv_lines(tsv)
+}
+
+/// Translates `src_dir` into `out_dir` the way `--data <dir> --out <dir>` does, with
+/// `threads` files in flight.
+pub async fn translate_directory<P: Provider + Clone>(
+    src_dir: &Path,
+    out_dir: PathBuf,
+    threads: usize,
+    translator: &Translator<P>,
+) -> Result<String> {
+    let config = DirTranslateConfig {
+        mime_hint: None,
+        ocr_languages: "eng".to_string(),
+        options: options(),
+        with_commentout: false,
+        debug_ocr: false,
+        overwrite: false,
+        force_translation: false,
+        translated_suffix: "_translated".to_string(),
+        backup_ttl_days: 0,
+        provider: ProviderKind::OpenAI,
+        history_model: "mock".to_string(),
+        history_limit: translator.settings().history_limit,
+        directory_threads: threads,
+        ignore: None,
+        output_dir: Some(out_dir),
+    };
+    crate::translate_data_dir(src_dir, translator, config).await
+}
@@ -1,13 +1,13 @@
 use anyhow::{Context, Result, anyhow};
 use serde::{Deserialize, Serialize};
 use serde_json::json;
-use tera::{Context as TeraContext, Tera};
+use tera::Context as TeraContext;
 
 use crate::Translator;
 use crate::languages::LanguageRegistry;
 use crate::providers::{Provider, ProviderUsage, ToolSpec};
 use crate::settings::Settings;
-use crate::translations::TranslateOptions;
+use crate::translations::{self, TranslateOptions};
 
 const TOOL_NAME: &str = "correct_text";
 
@@ -99,11 +99,11 @@ fn tool_spec(tool_name: &str) -> ToolSpec {
 }
 
 fn render_system_prompt(options: &TranslateOptions, _settings: &Settings) -> Result<String> {
-    let template = load_prompt_template("correction_prompt.tera")?;
     let mut context = TeraContext::new();
     context.insert("source_lang", options.source_lang.as_str());
     context.insert("tool_name", TOOL_NAME);
-    Tera::one_off(&template, &context, false).with_context(|| "failed to render correction prompt")
+    translations::render_prompt("correction_prompt.tera", &context)
+        .with_context(|| "failed to render correction prompt")
 }
 
 fn parse_tool_args(
@@ -176,21 +176,6 @@ fn validate_tool_args(
     Ok(())
 }
 
-fn load_prompt_template(name: &str) -> Result<String> {
-    let path = prompt_path(name)?;
-    std::fs::read_to_string(&path)
-        .with_context(|| format!("failed to read prompt: {}", path.display()))
-}
-
-fn prompt_path(name: &str) -> Result<std::path::PathBuf> {
-    let base = std::path::PathBuf::from(env!("CARGO_MANIFEST_DIR"))
-        .join("src")
-        .join("translations")
-        .join("prompts")
-        .join(name);
-    Ok(base)
-}
-
 fn normalize_lang_code(code: &str) -> String {
     code.trim().to_lowercase()
 }
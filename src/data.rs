@@ -1,4 +1,5 @@
 use anyhow::{Context, Result, anyhow};
+use std::io::Read;
 use std::path::{Path, PathBuf};
 
 pub const DOCX_MIME: &str =
@@ -26,6 +27,9 @@ pub const FLAC_MIME: &str = "audio/flac";
 pub const OGG_MIME: &str = "audio/ogg";
 pub const OCTET_STREAM_MIME: &str = "application/octet-stream";
 
+/// Bytes read from the start of a file when only its mime is needed.
+const SNIFF_LEN: u64 = 8 * 1024;
+
 #[derive(Debug, Clone)]
 pub struct DataAttachment {
     pub bytes: Vec<u8>,
@@ -59,13 +63,32 @@ pub fn load_attachment(path: &Path, mime_hint: Option<&str>) -> Result<DataAttac
     Ok(DataAttachment { bytes, mime, name })
 }
 
+/// Resolves the mime of a file from its first few KB and its extension, without loading it.
+pub fn resolve_file_mime(path: &Path, mime_hint: Option<&str>) -> Result<String> {
+    let mut head = Vec::with_capacity(SNIFF_LEN as usize);
+    std::fs::File::open(path)
+        .and_then(|file| file.take(SNIFF_LEN).read_to_end(&mut head))
+        .with_context(|| format!("failed to read data file: {}", path.display()))?;
+    resolve_mime(mime_hint.unwrap_or("auto"), &head, Some(path))
+}
+
+/// Loads a file whose mime was already resolved, e.g. by `resolve_file_mime`.
+pub fn load_attachment_with_mime(path: &Path, mime: String) -> Result<DataAttachment> {
+    let bytes = std::fs::read(path)
+        .with_context(|| format!("failed to read data file: {}", path.display()))?;
+    let name = path
+        .file_name()
+        .and_then(|value| value.to_str())
+        .map(|value| value.to_string());
+    Ok(DataAttachment { bytes, mime, name })
+}
+
 pub fn load_attachment_from_bytes(
     bytes: Vec<u8>,
     mime_hint: Option<&str>,
     name: Option<&str>,
 ) -> Result<DataAttachment> {
-    let path = name.map(PathBuf::from);
-    let mime = resolve_mime(mime_hint.unwrap_or("auto"), &bytes, path.as_deref())?;
+    let mime = resolve_mime_for_bytes(&bytes, mime_hint, name)?;
     Ok(DataAttachment {
         bytes,
         mime,
@@ -73,6 +96,16 @@ pub fn load_attachment_from_bytes(
     })
 }
 
+/// Resolves the mime of in-memory data without taking ownership of it.
+pub fn resolve_mime_for_bytes(
+    bytes: &[u8],
+    mime_hint: Option<&str>,
+    name: Option<&str>,
+) -> Result<String> {
+    let path = name.map(PathBuf::from);
+    resolve_mime(mime_hint.unwrap_or("auto"), bytes, path.as_deref())
+}
+
 pub fn sniff_mime(bytes: &[u8]) -> Option<String> {
     sniff_mime_bytes(bytes).map(|value| value.to_string())
 }
@@ -457,6 +490,15 @@ mod tests {
         assert_eq!(mime, "image/png");
     }
 
+    #[test]
+    fn resolve_mime_for_bytes_uses_name_and_sniffing() {
+        let mime = resolve_mime_for_bytes(b"<root>hello</root>", None, Some("sample.xml"))
+            .expect("resolve named xml");
+        assert_eq!(mime, XML_MIME);
+        let mime = resolve_mime_for_bytes(&png_bytes(), Some("auto"), None).expect("sniff png");
+        assert_eq!(mime, "image/png");
+    }
+
     #[test]
     fn extension_for_xml_mime() {
         assert_eq!(extension_from_mime(XML_MIME), Some("xml"));
@@ -1,14 +1,12 @@
 use anyhow::{Context, Result, anyhow};
 use serde::{Deserialize, Serialize};
 use serde_json::{Value, json};
-use std::fs;
-use std::path::PathBuf;
-use tera::{Context as TeraContext, Tera};
+use tera::Context as TeraContext;
 
 use crate::languages::{self, LanguageRegistry};
 use crate::providers::ToolSpec;
 use crate::settings::Settings;
-use crate::translations::TranslateOptions;
+use crate::translations::{self, TranslateOptions};
 use crate::translator::{ExecutionOutput, Translator};
 
 pub const TOOL_NAME: &str = "deliver_dictionary_entry";
@@ -158,16 +156,44 @@ pub fn tool_spec(tool_name: &str) -> ToolSpec {
     }
 }
 
+/// Looks up `input` as a dictionary entry. Entries are cached per model, language pair,
+/// style and POS filter, so repeated lookups of the same word skip the provider.
 pub async fn exec_pos<P: crate::providers::Provider + Clone>(
     translator: &Translator<P>,
     input: &str,
     options: &TranslateOptions,
     pos_filter: Option<&[String]>,
 ) -> Result<ExecutionOutput> {
-    let tool = tool_spec(TOOL_NAME);
+    let filter_key = pos_filter.map(|items| items.join(",")).unwrap_or_default();
     let prompt_filter = resolve_pos_filter(pos_filter, &options.source_lang);
     let system_prompt =
         render_system_prompt(options, translator.settings(), prompt_filter.as_deref())?;
+    let cache_key = translator.result_key(
+        "pos",
+        &system_prompt,
+        &format!("{}\u{0}{}", filter_key, input.trim()),
+        options,
+    );
+    if let Some(key) = cache_key.as_deref()
+        && let Some(hit) = translator.cached_result(key).await
+    {
+        return Ok(hit);
+    }
+    let output = lookup_pos(translator, input, options, pos_filter, system_prompt).await?;
+    if let Some(key) = cache_key.as_deref() {
+        translator.store_result(key, &output);
+    }
+    Ok(output)
+}
+
+async fn lookup_pos<P: crate::providers::Provider + Clone>(
+    translator: &Translator<P>,
+    input: &str,
+    options: &TranslateOptions,
+    pos_filter: Option<&[String]>,
+    system_prompt: String,
+) -> Result<ExecutionOutput> {
+    let tool = tool_spec(TOOL_NAME);
     let response = translator
         .call_tool_with_data(tool, system_prompt, input.to_string(), None)
         .await?;
@@ -197,20 +223,16 @@ pub async fn exec_pos<P: crate::providers::Provider + Clone>(
     if should_discard_labels(&parsed) {
         parsed.labels = Labels::default();
     }
-    if should_fix_attributes(&parsed)
-        && let Some(fixed) = translate_attributes_to_source(translator, &parsed, options).await?
-    {
-        parsed.attributes = fixed;
-    }
-    if should_fix_usage(&parsed)
-        && let Some(fixed) = translate_usage_to_source(translator, &parsed, options).await?
-    {
-        parsed.usage = fixed;
-    }
-    if should_fix_example_sources(&parsed) {
-        translate_example_sources(translator, &mut parsed, options).await?;
-    }
-    fill_missing_readings(translator, &mut parsed).await?;
+    // Source-language fix-ups and missing readings are independent follow-up calls; run
+    // them side by side instead of one after another.
+    let mut with_readings = parsed.clone();
+    let (fixes, ()) = tokio::try_join!(
+        translate_fixes_to_source(translator, &parsed, options),
+        fill_missing_readings(translator, &mut with_readings),
+    )?;
+    parsed.translation_reading = with_readings.translation_reading;
+    parsed.alternatives = with_readings.alternatives;
+    fixes.apply(&mut parsed);
     if filtered {
         parsed.attributes.retain(|value| !value.trim().is_empty());
     }
@@ -227,7 +249,6 @@ pub fn render_system_prompt(
     settings: &Settings,
     pos_filter: Option<&[String]>,
 ) -> Result<String> {
-    let template = load_prompt_template("pos_prompt.tera")?;
     let mut context = TeraContext::new();
     context.insert("source_lang", options.source_lang.as_str());
     context.insert("target_lang", options.lang.as_str());
@@ -237,7 +258,8 @@ pub fn render_system_prompt(
         context.insert("allowed_pos", filter);
     }
 
-    Tera::one_off(&template, &context, false).with_context(|| "failed to render pos prompt")
+    translations::render_prompt("pos_prompt.tera", &context)
+        .with_context(|| "failed to render pos prompt")
 }
 
 pub fn parse_tool_args(
@@ -640,23 +662,6 @@ fn should_fix_usage(result: &DictionaryResult) -> bool {
     matches!(source.as_str(), "en" | "eng") && contains_non_latin(&result.usage)
 }
 
-async fn translate_usage_to_source<P: crate::providers::Provider + Clone>(
-    translator: &Translator<P>,
-    result: &DictionaryResult,
-    options: &TranslateOptions,
-) -> Result<Option<String>> {
-    let mut translate_options = options.clone();
-    translate_options.lang = result.source_language.clone();
-    translate_options.source_lang = result.target_language.clone();
-    let output = translator.exec(&result.usage, translate_options).await?;
-    let trimmed = output.text.trim().to_string();
-    if trimmed.is_empty() {
-        Ok(None)
-    } else {
-        Ok(Some(trimmed))
-    }
-}
-
 fn should_fix_example_sources(result: &DictionaryResult) -> bool {
     let source = normalize_lang_code(&result.source_language);
     if !matches!(source.as_str(), "en" | "eng") {
@@ -668,28 +673,89 @@ fn should_fix_example_sources(result: &DictionaryResult) -> bool {
         .any(|example| contains_non_latin(example.source.trim()))
 }
 
-async fn translate_example_sources<P: crate::providers::Provider + Clone>(
+/// Dictionary fields written in the target language where the source language was
+/// expected, translated back in one batch.
+#[derive(Debug, Default)]
+struct SourceFixes {
+    attributes: Option<Vec<String>>,
+    usage: Option<String>,
+    examples: Vec<(usize, String)>,
+}
+
+impl SourceFixes {
+    fn apply(self, result: &mut DictionaryResult) {
+        if let Some(attributes) = self.attributes {
+            result.attributes = attributes;
+        }
+        if let Some(usage) = self.usage {
+            result.usage = usage;
+        }
+        for (index, source) in self.examples {
+            result.examples[index].source = source;
+        }
+    }
+}
+
+async fn translate_fixes_to_source<P: crate::providers::Provider + Clone>(
     translator: &Translator<P>,
-    result: &mut DictionaryResult,
+    result: &DictionaryResult,
     options: &TranslateOptions,
-) -> Result<()> {
+) -> Result<SourceFixes> {
+    let mut inputs: Vec<String> = Vec::new();
+    let attributes = if should_fix_attributes(result) {
+        inputs.extend(result.attributes.iter().cloned());
+        0..inputs.len()
+    } else {
+        0..0
+    };
+    let usage = should_fix_usage(result).then(|| {
+        inputs.push(result.usage.clone());
+        inputs.len() - 1
+    });
+    let mut examples = Vec::new();
+    if should_fix_example_sources(result) {
+        for (index, example) in result.examples.iter().enumerate() {
+            let source = example.source.trim();
+            if !source.is_empty() && contains_non_latin(source) {
+                examples.push((index, inputs.len()));
+                inputs.push(example.source.clone());
+            }
+        }
+    }
+    let mut fixes = SourceFixes::default();
+    if inputs.is_empty() {
+        return Ok(fixes);
+    }
+
     let mut translate_options = options.clone();
     translate_options.lang = result.source_language.clone();
     translate_options.source_lang = result.target_language.clone();
+    let output = translator.exec_batch(&inputs, translate_options).await?;
+    let mut fixed = Vec::with_capacity(output.items.len());
+    for item in output.items {
+        fixed.push(item.map_err(|err| anyhow!(err))?.trim().to_string());
+    }
 
-    for example in &mut result.examples {
-        if example.source.trim().is_empty() || !contains_non_latin(example.source.trim()) {
-            continue;
+    if !attributes.is_empty() {
+        let values = fixed[attributes]
+            .iter()
+            .flat_map(|value| split_attributes(value))
+            .collect::<Vec<_>>();
+        if !values.is_empty() {
+            fixes.attributes = Some(values);
         }
-        let output = translator
-            .exec(&example.source, translate_options.clone())
-            .await?;
-        let fixed = output.text.trim();
-        if !fixed.is_empty() {
-            example.source = fixed.to_string();
+    }
+    if let Some(index) = usage
+        && !fixed[index].is_empty()
+    {
+        fixes.usage = Some(fixed[index].clone());
+    }
+    for (example, index) in examples {
+        if !fixed[index].is_empty() {
+            fixes.examples.push((example, fixed[index].clone()));
         }
     }
-    Ok(())
+    Ok(fixes)
 }
 
 async fn fill_missing_readings<P: crate::providers::Provider + Clone>(
@@ -966,28 +1032,6 @@ fn should_fix_attributes(result: &DictionaryResult) -> bool {
         .any(|value| contains_non_latin(value))
 }
 
-async fn translate_attributes_to_source<P: crate::providers::Provider + Clone>(
-    translator: &Translator<P>,
-    result: &DictionaryResult,
-    options: &TranslateOptions,
-) -> Result<Option<Vec<String>>> {
-    if result.attributes.is_empty() {
-        return Ok(None);
-    }
-    let joined = result.attributes.join(", ");
-    let mut translate_options = options.clone();
-    translate_options.lang = result.source_language.clone();
-    translate_options.source_lang = result.target_language.clone();
-
-    let output = translator.exec(&joined, translate_options).await?;
-    let values = split_attributes(&output.text);
-    if values.is_empty() {
-        Ok(None)
-    } else {
-        Ok(Some(values))
-    }
-}
-
 fn split_attributes(value: &str) -> Vec<String> {
     value
         .split([',', '、', ';', '\n'])
@@ -1059,20 +1103,6 @@ fn contains_non_latin(value: &str) -> bool {
     })
 }
 
-fn load_prompt_template(name: &str) -> Result<String> {
-    let path = prompt_path(name)?;
-    fs::read_to_string(&path).with_context(|| format!("failed to read prompt: {}", path.display()))
-}
-
-fn prompt_path(name: &str) -> Result<PathBuf> {
-    let base = PathBuf::from(env!("CARGO_MANIFEST_DIR"))
-        .join("src")
-        .join("translations")
-        .join("prompts")
-        .join(name);
-    Ok(base)
-}
-
 fn normalize_lang_code(code: &str) -> String {
     code.trim().to_lowercase()
 }
@@ -1111,3 +1141,72 @@ fn split_lang_suffix(code: &str) -> Option<(String, String)> {
     }
     Some((base.to_lowercase(), suffix.to_lowercase()))
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::bench_support::{MockProvider, mock_translator, options};
+
+    #[tokio::test]
+    async fn follow_ups_share_one_batch_and_entries_are_cached() {
+        // Follow-up batches (attributes, usage, example sources) get the mock's echo.
+        let provider = MockProvider::new()
+            .answering(
+                TOOL_NAME,
+                json!({
+                    "translation": "猫",
+                    "translation_reading": "",
+                    "part_of_speech": "noun",
+                    "attributes": ["可算"],
+                    "alternatives": [],
+                    "inflections": {
+                        "plural": "cats",
+                        "third_person_singular": "-",
+                        "past_tense": "-",
+                        "present_participle": "-"
+                    },
+                    "usage": "動物を指す",
+                    "examples": [{"target": "猫がいる", "source": "猫がいる"}],
+                    "labels": null,
+                    "source_language": "en",
+                    "target_language": "ja"
+                }),
+            )
+            .answering(
+                READING_TOOL_NAME,
+                json!({"items": [{"id": 0, "reading": "neko"}]}),
+            );
+        let translator = mock_translator(provider.clone())
+            .expect("translator")
+            .with_memory("dictionary-test");
+        let options = options();
+
+        let output = exec_pos(&translator, "cat", &options, None)
+            .await
+            .expect("lookup");
+        // Entry, one batch for attributes/usage/example sources, and the readings.
+        assert_eq!(provider.calls(), 3);
+        assert!(output.text.contains("Reading: neko"), "{}", output.text);
+        assert!(
+            output.text.contains("Attributes: tr:可算"),
+            "{}",
+            output.text
+        );
+        assert!(
+            output.text.contains("Usage: tr:動物を指す"),
+            "{}",
+            output.text
+        );
+        assert!(
+            output.text.contains("- 猫がいる (tr:猫がいる)"),
+            "{}",
+            output.text
+        );
+
+        let cached = exec_pos(&translator, "cat", &options, None)
+            .await
+            .expect("cached lookup");
+        assert_eq!(provider.calls(), 3);
+        assert_eq!(cached.text, output.text);
+    }
+}
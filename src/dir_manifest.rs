@@ -0,0 +1,307 @@
+use anyhow::{Context, Result};
+use serde::{Deserialize, Serialize};
+use std::collections::{HashMap, HashSet};
+use std::fs::{self, File, OpenOptions};
+use std::io::{BufRead, BufReader, Read, Write};
+use std::path::{Path, PathBuf};
+use std::sync::Mutex;
+use std::time::UNIX_EPOCH;
+use tracing::warn;
+
+use crate::util::lock;
+
+/// Written to the output directory (or the source directory with `--overwrite`).
+pub(crate) const MANIFEST_FILE_NAME: &str = ".llm-translator-rust-manifest.jsonl";
+
+/// One finished file. `path` is relative to the source directory and `dest` to the output
+/// root; `dest` is `None` when nothing was written (skipped in place).
+#[derive(Debug, Clone, Serialize, Deserialize, PartialEq, Eq)]
+struct ManifestEntry {
+    path: String,
+    size: u64,
+    mtime_ns: u64,
+    source: String,
+    options: String,
+    #[serde(default)]
+    dest: Option<String>,
+    #[serde(default)]
+    output: Option<String>,
+    #[serde(default)]
+    output_size: Option<u64>,
+}
+
+#[derive(Debug, Clone)]
+struct Fingerprint {
+    size: u64,
+    mtime_ns: u64,
+    source: String,
+}
+
+/// Records which files of a directory translation are done, so re-runs only translate new
+/// or changed files.
+///
+/// The manifest is an append-only JSON lines log: every finished file appends one line and
+/// the latest line per path wins, so an interrupted run resumes where it stopped. A file
+/// whose size and mtime match its entry is skipped after a single `stat`; otherwise its
+/// content hash is compared. `finish` rewrites the log without stale lines.
+pub(crate) struct DirManifest {
+    path: PathBuf,
+    src_root: PathBuf,
+    output_root: PathBuf,
+    options: String,
+    entries: Mutex<HashMap<String, ManifestEntry>>,
+    pending: Mutex<HashMap<String, Fingerprint>>,
+    log: Mutex<File>,
+}
+
+impl DirManifest {
+    pub(crate) fn open(src_root: &Path, output_root: &Path, options: String) -> Result<Self> {
+        let path = output_root.join(MANIFEST_FILE_NAME);
+        let entries = read_entries(&path)?;
+        let log = OpenOptions::new()
+            .create(true)
+            .append(true)
+            .open(&path)
+            .with_context(|| format!("failed to open manifest: {}", path.display()))?;
+        Ok(Self {
+            path,
+            src_root: src_root.to_path_buf(),
+            output_root: output_root.to_path_buf(),
+            options,
+            entries: Mutex::new(entries),
+            pending: Mutex::new(HashMap::new()),
+            log: Mutex::new(log),
+        })
+    }
+
+    pub(crate) fn manifest_path(&self) -> &Path {
+        &self.path
+    }
+
+    /// Returns true when `source` was already handled with the same options and its output
+    /// is still in place. Otherwise the file's fingerprint is kept for `record`.
+    pub(crate) fn is_unchanged(&self, source: &Path) -> bool {
+        let key = self.key(source);
+        let Ok((size, mtime_ns)) = stat(source) else {
+            return false;
+        };
+        let entry = lock(&self.entries).get(&key).cloned();
+        if let Some(entry) = entry.as_ref()
+            && entry.options == self.options
+            && entry.size == size
+            && entry.mtime_ns == mtime_ns
+            && self.output_in_place(entry)
+        {
+            return true;
+        }
+
+        let Ok(hash) = hash_file(source) else {
+            return false;
+        };
+        let fingerprint = Fingerprint {
+            size,
+            mtime_ns,
+            source: hash,
+        };
+        if let Some(mut entry) = entry
+            && entry.options == self.options
+            && entry.source == fingerprint.source
+            && self.output_in_place(&entry)
+        {
+            // Touched but not edited: re-stamp so the next run only needs the stat.
+            entry.size = size;
+            entry.mtime_ns = mtime_ns;
+            self.append(entry);
+            return true;
+        }
+        lock(&self.pending).insert(key, fingerprint);
+        false
+    }
+
+    /// Marks `source` as done. `dest` is where its output went and `output` the bytes
+    /// written there; `None` means the source itself was copied.
+    pub(crate) fn record(&self, source: &Path, dest: Option<&Path>, output: Option<&[u8]>) {
+        let key = self.key(source);
+        let Some(mut fingerprint) = lock(&self.pending).remove(&key) else {
+            return;
+        };
+        let (output_hash, output_size) = match output {
+            Some(bytes) => (
+                format!("{:x}", md5::compute(bytes)),
+                Some(bytes.len() as u64),
+            ),
+            None => (fingerprint.source.clone(), Some(fingerprint.size)),
+        };
+        if dest == Some(source) {
+            // Translated in place: the file on disk is now the output.
+            if let Ok((size, mtime_ns)) = stat(source) {
+                fingerprint.size = size;
+                fingerprint.mtime_ns = mtime_ns;
+            }
+            fingerprint.source = output_hash.clone();
+        }
+        let dest = dest.map(|path| relative_key(&self.output_root, path));
+        self.append(ManifestEntry {
+            path: key,
+            size: fingerprint.size,
+            mtime_ns: fingerprint.mtime_ns,
+            source: fingerprint.source,
+            options: self.options.clone(),
+            output: dest.as_ref().map(|_| output_hash),
+            output_size: dest.as_ref().and(output_size),
+            dest,
+        });
+    }
+
+    /// Rewrites the log with one line per file still present in `sources`.
+    pub(crate) fn finish(&self, sources: &[PathBuf]) -> Result<()> {
+        let live: HashSet<String> = sources.iter().map(|path| self.key(path)).collect();
+        let entries = lock(&self.entries);
+        let mut keys: Vec<&String> = entries.keys().filter(|key| live.contains(*key)).collect();
+        keys.sort();
+        let mut content = String::new();
+        for key in keys {
+            content.push_str(&serde_json::to_string(&entries[key])?);
+            content.push('\n');
+        }
+        let tmp = self.path.with_extension("jsonl.tmp");
+        fs::write(&tmp, content)
+            .with_context(|| format!("failed to write manifest: {}", tmp.display()))?;
+        let mut log = lock(&self.log);
+        fs::rename(&tmp, &self.path)
+            .with_context(|| format!("failed to replace manifest: {}", self.path.display()))?;
+        *log = OpenOptions::new()
+            .append(true)
+            .open(&self.path)
+            .with_context(|| format!("failed to open manifest: {}", self.path.display()))?;
+        Ok(())
+    }
+
+    fn output_in_place(&self, entry: &ManifestEntry) -> bool {
+        let Some(dest) = entry.dest.as_ref() else {
+            return true;
+        };
+        match fs::metadata(self.output_root.join(dest)) {
+            Ok(metadata) => entry.output_size.is_none_or(|size| size == metadata.len()),
+            Err(_) => false,
+        }
+    }
+
+    fn append(&self, entry: ManifestEntry) {
+        let line = match serde_json::to_string(&entry) {
+            Ok(line) => line + "\n",
+            Err(err) => {
+                warn!("failed to encode manifest entry: {}", err);
+                return;
+            }
+        };
+        if let Err(err) = lock(&self.log).write_all(line.as_bytes()) {
+            warn!(
+                "failed to append to manifest {}: {}",
+                self.path.display(),
+                err
+            );
+        }
+        lock(&self.entries).insert(entry.path.clone(), entry);
+    }
+
+    fn key(&self, source: &Path) -> String {
+        relative_key(&self.src_root, source)
+    }
+}
+
+fn read_entries(path: &Path) -> Result<HashMap<String, ManifestEntry>> {
+    let mut entries = HashMap::new();
+    let file = match File::open(path) {
+        Ok(file) => file,
+        Err(err) if err.kind() == std::io::ErrorKind::NotFound => return Ok(entries),
+        Err(err) => {
+            return Err(err)
+                .with_context(|| format!("failed to read manifest: {}", path.display()));
+        }
+    };
+    for line in BufReader::new(file).lines() {
+        let line = line.with_context(|| format!("failed to read manifest: {}", path.display()))?;
+        // A crash can leave a torn last line; it is simply redone.
+        if let Ok(entry) = serde_json::from_str::<ManifestEntry>(&line) {
+            entries.insert(entry.path.clone(), entry);
+        }
+    }
+    Ok(entries)
+}
+
+fn relative_key(root: &Path, path: &Path) -> String {
+    let relative = path.strip_prefix(root).unwrap_or(path);
+    relative
+        .components()
+        .map(|part| part.as_os_str().to_string_lossy())
+        .collect::<Vec<_>>()
+        .join("/")
+}
+
+fn stat(path: &Path) -> std::io::Result<(u64, u64)> {
+    let metadata = fs::metadata(path)?;
+    let mtime_ns = metadata
+        .modified()?
+        .duration_since(UNIX_EPOCH)
+        .map(|value| value.as_nanos() as u64)
+        .unwrap_or(0);
+    Ok((metadata.len(), mtime_ns))
+}
+
+fn hash_file(path: &Path) -> std::io::Result<String> {
+    let mut file = File::open(path)?;
+    let mut context = md5::Context::new();
+    let mut buf = vec![0u8; 64 * 1024];
+    loop {
+        let read = file.read(&mut buf)?;
+        if read == 0 {
+            break;
+        }
+        context.consume(&buf[..read]);
+    }
+    Ok(format!("{:x}", context.compute()))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tempfile::tempdir;
+
+    #[test]
+    fn skips_unchanged_files_and_resumes_from_the_log() {
+        let dir = tempdir().expect("tempdir");
+        let src = dir.path().join("src");
+        let out = dir.path().join("out");
+        fs::create_dir_all(src.join("docs")).expect("src");
+        fs::create_dir_all(out.join("docs")).expect("out");
+        let a = src.join("docs/a.md");
+        let b = src.join("b.txt");
+        fs::write(&a, "hello").expect("a");
+        fs::write(&b, "world").expect("b");
+
+        let manifest = DirManifest::open(&src, &out, "opts".to_string()).expect("open");
+        assert!(!manifest.is_unchanged(&a));
+        assert!(!manifest.is_unchanged(&b));
+        fs::write(out.join("docs/a.md"), "hola").expect("out a");
+        manifest.record(&a, Some(&out.join("docs/a.md")), Some(b"hola"));
+        drop(manifest);
+
+        // b never finished; a is done and is skipped after a restart.
+        let manifest = DirManifest::open(&src, &out, "opts".to_string()).expect("reopen");
+        assert!(manifest.is_unchanged(&a));
+        assert!(!manifest.is_unchanged(&b));
+        manifest.finish(&[a.clone(), b.clone()]).expect("finish");
+
+        let other = DirManifest::open(&src, &out, "other".to_string()).expect("options");
+        assert!(!other.is_unchanged(&a));
+
+        fs::write(&a, "hello!").expect("edit");
+        let manifest = DirManifest::open(&src, &out, "opts".to_string()).expect("edited");
+        assert!(!manifest.is_unchanged(&a));
+
+        fs::write(&a, "hello").expect("revert");
+        fs::remove_file(out.join("docs/a.md")).expect("remove output");
+        assert!(!manifest.is_unchanged(&a));
+    }
+}
@@ -0,0 +1,229 @@
+use anyhow::{Context, Result};
+use futures_util::future;
+use futures_util::stream::{self, BoxStream, StreamExt};
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::sync::Arc;
+
+use crate::translation_ignore::TranslationIgnore;
+
+/// Sibling directories listed ahead of the consumer on the blocking pool.
+const LIST_CONCURRENCY: usize = 8;
+
+pub(crate) struct WalkedFile {
+    pub(crate) path: PathBuf,
+    /// Matched by the translation ignore rules; decided during the walk, before any file I/O.
+    pub(crate) ignored: bool,
+}
+
+enum Entry {
+    File(WalkedFile),
+    Dir(PathBuf),
+}
+
+enum Listed {
+    File(WalkedFile),
+    Dir(Vec<Entry>),
+}
+
+struct Walker {
+    root: PathBuf,
+    ignore: Option<TranslationIgnore>,
+    /// Paths relative to `root` that are skipped with everything below them.
+    excluded: Vec<PathBuf>,
+}
+
+/// Streams the regular files under `root` in sorted path order (the order a sorted list of
+/// every file would have) while the tree is still being listed, so callers can start work
+/// on the first files right away. Sibling directories are listed ahead concurrently.
+///
+/// `exclude` names paths the walk must not return, such as an output directory or manifest
+/// inside `root`; paths outside `root` are ignored. `root` itself is listed before
+/// returning, so a missing or unreadable root is an error here; a subdirectory that fails
+/// to list yields one error item and ends the stream.
+pub(crate) fn walk_files(
+    root: &Path,
+    ignore: Option<TranslationIgnore>,
+    exclude: &[&Path],
+) -> Result<BoxStream<'static, Result<WalkedFile>>> {
+    let excluded = match fs::canonicalize(root) {
+        Ok(canonical_root) => exclude
+            .iter()
+            .filter_map(|path| relative_to(&canonical_root, path))
+            .collect(),
+        Err(_) => Vec::new(),
+    };
+    let walker = Arc::new(Walker {
+        root: root.to_path_buf(),
+        ignore,
+        excluded,
+    });
+    let first = walker.list(root)?;
+    Ok(walk_entries(first, walker)
+        .scan(false, |failed, item| {
+            if *failed {
+                return future::ready(None);
+            }
+            *failed = item.is_err();
+            future::ready(Some(item))
+        })
+        .boxed())
+}
+
+fn walk_entries(
+    entries: Vec<Entry>,
+    walker: Arc<Walker>,
+) -> BoxStream<'static, Result<WalkedFile>> {
+    let lister = walker.clone();
+    stream::iter(entries)
+        .map(move |entry| {
+            let walker = lister.clone();
+            async move {
+                match entry {
+                    Entry::File(file) => Ok(Listed::File(file)),
+                    Entry::Dir(dir) => tokio::task::spawn_blocking(move || walker.list(&dir))
+                        .await
+                        .map_err(|err| anyhow::Error::from(err).context("directory walk failed"))?
+                        .map(Listed::Dir),
+                }
+            }
+        })
+        .buffered(LIST_CONCURRENCY)
+        .flat_map(move |listed| match listed {
+            Ok(Listed::File(file)) => stream::once(future::ready(Ok(file))).boxed(),
+            Ok(Listed::Dir(entries)) => walk_entries(entries, walker.clone()),
+            Err(err) => stream::once(future::ready(Err(err))).boxed(),
+        })
+        .boxed()
+}
+
+impl Walker {
+    /// Lists `dir` sorted by name, which keeps the walk in path order.
+    fn list(&self, dir: &Path) -> Result<Vec<Entry>> {
+        let mut listing = Vec::new();
+        let entries = fs::read_dir(dir)
+            .with_context(|| format!("failed to read directory: {}", dir.display()))?;
+        for entry in entries {
+            let entry = entry.with_context(|| "failed to read directory entry")?;
+            let path = entry.path();
+            if self.is_excluded(&path) {
+                continue;
+            }
+            let file_type = entry
+                .file_type()
+                .with_context(|| "failed to read file type")?;
+            if file_type.is_dir() {
+                listing.push(Entry::Dir(path));
+            } else if file_type.is_file() {
+                let ignored = self
+                    .ignore
+                    .as_ref()
+                    .is_some_and(|ignore| ignore.is_ignored(&path));
+                listing.push(Entry::File(WalkedFile { path, ignored }));
+            }
+        }
+        listing.sort_by(|a, b| a.path().file_name().cmp(&b.path().file_name()));
+        Ok(listing)
+    }
+
+    fn is_excluded(&self, path: &Path) -> bool {
+        !self.excluded.is_empty()
+            && path
+                .strip_prefix(&self.root)
+                .is_ok_and(|rel| self.excluded.iter().any(|excluded| excluded == rel))
+    }
+}
+
+impl Entry {
+    fn path(&self) -> &Path {
+        match self {
+            Entry::File(file) => &file.path,
+            Entry::Dir(path) => path,
+        }
+    }
+}
+
+/// `path` relative to `canonical_root`, or `None` when it is outside of it (or is the root).
+/// A path that does not exist yet is resolved through its parent.
+fn relative_to(canonical_root: &Path, path: &Path) -> Option<PathBuf> {
+    let canonical = fs::canonicalize(path).ok().or_else(|| {
+        let parent = fs::canonicalize(path.parent()?).ok()?;
+        Some(parent.join(path.file_name()?))
+    })?;
+    canonical
+        .strip_prefix(canonical_root)
+        .ok()
+        .filter(|rel| !rel.as_os_str().is_empty())
+        .map(Path::to_path_buf)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[tokio::test(flavor = "multi_thread")]
+    async fn walks_in_path_order_and_marks_ignored_files() {
+        let root = tempfile::tempdir().expect("tempdir");
+        for dir in ["a", "a/b", "c"] {
+            fs::create_dir_all(root.path().join(dir)).expect("dir");
+        }
+        for file in [
+            "top.md",
+            "a/one.md",
+            "a/b/two.md",
+            "a/b/skip.log",
+            "c/three.md",
+        ] {
+            fs::write(root.path().join(file), "text").expect("file");
+        }
+        let ignore = TranslationIgnore::new(root.path(), vec!["*.log".to_string()])
+            .expect("ignore")
+            .expect("patterns");
+
+        let walked = walk_files(root.path(), Some(ignore), &[])
+            .expect("walk")
+            .map(|item| {
+                let file = item.expect("entry");
+                let rel = file.path.strip_prefix(root.path()).unwrap().to_path_buf();
+                (rel.to_string_lossy().replace('\\', "/"), file.ignored)
+            })
+            .collect::<Vec<_>>()
+            .await;
+        assert_eq!(
+            walked,
+            vec![
+                ("a/b/skip.log".to_string(), true),
+                ("a/b/two.md".to_string(), false),
+                ("a/one.md".to_string(), false),
+                ("c/three.md".to_string(), false),
+                ("top.md".to_string(), false),
+            ]
+        );
+    }
+
+    #[tokio::test]
+    async fn missing_root_is_an_error() {
+        let root = tempfile::tempdir().expect("tempdir");
+        assert!(walk_files(&root.path().join("missing"), None, &[]).is_err());
+    }
+
+    #[tokio::test(flavor = "multi_thread")]
+    async fn skips_excluded_paths_under_the_root() {
+        let root = tempfile::tempdir().expect("tempdir");
+        fs::create_dir_all(root.path().join("out/nested")).expect("dir");
+        for file in ["doc.md", "manifest.json", "out/doc.md", "out/nested/doc.md"] {
+            fs::write(root.path().join(file), "text").expect("file");
+        }
+        let outside = tempfile::tempdir().expect("tempdir");
+        let out = root.path().join("out");
+        let manifest = root.path().join("manifest.json");
+        let exclude = [out.as_path(), manifest.as_path(), outside.path()];
+
+        let walked = walk_files(root.path(), None, &exclude)
+            .expect("walk")
+            .map(|item| item.expect("entry").path)
+            .collect::<Vec<_>>()
+            .await;
+        assert_eq!(walked, vec![root.path().join("doc.md")]);
+    }
+}
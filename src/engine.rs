@@ -0,0 +1,154 @@
+use anyhow::{Result, anyhow};
+use std::path::Path;
+use tracing::warn;
+
+use crate::languages::LanguageRegistry;
+use crate::providers::{ProviderImpl, ProviderKind};
+use crate::settings::{self, Settings};
+use crate::translations::{self, TOOL_NAME, TranslateOptions};
+use crate::{
+    Config, HistoryRecordInput, PreparedTranslator, TranslationInput, Translator,
+    format_execution_output, prepare_translator, record_translation,
+};
+
+/// A ready-to-use text translator for repeated calls with the same config.
+///
+/// Settings, the language registry, provider/model resolution and the rendered system
+/// prompt are computed once in `Engine::new`; `translate` only does the provider round-trip
+/// (plus history recording, like `run`).
+pub struct Engine {
+    translator: Translator<ProviderImpl>,
+    provider: ProviderKind,
+    model: String,
+    options: TranslateOptions,
+    system_prompt: String,
+    history_limit: usize,
+    with_using_model: bool,
+    with_using_tokens: bool,
+    skip_history_tags: bool,
+}
+
+impl Engine {
+    /// Builds an engine from `config`. When `settings` is `None` they are loaded like `run`.
+    ///
+    /// Only plain text translation is supported; attachment, report and dictionary modes
+    /// still go through `run`.
+    pub async fn new(config: Config, settings: Option<Settings>) -> Result<Self> {
+        if config.data.is_some()
+            || config.data_attachment.is_some()
+            || config.report_format.is_some()
+            || config.pos
+            || config.correction
+            || config.details
+        {
+            return Err(anyhow!("engine only supports plain text translation"));
+        }
+        let settings = match settings {
+            Some(settings) => settings,
+            None => settings::load_settings(config.settings_path.as_deref().map(Path::new))?,
+        };
+        let formality = config.formal.trim().to_string();
+        if formality.is_empty() {
+            return Err(anyhow!("formality is empty"));
+        }
+        let history_limit = settings.history_limit;
+        let registry = LanguageRegistry::load()?;
+        let PreparedTranslator {
+            translator,
+            provider,
+            model,
+        } = prepare_translator(&config, settings, registry).await?;
+        let options = TranslateOptions {
+            lang: config.lang,
+            formality,
+            source_lang: config.source_lang,
+            slang: config.slang,
+        };
+        let system_prompt =
+            translations::render_system_prompt(&options, TOOL_NAME, translator.settings())?;
+        Ok(Self {
+            translator,
+            provider,
+            model,
+            options,
+            system_prompt,
+            history_limit,
+            with_using_model: config.with_using_model,
+            with_using_tokens: config.with_using_tokens,
+            skip_history_tags: config.skip_history_tags,
+        })
+    }
+
+    pub fn model(&self) -> &str {
+        &self.model
+    }
+
+    pub fn provider(&self) -> ProviderKind {
+        self.provider
+    }
+
+    /// Translates `input` and formats it like `run` (including `--with-using-*` lines).
+    pub async fn translate(&self, input: &str) -> Result<String> {
+        self.translate_with(input, None::<fn(&str)>).await
+    }
+
+    /// Like `translate`, but passes translated text to `on_text` as the provider streams it.
+    pub async fn translate_streaming<F>(&self, input: &str, on_text: F) -> Result<String>
+    where
+        F: Fn(&str) + Send + Sync + 'static,
+    {
+        self.translate_with(input, Some(on_text)).await
+    }
+
+    async fn translate_with<F>(&self, input: &str, on_text: Option<F>) -> Result<String>
+    where
+        F: Fn(&str) + Send + Sync + 'static,
+    {
+        let input = input.trim();
+        if input.is_empty() {
+            return Err(anyhow!("stdin is empty"));
+        }
+        let translation_input = TranslationInput {
+            text: input.to_string(),
+            data: None,
+        };
+        let options = self.options.clone();
+        let system_prompt = self.system_prompt.clone();
+        let execution = match on_text {
+            Some(on_text) => {
+                self.translator
+                    .exec_streaming(translation_input, options, system_prompt, on_text)
+                    .await?
+            }
+            None => {
+                self.translator
+                    .exec_with_system_prompt(translation_input, options, system_prompt)
+                    .await?
+            }
+        };
+        let output =
+            format_execution_output(&execution, self.with_using_model, self.with_using_tokens);
+
+        if let Err(err) = record_translation(
+            &self.translator,
+            HistoryRecordInput {
+                provider: self.provider,
+                model: &self.model,
+                src_path: None,
+                history_limit: self.history_limit,
+                input_text: input,
+                attachment_mime: None,
+                output_text: &execution.text,
+                source_lang: &self.options.source_lang,
+                target_lang: &self.options.lang,
+                formal: &self.options.formality,
+                tags: None,
+            },
+            self.skip_history_tags,
+        ) {
+            warn!("failed to record history: {}", err);
+        }
+
+        Ok(output)
+    }
+}
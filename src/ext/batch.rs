@@ -0,0 +1,118 @@
+use std::os::raw::c_char;
+use std::ptr;
+
+use crate::run_batch;
+
+use super::config::ExtConfig;
+use super::error::{cstr_to_string, set_last_error, string_to_c};
+use super::runtime::runtime;
+use super::settings::ExtSettings;
+
+pub struct ExtBatch {
+    items: Vec<Result<String, String>>,
+    model: Option<String>,
+}
+
+/// Translates `len` inputs with as few provider calls as possible.
+///
+/// `settings` may be NULL, in which case settings are loaded like `llm_ext_run`.
+/// Per-item failures are reported through `llm_ext_batch_get_error`; NULL is only returned
+/// when the whole batch could not be started.
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_run_batch(
+    config: *const ExtConfig,
+    settings: *const ExtSettings,
+    inputs: *const *const c_char,
+    len: usize,
+) -> *mut ExtBatch {
+    let Some(config) = (unsafe { config.as_ref() }) else {
+        set_last_error("config is null");
+        return ptr::null_mut();
+    };
+    let Some(inputs) = collect_inputs(inputs, len) else {
+        set_last_error("inputs is null");
+        return ptr::null_mut();
+    };
+    let settings = unsafe { settings.as_ref() }.map(|settings| settings.inner.clone());
+    match runtime().block_on(run_batch(config.inner.clone(), settings, inputs)) {
+        Ok(output) => Box::into_raw(Box::new(ExtBatch {
+            items: output.items,
+            model: output.model,
+        })),
+        Err(err) => {
+            set_last_error(err.to_string());
+            ptr::null_mut()
+        }
+    }
+}
+
+pub(crate) fn collect_inputs(inputs: *const *const c_char, len: usize) -> Option<Vec<String>> {
+    if len == 0 {
+        return Some(Vec::new());
+    }
+    if inputs.is_null() {
+        return None;
+    }
+    let values = unsafe { std::slice::from_raw_parts(inputs, len) };
+    Some(
+        values
+            .iter()
+            .map(|value| cstr_to_string(*value).unwrap_or_default())
+            .collect(),
+    )
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_batch_len(batch: *const ExtBatch) -> usize {
+    let Some(batch) = (unsafe { batch.as_ref() }) else {
+        set_last_error("batch is null");
+        return 0;
+    };
+    batch.items.len()
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_batch_get_output(batch: *const ExtBatch, index: usize) -> *mut c_char {
+    let Some(batch) = (unsafe { batch.as_ref() }) else {
+        set_last_error("batch is null");
+        return ptr::null_mut();
+    };
+    match batch.items.get(index) {
+        Some(Ok(value)) => string_to_c(value),
+        _ => ptr::null_mut(),
+    }
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_batch_get_error(batch: *const ExtBatch, index: usize) -> *mut c_char {
+    let Some(batch) = (unsafe { batch.as_ref() }) else {
+        set_last_error("batch is null");
+        return ptr::null_mut();
+    };
+    match batch.items.get(index) {
+        Some(Err(message)) => string_to_c(message),
+        _ => ptr::null_mut(),
+    }
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_batch_get_model(batch: *const ExtBatch) -> *mut c_char {
+    let Some(batch) = (unsafe { batch.as_ref() }) else {
+        set_last_error("batch is null");
+        return ptr::null_mut();
+    };
+    match batch.model.as_deref() {
+        Some(model) => string_to_c(model),
+        None => ptr::null_mut(),
+    }
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_batch_free(batch: *mut ExtBatch) {
+    if batch.is_null() {
+        return;
+    }
+    unsafe {
+        let _ = Box::from_raw(batch);
+    }
+}
@@ -0,0 +1,109 @@
+use std::os::raw::c_char;
+use std::ptr;
+
+use crate::data::DataAttachment;
+use crate::run_bytes;
+
+use super::config::ExtConfig;
+use super::error::{cstr_to_string, set_last_error, string_to_c};
+use super::runtime::runtime;
+use super::settings::ExtSettings;
+
+/// Library-owned translated bytes; read them in place with `llm_ext_buffer_data`.
+pub struct ExtBuffer {
+    bytes: Box<[u8]>,
+    mime: String,
+    model: Option<String>,
+}
+
+/// Translates an in-memory attachment without going through the filesystem.
+///
+/// `settings` may be NULL, in which case settings are loaded like `llm_ext_run`.
+/// `mime` may be NULL or "auto" to sniff the type; `name` (optional) helps mime detection.
+/// The input is not retained after the call returns.
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_run_bytes(
+    config: *const ExtConfig,
+    settings: *const ExtSettings,
+    data: *const u8,
+    len: usize,
+    mime: *const c_char,
+    name: *const c_char,
+) -> *mut ExtBuffer {
+    let Some(config) = (unsafe { config.as_ref() }) else {
+        set_last_error("config is null");
+        return ptr::null_mut();
+    };
+    if data.is_null() || len == 0 {
+        set_last_error("data is empty");
+        return ptr::null_mut();
+    }
+    let bytes = unsafe { std::slice::from_raw_parts(data, len) }.to_vec();
+    let attachment = DataAttachment {
+        bytes,
+        mime: cstr_to_string(mime).unwrap_or_else(|| "auto".to_string()),
+        name: cstr_to_string(name),
+    };
+    let settings = unsafe { settings.as_ref() }.map(|settings| settings.inner.clone());
+    match runtime().block_on(run_bytes(config.inner.clone(), settings, attachment)) {
+        Ok(output) => Box::into_raw(Box::new(ExtBuffer {
+            bytes: output.bytes.into_boxed_slice(),
+            mime: output.mime,
+            model: output.model,
+        })),
+        Err(err) => {
+            set_last_error(err.to_string());
+            ptr::null_mut()
+        }
+    }
+}
+
+/// Borrowed pointer to the buffer contents; valid until `llm_ext_buffer_free`.
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_buffer_data(buffer: *const ExtBuffer) -> *const u8 {
+    let Some(buffer) = (unsafe { buffer.as_ref() }) else {
+        set_last_error("buffer is null");
+        return ptr::null();
+    };
+    buffer.bytes.as_ptr()
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_buffer_len(buffer: *const ExtBuffer) -> usize {
+    let Some(buffer) = (unsafe { buffer.as_ref() }) else {
+        set_last_error("buffer is null");
+        return 0;
+    };
+    buffer.bytes.len()
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_buffer_get_mime(buffer: *const ExtBuffer) -> *mut c_char {
+    let Some(buffer) = (unsafe { buffer.as_ref() }) else {
+        set_last_error("buffer is null");
+        return ptr::null_mut();
+    };
+    string_to_c(&buffer.mime)
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_buffer_get_model(buffer: *const ExtBuffer) -> *mut c_char {
+    let Some(buffer) = (unsafe { buffer.as_ref() }) else {
+        set_last_error("buffer is null");
+        return ptr::null_mut();
+    };
+    match buffer.model.as_deref() {
+        Some(model) => string_to_c(model),
+        None => ptr::null_mut(),
+    }
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_buffer_free(buffer: *mut ExtBuffer) {
+    if buffer.is_null() {
+        return;
+    }
+    unsafe {
+        let _ = Box::from_raw(buffer);
+    }
+}
@@ -13,6 +13,7 @@ pub struct ExtConfig {
 fn default_config() -> Config {
     Config {
         lang: "en".to_string(),
+        extra_langs: Vec::new(),
         model: None,
         key: None,
         formal: "formal".to_string(),
@@ -45,6 +46,7 @@ fn default_config() -> Config {
         debug_ocr: false,
         verbose: false,
         whisper_model: None,
+        skip_history_tags: false,
     }
 }
 
@@ -259,6 +261,56 @@ config_set_bool!(llm_ext_config_set_verbose, verbose);
 config_get_bool!(llm_ext_config_get_verbose, verbose);
 config_set_option_string!(llm_ext_config_set_whisper_model, whisper_model);
 config_get_option_string!(llm_ext_config_get_whisper_model, whisper_model);
+config_set_bool!(llm_ext_config_set_skip_history_tags, skip_history_tags);
+config_get_bool!(llm_ext_config_get_skip_history_tags, skip_history_tags);
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_config_clear_extra_langs(config: *mut ExtConfig) -> bool {
+    let Some(config) = (unsafe { config.as_mut() }) else {
+        set_last_error("config is null");
+        return false;
+    };
+    config.inner.extra_langs.clear();
+    true
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_config_add_lang(config: *mut ExtConfig, value: *const c_char) -> bool {
+    let Some(config) = (unsafe { config.as_mut() }) else {
+        set_last_error("config is null");
+        return false;
+    };
+    let Some(value) = cstr_to_string(value) else {
+        set_last_error("value is null");
+        return false;
+    };
+    config.inner.extra_langs.push(value);
+    true
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_config_extra_langs_len(config: *const ExtConfig) -> usize {
+    let Some(config) = (unsafe { config.as_ref() }) else {
+        set_last_error("config is null");
+        return 0;
+    };
+    config.inner.extra_langs.len()
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_config_get_extra_lang(
+    config: *const ExtConfig,
+    index: usize,
+) -> *mut c_char {
+    let Some(config) = (unsafe { config.as_ref() }) else {
+        set_last_error("config is null");
+        return ptr::null_mut();
+    };
+    match config.inner.extra_langs.get(index) {
+        Some(value) => string_to_c(value),
+        None => ptr::null_mut(),
+    }
+}
 
 #[unsafe(no_mangle)]
 pub extern "C" fn llm_ext_config_clear_ignore_translation_files(config: *mut ExtConfig) -> bool {
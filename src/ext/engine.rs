@@ -0,0 +1,103 @@
+use std::os::raw::{c_char, c_void};
+use std::ptr;
+use std::sync::Arc;
+
+use crate::Engine;
+
+use super::config::ExtConfig;
+use super::error::{cstr_to_string, set_last_error, string_to_c};
+use super::job::{ExtJob, ExtJobCallback, spawn_job};
+use super::runtime::runtime;
+use super::settings::ExtSettings;
+
+pub struct ExtEngine {
+    pub(crate) inner: Arc<Engine>,
+}
+
+/// Resolves settings, languages, provider/model and the system prompt once.
+///
+/// `settings` may be NULL, in which case settings are loaded like `llm_ext_run`.
+/// Later changes to `config`/`settings` do not affect the engine.
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_engine_new(
+    config: *const ExtConfig,
+    settings: *const ExtSettings,
+) -> *mut ExtEngine {
+    let Some(config) = (unsafe { config.as_ref() }) else {
+        set_last_error("config is null");
+        return ptr::null_mut();
+    };
+    let settings = unsafe { settings.as_ref() }.map(|settings| settings.inner.clone());
+    match runtime().block_on(Engine::new(config.inner.clone(), settings)) {
+        Ok(engine) => Box::into_raw(Box::new(ExtEngine {
+            inner: Arc::new(engine),
+        })),
+        Err(err) => {
+            set_last_error(err.to_string());
+            ptr::null_mut()
+        }
+    }
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_engine_free(engine: *mut ExtEngine) {
+    if engine.is_null() {
+        return;
+    }
+    unsafe {
+        let _ = Box::from_raw(engine);
+    }
+}
+
+/// Translates `input` with a prepared engine. Safe to call from several threads at once.
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_engine_translate(
+    engine: *const ExtEngine,
+    input: *const c_char,
+) -> *mut c_char {
+    let Some(engine) = (unsafe { engine.as_ref() }) else {
+        set_last_error("engine is null");
+        return ptr::null_mut();
+    };
+    let input = cstr_to_string(input).unwrap_or_default();
+    match runtime().block_on(engine.inner.translate(&input)) {
+        Ok(output) => string_to_c(&output),
+        Err(err) => {
+            set_last_error(err.to_string());
+            ptr::null_mut()
+        }
+    }
+}
+
+/// Async variant of `llm_ext_engine_translate`; the job keeps the engine alive, so the
+/// engine handle may be freed before the job settles.
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_engine_translate_async(
+    engine: *const ExtEngine,
+    input: *const c_char,
+    callback: ExtJobCallback,
+    user_data: *mut c_void,
+) -> *mut ExtJob {
+    let Some(engine) = (unsafe { engine.as_ref() }) else {
+        set_last_error("engine is null");
+        return ptr::null_mut();
+    };
+    let engine = engine.inner.clone();
+    let input = cstr_to_string(input).unwrap_or_default();
+    spawn_job(callback, user_data, move || async move {
+        engine.translate(&input).await
+    })
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_engine_get_model(engine: *const ExtEngine) -> *mut c_char {
+    let Some(engine) = (unsafe { engine.as_ref() }) else {
+        set_last_error("engine is null");
+        return ptr::null_mut();
+    };
+    string_to_c(&format!(
+        "{}:{}",
+        engine.inner.provider().as_str(),
+        engine.inner.model()
+    ))
+}
@@ -0,0 +1,289 @@
+use std::os::raw::{c_char, c_void};
+use std::ptr;
+use std::sync::{Arc, Condvar, Mutex};
+use std::time::Duration;
+
+#[cfg(unix)]
+use std::os::unix::net::UnixStream;
+
+use tokio::sync::Notify;
+
+use crate::{run, run_with_settings};
+
+use super::config::ExtConfig;
+use super::error::{cstr_to_string, set_last_error, string_to_c};
+use super::runtime::spawn_local;
+use super::settings::ExtSettings;
+
+pub const LLM_EXT_JOB_PENDING: i32 = 0;
+pub const LLM_EXT_JOB_SUCCEEDED: i32 = 1;
+pub const LLM_EXT_JOB_FAILED: i32 = 2;
+pub const LLM_EXT_JOB_CANCELLED: i32 = 3;
+
+pub type ExtJobCallback = Option<extern "C" fn(user_data: *mut c_void, status: i32)>;
+
+pub struct ExtJob {
+    shared: Arc<JobShared>,
+}
+
+struct JobShared {
+    state: Mutex<JobState>,
+    done: Condvar,
+    cancel: Notify,
+    callback: ExtJobCallback,
+    user_data: UserData,
+    #[cfg(unix)]
+    notifier: Option<(UnixStream, UnixStream)>,
+}
+
+struct JobState {
+    status: i32,
+    output: Option<String>,
+    error: Option<String>,
+}
+
+pub(crate) struct UserData(pub(crate) *mut c_void);
+
+// The pointer is only handed back to the caller's callback; the caller owns its thread-safety.
+unsafe impl Send for UserData {}
+unsafe impl Sync for UserData {}
+
+impl UserData {
+    /// Reads the pointer through the wrapper, so closures capture the `Send + Sync` wrapper
+    /// rather than (under edition 2024 disjoint captures) the raw pointer field.
+    pub(crate) fn get(&self) -> *mut c_void {
+        self.0
+    }
+}
+
+impl JobShared {
+    fn new(callback: ExtJobCallback, user_data: *mut c_void) -> Self {
+        Self {
+            state: Mutex::new(JobState {
+                status: LLM_EXT_JOB_PENDING,
+                output: None,
+                error: None,
+            }),
+            done: Condvar::new(),
+            cancel: Notify::new(),
+            callback,
+            user_data: UserData(user_data),
+            #[cfg(unix)]
+            notifier: UnixStream::pair().ok(),
+        }
+    }
+
+    fn status(&self) -> i32 {
+        self.state
+            .lock()
+            .map(|state| state.status)
+            .unwrap_or(LLM_EXT_JOB_FAILED)
+    }
+
+    /// Settles the job once; later calls (e.g. cancel after completion) are no-ops.
+    fn settle(&self, status: i32, output: Option<String>, error: Option<String>) -> bool {
+        {
+            let Ok(mut state) = self.state.lock() else {
+                return false;
+            };
+            if state.status != LLM_EXT_JOB_PENDING {
+                return false;
+            }
+            state.status = status;
+            state.output = output;
+            state.error = error;
+        }
+        self.done.notify_all();
+        #[cfg(unix)]
+        if let Some((_, writer)) = self.notifier.as_ref() {
+            use std::io::Write;
+            let _ = (&*writer).write_all(&[1]);
+        }
+        if let Some(callback) = self.callback {
+            callback(self.user_data.get(), status);
+        }
+        true
+    }
+}
+
+/// Starts a translation on the shared runtime and returns immediately.
+///
+/// `settings` may be NULL, in which case settings are loaded like `llm_ext_run`.
+/// `callback` (optional) fires exactly once when the job settles, from a worker thread
+/// (or from the thread calling `llm_ext_job_cancel`). If no worker can take the job, it is
+/// returned already failed (callback fired on the calling thread, last error set).
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_run_async(
+    config: *const ExtConfig,
+    settings: *const ExtSettings,
+    input: *const c_char,
+    callback: ExtJobCallback,
+    user_data: *mut c_void,
+) -> *mut ExtJob {
+    let Some(config) = (unsafe { config.as_ref() }) else {
+        set_last_error("config is null");
+        return ptr::null_mut();
+    };
+    let config = config.inner.clone();
+    let settings = unsafe { settings.as_ref() }.map(|settings| settings.inner.clone());
+    let input = cstr_to_string(input);
+
+    spawn_job(callback, user_data, move || async move {
+        match settings {
+            Some(settings) => run_with_settings(config, settings, input).await,
+            None => run(config, input).await,
+        }
+    })
+}
+
+pub(crate) fn spawn_job<F, Fut>(
+    callback: ExtJobCallback,
+    user_data: *mut c_void,
+    make: F,
+) -> *mut ExtJob
+where
+    F: FnOnce() -> Fut + Send + 'static,
+    Fut: std::future::Future<Output = anyhow::Result<String>> + 'static,
+{
+    let shared = Arc::new(JobShared::new(callback, user_data));
+    let task_shared = shared.clone();
+    let spawned = spawn_local(move || async move {
+        let cancelled = task_shared.cancel.notified();
+        tokio::select! {
+            result = make() => match result {
+                Ok(output) => {
+                    task_shared.settle(LLM_EXT_JOB_SUCCEEDED, Some(output), None);
+                }
+                Err(err) => {
+                    task_shared.settle(LLM_EXT_JOB_FAILED, None, Some(err.to_string()));
+                }
+            },
+            _ = cancelled => {}
+        }
+    });
+    if let Err(err) = spawned {
+        // Settle here so waiters and the callback still see exactly one outcome.
+        let message = format!("failed to start job: {}", err);
+        set_last_error(message.clone());
+        shared.settle(LLM_EXT_JOB_FAILED, None, Some(message));
+    }
+    Box::into_raw(Box::new(ExtJob { shared }))
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_job_status(job: *const ExtJob) -> i32 {
+    let Some(job) = (unsafe { job.as_ref() }) else {
+        set_last_error("job is null");
+        return LLM_EXT_JOB_FAILED;
+    };
+    job.shared.status()
+}
+
+/// Blocks until the job settles or `timeout_ms` elapses (negative waits forever).
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_job_wait(job: *const ExtJob, timeout_ms: i64) -> i32 {
+    let Some(job) = (unsafe { job.as_ref() }) else {
+        set_last_error("job is null");
+        return LLM_EXT_JOB_FAILED;
+    };
+    let Ok(state) = job.shared.state.lock() else {
+        return LLM_EXT_JOB_FAILED;
+    };
+    let pending = |state: &mut JobState| state.status == LLM_EXT_JOB_PENDING;
+    let state = if timeout_ms < 0 {
+        job.shared.done.wait_while(state, pending).ok()
+    } else {
+        job.shared
+            .done
+            .wait_timeout_while(state, Duration::from_millis(timeout_ms as u64), pending)
+            .ok()
+            .map(|(state, _)| state)
+    };
+    state
+        .map(|state| state.status)
+        .unwrap_or(LLM_EXT_JOB_FAILED)
+}
+
+/// Takes the translated output of a succeeded job (NULL otherwise); free it with
+/// `llm_ext_free_string`. The output can only be taken once.
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_job_take_output(job: *mut ExtJob) -> *mut c_char {
+    let Some(job) = (unsafe { job.as_ref() }) else {
+        set_last_error("job is null");
+        return ptr::null_mut();
+    };
+    let Ok(mut state) = job.shared.state.lock() else {
+        set_last_error("job state is poisoned");
+        return ptr::null_mut();
+    };
+    match state.output.take() {
+        Some(output) => string_to_c(&output),
+        None => ptr::null_mut(),
+    }
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_job_error_message(job: *const ExtJob) -> *mut c_char {
+    let Some(job) = (unsafe { job.as_ref() }) else {
+        set_last_error("job is null");
+        return ptr::null_mut();
+    };
+    let Ok(state) = job.shared.state.lock() else {
+        return ptr::null_mut();
+    };
+    match state.error.as_deref() {
+        Some(message) => string_to_c(message),
+        None => ptr::null_mut(),
+    }
+}
+
+/// Cancels a pending job. Returns false when the job had already settled.
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_job_cancel(job: *mut ExtJob) -> bool {
+    let Some(job) = (unsafe { job.as_ref() }) else {
+        set_last_error("job is null");
+        return false;
+    };
+    cancel(&job.shared)
+}
+
+fn cancel(shared: &JobShared) -> bool {
+    if !shared.settle(
+        LLM_EXT_JOB_CANCELLED,
+        None,
+        Some("job cancelled".to_string()),
+    ) {
+        return false;
+    }
+    shared.cancel.notify_one();
+    true
+}
+
+/// Returns a file descriptor that becomes readable once the job settles, so the job can
+/// be registered with poll/epoll/kqueue. Returns -1 when unavailable.
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_job_fd(job: *const ExtJob) -> i32 {
+    let Some(job) = (unsafe { job.as_ref() }) else {
+        set_last_error("job is null");
+        return -1;
+    };
+    #[cfg(unix)]
+    {
+        use std::os::fd::AsRawFd;
+        if let Some((reader, _)) = job.shared.notifier.as_ref() {
+            return reader.as_raw_fd();
+        }
+    }
+    let _ = job;
+    -1
+}
+
+/// Frees the job handle, cancelling it first when it is still pending.
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_job_free(job: *mut ExtJob) {
+    if job.is_null() {
+        return;
+    }
+    let job = unsafe { Box::from_raw(job) };
+    cancel(&job.shared);
+}
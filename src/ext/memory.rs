@@ -0,0 +1,27 @@
+use crate::response_cache;
+use crate::translation_memory;
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_translation_memory_hits() -> u64 {
+    translation_memory::stats().hits
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_translation_memory_misses() -> u64 {
+    translation_memory::stats().misses
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_response_cache_hits() -> u64 {
+    response_cache::stats().hits
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_response_cache_misses() -> u64 {
+    response_cache::stats().misses
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_response_cache_coalesced() -> u64 {
+    response_cache::stats().coalesced
+}
@@ -0,0 +1,10 @@
+use std::os::raw::c_char;
+
+use crate::metrics;
+
+use super::error::string_to_c;
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_metrics_snapshot() -> *mut c_char {
+    string_to_c(&metrics::snapshot_json().to_string())
+}
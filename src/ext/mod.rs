@@ -1,8 +1,20 @@
+mod batch;
+mod buffer;
 mod config;
+mod engine;
 mod error;
+mod job;
+mod memory;
+mod metrics;
+mod prompts;
 mod run;
 mod runtime;
 mod settings;
+mod stream;
 
+pub use batch::ExtBatch;
+pub use buffer::ExtBuffer;
 pub use config::ExtConfig;
+pub use engine::ExtEngine;
+pub use job::ExtJob;
 pub use settings::ExtSettings;
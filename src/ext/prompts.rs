@@ -0,0 +1,14 @@
+use crate::translations;
+
+use super::error::set_last_error;
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_reload_prompts() -> bool {
+    match translations::reload_prompts() {
+        Ok(()) => true,
+        Err(err) => {
+            set_last_error(err.to_string());
+            false
+        }
+    }
+}
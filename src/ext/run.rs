@@ -1,7 +1,7 @@
 use std::os::raw::c_char;
 use std::ptr;
 
-use crate::{run, run_with_settings};
+use crate::{flush_history_tags, run, run_with_settings};
 
 use super::config::ExtConfig;
 use super::error::{cstr_to_string, set_last_error, string_to_c};
@@ -51,3 +51,8 @@ pub extern "C" fn llm_ext_run_with_settings(
         }
     }
 }
+
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_flush_history_tags() {
+    runtime().block_on(flush_history_tags());
+}
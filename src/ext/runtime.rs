@@ -1,8 +1,64 @@
+use anyhow::{Result, anyhow};
+use std::future::Future;
+use std::pin::Pin;
 use std::sync::OnceLock;
+use std::sync::atomic::{AtomicUsize, Ordering};
 
 use tokio::runtime::Runtime;
+use tokio::sync::mpsc;
+use tokio::task::LocalSet;
+
+type LocalJob = Box<dyn FnOnce() -> Pin<Box<dyn Future<Output = ()>>> + Send>;
 
 pub(crate) fn runtime() -> &'static Runtime {
     static RUNTIME: OnceLock<Runtime> = OnceLock::new();
     RUNTIME.get_or_init(|| Runtime::new().expect("failed to init runtime"))
 }
+
+/// Spawns a job on one of the local worker threads.
+///
+/// Translation futures are not `Send` (HTML attachments hold DOM nodes across awaits), so
+/// they cannot go through `Runtime::spawn`. Each worker drives a `LocalSet` on the shared
+/// runtime instead, which lets a single thread keep many network-bound jobs in flight.
+///
+/// Fails when the chosen worker has stopped; the job is dropped without running.
+pub(crate) fn spawn_local<F, Fut>(make: F) -> Result<()>
+where
+    F: FnOnce() -> Fut + Send + 'static,
+    Fut: Future<Output = ()> + 'static,
+{
+    let workers = local_workers();
+    let index = NEXT_WORKER.fetch_add(1, Ordering::Relaxed) % workers.len();
+    let job: LocalJob = Box::new(move || Box::pin(make()));
+    if workers[index].send(job).is_err() {
+        tracing::warn!("ext worker {} is not running", index);
+        return Err(anyhow!("ext worker {} is not running", index));
+    }
+    Ok(())
+}
+
+static NEXT_WORKER: AtomicUsize = AtomicUsize::new(0);
+
+fn local_workers() -> &'static [mpsc::UnboundedSender<LocalJob>] {
+    static WORKERS: OnceLock<Vec<mpsc::UnboundedSender<LocalJob>>> = OnceLock::new();
+    WORKERS.get_or_init(|| {
+        let count = num_cpus::get().clamp(1, 8);
+        (0..count)
+            .map(|index| {
+                let (tx, mut rx) = mpsc::unbounded_channel::<LocalJob>();
+                std::thread::Builder::new()
+                    .name(format!("llm-ext-worker-{}", index))
+                    .spawn(move || {
+                        let local = LocalSet::new();
+                        local.block_on(runtime(), async move {
+                            while let Some(job) = rx.recv().await {
+                                tokio::task::spawn_local(job());
+                            }
+                        });
+                    })
+                    .expect("failed to spawn ext worker");
+                tx
+            })
+            .collect()
+    })
+}
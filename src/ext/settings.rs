@@ -261,8 +261,52 @@ settings_set_option_string!(llm_ext_settings_set_overlay_font_path, overlay_font
 settings_get_option_string!(llm_ext_settings_get_overlay_font_path, overlay_font_path);
 settings_set_option_string!(llm_ext_settings_set_whisper_model, whisper_model);
 settings_get_option_string!(llm_ext_settings_get_whisper_model, whisper_model);
+settings_set_usize!(llm_ext_settings_set_whisper_pool_size, whisper_pool_size);
+settings_get_usize!(llm_ext_settings_get_whisper_pool_size, whisper_pool_size);
+settings_set_usize!(
+    llm_ext_settings_set_whisper_threads_per_job,
+    whisper_threads_per_job
+);
+settings_get_usize!(
+    llm_ext_settings_get_whisper_threads_per_job,
+    whisper_threads_per_job
+);
 settings_set_bool!(llm_ext_settings_set_ocr_normalize, ocr_normalize);
 settings_get_bool!(llm_ext_settings_get_ocr_normalize, ocr_normalize);
+settings_set_usize!(llm_ext_settings_set_pdf_page_workers, pdf_page_workers);
+settings_get_usize!(llm_ext_settings_get_pdf_page_workers, pdf_page_workers);
+settings_set_u64!(
+    llm_ext_settings_set_pdf_max_inflight_mb,
+    pdf_max_inflight_mb
+);
+settings_get_u64!(
+    llm_ext_settings_get_pdf_max_inflight_mb,
+    pdf_max_inflight_mb
+);
+settings_set_usize!(
+    llm_ext_settings_set_rate_limit_max_concurrency,
+    rate_limit_max_concurrency
+);
+settings_get_usize!(
+    llm_ext_settings_get_rate_limit_max_concurrency,
+    rate_limit_max_concurrency
+);
+settings_set_u64!(
+    llm_ext_settings_set_rate_limit_requests_per_minute,
+    rate_limit_requests_per_minute
+);
+settings_get_u64!(
+    llm_ext_settings_get_rate_limit_requests_per_minute,
+    rate_limit_requests_per_minute
+);
+settings_set_u64!(
+    llm_ext_settings_set_rate_limit_tokens_per_minute,
+    rate_limit_tokens_per_minute
+);
+settings_get_u64!(
+    llm_ext_settings_get_rate_limit_tokens_per_minute,
+    rate_limit_tokens_per_minute
+);
 settings_set_usize!(llm_ext_settings_set_history_limit, history_limit);
 settings_get_usize!(llm_ext_settings_get_history_limit, history_limit);
 settings_set_u64!(llm_ext_settings_set_backup_ttl_days, backup_ttl_days);
@@ -281,6 +325,86 @@ settings_set_string!(llm_ext_settings_set_server_host, server_host);
 settings_get_string!(llm_ext_settings_get_server_host, server_host);
 settings_set_option_string!(llm_ext_settings_set_server_tmp_dir, server_tmp_dir);
 settings_get_option_string!(llm_ext_settings_get_server_tmp_dir, server_tmp_dir);
+settings_set_u64!(
+    llm_ext_settings_set_server_max_upload_mb,
+    server_max_upload_mb
+);
+settings_get_u64!(
+    llm_ext_settings_get_server_max_upload_mb,
+    server_max_upload_mb
+);
+settings_set_usize!(
+    llm_ext_settings_set_http_pool_max_idle_per_host,
+    http_pool_max_idle_per_host
+);
+settings_get_usize!(
+    llm_ext_settings_get_http_pool_max_idle_per_host,
+    http_pool_max_idle_per_host
+);
+settings_set_u64!(
+    llm_ext_settings_set_http_pool_idle_timeout_secs,
+    http_pool_idle_timeout_secs
+);
+settings_get_u64!(
+    llm_ext_settings_get_http_pool_idle_timeout_secs,
+    http_pool_idle_timeout_secs
+);
+settings_set_u64!(
+    llm_ext_settings_set_http_connect_timeout_secs,
+    http_connect_timeout_secs
+);
+settings_get_u64!(
+    llm_ext_settings_get_http_connect_timeout_secs,
+    http_connect_timeout_secs
+);
+settings_set_u64!(
+    llm_ext_settings_set_http_read_timeout_secs,
+    http_read_timeout_secs
+);
+settings_get_u64!(
+    llm_ext_settings_get_http_read_timeout_secs,
+    http_read_timeout_secs
+);
+settings_set_u64!(
+    llm_ext_settings_set_http_tcp_keepalive_secs,
+    http_tcp_keepalive_secs
+);
+settings_get_u64!(
+    llm_ext_settings_get_http_tcp_keepalive_secs,
+    http_tcp_keepalive_secs
+);
+settings_set_bool!(
+    llm_ext_settings_set_translation_memory_enabled,
+    translation_memory_enabled
+);
+settings_get_bool!(
+    llm_ext_settings_get_translation_memory_enabled,
+    translation_memory_enabled
+);
+settings_set_u64!(
+    llm_ext_settings_set_translation_memory_max_mb,
+    translation_memory_max_mb
+);
+settings_get_u64!(
+    llm_ext_settings_get_translation_memory_max_mb,
+    translation_memory_max_mb
+);
+settings_set_usize!(
+    llm_ext_settings_set_response_cache_entries,
+    response_cache_entries
+);
+settings_get_usize!(
+    llm_ext_settings_get_response_cache_entries,
+    response_cache_entries
+);
+settings_set_u64!(
+    llm_ext_settings_set_response_cache_ttl_secs,
+    response_cache_ttl_secs
+);
+settings_get_u64!(
+    llm_ext_settings_get_response_cache_ttl_secs,
+    response_cache_ttl_secs
+);
 
 #[unsafe(no_mangle)]
 pub extern "C" fn llm_ext_settings_set_server_port(settings: *mut ExtSettings, value: u16) -> bool {
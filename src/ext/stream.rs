@@ -0,0 +1,83 @@
+use std::os::raw::{c_char, c_void};
+use std::ptr;
+
+use crate::Engine;
+
+use super::config::ExtConfig;
+use super::engine::ExtEngine;
+use super::error::{cstr_to_string, set_last_error, string_to_c};
+use super::job::UserData;
+use super::runtime::runtime;
+use super::settings::ExtSettings;
+
+/// Receives UTF-8 text as it is translated. `text` is not NUL-terminated and is only valid
+/// for the duration of the call.
+pub type ExtStreamCallback =
+    Option<extern "C" fn(user_data: *mut c_void, text: *const c_char, len: usize)>;
+
+/// Translates `input` like `llm_ext_run`, calling `callback` with translated text as the
+/// provider streams it. Returns the complete output (free with `llm_ext_free_string`).
+///
+/// `settings` may be NULL. The callback runs on the calling thread.
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_run_streaming(
+    config: *const ExtConfig,
+    settings: *const ExtSettings,
+    input: *const c_char,
+    callback: ExtStreamCallback,
+    user_data: *mut c_void,
+) -> *mut c_char {
+    let Some(config) = (unsafe { config.as_ref() }) else {
+        set_last_error("config is null");
+        return ptr::null_mut();
+    };
+    let settings = unsafe { settings.as_ref() }.map(|settings| settings.inner.clone());
+    let input = cstr_to_string(input).unwrap_or_default();
+    let on_text = stream_handler(callback, user_data);
+    let result = runtime().block_on(async move {
+        let engine = Engine::new(config.inner.clone(), settings).await?;
+        engine.translate_streaming(&input, on_text).await
+    });
+    match result {
+        Ok(output) => string_to_c(&output),
+        Err(err) => {
+            set_last_error(err.to_string());
+            ptr::null_mut()
+        }
+    }
+}
+
+/// Streaming variant of `llm_ext_engine_translate`. The callback runs on the calling thread.
+#[unsafe(no_mangle)]
+pub extern "C" fn llm_ext_engine_translate_streaming(
+    engine: *const ExtEngine,
+    input: *const c_char,
+    callback: ExtStreamCallback,
+    user_data: *mut c_void,
+) -> *mut c_char {
+    let Some(engine) = (unsafe { engine.as_ref() }) else {
+        set_last_error("engine is null");
+        return ptr::null_mut();
+    };
+    let input = cstr_to_string(input).unwrap_or_default();
+    let on_text = stream_handler(callback, user_data);
+    match runtime().block_on(engine.inner.translate_streaming(&input, on_text)) {
+        Ok(output) => string_to_c(&output),
+        Err(err) => {
+            set_last_error(err.to_string());
+            ptr::null_mut()
+        }
+    }
+}
+
+fn stream_handler(
+    callback: ExtStreamCallback,
+    user_data: *mut c_void,
+) -> impl Fn(&str) + Send + Sync + 'static {
+    let user_data = UserData(user_data);
+    move |text: &str| {
+        if let Some(callback) = callback {
+            callback(user_data.get(), text.as_ptr() as *const c_char, text.len());
+        }
+    }
+}
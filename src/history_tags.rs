@@ -1,15 +1,28 @@
 use anyhow::{Context, Result};
 use serde::Deserialize;
 use serde_json::json;
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::Duration;
+use tokio::sync::Notify;
+use tracing::warn;
 
 use crate::Translator;
-use crate::providers::{Provider, ToolSpec};
+use crate::model_registry::{self, HistoryEntry};
+use crate::providers::{Provider, ProviderImpl, ToolSpec, scheduler};
+use crate::translations;
+use crate::util::lock;
 
 const TOOL_NAME: &str = "generate_history_tags";
 const MAX_TEXT_LEN: usize = 600;
 const MAX_TAGS: usize = 8;
 const MAX_CATEGORIES: usize = 6;
 const MAX_KEYWORDS: usize = 12;
+/// Entries tagged by one provider call.
+const MAX_BATCH: usize = 16;
+/// How long the first queued entry waits for others to share its tagging call.
+const BATCH_DELAY: Duration = Duration::from_secs(2);
 
 pub struct HistoryTagResult {
     pub tags: Vec<String>,
@@ -19,6 +32,13 @@ pub struct HistoryTagResult {
 
 #[derive(Debug, Default, Deserialize)]
 struct TagResponse {
+    #[serde(default)]
+    items: Vec<TagItem>,
+}
+
+#[derive(Debug, Default, Deserialize)]
+struct TagItem {
+    id: usize,
     #[serde(default)]
     tags: Vec<String>,
     #[serde(default)]
@@ -27,27 +47,152 @@ struct TagResponse {
     keywords: Vec<String>,
 }
 
+struct TagJob {
+    entry: HistoryEntry,
+    text: String,
+}
+
+struct PendingBatch {
+    translator: Translator<ProviderImpl>,
+    jobs: Vec<TagJob>,
+    ready: Arc<Notify>,
+}
+
+/// Batches waiting to be tagged, one per `provider:model`.
+static QUEUE: Mutex<Option<HashMap<String, PendingBatch>>> = Mutex::new(None);
+static OUTSTANDING: AtomicUsize = AtomicUsize::new(0);
+static IDLE: Notify = Notify::const_new();
+
+/// Queues a text history entry for tagging in the background.
+///
+/// Tagging is a separate LLM round-trip, so it no longer delays the translation result.
+/// Entries queued within `BATCH_DELAY` of each other (up to `MAX_BATCH`) share one call,
+/// after which their tags are written to the history log and the categories and keywords
+/// added to the trend counts. Must be called from within a tokio runtime.
+pub(crate) fn enqueue(translator: &Translator<ProviderImpl>, entry: HistoryEntry, text: &str) {
+    let text = text.trim();
+    if text.is_empty() {
+        return;
+    }
+    let job = TagJob {
+        entry,
+        text: truncate_text(text, MAX_TEXT_LEN),
+    };
+    let key = job.entry.model.clone();
+    let mut guard = lock(&QUEUE);
+    let queue = guard.get_or_insert_with(HashMap::new);
+    OUTSTANDING.fetch_add(1, Ordering::AcqRel);
+    let batch = queue.entry(key.clone()).or_insert_with(|| {
+        let ready = Arc::new(Notify::new());
+        // Tagging is background work; it waits behind user-facing translations.
+        tokio::spawn(scheduler::bulk(run_batch(key, ready.clone())));
+        PendingBatch {
+            translator: translator.clone(),
+            jobs: Vec::new(),
+            ready,
+        }
+    });
+    batch.jobs.push(job);
+    if batch.jobs.len() >= MAX_BATCH {
+        batch.ready.notify_one();
+    }
+}
+
+/// Tags everything queued so far without waiting out `BATCH_DELAY`, and returns once every
+/// queued entry has been handled. One-shot callers (the CLI) call this before exiting.
+pub async fn flush() {
+    if let Some(queue) = lock(&QUEUE).as_ref() {
+        for batch in queue.values() {
+            batch.ready.notify_one();
+        }
+    }
+    loop {
+        let idle = IDLE.notified();
+        tokio::pin!(idle);
+        idle.as_mut().enable();
+        if OUTSTANDING.load(Ordering::Acquire) == 0 {
+            return;
+        }
+        idle.await;
+    }
+}
+
+async fn run_batch(key: String, ready: Arc<Notify>) {
+    let _ = tokio::time::timeout(BATCH_DELAY, ready.notified()).await;
+    let Some(batch) = lock(&QUEUE).as_mut().and_then(|queue| queue.remove(&key)) else {
+        return;
+    };
+    let total = batch.jobs.len();
+    for chunk in batch.jobs.chunks(MAX_BATCH) {
+        if let Err(err) = tag_chunk(&batch.translator, chunk).await {
+            warn!("failed to generate history tags: {}", err);
+        }
+    }
+    if OUTSTANDING.fetch_sub(total, Ordering::AcqRel) == total {
+        IDLE.notify_waiters();
+    }
+}
+
+async fn tag_chunk<P: Provider + Clone>(translator: &Translator<P>, jobs: &[TagJob]) -> Result<()> {
+    let texts = jobs
+        .iter()
+        .map(|job| {
+            (
+                job.text.as_str(),
+                job.entry.source_language.as_deref().unwrap_or("auto"),
+                job.entry.target_language.as_deref().unwrap_or(""),
+            )
+        })
+        .collect::<Vec<_>>();
+    let results = generate_history_tags(translator, &texts).await?;
+
+    let mut categories = Vec::new();
+    let mut keywords = Vec::new();
+    let mut tagged = Vec::new();
+    for (job, result) in jobs.iter().zip(results) {
+        let Some(result) = result else {
+            continue;
+        };
+        categories.extend(result.categories);
+        keywords.extend(result.keywords);
+        if !result.tags.is_empty() {
+            tagged.push((job.entry.clone(), result.tags));
+        }
+    }
+    if (!categories.is_empty() || !keywords.is_empty())
+        && let Err(err) = model_registry::update_trend(&categories, &keywords)
+    {
+        warn!("failed to update trend meta: {}", err);
+    }
+    if !tagged.is_empty() {
+        model_registry::set_history_tags(&tagged)?;
+    }
+    Ok(())
+}
+
+/// Tags `(text, source_language, target_language)` items in one provider call. Results are
+/// in input order; an item the provider skipped is `None`.
 pub async fn generate_history_tags<P: Provider + Clone>(
     translator: &Translator<P>,
-    text: &str,
-    source_lang: &str,
-    target_lang: &str,
-) -> Result<HistoryTagResult> {
-    let trimmed = text.trim();
-    if trimmed.is_empty() {
-        return Ok(HistoryTagResult {
-            tags: Vec::new(),
-            categories: Vec::new(),
-            keywords: Vec::new(),
-        });
+    items: &[(&str, &str, &str)],
+) -> Result<Vec<Option<HistoryTagResult>>> {
+    if items.is_empty() {
+        return Ok(Vec::new());
     }
 
     let prompt = render_prompt()?;
     let tool = tool_spec();
     let input_json = serde_json::to_string_pretty(&json!({
-        "text": truncate_text(trimmed, MAX_TEXT_LEN),
-        "source_language": source_lang,
-        "target_language": target_lang
+        "items": items
+            .iter()
+            .enumerate()
+            .map(|(id, (text, source_lang, target_lang))| json!({
+                "id": id,
+                "text": text,
+                "source_language": source_lang,
+                "target_language": target_lang
+            }))
+            .collect::<Vec<_>>()
     }))?;
 
     let response = translator
@@ -56,11 +201,17 @@ pub async fn generate_history_tags<P: Provider + Clone>(
     let parsed: TagResponse = serde_json::from_value(response.args)
         .with_context(|| "failed to parse history tag response")?;
 
-    Ok(HistoryTagResult {
-        tags: normalize_list(parsed.tags, MAX_TAGS),
-        categories: normalize_list(parsed.categories, MAX_CATEGORIES),
-        keywords: normalize_list(parsed.keywords, MAX_KEYWORDS),
-    })
+    let mut results = (0..items.len()).map(|_| None).collect::<Vec<_>>();
+    for item in parsed.items {
+        if let Some(slot) = results.get_mut(item.id) {
+            *slot = Some(HistoryTagResult {
+                tags: normalize_list(item.tags, MAX_TAGS),
+                categories: normalize_list(item.categories, MAX_CATEGORIES),
+                keywords: normalize_list(item.keywords, MAX_KEYWORDS),
+            });
+        }
+    }
+    Ok(results)
 }
 
 fn tool_spec() -> ToolSpec {
@@ -70,46 +221,41 @@ fn tool_spec() -> ToolSpec {
         parameters: json!({
             "type": "object",
             "properties": {
-                "tags": {
-                    "type": "array",
-                    "items": { "type": "string" }
-                },
-                "categories": {
+                "items": {
                     "type": "array",
-                    "items": { "type": "string" }
-                },
-                "keywords": {
-                    "type": "array",
-                    "items": { "type": "string" }
+                    "items": {
+                        "type": "object",
+                        "properties": {
+                            "id": { "type": "integer" },
+                            "tags": {
+                                "type": "array",
+                                "items": { "type": "string" }
+                            },
+                            "categories": {
+                                "type": "array",
+                                "items": { "type": "string" }
+                            },
+                            "keywords": {
+                                "type": "array",
+                                "items": { "type": "string" }
+                            }
+                        },
+                        "required": ["id", "tags", "categories", "keywords"]
+                    }
                 }
             },
-            "required": ["tags", "categories", "keywords"]
+            "required": ["items"]
         }),
     }
 }
 
 fn render_prompt() -> Result<String> {
-    let template = load_prompt_template("history_tags_prompt.tera")?;
     let mut context = tera::Context::new();
     context.insert("tool_name", TOOL_NAME);
-    tera::Tera::one_off(&template, &context, false)
+    translations::render_prompt("history_tags_prompt.tera", &context)
         .with_context(|| "failed to render history tags prompt")
 }
 
-fn load_prompt_template(name: &str) -> Result<String> {
-    let path = prompt_path(name)?;
-    std::fs::read_to_string(&path)
-        .with_context(|| format!("failed to read prompt: {}", path.display()))
-}
-
-fn prompt_path(name: &str) -> Result<std::path::PathBuf> {
-    Ok(std::path::PathBuf::from(env!("CARGO_MANIFEST_DIR"))
-        .join("src")
-        .join("translations")
-        .join("prompts")
-        .join(name))
-}
-
 fn truncate_text(text: &str, max_len: usize) -> String {
     if text.chars().count() <= max_len {
         return text.to_string();
@@ -1,5 +1,6 @@
 use anyhow::{Context, Result, anyhow};
-use futures_util::stream::{self, StreamExt};
+use futures_util::future;
+use futures_util::stream::StreamExt;
 use std::fs;
 use std::path::{Path, PathBuf};
 use std::sync::Arc;
@@ -14,32 +15,49 @@ pub mod correction;
 pub mod data;
 pub mod details;
 pub mod dictionary;
+mod dir_manifest;
+mod dir_walk;
+mod engine;
 pub mod ext;
 mod history_tags;
 pub mod languages;
 pub mod logging;
 pub mod mcp;
+mod metrics;
 mod model_registry;
 pub mod ocr;
 mod providers;
 pub mod report;
+mod response_cache;
 pub mod server;
 pub mod settings;
+mod text_chunks;
 mod translation_ignore;
+mod translation_memory;
 pub mod translations;
 mod translator;
+mod util;
 
-pub use providers::{Claude, Gemini, OpenAI, Provider, ProviderKind, ProviderUsage};
+use dir_manifest::DirManifest;
+pub use engine::Engine;
+pub use providers::{Claude, Gemini, OpenAI, Provider, ProviderKind, ProviderUsage, StreamSink};
 use translation_ignore::TranslationIgnore;
 pub use translations::TranslateOptions;
-pub use translator::{ExecutionOutput, TranslationInput, Translator};
+pub use translator::{BatchExecutionOutput, ExecutionOutput, TranslationInput, Translator};
 
+// Also built for unit tests, which share its mock provider and translator.
+#[cfg(any(test, feature = "bench"))]
+#[doc(hidden)]
+pub mod bench_support;
 #[cfg(test)]
 mod test_util;
 
 #[derive(Debug, Clone)]
 pub struct Config {
     pub lang: String,
+    /// Further target languages for a `data` file or attachment, translated alongside `lang`
+    /// from a single read, parse and OCR/transcription of the input.
+    pub extra_langs: Vec<String>,
     pub model: Option<String>,
     pub key: Option<String>,
     pub formal: String,
@@ -72,6 +90,30 @@ pub struct Config {
     pub debug_ocr: bool,
     pub verbose: bool,
     pub whisper_model: Option<String>,
+    /// Skip background tag generation for the history entry of this call.
+    pub skip_history_tags: bool,
+}
+
+impl Config {
+    /// `lang` followed by `extra_langs`, without blanks or repeats.
+    pub fn target_langs(&self) -> Vec<&str> {
+        let mut langs: Vec<&str> = Vec::with_capacity(1 + self.extra_langs.len());
+        for lang in std::iter::once(&self.lang).chain(&self.extra_langs) {
+            let lang = lang.trim();
+            if !lang.is_empty() && !langs.contains(&lang) {
+                langs.push(lang);
+            }
+        }
+        langs
+    }
+
+    /// Target languages added to the OCR languages. With several targets there are none, so
+    /// the one OCR pass shared by every target depends only on the source language (or the
+    /// installed defaults when it is auto).
+    pub(crate) fn ocr_hint_langs(&self) -> Vec<&str> {
+        let langs = self.target_langs();
+        if langs.len() > 1 { Vec::new() } else { langs }
+    }
 }
 
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -91,6 +133,11 @@ impl ReportFormat {
     }
 }
 
+/// Waits for queued history tagging to finish; call before a one-shot process exits.
+pub async fn flush_history_tags() {
+    history_tags::flush().await;
+}
+
 pub async fn run(config: Config, input: Option<String>) -> Result<String> {
     let settings_path = config.settings_path.as_deref().map(Path::new);
     let settings = settings::load_settings(settings_path)?;
@@ -105,6 +152,193 @@ pub async fn run_with_settings(
     run_with_loaded_settings(config, settings, input).await
 }
 
+/// Translates many independent texts in one call (see `Translator::exec_batch`).
+///
+/// Only the provider/model options of `config` are used; batches are not recorded in history.
+pub async fn run_batch(
+    config: Config,
+    settings: Option<settings::Settings>,
+    inputs: Vec<String>,
+) -> Result<BatchExecutionOutput> {
+    let settings = match settings {
+        Some(settings) => settings,
+        None => settings::load_settings(config.settings_path.as_deref().map(Path::new))?,
+    };
+    let formality = config.formal.trim().to_string();
+    if formality.is_empty() {
+        return Err(anyhow!("formality is empty"));
+    }
+    let registry = languages::LanguageRegistry::load()?;
+    let PreparedTranslator { translator, .. } =
+        prepare_translator(&config, settings, registry).await?;
+    let options = TranslateOptions {
+        lang: config.lang,
+        formality,
+        source_lang: config.source_lang,
+        slang: config.slang,
+    };
+    translator.exec_batch(&inputs, options).await
+}
+
+/// Translated attachment returned by `run_bytes`.
+#[derive(Debug, Clone)]
+pub struct BytesOutput {
+    pub bytes: Vec<u8>,
+    pub mime: String,
+    pub model: Option<String>,
+    pub usage: Option<ProviderUsage>,
+}
+
+/// Translates an in-memory attachment and returns the translated bytes.
+///
+/// Nothing is read from or written to disk for the attachment itself (no `--data` path, no
+/// `--out`, no history copy), so this path is not recorded in history. `attachment.mime` may be
+/// `auto`, in which case it is sniffed (falling back to LLM detection like `run`).
+pub async fn run_bytes(
+    mut config: Config,
+    settings: Option<settings::Settings>,
+    mut attachment: data::DataAttachment,
+) -> Result<BytesOutput> {
+    let mut settings = match settings {
+        Some(settings) => settings,
+        None => settings::load_settings(config.settings_path.as_deref().map(Path::new))?,
+    };
+    if let Some(model) = config.whisper_model.take()
+        && !model.trim().is_empty()
+    {
+        settings.whisper_model = Some(model);
+    }
+    let formality = config.formal.trim().to_string();
+    if formality.is_empty() {
+        return Err(anyhow!("formality is empty"));
+    }
+    if !config.extra_langs.is_empty() {
+        return Err(anyhow!(
+            "run_bytes translates into one language; use run with a --data path for several"
+        ));
+    }
+    let ocr_languages = resolve_ocr_languages(&settings, &config.source_lang, &[&config.lang])?;
+    let registry = languages::LanguageRegistry::load()?;
+    let PreparedTranslator { translator, .. } =
+        prepare_translator(&config, settings, registry).await?;
+
+    let needs_mime_detection = match data::resolve_mime_for_bytes(
+        &attachment.bytes,
+        Some(attachment.mime.as_str()),
+        attachment.name.as_deref(),
+    ) {
+        Ok(mime) => {
+            attachment.mime = mime;
+            false
+        }
+        Err(err) => {
+            if !attachment.mime.trim().eq_ignore_ascii_case("auto") {
+                return Err(err);
+            }
+            attachment.mime = data::OCTET_STREAM_MIME.to_string();
+            true
+        }
+    };
+    if needs_mime_detection {
+        detect_attachment_mime(&mut attachment, &translator, config.force_translation).await?;
+    }
+
+    let options = TranslateOptions {
+        lang: config.lang,
+        formality,
+        source_lang: config.source_lang,
+        slang: config.slang,
+    };
+    info!("translating attachment: {}", attachment.mime);
+    if let Some(output) = attachments::translate_attachment(
+        &attachment,
+        &ocr_languages,
+        &translator,
+        &options,
+        config.with_commentout,
+        config.debug_ocr,
+        config.force_translation,
+        None,
+    )
+    .await?
+    {
+        return Ok(BytesOutput {
+            bytes: output.bytes,
+            mime: output.mime,
+            model: output.model,
+            usage: output.usage,
+        });
+    }
+
+    let text = format!("Translate the attached file into {}.", options.lang);
+    let execution = translator
+        .exec_with_data(
+            TranslationInput {
+                text,
+                data: Some(attachment),
+            },
+            options,
+        )
+        .await?;
+    Ok(BytesOutput {
+        bytes: execution.text.into_bytes(),
+        mime: data::TEXT_MIME.to_string(),
+        model: execution.model,
+        usage: execution.usage,
+    })
+}
+
+pub(crate) struct PreparedTranslator {
+    pub(crate) translator: Translator<providers::ProviderImpl>,
+    pub(crate) provider: ProviderKind,
+    pub(crate) model: String,
+}
+
+/// Resolves provider, key and model for `config` and builds the translator.
+pub(crate) async fn prepare_translator(
+    config: &Config,
+    settings: settings::Settings,
+    registry: languages::LanguageRegistry,
+) -> Result<PreparedTranslator> {
+    providers::http::configure(&settings);
+    providers::scheduler::configure(&settings);
+    let selection = if let Some(model_arg) = config.model.as_deref() {
+        info!("model requested: {}", model_arg);
+        providers::resolve_provider_selection(Some(model_arg), config.key.as_deref())?
+    } else {
+        match model_registry::get_last_using_model()? {
+            Some(last) => providers::resolve_provider_selection(Some(&last), config.key.as_deref())
+                .or_else(|_| providers::resolve_provider_selection(None, config.key.as_deref()))?,
+            None => providers::resolve_provider_selection(None, config.key.as_deref())?,
+        }
+    };
+    let key = providers::resolve_key(selection.provider, config.key.as_deref())
+        .with_context(|| "no API key found for selected provider")?;
+
+    let model = resolve_model(
+        selection.provider,
+        selection.requested_model.as_deref(),
+        &key,
+    )
+    .await
+    .with_context(|| "failed to resolve model")?;
+    info!(
+        "provider selected: {} (model={})",
+        selection.provider.as_str(),
+        model
+    );
+
+    validate_lang_codes(config, &registry)?;
+
+    model_registry::set_last_using_model(selection.provider, &model)?;
+    let provider = providers::build_provider(selection.provider, key, model.clone());
+    Ok(PreparedTranslator {
+        translator: Translator::new(provider, settings, registry).with_memory(&model),
+        provider: selection.provider,
+        model,
+    })
+}
+
 async fn run_with_loaded_settings(
     mut config: Config,
     mut settings: settings::Settings,
@@ -117,7 +351,8 @@ async fn run_with_loaded_settings(
     }
     let registry = languages::LanguageRegistry::load()?;
     let packs = languages::load_language_packs(&settings.system_languages)?;
-    let ocr_languages = resolve_ocr_languages(&settings, &config.source_lang, &config.lang)?;
+    let ocr_languages =
+        resolve_ocr_languages(&settings, &config.source_lang, &config.ocr_hint_langs())?;
     info!(
         "settings loaded (history_limit={}, ocr_languages={})",
         settings.history_limit, ocr_languages
@@ -221,6 +456,28 @@ async fn run_with_loaded_settings(
     if config.out_path.is_some() && !data_is_dir && data_attachment.is_none() {
         return Err(anyhow!("--out requires --data or stdin attachment"));
     }
+    let target_langs = config
+        .target_langs()
+        .into_iter()
+        .map(str::to_string)
+        .collect::<Vec<_>>();
+    if target_langs.len() > 1 {
+        if report_requested || config.pos || config.correction || config.details {
+            return Err(anyhow!(
+                "multiple target languages cannot be used with --report/--pos/--correction/--details"
+            ));
+        }
+        if data_is_dir || data_attachment.is_none() {
+            return Err(anyhow!(
+                "multiple target languages require a --data file or stdin attachment"
+            ));
+        }
+        if config.overwrite || config.out_path.is_some() {
+            return Err(anyhow!(
+                "--out/--overwrite cannot be used with multiple target languages"
+            ));
+        }
+    }
 
     let input = input.unwrap_or_default();
     let input = input.trim();
@@ -233,6 +490,7 @@ async fn run_with_loaded_settings(
     }
     let with_using_model = config.with_using_model;
     let with_using_tokens = config.with_using_tokens;
+    let skip_history_tags = config.skip_history_tags;
     let input_text = input.to_string();
     let history_limit = settings.history_limit;
     let translated_suffix = settings.translated_suffix.clone();
@@ -244,38 +502,11 @@ async fn run_with_loaded_settings(
         .max(1);
     let out_path = config.out_path.as_ref().map(PathBuf::from);
 
-    let selection = if let Some(model_arg) = config.model.as_deref() {
-        info!("model requested: {}", model_arg);
-        providers::resolve_provider_selection(Some(model_arg), config.key.as_deref())?
-    } else {
-        match model_registry::get_last_using_model()? {
-            Some(last) => providers::resolve_provider_selection(Some(&last), config.key.as_deref())
-                .or_else(|_| providers::resolve_provider_selection(None, config.key.as_deref()))?,
-            None => providers::resolve_provider_selection(None, config.key.as_deref())?,
-        }
-    };
-    let key = providers::resolve_key(selection.provider, config.key.as_deref())
-        .with_context(|| "no API key found for selected provider")?;
-
-    let model = resolve_model(
-        selection.provider,
-        selection.requested_model.as_deref(),
-        &key,
-    )
-    .await
-    .with_context(|| "failed to resolve model")?;
-    let history_model = model.clone();
-    info!(
-        "provider selected: {} (model={})",
-        selection.provider.as_str(),
-        history_model
-    );
-
-    validate_lang_codes(&config, &registry)?;
-
-    model_registry::set_last_using_model(selection.provider, &model)?;
-    let provider = providers::build_provider(selection.provider, key, model);
-    let translator = Translator::new(provider, settings, registry);
+    let PreparedTranslator {
+        translator,
+        provider: provider_kind,
+        model: history_model,
+    } = prepare_translator(&config, settings, registry).await?;
 
     let report_lang_hint = config.source_lang.clone();
     let options = TranslateOptions {
@@ -408,7 +639,7 @@ async fn run_with_loaded_settings(
             force_translation: config.force_translation,
             translated_suffix,
             backup_ttl_days,
-            provider: selection.provider,
+            provider: provider_kind,
             history_model,
             history_limit,
             directory_threads,
@@ -420,28 +651,33 @@ async fn run_with_loaded_settings(
     }
 
     if needs_mime_detection && let Some(attachment) = data_attachment.as_mut() {
-        let detection = attachments::detect_mime_with_llm(attachment, &translator).await?;
-        let normalized = data::normalize_mime_hint(&detection.mime);
-        if detection.confident {
-            if let Some(mime) = normalized {
-                attachment.mime = mime;
-            } else if config.force_translation {
-                attachment.mime = data::TEXT_MIME.to_string();
-            } else {
-                return Err(anyhow!(
-                    "unable to determine supported mime for '{}' (detected '{}'); use --force to treat as text",
-                    attachment.name.as_deref().unwrap_or("attachment"),
-                    detection.mime
-                ));
-            }
-        } else if config.force_translation {
-            attachment.mime = data::TEXT_MIME.to_string();
-        } else {
-            return Err(anyhow!(
-                "unable to determine mime for '{}' (low confidence); use --force to treat as text",
-                attachment.name.as_deref().unwrap_or("attachment")
-            ));
-        }
+        detect_attachment_mime(attachment, &translator, config.force_translation).await?;
+    }
+
+    if target_langs.len() > 1
+        && let Some(data) = data_attachment.as_ref()
+    {
+        let execution = translate_attachment_langs(LangsRequest {
+            data,
+            langs: &target_langs,
+            options: &options,
+            ocr_languages: &ocr_languages,
+            with_commentout: config.with_commentout,
+            debug_ocr: config.debug_ocr,
+            force_translation: config.force_translation,
+            src_path: history_src.as_deref().map(Path::new),
+            translated_suffix: &translated_suffix,
+            provider: provider_kind,
+            history_model: &history_model,
+            history_limit,
+            translator: &translator,
+        })
+        .await?;
+        return Ok(format_execution_output(
+            &execution,
+            with_using_model,
+            with_using_tokens,
+        ));
     }
 
     if let Some(data) = data_attachment.as_ref() {
@@ -490,20 +726,11 @@ async fn run_with_loaded_settings(
             } else {
                 PathBuf::from(&dest_path)
             };
-            let output_path = std::fs::canonicalize(&output_path).unwrap_or(output_path);
-            let output_text = if output.mime.starts_with("image/") {
-                let size_kb = output.bytes.len().div_ceil(1024);
-                format!("Created image {} ({}KB) !", output_path.display(), size_kb)
-            } else if output.mime.starts_with("audio/") {
-                let size_kb = output.bytes.len().div_ceil(1024);
-                format!("Created audio {} ({}KB) !", output_path.display(), size_kb)
-            } else {
-                output_path.to_string_lossy().to_string()
-            };
+            let output_text = describe_attachment_output(output_path, &output);
 
             let entry = model_registry::HistoryEntry {
                 datetime,
-                model: format!("{}:{}", selection.provider.as_str(), history_model),
+                model: format!("{}:{}", provider_kind.as_str(), history_model),
                 formal: Some(options.formality.clone()),
                 mime: output.mime.clone(),
                 kind: model_registry::HistoryType::Attachment,
@@ -545,56 +772,194 @@ async fn run_with_loaded_settings(
 
     let output = format_execution_output(&execution, with_using_model, with_using_tokens);
 
-    let tags = if attachment_mime.is_none() {
-        match history_tags::generate_history_tags(
-            &translator,
-            &input_text,
-            &options.source_lang,
-            &options.lang,
-        )
-        .await
-        {
-            Ok(result) => {
-                if (!result.categories.is_empty() || !result.keywords.is_empty())
-                    && let Err(err) =
-                        model_registry::update_trend(&result.categories, &result.keywords)
-                {
-                    warn!("failed to update trend meta: {}", err);
-                }
-                if result.tags.is_empty() {
-                    None
-                } else {
-                    Some(result.tags)
-                }
-            }
-            Err(err) => {
-                warn!("failed to generate history tags: {}", err);
-                None
-            }
-        }
-    } else {
-        None
-    };
-
-    if let Err(err) = record_history(HistoryRecordInput {
-        provider: selection.provider,
-        model: &history_model,
-        src_path: history_src.as_deref(),
-        history_limit,
-        input_text: &input_text,
-        attachment_mime: attachment_mime.as_deref(),
-        output_text: &execution.text,
-        source_lang: &options.source_lang,
-        target_lang: &options.lang,
-        formal: &options.formality,
-        tags,
-    }) {
+    if let Err(err) = record_translation(
+        &translator,
+        HistoryRecordInput {
+            provider: provider_kind,
+            model: &history_model,
+            src_path: history_src.as_deref(),
+            history_limit,
+            input_text: &input_text,
+            attachment_mime: attachment_mime.as_deref(),
+            output_text: &execution.text,
+            source_lang: &options.source_lang,
+            target_lang: &options.lang,
+            formal: &options.formality,
+            tags: None,
+        },
+        skip_history_tags,
+    ) {
         eprintln!("warning: failed to record history: {}", err);
     }
 
     Ok(output)
 }
 
+/// Canonical path of a written attachment, with its size for images and audio.
+fn describe_attachment_output(
+    output_path: PathBuf,
+    output: &attachments::AttachmentTranslation,
+) -> String {
+    let output_path = std::fs::canonicalize(&output_path).unwrap_or(output_path);
+    if output.mime.starts_with("image/") {
+        let size_kb = output.bytes.len().div_ceil(1024);
+        format!("Created image {} ({}KB) !", output_path.display(), size_kb)
+    } else if output.mime.starts_with("audio/") {
+        let size_kb = output.bytes.len().div_ceil(1024);
+        format!("Created audio {} ({}KB) !", output_path.display(), size_kb)
+    } else {
+        output_path.to_string_lossy().to_string()
+    }
+}
+
+struct LangsRequest<'a, P: Provider + Clone> {
+    data: &'a data::DataAttachment,
+    langs: &'a [String],
+    options: &'a TranslateOptions,
+    ocr_languages: &'a str,
+    with_commentout: bool,
+    debug_ocr: bool,
+    force_translation: bool,
+    src_path: Option<&'a Path>,
+    translated_suffix: &'a str,
+    provider: ProviderKind,
+    history_model: &'a str,
+    history_limit: usize,
+    translator: &'a Translator<P>,
+}
+
+/// Translates one attachment into every language of `langs` concurrently. The input is
+/// read and its MIME resolved once by the caller; OCR and transcription results are shared
+/// between the languages, so only translation and output encoding run once per language.
+///
+/// Each output goes next to the source as `<stem><suffix>_<lang>.<ext>` (stdin attachments
+/// only get their history copy), and the result lists one line per language.
+async fn translate_attachment_langs<P: Provider + Clone>(
+    request: LangsRequest<'_, P>,
+) -> Result<ExecutionOutput> {
+    let data = request.data;
+    info!(
+        "translating attachment into {} languages: {}",
+        request.langs.len(),
+        data.mime
+    );
+    let outputs = attachments::share_extraction(future::try_join_all(request.langs.iter().map(
+        |lang| async move {
+            let options = TranslateOptions {
+                lang: lang.clone(),
+                ..request.options.clone()
+            };
+            let output = attachments::translate_attachment(
+                data,
+                request.ocr_languages,
+                request.translator,
+                &options,
+                request.with_commentout,
+                request.debug_ocr,
+                request.force_translation,
+                request.src_path,
+            )
+            .await?
+            .ok_or_else(|| {
+                anyhow!(
+                    "multiple target languages are not supported for '{}'",
+                    data.mime
+                )
+            })?;
+            Ok::<_, anyhow::Error>((options, output))
+        },
+    )))
+    .await?;
+
+    let mut lines = Vec::with_capacity(outputs.len());
+    let mut model = None;
+    let mut usage: Option<ProviderUsage> = None;
+    for (options, output) in outputs {
+        let datetime = SystemTime::now()
+            .duration_since(UNIX_EPOCH)
+            .unwrap_or_default()
+            .as_secs()
+            .to_string();
+        let dest_path = model_registry::write_history_dest_bytes(&output.bytes, &datetime)?;
+        let output_path = if let Some(src_path) = request.src_path {
+            let suffix = format!("{}_{}", request.translated_suffix, options.lang);
+            let translated = translated_output_path(src_path, &output.mime, &suffix)?;
+            fs::write(&translated, &output.bytes)
+                .with_context(|| "failed to write translated file")?;
+            translated
+        } else {
+            PathBuf::from(&dest_path)
+        };
+        lines.push(format!(
+            "{}: {}",
+            options.lang,
+            describe_attachment_output(output_path, &output)
+        ));
+
+        let entry = model_registry::HistoryEntry {
+            datetime,
+            model: format!("{}:{}", request.provider.as_str(), request.history_model),
+            formal: Some(options.formality.clone()),
+            mime: output.mime.clone(),
+            kind: model_registry::HistoryType::Attachment,
+            source_language: normalize_lang_for_history(&options.source_lang),
+            target_language: normalize_lang_for_history(&options.lang),
+            tags: None,
+            src: request
+                .src_path
+                .map(|path| path.to_string_lossy().to_string())
+                .unwrap_or_else(|| "stdin".to_string()),
+            dest: dest_path,
+        };
+        if let Err(err) = model_registry::record_history(entry, request.history_limit) {
+            warn!("failed to record history: {}", err);
+        }
+
+        if model.is_none() {
+            model = output.model;
+        }
+        usage = match usage {
+            Some(total) => Some(providers::merge_usage(total, output.usage)),
+            None => output.usage,
+        };
+    }
+    Ok(ExecutionOutput {
+        text: lines.join("\n"),
+        model,
+        usage,
+    })
+}
+
+async fn detect_attachment_mime<P: Provider + Clone>(
+    attachment: &mut data::DataAttachment,
+    translator: &Translator<P>,
+    force_translation: bool,
+) -> Result<()> {
+    let detection = attachments::detect_mime_with_llm(attachment, translator).await?;
+    let normalized = data::normalize_mime_hint(&detection.mime);
+    if detection.confident {
+        if let Some(mime) = normalized {
+            attachment.mime = mime;
+        } else if force_translation {
+            attachment.mime = data::TEXT_MIME.to_string();
+        } else {
+            return Err(anyhow!(
+                "unable to determine supported mime for '{}' (detected '{}'); use --force to treat as text",
+                attachment.name.as_deref().unwrap_or("attachment"),
+                detection.mime
+            ));
+        }
+    } else if force_translation {
+        attachment.mime = data::TEXT_MIME.to_string();
+    } else {
+        return Err(anyhow!(
+            "unable to determine mime for '{}' (low confidence); use --force to treat as text",
+            attachment.name.as_deref().unwrap_or("attachment")
+        ));
+    }
+    Ok(())
+}
+
 fn translated_output_path(src: &Path, mime: &str, suffix: &str) -> Result<PathBuf> {
     let ext = data::extension_from_mime(mime)
         .ok_or_else(|| anyhow!("unsupported output mime '{}'", mime))?;
@@ -668,29 +1033,6 @@ fn resolve_out_path(
     Ok(out.to_path_buf())
 }
 
-fn collect_directory_files(root: &Path) -> Result<Vec<PathBuf>> {
-    let mut files = Vec::new();
-    let mut stack = vec![root.to_path_buf()];
-    while let Some(dir) = stack.pop() {
-        let entries = fs::read_dir(&dir)
-            .with_context(|| format!("failed to read directory: {}", dir.display()))?;
-        for entry in entries {
-            let entry = entry.with_context(|| "failed to read directory entry")?;
-            let path = entry.path();
-            let file_type = entry
-                .file_type()
-                .with_context(|| "failed to read file type")?;
-            if file_type.is_dir() {
-                stack.push(path);
-            } else if file_type.is_file() {
-                files.push(path);
-            }
-        }
-    }
-    files.sort();
-    Ok(files)
-}
-
 fn build_translation_ignore(
     src_dir: &Path,
     ignore_file_name: &str,
@@ -751,14 +1093,15 @@ struct DirTranslateShared {
     provider: ProviderKind,
     history_model: String,
     history_limit: usize,
-    ignore: Option<TranslationIgnore>,
-    meta_lock: Arc<Mutex<()>>,
+    manifest: Option<DirManifest>,
+    backup_lock: Arc<Mutex<()>>,
 }
 
 enum DirItemStatus {
     Translated,
     Copied,
     Skipped,
+    Unchanged,
     Failed,
 }
 
@@ -787,20 +1130,23 @@ async fn translate_data_dir<P: Provider + Clone>(
             .with_context(|| format!("failed to create output dir: {}", dir.display()))?;
     }
 
-    let files = collect_directory_files(src_dir)?;
-    if files.is_empty() {
-        let message = if let Some(dir) = output_dir.as_ref() {
-            let output_dir = std::fs::canonicalize(dir).unwrap_or_else(|_| dir.to_path_buf());
-            format!(
-                "No files found in {} (output dir: {})",
-                src_dir.display(),
-                output_dir.display()
-            )
-        } else {
-            format!("No files found in {}", src_dir.display())
-        };
-        return Ok(message);
-    }
+    let manifest_root = output_dir.as_deref().unwrap_or(src_dir);
+    let manifest = match DirManifest::open(
+        src_dir,
+        manifest_root,
+        dir_options_hash(&config, translator),
+    ) {
+        Ok(value) => Some(value),
+        Err(err) => {
+            warn!("directory manifest disabled: {}", err);
+            None
+        }
+    };
+    // Outputs written under the source directory are not walked as inputs.
+    let mut exclude = Vec::new();
+    exclude.extend(output_dir.as_deref());
+    exclude.extend(manifest.as_ref().map(DirManifest::manifest_path));
+    let walk = dir_walk::walk_files(src_dir, config.ignore, &exclude)?;
 
     let shared = Arc::new(DirTranslateShared {
         src_dir: src_dir.to_path_buf(),
@@ -816,24 +1162,56 @@ async fn translate_data_dir<P: Provider + Clone>(
         provider: config.provider,
         history_model: config.history_model,
         history_limit: config.history_limit,
-        ignore: config.ignore,
-        meta_lock: Arc::new(Mutex::new(())),
+        manifest,
+        backup_lock: Arc::new(Mutex::new(())),
     });
 
+    // Files are processed as the walk finds them; the list is kept for the manifest.
     let concurrency = config.directory_threads.max(1);
-    let results: Vec<DirItemResult> = stream::iter(files)
-        .map(|path| {
+    let mut files: Vec<PathBuf> = Vec::new();
+    let mut walk_failed = false;
+    let results: Vec<DirItemResult> = walk
+        .map(|entry| {
             let translator = translator.clone();
             let shared = shared.clone();
-            async move { process_dir_file(path, translator, shared).await }
+            match &entry {
+                Ok(file) => files.push(file.path.clone()),
+                Err(_) => walk_failed = true,
+            }
+            async move {
+                match entry {
+                    Ok(file) => {
+                        providers::scheduler::bulk(process_dir_file(file, translator, shared)).await
+                    }
+                    Err(err) => DirItemResult {
+                        status: DirItemStatus::Failed,
+                        message: Some(err.to_string()),
+                    },
+                }
+            }
         })
         .buffer_unordered(concurrency)
         .collect()
         .await;
 
+    if results.is_empty() {
+        let message = if let Some(dir) = shared.output_dir.as_ref() {
+            let output_dir = std::fs::canonicalize(dir).unwrap_or_else(|_| dir.to_path_buf());
+            format!(
+                "No files found in {} (output dir: {})",
+                src_dir.display(),
+                output_dir.display()
+            )
+        } else {
+            format!("No files found in {}", src_dir.display())
+        };
+        return Ok(message);
+    }
+
     let mut translated = 0usize;
     let mut copied = 0usize;
     let mut skipped = 0usize;
+    let mut unchanged = 0usize;
     let mut failed = 0usize;
     let mut failures: Vec<String> = Vec::new();
 
@@ -842,6 +1220,7 @@ async fn translate_data_dir<P: Provider + Clone>(
             DirItemStatus::Translated => translated += 1,
             DirItemStatus::Copied => copied += 1,
             DirItemStatus::Skipped => skipped += 1,
+            DirItemStatus::Unchanged => unchanged += 1,
             DirItemStatus::Failed => failed += 1,
         }
         if let Some(message) = result.message {
@@ -858,13 +1237,21 @@ async fn translate_data_dir<P: Provider + Clone>(
         let backup_dir = backup::backup_dir();
         lines.push(format!("backup dir: {}", backup_dir.display()));
     }
+    // An incomplete walk would drop the entries of every file it did not reach.
+    if !walk_failed
+        && let Some(manifest) = shared.manifest.as_ref()
+        && let Err(err) = manifest.finish(&files)
+    {
+        warn!("failed to compact directory manifest: {}", err);
+    }
     lines.push(format!(
-        "files: {} translated, {} copied, {} skipped, {} failed (total {})",
+        "files: {} translated, {} copied, {} skipped, {} unchanged, {} failed (total {})",
         translated,
         copied,
         skipped,
+        unchanged,
         failed,
-        translated + copied + skipped + failed
+        translated + copied + skipped + unchanged + failed
     ));
     if !failures.is_empty() {
         lines.push("failures:".to_string());
@@ -880,18 +1267,80 @@ async fn translate_data_dir<P: Provider + Clone>(
     Ok(lines.join("\n"))
 }
 
+/// Everything that changes what a directory run would write for an unchanged source file.
+fn dir_options_hash<P: Provider + Clone>(
+    config: &DirTranslateConfig,
+    translator: &Translator<P>,
+) -> String {
+    let options = &config.options;
+    let flags = [
+        options.slang,
+        config.with_commentout,
+        config.force_translation,
+        translator.settings().ocr_normalize,
+    ]
+    .map(|flag| if flag { "1" } else { "0" })
+    .concat();
+    let fields = [
+        "v1",
+        config.provider.as_str(),
+        config.history_model.as_str(),
+        options.lang.as_str(),
+        options.formality.as_str(),
+        options.source_lang.as_str(),
+        config.mime_hint.as_deref().unwrap_or("auto"),
+        config.ocr_languages.as_str(),
+        flags.as_str(),
+        config
+            .ignore
+            .as_ref()
+            .map(TranslationIgnore::digest)
+            .unwrap_or(""),
+    ];
+    format!("{:x}", md5::compute(fields.join("\0").as_bytes()))
+}
+
 async fn process_dir_file<P: Provider + Clone>(
-    path: PathBuf,
+    file: dir_walk::WalkedFile,
     translator: Translator<P>,
     shared: Arc<DirTranslateShared>,
 ) -> DirItemResult {
-    if let Some(ignore) = &shared.ignore
-        && ignore.is_ignored(&path)
-    {
+    let path = file.path;
+    let unchanged = || {
+        shared
+            .manifest
+            .as_ref()
+            .is_some_and(|manifest| manifest.is_unchanged(&path))
+    };
+    // Ignore rules are checked first, so a file translated before it was ignored is copied
+    // instead of keeping its translation. The rules are part of the manifest options, so an
+    // unchanged entry for an ignored file means it was already copied under the same rules.
+    if file.ignored {
+        if unchanged() {
+            return DirItemResult {
+                status: DirItemStatus::Unchanged,
+                message: None,
+            };
+        }
         return copy_or_skip(&path, &shared, None);
     }
+    if unchanged() {
+        return DirItemResult {
+            status: DirItemStatus::Unchanged,
+            message: None,
+        };
+    }
 
-    let attachment = match data::load_attachment(&path, shared.mime_hint.as_deref()) {
+    // The mime comes from the file's first few KB; files without a translator are copied
+    // without ever being read whole.
+    let resolved = data::resolve_file_mime(&path, shared.mime_hint.as_deref());
+    if let Ok(mime) = resolved.as_ref()
+        && !attachments::supports_mime(mime)
+    {
+        return copy_or_skip(&path, &shared, None);
+    }
+    let loaded = resolved.and_then(|mime| data::load_attachment_with_mime(&path, mime));
+    let attachment = match loaded {
         Ok(value) => value,
         Err(err) => {
             let mime_hint = shared.mime_hint.as_deref().unwrap_or("auto");
@@ -972,7 +1421,7 @@ async fn process_dir_file<P: Provider + Clone>(
     };
 
     let output_path = if shared.overwrite {
-        let guard = shared.meta_lock.lock().await;
+        let guard = shared.backup_lock.lock().await;
         if let Err(err) = backup::backup_file(&path, shared.backup_ttl_days) {
             drop(guard);
             return copy_or_skip(&path, &shared, Some(anyhow!("backup failed: {}", err)));
@@ -1024,6 +1473,9 @@ async fn process_dir_file<P: Provider + Clone>(
             )),
         };
     }
+    if let Some(manifest) = shared.manifest.as_ref() {
+        manifest.record(&path, Some(&output_path), Some(&output.bytes));
+    }
 
     let datetime = SystemTime::now()
         .duration_since(UNIX_EPOCH)
@@ -1044,11 +1496,9 @@ async fn process_dir_file<P: Provider + Clone>(
                 src: path.to_string_lossy().to_string(),
                 dest: dest_path,
             };
-            let guard = shared.meta_lock.lock().await;
             if let Err(err) = model_registry::record_history(entry, shared.history_limit) {
                 warn!("failed to record history: {}", err);
             }
-            drop(guard);
         }
         Err(err) => {
             warn!("failed to write history output: {}", err);
@@ -1091,6 +1541,11 @@ fn copy_or_skip(
                         )),
                     };
                 }
+                if err.is_none()
+                    && let Some(manifest) = shared.manifest.as_ref()
+                {
+                    manifest.record(path, Some(&dest), None);
+                }
                 return DirItemResult {
                     status: if err.is_some() {
                         DirItemStatus::Failed
@@ -1109,6 +1564,11 @@ fn copy_or_skip(
         }
     }
 
+    if err.is_none()
+        && let Some(manifest) = shared.manifest.as_ref()
+    {
+        manifest.record(path, None, None);
+    }
     DirItemResult {
         status: if err.is_some() {
             DirItemStatus::Failed
@@ -1224,7 +1684,23 @@ pub(crate) struct HistoryRecordInput<'a> {
     tags: Option<Vec<String>>,
 }
 
-pub(crate) fn record_history(input: HistoryRecordInput<'_>) -> Result<()> {
+/// Records a finished translation in the history and, for text input, queues tag generation
+/// for it unless `skip_tags`. The CLI, the engine handle and the server all go through here.
+pub(crate) fn record_translation(
+    translator: &Translator<providers::ProviderImpl>,
+    input: HistoryRecordInput<'_>,
+    skip_tags: bool,
+) -> Result<()> {
+    let tag_text = (input.attachment_mime.is_none() && !skip_tags).then_some(input.input_text);
+    let entry = record_history(input)?;
+    if let Some(text) = tag_text {
+        history_tags::enqueue(translator, entry, text);
+    }
+    Ok(())
+}
+
+/// Appends the translation to the history log and returns the recorded entry.
+fn record_history(input: HistoryRecordInput<'_>) -> Result<model_registry::HistoryEntry> {
     let datetime = SystemTime::now()
         .duration_since(UNIX_EPOCH)
         .unwrap_or_default()
@@ -1264,7 +1740,8 @@ pub(crate) fn record_history(input: HistoryRecordInput<'_>) -> Result<()> {
         src,
         dest,
     };
-    model_registry::record_history(entry, input.history_limit)
+    model_registry::record_history(entry.clone(), input.history_limit)?;
+    Ok(entry)
 }
 
 pub(crate) fn normalize_lang_for_history(value: &str) -> Option<String> {
@@ -1288,7 +1765,7 @@ pub(crate) fn normalize_formality_for_history(value: &str) -> Option<String> {
 pub(crate) fn resolve_ocr_languages(
     _settings: &settings::Settings,
     source_lang: &str,
-    target_lang: &str,
+    target_langs: &[&str],
 ) -> Result<String> {
     let mut langs = Vec::new();
     let source_trimmed = source_lang.trim();
@@ -1302,12 +1779,14 @@ pub(crate) fn resolve_ocr_languages(
             langs.push(source_trimmed.to_string());
         }
     }
-    let target_trimmed = target_lang.trim();
-    if !target_trimmed.is_empty() {
-        if let Some(mapped) = map_lang_to_tesseract(target_trimmed) {
-            langs.push(mapped.to_string());
-        } else {
-            langs.push(target_trimmed.to_string());
+    for target_lang in target_langs {
+        let target_trimmed = target_lang.trim();
+        if !target_trimmed.is_empty() {
+            if let Some(mapped) = map_lang_to_tesseract(target_trimmed) {
+                langs.push(mapped.to_string());
+            } else {
+                langs.push(target_trimmed.to_string());
+            }
         }
     }
 
@@ -1399,6 +1878,13 @@ fn format_execution_output(
     if with_using_tokens {
         let tokens = format_usage(execution.usage.as_ref());
         meta_lines.push(tokens);
+        let memory = translation_memory::stats();
+        if memory.hits + memory.misses > 0 {
+            meta_lines.push(format!(
+                "memory: hits={} misses={}",
+                memory.hits, memory.misses
+            ));
+        }
     }
 
     if !meta_lines.is_empty() {
@@ -1532,11 +2018,13 @@ pub(crate) fn validate_lang_codes(
         ));
     }
 
-    if !is_valid_lang_code(&config.lang, registry) {
-        return Err(anyhow!(
-            "invalid target language code '{}' (expected ISO 639-1/2/3 code or zho-hans/zho-hant)",
-            config.lang
-        ));
+    for lang in std::iter::once(&config.lang).chain(&config.extra_langs) {
+        if !is_valid_lang_code(lang, registry) {
+            return Err(anyhow!(
+                "invalid target language code '{}' (expected ISO 639-1/2/3 code or zho-hans/zho-hant)",
+                lang
+            ));
+        }
     }
     Ok(())
 }
@@ -11,7 +11,7 @@ use clap::{Parser, ValueEnum};
     about = "Translate text using LLM tool calls"
 )]
 struct Cli {
-    /// Target language (default: en)
+    /// Target language (default: en); comma-separated for several with --data
     #[arg(short = 'l', long = "lang", default_value = "en")]
     lang: String,
 
@@ -139,6 +139,10 @@ struct Cli {
     #[arg(long = "whisper-model")]
     whisper_model: Option<String>,
 
+    /// Do not generate tags for the history entry of this translation
+    #[arg(long = "no-history-tags")]
+    no_history_tags: bool,
+
     /// Start HTTP server (default: settings or 0.0.0.0:11223)
     #[arg(long = "server", value_name = "ADDR", num_args = 0..=1, default_missing_value = "__settings__")]
     server: Option<String>,
@@ -267,9 +271,11 @@ async fn main() -> Result<()> {
         }
     }
 
+    let (lang, extra_langs) = split_langs(&cli.lang);
     let output = llm_translator_rust::run(
         llm_translator_rust::Config {
-            lang: cli.lang,
+            lang,
+            extra_langs,
             model: cli.model,
             key: cli.key,
             formal: cli.formal,
@@ -305,15 +311,28 @@ async fn main() -> Result<()> {
             force_translation: cli.force_translation,
             verbose: cli.verbose,
             whisper_model: cli.whisper_model,
+            skip_history_tags: cli.no_history_tags,
         },
         input,
     )
     .await?;
 
     println!("{}", output);
+    llm_translator_rust::flush_history_tags().await;
     Ok(())
 }
 
+/// Splits `--lang ja,fr,de` into the first target and the rest.
+fn split_langs(value: &str) -> (String, Vec<String>) {
+    let mut langs = value
+        .split(',')
+        .map(str::trim)
+        .filter(|lang| !lang.is_empty())
+        .map(str::to_string);
+    let lang = langs.next().unwrap_or_default();
+    (lang, langs.collect())
+}
+
 struct InteractiveState {
     config: llm_translator_rust::Config,
 }
@@ -322,9 +341,11 @@ const SERVER_DEFAULT_SENTINEL: &str = "__settings__";
 
 impl InteractiveState {
     fn new(cli: &Cli) -> Self {
+        let (lang, extra_langs) = split_langs(&cli.lang);
         Self {
             config: llm_translator_rust::Config {
-                lang: cli.lang.clone(),
+                lang,
+                extra_langs,
                 model: cli.model.clone(),
                 key: cli.key.clone(),
                 formal: cli.formal.clone(),
@@ -360,6 +381,7 @@ impl InteractiveState {
                 force_translation: cli.force_translation,
                 verbose: cli.verbose,
                 whisper_model: cli.whisper_model.clone(),
+                skip_history_tags: cli.no_history_tags,
             },
         }
     }
@@ -568,6 +590,7 @@ async fn run_interactive(cli: Cli) -> Result<()> {
             llm_translator_rust::run(state.config_for_run(), Some(input.to_string())).await?;
         println!("{}", output);
     }
+    llm_translator_rust::flush_history_tags().await;
     Ok(())
 }
 
@@ -687,9 +710,9 @@ async fn handle_interactive_command(input: &str, state: &mut InteractiveState) -
     if let Some(arg) = trimmed.strip_prefix("/lang") {
         let value = arg.trim();
         if value.is_empty() {
-            println!("lang: {}", state.config.lang);
+            println!("lang: {}", state.config.target_langs().join(","));
         } else {
-            state.config.lang = value.to_string();
+            (state.config.lang, state.config.extra_langs) = split_langs(value);
             println!("lang set to {}", value);
         }
         return Ok(false);
@@ -863,9 +886,18 @@ fn print_interactive_help() {
 
 #[cfg(test)]
 mod tests {
-    use super::{Cli, ReportFormatArg};
+    use super::{Cli, ReportFormatArg, split_langs};
     use clap::Parser;
 
+    #[test]
+    fn lang_list_splits_into_first_and_extra_targets() {
+        assert_eq!(split_langs("ja"), ("ja".to_string(), Vec::new()));
+        assert_eq!(
+            split_langs(" ja, fr ,,de"),
+            ("ja".to_string(), vec!["fr".to_string(), "de".to_string()])
+        );
+    }
+
     #[test]
     fn cli_defaults() {
         let cli = Cli::parse_from(["llm-translator-rust"]);
@@ -901,6 +933,7 @@ mod tests {
         assert!(!cli.verbose);
         assert!(!cli.interactive);
         assert!(cli.whisper_model.is_none());
+        assert!(!cli.no_history_tags);
         assert!(cli.server.is_none());
         assert!(cli.client.is_none());
         assert!(!cli.mcp);
@@ -261,6 +261,7 @@ impl McpDefaults {
     fn base_config(&self) -> Config {
         Config {
             lang: self.lang.clone(),
+            extra_langs: Vec::new(),
             model: self.model.clone(),
             key: self.key.clone(),
             formal: self.formal.clone(),
@@ -293,6 +294,7 @@ impl McpDefaults {
             debug_ocr: false,
             verbose: false,
             whisper_model: None,
+            skip_history_tags: false,
         }
     }
 }
@@ -0,0 +1,431 @@
+use std::collections::BTreeMap;
+use std::fmt::Write;
+use std::sync::Mutex;
+use std::time::Instant;
+
+use serde_json::{Value, json};
+
+use crate::providers::ProviderUsage;
+use crate::util::lock;
+use crate::{response_cache, translation_memory};
+
+/// Seconds, from a fast cache-warm call to a long document page.
+const LATENCY_BUCKETS: &[f64] = &[0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0, 60.0, 120.0];
+const RENDER_BUCKETS: &[f64] = &[0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5];
+/// Whisper wall time per second of audio; below 1.0 is faster than real time.
+const REALTIME_BUCKETS: &[f64] = &[0.05, 0.1, 0.25, 0.5, 1.0, 2.0, 5.0];
+
+pub(crate) struct Metric {
+    name: &'static str,
+    help: &'static str,
+    kind: Kind,
+}
+
+#[derive(Clone, Copy)]
+enum Kind {
+    Counter,
+    Gauge,
+    Histogram(&'static [f64]),
+}
+
+pub(crate) static PROVIDER_LATENCY: Metric = Metric {
+    name: "llm_provider_request_duration_seconds",
+    help: "Provider HTTP call latency, excluding time queued by the rate limiter.",
+    kind: Kind::Histogram(LATENCY_BUCKETS),
+};
+pub(crate) static PROVIDER_TOKENS: Metric = Metric {
+    name: "llm_provider_tokens_total",
+    help: "Tokens reported by providers, by kind (prompt or completion).",
+    kind: Kind::Counter,
+};
+pub(crate) static PROVIDER_RATE_LIMITED: Metric = Metric {
+    name: "llm_provider_rate_limited_total",
+    help: "Rate-limit (429/503) responses from providers.",
+    kind: Kind::Counter,
+};
+pub(crate) static PROVIDER_QUEUE_DEPTH: Metric = Metric {
+    name: "llm_provider_queue_depth",
+    help: "Calls waiting for a rate-limiter slot.",
+    kind: Kind::Gauge,
+};
+pub(crate) static PROMPT_RENDER: Metric = Metric {
+    name: "llm_prompt_render_duration_seconds",
+    help: "Time spent rendering system prompts.",
+    kind: Kind::Histogram(RENDER_BUCKETS),
+};
+pub(crate) static OCR_PAGE: Metric = Metric {
+    name: "llm_ocr_page_duration_seconds",
+    help: "OCR time per page or image.",
+    kind: Kind::Histogram(LATENCY_BUCKETS),
+};
+pub(crate) static WHISPER_REALTIME: Metric = Metric {
+    name: "llm_whisper_seconds_per_audio_second",
+    help: "Whisper transcription time per second of audio.",
+    kind: Kind::Histogram(REALTIME_BUCKETS),
+};
+
+type Labels = Vec<(&'static str, String)>;
+
+enum Series {
+    Counter(u64),
+    Gauge(i64),
+    Histogram {
+        buckets: Vec<u64>,
+        sum: f64,
+        count: u64,
+    },
+}
+
+struct Family {
+    metric: &'static Metric,
+    series: BTreeMap<Labels, Series>,
+}
+
+/// Families keyed by metric name, so the exposition output is stable between scrapes.
+static REGISTRY: Mutex<BTreeMap<&'static str, Family>> = Mutex::new(BTreeMap::new());
+
+fn update(
+    metric: &'static Metric,
+    labels: &[(&'static str, &str)],
+    apply: impl FnOnce(&mut Series),
+) {
+    let labels = labels
+        .iter()
+        .map(|(key, value)| (*key, value.to_string()))
+        .collect::<Labels>();
+    let mut registry = lock(&REGISTRY);
+    let family = registry.entry(metric.name).or_insert_with(|| Family {
+        metric,
+        series: BTreeMap::new(),
+    });
+    let series = family
+        .series
+        .entry(labels)
+        .or_insert_with(|| match metric.kind {
+            Kind::Counter => Series::Counter(0),
+            Kind::Gauge => Series::Gauge(0),
+            Kind::Histogram(bounds) => Series::Histogram {
+                buckets: vec![0; bounds.len()],
+                sum: 0.0,
+                count: 0,
+            },
+        });
+    apply(series);
+}
+
+pub(crate) fn add(metric: &'static Metric, labels: &[(&'static str, &str)], value: u64) {
+    update(metric, labels, |series| {
+        if let Series::Counter(total) = series {
+            *total += value;
+        }
+    });
+}
+
+pub(crate) fn gauge_add(metric: &'static Metric, labels: &[(&'static str, &str)], delta: i64) {
+    update(metric, labels, |series| {
+        if let Series::Gauge(current) = series {
+            *current += delta;
+        }
+    });
+}
+
+pub(crate) fn observe(metric: &'static Metric, labels: &[(&'static str, &str)], value: f64) {
+    let Kind::Histogram(bounds) = metric.kind else {
+        return;
+    };
+    update(metric, labels, |series| {
+        if let Series::Histogram {
+            buckets,
+            sum,
+            count,
+        } = series
+        {
+            for (bucket, bound) in buckets.iter_mut().zip(bounds) {
+                if value <= *bound {
+                    *bucket += 1;
+                }
+            }
+            *sum += value;
+            *count += 1;
+        }
+    });
+}
+
+/// Runs `f` and records its wall time in seconds.
+pub(crate) fn time<T>(
+    metric: &'static Metric,
+    labels: &[(&'static str, &str)],
+    f: impl FnOnce() -> T,
+) -> T {
+    let started = Instant::now();
+    let result = f();
+    observe(metric, labels, started.elapsed().as_secs_f64());
+    result
+}
+
+pub(crate) fn record_usage(provider: &str, model: Option<&str>, usage: Option<&ProviderUsage>) {
+    let Some(usage) = usage else {
+        return;
+    };
+    let model = model.unwrap_or("unknown");
+    for (kind, tokens) in [
+        ("prompt", usage.prompt_tokens),
+        ("completion", usage.completion_tokens),
+    ] {
+        if let Some(tokens) = tokens {
+            add(
+                &PROVIDER_TOKENS,
+                &[("provider", provider), ("model", model), ("kind", kind)],
+                tokens,
+            );
+        }
+    }
+}
+
+/// Cache metrics kept by their own modules, derived from one read of their counters and
+/// exported as `(name, help, type, value)` by both the Prometheus and the JSON output.
+fn cache_metrics() -> Vec<(&'static str, &'static str, &'static str, Value)> {
+    let cache = response_cache::stats();
+    let memory = translation_memory::stats();
+    vec![
+        (
+            "llm_response_cache_hits_total",
+            "In-process response cache hits.",
+            "counter",
+            Value::from(cache.hits),
+        ),
+        (
+            "llm_response_cache_misses_total",
+            "In-process response cache misses.",
+            "counter",
+            Value::from(cache.misses),
+        ),
+        (
+            "llm_response_cache_coalesced_total",
+            "Requests that shared an identical in-flight provider call.",
+            "counter",
+            Value::from(cache.coalesced),
+        ),
+        (
+            "llm_translation_memory_hits_total",
+            "Persistent translation memory hits.",
+            "counter",
+            Value::from(memory.hits),
+        ),
+        (
+            "llm_translation_memory_misses_total",
+            "Persistent translation memory misses.",
+            "counter",
+            Value::from(memory.misses),
+        ),
+        (
+            "llm_response_cache_hit_ratio",
+            "Response cache hits over lookups since start-up.",
+            "gauge",
+            Value::from(hit_ratio(cache.hits, cache.misses)),
+        ),
+        (
+            "llm_translation_memory_hit_ratio",
+            "Translation memory hits over lookups since start-up.",
+            "gauge",
+            Value::from(hit_ratio(memory.hits, memory.misses)),
+        ),
+    ]
+}
+
+fn hit_ratio(hits: u64, misses: u64) -> f64 {
+    match hits + misses {
+        0 => 0.0,
+        total => hits as f64 / total as f64,
+    }
+}
+
+/// Prometheus text exposition format (0.0.4), served on `GET /metrics`.
+pub fn render_prometheus() -> String {
+    let mut out = String::new();
+    for family in lock(&REGISTRY).values() {
+        let metric = family.metric;
+        let kind = match metric.kind {
+            Kind::Counter => "counter",
+            Kind::Gauge => "gauge",
+            Kind::Histogram(_) => "histogram",
+        };
+        let _ = writeln!(out, "# HELP {} {}", metric.name, metric.help);
+        let _ = writeln!(out, "# TYPE {} {}", metric.name, kind);
+        for (labels, series) in &family.series {
+            match series {
+                Series::Counter(value) => {
+                    let _ = writeln!(out, "{}{} {}", metric.name, label_set(labels, None), value);
+                }
+                Series::Gauge(value) => {
+                    let _ = writeln!(out, "{}{} {}", metric.name, label_set(labels, None), value);
+                }
+                Series::Histogram {
+                    buckets,
+                    sum,
+                    count,
+                } => {
+                    let Kind::Histogram(bounds) = metric.kind else {
+                        continue;
+                    };
+                    for (bound, bucket) in bounds.iter().zip(buckets) {
+                        let le = bound.to_string();
+                        let _ = writeln!(
+                            out,
+                            "{}_bucket{} {}",
+                            metric.name,
+                            label_set(labels, Some(&le)),
+                            bucket
+                        );
+                    }
+                    let _ = writeln!(
+                        out,
+                        "{}_bucket{} {}",
+                        metric.name,
+                        label_set(labels, Some("+Inf")),
+                        count
+                    );
+                    let _ = writeln!(
+                        out,
+                        "{}_sum{} {}",
+                        metric.name,
+                        label_set(labels, None),
+                        sum
+                    );
+                    let _ = writeln!(
+                        out,
+                        "{}_count{} {}",
+                        metric.name,
+                        label_set(labels, None),
+                        count
+                    );
+                }
+            }
+        }
+    }
+    for (name, help, kind, value) in cache_metrics() {
+        let _ = writeln!(out, "# HELP {} {}", name, help);
+        let _ = writeln!(out, "# TYPE {} {}", name, kind);
+        let _ = writeln!(out, "{} {}", name, value);
+    }
+    out
+}
+
+/// The same metrics as JSON, for hosts that scrape through the C API:
+/// `{ "<name>": { "type", "help", "series": [{ "labels", ... }] } }`. Histogram series carry
+/// cumulative `buckets` as `[upper_bound, count]` pairs plus `sum` and `count`.
+pub fn snapshot_json() -> Value {
+    let mut out = serde_json::Map::new();
+    for family in lock(&REGISTRY).values() {
+        let metric = family.metric;
+        let series = family
+            .series
+            .iter()
+            .map(|(labels, series)| {
+                let labels = labels
+                    .iter()
+                    .map(|(key, value)| (key.to_string(), Value::from(value.clone())))
+                    .collect::<serde_json::Map<_, _>>();
+                match (series, metric.kind) {
+                    (Series::Counter(value), _) => json!({ "labels": labels, "value": value }),
+                    (Series::Gauge(value), _) => json!({ "labels": labels, "value": value }),
+                    (
+                        Series::Histogram {
+                            buckets,
+                            sum,
+                            count,
+                        },
+                        Kind::Histogram(bounds),
+                    ) => json!({
+                        "labels": labels,
+                        "buckets": bounds.iter().zip(buckets).collect::<Vec<_>>(),
+                        "sum": sum,
+                        "count": count,
+                    }),
+                    (Series::Histogram { .. }, _) => json!({ "labels": labels }),
+                }
+            })
+            .collect::<Vec<_>>();
+        let kind = match metric.kind {
+            Kind::Counter => "counter",
+            Kind::Gauge => "gauge",
+            Kind::Histogram(_) => "histogram",
+        };
+        out.insert(
+            metric.name.to_string(),
+            json!({ "type": kind, "help": metric.help, "series": series }),
+        );
+    }
+    for (name, help, kind, value) in cache_metrics() {
+        out.insert(
+            name.to_string(),
+            json!({ "type": kind, "help": help, "series": [{ "labels": {}, "value": value }] }),
+        );
+    }
+    Value::Object(out)
+}
+
+fn label_set(labels: &Labels, le: Option<&str>) -> String {
+    let mut parts = labels
+        .iter()
+        .map(|(key, value)| format!("{}=\"{}\"", key, escape_label(value)))
+        .collect::<Vec<_>>();
+    if let Some(le) = le {
+        parts.push(format!("le=\"{}\"", le));
+    }
+    if parts.is_empty() {
+        String::new()
+    } else {
+        format!("{{{}}}", parts.join(","))
+    }
+}
+
+fn escape_label(value: &str) -> String {
+    value
+        .replace('\\', "\\\\")
+        .replace('"', "\\\"")
+        .replace('\n', "\\n")
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    static TEST_HISTOGRAM: Metric = Metric {
+        name: "llm_test_duration_seconds",
+        help: "Test histogram.",
+        kind: Kind::Histogram(&[0.1, 1.0]),
+    };
+
+    #[test]
+    fn renders_cumulative_histogram_buckets() {
+        for value in [0.05, 0.5, 5.0] {
+            observe(&TEST_HISTOGRAM, &[("model", "m\"1")], value);
+        }
+        let text = render_prometheus();
+        assert!(text.contains("# TYPE llm_test_duration_seconds histogram"));
+        assert!(text.contains("llm_test_duration_seconds_bucket{model=\"m\\\"1\",le=\"0.1\"} 1"));
+        assert!(text.contains("llm_test_duration_seconds_bucket{model=\"m\\\"1\",le=\"1\"} 2"));
+        assert!(text.contains("llm_test_duration_seconds_bucket{model=\"m\\\"1\",le=\"+Inf\"} 3"));
+        assert!(text.contains("llm_test_duration_seconds_count{model=\"m\\\"1\"} 3"));
+
+        let snapshot = snapshot_json();
+        let series = &snapshot["llm_test_duration_seconds"]["series"][0];
+        assert_eq!(series["count"], 3);
+        assert_eq!(series["buckets"][1], json!([1.0, 2]));
+    }
+
+    #[test]
+    fn cache_ratios_are_in_both_outputs() {
+        let text = render_prometheus();
+        let snapshot = snapshot_json();
+        for name in [
+            "llm_response_cache_hit_ratio",
+            "llm_translation_memory_hit_ratio",
+        ] {
+            assert!(text.contains(&format!("# TYPE {} gauge", name)), "{}", name);
+            assert_eq!(snapshot[name]["type"], "gauge");
+            assert!(snapshot[name]["series"][0]["value"].is_f64(), "{}", name);
+        }
+    }
+}
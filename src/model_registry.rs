@@ -2,10 +2,13 @@ use anyhow::{Context, Result, anyhow};
 use serde::{Deserialize, Serialize};
 use std::fs;
 use std::path::{Path, PathBuf};
+use std::sync::Mutex;
 use std::time::{Duration, SystemTime, UNIX_EPOCH};
 
 use crate::build_env;
-use crate::providers::ProviderKind;
+use crate::providers::{self, ProviderKind};
+
+mod history;
 
 const TTL_SECONDS: u64 = 60 * 60 * 24;
 
@@ -17,12 +20,22 @@ struct MetaCache {
     last_fetched_model_datetime: Option<String>,
     #[serde(default)]
     models: Vec<String>,
-    #[serde(default)]
+    /// Legacy location of the history; moved to `histories.jsonl` on first read.
+    #[serde(default, skip_serializing)]
     histories: Vec<HistoryEntry>,
+    #[serde(
+        rename = "historyLimit",
+        default,
+        skip_serializing_if = "Option::is_none"
+    )]
+    history_limit: Option<usize>,
     #[serde(default)]
     trend: TrendMeta,
 }
 
+// Serialises read-modify-write updates of meta.json within the process.
+static META_LOCK: Mutex<()> = Mutex::new(());
+
 #[derive(Debug, Serialize, Deserialize, Clone)]
 #[serde(rename_all = "lowercase")]
 pub enum HistoryType {
@@ -79,7 +92,7 @@ pub struct TrendKeyword {
 }
 
 pub async fn get_models(provider: ProviderKind, key: &str) -> Result<Vec<String>> {
-    let mut meta = read_meta()?;
+    let meta = read_meta()?;
     let prefix = provider_prefix(provider);
     let cached = models_for_provider(&meta.models, &prefix);
     if !cached.is_empty() && !is_expired(&meta) {
@@ -87,12 +100,34 @@ pub async fn get_models(provider: ProviderKind, key: &str) -> Result<Vec<String>
     }
 
     let models = fetch_models(provider, key).await?;
+    let _guard = lock_meta();
+    let mut meta = read_meta()?;
     update_provider_models(&mut meta.models, &prefix, &models);
     meta.last_fetched_model_datetime = Some(now_unix().to_string());
     write_meta(&meta)?;
     Ok(models)
 }
 
+/// Largest completion `model` can return in one call, in tokens, judged from its name.
+/// Claude is capped by the `max_tokens` the provider requests; unknown models get a
+/// conservative default.
+pub(crate) fn output_token_limit(model: &str) -> usize {
+    let model = model.to_ascii_lowercase();
+    let model = model.rsplit('/').next().unwrap_or(&model);
+    if model.starts_with("claude") {
+        providers::CLAUDE_MAX_TOKENS
+    } else if model.starts_with("gpt-4.1") || model.starts_with("gpt-5") {
+        32_768
+    } else if model.starts_with("gpt-4o") || ["o1", "o3", "o4"].iter().any(|p| model.starts_with(p))
+    {
+        16_384
+    } else if model.starts_with("gemini") {
+        8_192
+    } else {
+        4_096
+    }
+}
+
 fn base_cache_dir() -> PathBuf {
     if let Ok(home) = std::env::var("HOME")
         && !home.trim().is_empty()
@@ -117,15 +152,31 @@ pub fn get_cached_models() -> Result<Vec<String>> {
 }
 
 pub fn set_last_using_model(provider: ProviderKind, model: &str) -> Result<()> {
+    let _guard = lock_meta();
     let mut meta = read_meta()?;
     meta.last_using_model = Some(format!("{}:{}", provider.as_str(), model));
     write_meta(&meta)?;
     Ok(())
 }
 
+/// Newest first, at most `history_limit` entries.
 pub fn get_histories() -> Result<Vec<HistoryEntry>> {
-    let meta = read_meta()?;
-    Ok(meta.histories)
+    with_history(|log| Ok(log.recent()))
+}
+
+/// Looks up the history entry whose stored output is `dest`.
+pub fn find_history_by_dest(dest: &str) -> Result<Option<HistoryEntry>> {
+    with_history(|log| Ok(log.find_by_dest(dest)))
+}
+
+/// Fills in tags generated after the entries were recorded (see `history_tags::enqueue`).
+pub(crate) fn set_history_tags(tagged: &[(HistoryEntry, Vec<String>)]) -> Result<()> {
+    with_history(|log| {
+        for (entry, tags) in tagged {
+            log.set_tags(entry, tags.clone())?;
+        }
+        Ok(())
+    })
 }
 
 pub fn get_trend() -> Result<TrendMeta> {
@@ -134,6 +185,7 @@ pub fn get_trend() -> Result<TrendMeta> {
 }
 
 pub fn update_trend(categories: &[String], keywords: &[String]) -> Result<()> {
+    let _guard = lock_meta();
     let mut meta = read_meta()?;
     update_category_counts(&mut meta.trend.categories, categories);
     update_keyword_counts(&mut meta.trend.freq_keywords, keywords);
@@ -141,22 +193,23 @@ pub fn update_trend(categories: &[String], keywords: &[String]) -> Result<()> {
     Ok(())
 }
 
+/// Appends `entry` to the history log. Entries beyond `limit` (and the stored output of
+/// dropped attachments) are removed by a periodic compaction rather than on every call.
 pub fn record_history(entry: HistoryEntry, limit: usize) -> Result<()> {
-    let mut meta = read_meta()?;
-    meta.histories.insert(0, entry);
-    if limit > 0 && meta.histories.len() > limit {
-        let removed = meta.histories.split_off(limit);
-        for item in removed {
-            if matches!(item.kind, HistoryType::Attachment) {
-                let path = PathBuf::from(item.dest);
-                if path.exists() {
-                    let _ = fs::remove_file(path);
-                }
-            }
-        }
+    let limit_changed = with_history(|log| {
+        log.append(&entry)?;
+        let changed = log.limit() != Some(limit);
+        log.set_limit(limit);
+        Ok(changed)
+    })?;
+    if limit_changed {
+        // Remembered so readers without settings show the same window.
+        let _guard = lock_meta();
+        let mut meta = read_meta()?;
+        meta.history_limit = Some(limit);
+        write_meta(&meta)?;
     }
-    write_meta(&meta)?;
-    Ok(())
+    history::compact(&history_path())
 }
 
 pub fn write_history_dest(content: &str, salt: &str) -> Result<String> {
@@ -184,6 +237,26 @@ fn meta_path() -> PathBuf {
     base_cache_dir().join("meta.json")
 }
 
+fn history_path() -> PathBuf {
+    base_cache_dir().join("histories.jsonl")
+}
+
+fn with_history<T>(f: impl FnOnce(&mut history::HistoryLog) -> Result<T>) -> Result<T> {
+    let path = history_path();
+    history::with_log(
+        &path,
+        || read_meta().ok().and_then(|meta| meta.history_limit),
+        f,
+    )
+}
+
+fn lock_meta() -> std::sync::MutexGuard<'static, ()> {
+    match META_LOCK.lock() {
+        Ok(guard) => guard,
+        Err(poisoned) => poisoned.into_inner(),
+    }
+}
+
 fn read_meta() -> Result<MetaCache> {
     let path = meta_path();
     if !path.exists() {
@@ -191,8 +264,13 @@ fn read_meta() -> Result<MetaCache> {
     }
 
     let content = fs::read_to_string(path).with_context(|| "failed to read meta cache")?;
-    let entry: MetaCache =
+    let mut entry: MetaCache =
         serde_json::from_str(&content).with_context(|| "failed to parse meta cache JSON")?;
+    if !entry.histories.is_empty() {
+        history::import(&history_path(), &entry.histories)?;
+        entry.histories.clear();
+        write_meta(&entry)?;
+    }
     Ok(entry)
 }
 
@@ -310,7 +388,7 @@ async fn fetch_openai_models(key: &str) -> Result<Vec<String>> {
         .unwrap_or_else(|_| "https://api.openai.com/v1".to_string());
     let url = format!("{}/models", base_url.trim_end_matches('/'));
 
-    let response = reqwest::Client::new()
+    let response = providers::http::client()
         .get(url)
         .bearer_auth(key)
         .send()
@@ -339,7 +417,7 @@ async fn fetch_openai_models(key: &str) -> Result<Vec<String>> {
 
 async fn fetch_gemini_models(key: &str) -> Result<Vec<String>> {
     let url = "https://generativelanguage.googleapis.com/v1beta/models";
-    let response = reqwest::Client::new()
+    let response = providers::http::client()
         .get(url)
         .header("x-goog-api-key", key)
         .send()
@@ -369,7 +447,7 @@ async fn fetch_gemini_models(key: &str) -> Result<Vec<String>> {
 
 async fn fetch_claude_models(key: &str) -> Result<Vec<String>> {
     let url = "https://api.anthropic.com/v1/models";
-    let response = reqwest::Client::new()
+    let response = providers::http::client()
         .get(url)
         .header("x-api-key", key)
         .header("anthropic-version", "2023-06-01")
@@ -0,0 +1,608 @@
+use anyhow::{Context, Result};
+use std::collections::HashMap;
+use std::fs::{self, File, OpenOptions};
+use std::io::{BufRead, BufReader, Seek, SeekFrom, Write};
+use std::path::{Path, PathBuf};
+use std::sync::Mutex;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::time::{SystemTime, UNIX_EPOCH};
+
+use serde::{Deserialize, Serialize};
+
+use crate::util::lock;
+
+use super::{HistoryEntry, HistoryType};
+
+/// The log is compacted once it holds this many entries past the limit (or `limit` more,
+/// whichever is larger), so rewrites happen once per many appends.
+const MIN_COMPACT_SLACK: usize = 64;
+
+/// Translation history as an append-only JSON lines log, oldest entry first.
+///
+/// Recording a translation appends one line. The process keeps the parsed entries and an
+/// index by `dest` in memory and only reads lines appended since its last look, so other
+/// processes' appends are picked up without re-reading the file. Entries beyond the
+/// history limit are dropped by `compact`, which writes the kept entries under a new
+/// generation header; a reader that sees a different header reloads from the start. Tags
+/// generated after the fact are appended as `TagUpdate` lines and folded into their entries
+/// on read and by the next compaction.
+pub(super) struct HistoryLog {
+    path: PathBuf,
+    entries: Vec<HistoryEntry>,
+    by_dest: HashMap<String, usize>,
+    tag_updates: Vec<TagUpdate>,
+    synced_len: u64,
+    generation: Option<String>,
+    limit: Option<usize>,
+}
+
+/// First line of a log written by `compact` or `import`. Logs from older versions have none.
+#[derive(Debug, Serialize, Deserialize)]
+struct Header {
+    generation: String,
+}
+
+/// Tags for an entry recorded earlier, identified by its timestamp, source and dest.
+#[derive(Debug, Clone, Serialize, Deserialize)]
+struct TagUpdate {
+    #[serde(rename = "tagsFor")]
+    tags_for: EntryKey,
+    tags: Vec<String>,
+}
+
+#[derive(Debug, Clone, PartialEq, Eq, Serialize, Deserialize)]
+struct EntryKey {
+    datetime: String,
+    src: String,
+    dest: String,
+}
+
+impl EntryKey {
+    fn of(entry: &HistoryEntry) -> Self {
+        Self {
+            datetime: entry.datetime.clone(),
+            src: entry.src.clone(),
+            dest: entry.dest.clone(),
+        }
+    }
+
+    fn matches(&self, entry: &HistoryEntry) -> bool {
+        self.datetime == entry.datetime && self.src == entry.src && self.dest == entry.dest
+    }
+}
+
+static LOG: Mutex<Option<HistoryLog>> = Mutex::new(None);
+static COMPACTING: AtomicBool = AtomicBool::new(false);
+
+/// Runs `f` on the process-wide log at `path`, caught up with the file.
+pub(super) fn with_log<T>(
+    path: &Path,
+    limit: impl FnOnce() -> Option<usize>,
+    f: impl FnOnce(&mut HistoryLog) -> Result<T>,
+) -> Result<T> {
+    let mut guard = lock(&LOG);
+    if guard.as_ref().is_none_or(|log| log.path != path) {
+        *guard = Some(HistoryLog {
+            path: path.to_path_buf(),
+            entries: Vec::new(),
+            by_dest: HashMap::new(),
+            tag_updates: Vec::new(),
+            synced_len: 0,
+            generation: None,
+            limit: limit(),
+        });
+    }
+    let log = guard.as_mut().expect("history log initialised");
+    log.sync()?;
+    f(log)
+}
+
+impl HistoryLog {
+    pub(super) fn limit(&self) -> Option<usize> {
+        self.limit
+    }
+
+    pub(super) fn set_limit(&mut self, limit: usize) {
+        self.limit = Some(limit);
+    }
+
+    /// Newest first, at most `limit` entries (all when the limit is unknown or 0).
+    pub(super) fn recent(&self) -> Vec<HistoryEntry> {
+        let take = match self.limit {
+            Some(limit) if limit > 0 => limit,
+            _ => usize::MAX,
+        };
+        self.entries.iter().rev().take(take).cloned().collect()
+    }
+
+    pub(super) fn find_by_dest(&self, dest: &str) -> Option<HistoryEntry> {
+        self.by_dest
+            .get(dest)
+            .and_then(|&idx| self.entries.get(idx))
+            .cloned()
+    }
+
+    pub(super) fn append(&mut self, entry: &HistoryEntry) -> Result<()> {
+        self.append_line(serde_json::to_string(entry)?)
+    }
+
+    /// Records `tags` for `entry`, which was appended earlier. Nothing changes if the entry
+    /// has been compacted away meanwhile.
+    pub(super) fn set_tags(&mut self, entry: &HistoryEntry, tags: Vec<String>) -> Result<()> {
+        self.append_line(serde_json::to_string(&TagUpdate {
+            tags_for: EntryKey::of(entry),
+            tags,
+        })?)
+    }
+
+    fn append_line(&mut self, mut line: String) -> Result<()> {
+        line.push('\n');
+        if let Some(dir) = self.path.parent() {
+            fs::create_dir_all(dir).with_context(|| "failed to create cache directory")?;
+        }
+        // Held shared so a compaction in another process cannot replace the file between
+        // opening and writing it.
+        let lock = lock_log(&self.path, false)?;
+        let mut file = match OpenOptions::new().append(true).open(&self.path) {
+            Ok(file) => file,
+            Err(err) if err.kind() == std::io::ErrorKind::NotFound => create_log(&self.path)?,
+            Err(err) => return Err(err).with_context(|| "failed to append history"),
+        };
+        // One write with O_APPEND, so concurrent processes never interleave lines.
+        file.write_all(line.as_bytes())
+            .with_context(|| "failed to append history")?;
+        drop(file);
+        drop(lock);
+        self.sync()
+    }
+
+    fn needs_compaction(&self) -> bool {
+        match self.limit {
+            Some(limit) if limit > 0 => self.entries.len() > limit + limit.max(MIN_COMPACT_SLACK),
+            _ => false,
+        }
+    }
+
+    /// Reads lines appended since the last call. A log with another generation header was
+    /// rewritten by a compaction (possibly in another process) and is read again from the
+    /// start; so is one that shrank.
+    fn sync(&mut self) -> Result<()> {
+        let file = match File::open(&self.path) {
+            Ok(file) => file,
+            Err(err) if err.kind() == std::io::ErrorKind::NotFound => {
+                if self.synced_len > 0 || self.generation.is_some() {
+                    self.reset(None);
+                }
+                return Ok(());
+            }
+            Err(err) => return Err(err).with_context(|| "failed to read history"),
+        };
+        // The header and the tail are read through one handle, so they come from the same
+        // file even if a compaction renames a new one into place meanwhile.
+        let len = file
+            .metadata()
+            .with_context(|| "failed to stat history log")?
+            .len();
+        let mut reader = BufReader::new(file);
+        let mut line = String::new();
+        reader
+            .read_line(&mut line)
+            .with_context(|| "failed to read history")?;
+        let generation = serde_json::from_str::<Header>(&line)
+            .ok()
+            .map(|header| header.generation);
+        if generation != self.generation || len < self.synced_len {
+            self.reset(generation);
+        }
+        if len == self.synced_len {
+            return Ok(());
+        }
+
+        reader
+            .seek(SeekFrom::Start(self.synced_len))
+            .with_context(|| "failed to read history")?;
+        loop {
+            line.clear();
+            let read = reader
+                .read_line(&mut line)
+                .with_context(|| "failed to read history")?;
+            // Stop before a line another process is still writing.
+            if read == 0 || !line.ends_with('\n') {
+                break;
+            }
+            self.synced_len += read as u64;
+            if let Ok(entry) = serde_json::from_str::<HistoryEntry>(&line) {
+                self.push(entry);
+            } else if let Ok(update) = serde_json::from_str::<TagUpdate>(&line) {
+                self.apply_tags(update);
+            }
+        }
+        Ok(())
+    }
+
+    fn push(&mut self, entry: HistoryEntry) {
+        self.by_dest.insert(entry.dest.clone(), self.entries.len());
+        self.entries.push(entry);
+    }
+
+    /// Dests are unique for attachments; text entries share a dest when their output is the
+    /// same, so the index is only a first guess.
+    fn apply_tags(&mut self, update: TagUpdate) {
+        let indexed = self
+            .by_dest
+            .get(&update.tags_for.dest)
+            .copied()
+            .filter(|&idx| update.tags_for.matches(&self.entries[idx]));
+        let found = indexed.or_else(|| {
+            self.entries
+                .iter()
+                .rposition(|entry| update.tags_for.matches(entry))
+        });
+        if let Some(idx) = found {
+            self.entries[idx].tags = Some(update.tags.clone());
+            self.tag_updates.push(update);
+        }
+    }
+
+    fn reset(&mut self, generation: Option<String>) {
+        self.entries.clear();
+        self.by_dest.clear();
+        self.tag_updates.clear();
+        self.synced_len = 0;
+        self.generation = generation;
+    }
+
+    fn replace(&mut self, entries: Vec<HistoryEntry>, generation: String) -> Result<()> {
+        self.entries.clear();
+        self.by_dest.clear();
+        self.tag_updates.clear();
+        for entry in entries {
+            self.push(entry);
+        }
+        self.synced_len = fs::metadata(&self.path)
+            .with_context(|| "failed to stat history log")?
+            .len();
+        self.generation = Some(generation);
+        Ok(())
+    }
+}
+
+/// Writes entries migrated from the old meta cache (newest first) as a new log.
+pub(super) fn import(path: &Path, newest_first: &[HistoryEntry]) -> Result<()> {
+    if path.exists() {
+        return Ok(());
+    }
+    if let Some(dir) = path.parent() {
+        fs::create_dir_all(dir).with_context(|| "failed to create cache directory")?;
+    }
+    let _lock = lock_log(path, true)?;
+    // Another process may have started the log while this one waited for the lock.
+    if path.exists() {
+        return Ok(());
+    }
+    let tmp = temp_path(path);
+    write_log(&tmp, &new_generation(), newest_first.iter().rev())?;
+    fs::rename(&tmp, path).with_context(|| "failed to write history")?;
+    Ok(())
+}
+
+/// Drops entries beyond the limit once enough have piled up, deleting the stored output of
+/// dropped attachments. The kept entries are written to a temp file without holding any
+/// lock, so other tasks and processes keep appending meanwhile. The file lock is then taken
+/// exclusively, which holds off appends, while their lines (entries and tag updates) are
+/// carried over and the temp file replaces the log. If another process compacted first, the
+/// generation header has changed and its log is kept instead.
+pub(super) fn compact(path: &Path) -> Result<()> {
+    let snapshot = with_log(
+        path,
+        || None,
+        |log| {
+            if !log.needs_compaction() || COMPACTING.swap(true, Ordering::AcqRel) {
+                return Ok(None);
+            }
+            let keep_from = log.entries.len() - log.limit.unwrap_or(0);
+            Ok(Some(Snapshot {
+                kept: log.entries[keep_from..].to_vec(),
+                dropped: log.entries[..keep_from].to_vec(),
+                keep_from,
+                seen: log.entries.len(),
+                seen_tags: log.tag_updates.len(),
+                generation: log.generation.clone(),
+            }))
+        },
+    )?;
+    let Some(Snapshot {
+        kept,
+        dropped,
+        keep_from,
+        seen,
+        seen_tags,
+        generation,
+    }) = snapshot
+    else {
+        return Ok(());
+    };
+    let result: Result<()> = (|| {
+        let tmp = temp_path(path);
+        let next = new_generation();
+        write_log(&tmp, &next, kept.iter())?;
+        let stale = with_log(
+            path,
+            || None,
+            |log| {
+                let _lock = lock_log(path, true)?;
+                log.sync()?;
+                if log.generation != generation
+                    || log.entries.len() < seen
+                    || log.tag_updates.len() < seen_tags
+                {
+                    // Another process compacted first; its log wins.
+                    let _ = fs::remove_file(&tmp);
+                    return Ok(Vec::new());
+                }
+                let mut lines = Vec::new();
+                for entry in &log.entries[seen..] {
+                    lines.push(serde_json::to_string(entry)?);
+                }
+                for update in &log.tag_updates[seen_tags..] {
+                    lines.push(serde_json::to_string(update)?);
+                }
+                let mut file = OpenOptions::new()
+                    .append(true)
+                    .open(&tmp)
+                    .with_context(|| "failed to write history")?;
+                for mut line in lines {
+                    line.push('\n');
+                    file.write_all(line.as_bytes())
+                        .with_context(|| "failed to write history")?;
+                }
+                drop(file);
+                fs::rename(&tmp, path).with_context(|| "failed to replace history log")?;
+                // Kept entries as they are now, with tags set since the snapshot.
+                let current = log.entries[keep_from..].to_vec();
+                log.replace(current, next)?;
+                Ok(dropped
+                    .into_iter()
+                    .filter(|item| matches!(item.kind, HistoryType::Attachment))
+                    .filter(|item| !log.by_dest.contains_key(&item.dest))
+                    .map(|item| PathBuf::from(item.dest))
+                    .collect::<Vec<_>>())
+            },
+        )?;
+        for path in stale {
+            if path.exists() {
+                let _ = fs::remove_file(path);
+            }
+        }
+        Ok(())
+    })();
+    COMPACTING.store(false, Ordering::Release);
+    result
+}
+
+struct Snapshot {
+    kept: Vec<HistoryEntry>,
+    dropped: Vec<HistoryEntry>,
+    keep_from: usize,
+    seen: usize,
+    seen_tags: usize,
+    generation: Option<String>,
+}
+
+/// Takes the advisory lock shared by every process using the log at `path`. It lives in a
+/// file next to the log, since the log itself is replaced by compaction. Appends hold it
+/// shared; compaction and import hold it exclusively while they replace the log. Released
+/// when the returned handle is dropped.
+fn lock_log(path: &Path, exclusive: bool) -> Result<File> {
+    let file = OpenOptions::new()
+        .create(true)
+        .truncate(false)
+        .write(true)
+        .open(path.with_extension("jsonl.lock"))
+        .with_context(|| "failed to open history lock")?;
+    let locked = if exclusive {
+        file.lock()
+    } else {
+        file.lock_shared()
+    };
+    locked.with_context(|| "failed to lock history log")?;
+    Ok(file)
+}
+
+/// Starts a log with a generation header. If another process created it first, its file is
+/// appended to instead.
+fn create_log(path: &Path) -> Result<File> {
+    let mut file = match OpenOptions::new().append(true).create_new(true).open(path) {
+        Ok(file) => file,
+        Err(err) if err.kind() == std::io::ErrorKind::AlreadyExists => {
+            return OpenOptions::new()
+                .append(true)
+                .open(path)
+                .with_context(|| "failed to append history");
+        }
+        Err(err) => return Err(err).with_context(|| "failed to create history log"),
+    };
+    let mut header = serde_json::to_string(&Header {
+        generation: new_generation(),
+    })?;
+    header.push('\n');
+    file.write_all(header.as_bytes())
+        .with_context(|| "failed to write history header")?;
+    Ok(file)
+}
+
+/// Per process, so concurrent compactions in different processes never share a temp file.
+fn temp_path(path: &Path) -> PathBuf {
+    path.with_extension(format!("jsonl.{}.tmp", std::process::id()))
+}
+
+fn write_log<'a>(
+    path: &Path,
+    generation: &str,
+    entries: impl Iterator<Item = &'a HistoryEntry>,
+) -> Result<()> {
+    let mut content = serde_json::to_string(&Header {
+        generation: generation.to_string(),
+    })?;
+    content.push('\n');
+    for entry in entries {
+        content.push_str(&serde_json::to_string(entry)?);
+        content.push('\n');
+    }
+    fs::write(path, content).with_context(|| "failed to write history")
+}
+
+fn new_generation() -> String {
+    let nanos = SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .unwrap_or_default()
+        .as_nanos();
+    format!("{}-{}", nanos, std::process::id())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tempfile::tempdir;
+
+    /// The log is process-wide, so tests that point it at their own file run one at a time.
+    static TEST_LOCK: Mutex<()> = Mutex::new(());
+
+    fn entry(index: usize, dest: String) -> HistoryEntry {
+        HistoryEntry {
+            datetime: index.to_string(),
+            model: "openai:test".to_string(),
+            formal: None,
+            mime: "text/plain".to_string(),
+            kind: HistoryType::Attachment,
+            source_language: None,
+            target_language: None,
+            tags: None,
+            src: format!("src-{}", index),
+            dest,
+        }
+    }
+
+    #[test]
+    fn appends_reads_incrementally_and_compacts_to_the_limit() {
+        let _serial = lock(&TEST_LOCK);
+        let dir = tempdir().expect("tempdir");
+        let path = dir.path().join("histories.jsonl");
+        let limit = 4;
+        let total = limit + MIN_COMPACT_SLACK + 1;
+        let dests: Vec<PathBuf> = (0..total)
+            .map(|i| dir.path().join(format!("dest-{}", i)))
+            .collect();
+        for (i, dest) in dests.iter().enumerate() {
+            fs::write(dest, "out").expect("dest");
+            let item = entry(i, dest.to_string_lossy().to_string());
+            with_log(&path, || Some(limit), |log| log.append(&item)).expect("append");
+        }
+
+        // A torn line from a writer that has not finished yet is left for later.
+        let mut file = OpenOptions::new().append(true).open(&path).expect("open");
+        file.write_all(b"{\"datetime\":").expect("partial");
+        drop(file);
+
+        let recent = with_log(&path, || None, |log| Ok(log.recent())).expect("recent");
+        assert_eq!(recent.len(), limit);
+        assert_eq!(recent[0].datetime, (total - 1).to_string());
+        let first = dests[0].to_string_lossy().to_string();
+        let found = with_log(&path, || None, |log| Ok(log.find_by_dest(&first))).expect("find");
+        assert_eq!(found.map(|item| item.src), Some("src-0".to_string()));
+
+        fs::write(
+            &path,
+            fs::read_to_string(&path)
+                .expect("read")
+                .trim_end_matches("{\"datetime\":"),
+        )
+        .expect("repair");
+        compact(&path).expect("compact");
+        let lines = fs::read_to_string(&path).expect("read").lines().count();
+        assert_eq!(lines, limit + 1);
+        assert!(!dests[0].exists());
+        assert!(dests[total - 1].exists());
+        let all = with_log(&path, || None, |log| Ok(log.recent())).expect("after");
+        assert_eq!(all.len(), limit);
+    }
+
+    #[test]
+    fn tag_updates_apply_to_their_entry_and_survive_compaction() {
+        let _serial = lock(&TEST_LOCK);
+        let dir = tempdir().expect("tempdir");
+        let path = dir.path().join("histories.jsonl");
+        let limit = 2;
+        // Text entries with the same output share a dest.
+        let first = entry(0, "same output".to_string());
+        let second = entry(1, "same output".to_string());
+        with_log(&path, || Some(limit), |log| log.append(&first)).expect("first");
+        with_log(&path, || None, |log| log.append(&second)).expect("second");
+        let tags = vec!["greeting".to_string()];
+        with_log(&path, || None, |log| log.set_tags(&first, tags.clone())).expect("tags");
+
+        let recent = with_log(&path, || None, |log| Ok(log.recent())).expect("recent");
+        assert_eq!(recent[0].tags, None);
+        assert_eq!(recent[1].tags.as_ref(), Some(&tags));
+
+        // Re-read from disk as another process would.
+        with_log(
+            &path,
+            || None,
+            |log| {
+                log.reset(None);
+                log.sync()
+            },
+        )
+        .expect("reread");
+        for index in 2..(limit + MIN_COMPACT_SLACK + 1) {
+            let item = entry(index, format!("dest-{}", index));
+            with_log(&path, || None, |log| log.append(&item)).expect("append");
+        }
+        let later = entry(99, "later".to_string());
+        with_log(
+            &path,
+            || None,
+            |log| {
+                log.append(&later)?;
+                log.set_tags(&later, tags.clone())
+            },
+        )
+        .expect("later");
+        compact(&path).expect("compact");
+        let content = fs::read_to_string(&path).expect("read");
+        assert_eq!(content.lines().count(), limit + 1);
+        assert!(!content.contains("tagsFor"));
+        let recent = with_log(&path, || None, |log| Ok(log.recent())).expect("after");
+        assert_eq!(recent[0].tags.as_ref(), Some(&tags));
+    }
+
+    #[test]
+    fn a_log_rewritten_by_another_process_is_reloaded_even_when_it_grew() {
+        let _serial = lock(&TEST_LOCK);
+        let dir = tempdir().expect("tempdir");
+        let path = dir.path().join("histories.jsonl");
+        for index in 0..2 {
+            let item = entry(index, format!("dest-{}", index));
+            with_log(&path, || Some(10), |log| log.append(&item)).expect("append");
+        }
+        let content = fs::read_to_string(&path).expect("read");
+        assert!(content.starts_with("{\"generation\":"));
+
+        // Another process compacts and appends past this process's offset.
+        let others: Vec<HistoryEntry> = (10..16)
+            .map(|index| entry(index, format!("other-{}", index)))
+            .collect();
+        let tmp = dir.path().join("other.tmp");
+        write_log(&tmp, "other", others.iter()).expect("write");
+        fs::rename(&tmp, &path).expect("rename");
+        assert!(fs::metadata(&path).expect("stat").len() > content.len() as u64);
+
+        let recent = with_log(&path, || None, |log| Ok(log.recent())).expect("recent");
+        let dests: Vec<String> = recent.into_iter().map(|item| item.dest).collect();
+        let expected: Vec<String> = others.iter().rev().map(|item| item.dest.clone()).collect();
+        assert_eq!(dests, expected);
+        let generation = with_log(&path, || None, |log| Ok(log.generation.clone())).expect("gen");
+        assert_eq!(generation.as_deref(), Some("other"));
+    }
+}
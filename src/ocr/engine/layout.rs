@@ -1,16 +1,27 @@
 use crate::ocr::TranslatedLine;
 
 pub(crate) fn wrap_text(text: &str, max_units: f32) -> Vec<String> {
-    let tokens = tokenize_text(text);
-    wrap_tokens(&tokens, max_units)
+    wrap_tokens(&measure_tokens(text), max_units)
 }
 
-fn wrap_tokens(tokens: &[String], max_units: f32) -> Vec<String> {
+/// Tokens of `text` paired with their estimated width, measured once so repeated wraps at
+/// different widths only re-run the line breaking.
+fn measure_tokens(text: &str) -> Vec<(String, f32)> {
+    tokenize_text(text)
+        .into_iter()
+        .map(|token| {
+            let units = estimate_text_units(&token);
+            (token, units)
+        })
+        .collect()
+}
+
+fn wrap_tokens(tokens: &[(String, f32)], max_units: f32) -> Vec<String> {
     let mut result = Vec::new();
     let mut current = String::new();
     let mut units = 0.0;
 
-    for token in tokens {
+    for (token, token_units) in tokens {
         if token == "\n" {
             if !current.trim().is_empty() {
                 result.push(current.trim_end().to_string());
@@ -29,14 +40,13 @@ fn wrap_tokens(tokens: &[String], max_units: f32) -> Vec<String> {
             }
             continue;
         }
-        let token_units = estimate_text_units(token);
-        if units + token_units > max_units && !current.trim().is_empty() {
+        if units + *token_units > max_units && !current.trim().is_empty() {
             result.push(current.trim_end().to_string());
             current.clear();
             units = 0.0;
         }
         current.push_str(token);
-        units += token_units;
+        units += *token_units;
     }
 
     if !current.trim().is_empty() {
@@ -44,7 +54,11 @@ fn wrap_tokens(tokens: &[String], max_units: f32) -> Vec<String> {
     }
 
     if result.is_empty() {
-        result.push(tokens.join("").trim().to_string());
+        let joined = tokens
+            .iter()
+            .map(|(token, _)| token.as_str())
+            .collect::<String>();
+        result.push(joined.trim().to_string());
     }
     result
 }
@@ -64,9 +78,10 @@ pub(crate) fn fit_text_to_box(
         return (font_size, lines_text, line_height);
     }
 
+    let tokens = measure_tokens(text);
     let mut font_size = font_size_base.min(inner_h.max(min_size));
     let mut line_height = font_size * 1.1;
-    let mut lines_text = wrap_text(text, (inner_w / font_size).max(1.0));
+    let mut lines_text = wrap_tokens(&tokens, (inner_w / font_size).max(1.0));
     let has_cjk = text.chars().any(|ch| {
         matches!(
             ch as u32,
@@ -97,7 +112,7 @@ pub(crate) fn fit_text_to_box(
         };
         let shrink = shrink_by_lines.min(shrink_by_height).min(0.92);
         font_size = (font_size * shrink).max(min_size);
-        lines_text = wrap_text(text, (inner_w / font_size).max(1.0));
+        lines_text = wrap_tokens(&tokens, (inner_w / font_size).max(1.0));
     }
 
     (font_size, lines_text, line_height)
@@ -0,0 +1,233 @@
+use anyhow::{Result, anyhow};
+use image::GrayImage;
+use libloading::Library;
+use std::collections::HashMap;
+use std::ffi::{CStr, CString, c_char, c_int, c_void};
+use std::ptr;
+use std::sync::{Mutex, OnceLock};
+use tracing::{info, warn};
+
+const OEM_LSTM_ONLY: c_int = 1;
+const SOURCE_DPI: c_int = 300;
+
+const LIBRARY_NAMES: &[&str] = &[
+    "libtesseract.so.5",
+    "libtesseract.so.4",
+    "libtesseract.so",
+    "libtesseract.5.dylib",
+    "libtesseract.dylib",
+    "/opt/homebrew/lib/libtesseract.dylib",
+    "/usr/local/lib/libtesseract.dylib",
+    "libtesseract-5.dll",
+    "tesseract.dll",
+];
+
+type CreateFn = unsafe extern "C" fn() -> *mut c_void;
+type DeleteFn = unsafe extern "C" fn(*mut c_void);
+type Init2Fn = unsafe extern "C" fn(*mut c_void, *const c_char, *const c_char, c_int) -> c_int;
+type SetPageSegModeFn = unsafe extern "C" fn(*mut c_void, c_int);
+type SetImageFn = unsafe extern "C" fn(*mut c_void, *const u8, c_int, c_int, c_int, c_int);
+type SetSourceResolutionFn = unsafe extern "C" fn(*mut c_void, c_int);
+type GetTextFn = unsafe extern "C" fn(*mut c_void, c_int) -> *mut c_char;
+type DeleteTextFn = unsafe extern "C" fn(*const c_char);
+
+struct TessApi {
+    create: CreateFn,
+    delete: DeleteFn,
+    init2: Init2Fn,
+    set_page_seg_mode: SetPageSegModeFn,
+    set_image: SetImageFn,
+    set_source_resolution: SetSourceResolutionFn,
+    get_hocr_text: GetTextFn,
+    get_tsv_text: GetTextFn,
+    delete_text: DeleteTextFn,
+    // Keeps the function pointers above valid for the life of the process.
+    _library: Library,
+}
+
+static API: OnceLock<Option<TessApi>> = OnceLock::new();
+static POOL: Mutex<Option<HashMap<String, Vec<TessEngine>>>> = Mutex::new(None);
+
+/// Opens libtesseract once per process. The library is loaded at runtime so builds need no
+/// tesseract headers, and machines without it keep using the `tesseract` CLI.
+fn api() -> Option<&'static TessApi> {
+    API.get_or_init(|| {
+        for name in LIBRARY_NAMES {
+            let Ok(library) = (unsafe { Library::new(name) }) else {
+                continue;
+            };
+            match unsafe { TessApi::load(library) } {
+                Ok(api) => {
+                    info!("ocr: using in-process libtesseract ({})", name);
+                    return Some(api);
+                }
+                Err(err) => warn!("ocr: {} is missing symbols: {}", name, err),
+            }
+        }
+        None
+    })
+    .as_ref()
+}
+
+impl TessApi {
+    unsafe fn load(library: Library) -> Result<Self, libloading::Error> {
+        unsafe {
+            Ok(Self {
+                create: *library.get::<CreateFn>(b"TessBaseAPICreate\0")?,
+                delete: *library.get::<DeleteFn>(b"TessBaseAPIDelete\0")?,
+                init2: *library.get::<Init2Fn>(b"TessBaseAPIInit2\0")?,
+                set_page_seg_mode: *library
+                    .get::<SetPageSegModeFn>(b"TessBaseAPISetPageSegMode\0")?,
+                set_image: *library.get::<SetImageFn>(b"TessBaseAPISetImage\0")?,
+                set_source_resolution: *library
+                    .get::<SetSourceResolutionFn>(b"TessBaseAPISetSourceResolution\0")?,
+                get_hocr_text: *library.get::<GetTextFn>(b"TessBaseAPIGetHOCRText\0")?,
+                get_tsv_text: *library.get::<GetTextFn>(b"TessBaseAPIGetTsvText\0")?,
+                delete_text: *library.get::<DeleteTextFn>(b"TessDeleteText\0")?,
+                _library: library,
+            })
+        }
+    }
+}
+
+/// One initialised `TessBaseAPI` handle. Handles are not shared between threads; the pool
+/// hands each one to a single caller at a time.
+struct TessEngine {
+    api: &'static TessApi,
+    handle: *mut c_void,
+}
+
+// The handle is only ever used by the thread that checked it out of the pool.
+unsafe impl Send for TessEngine {}
+
+impl TessEngine {
+    fn new(api: &'static TessApi, languages: &str) -> Result<Self> {
+        let languages_c =
+            CString::new(languages).map_err(|_| anyhow!("invalid ocr languages: {}", languages))?;
+        let handle = unsafe { (api.create)() };
+        if handle.is_null() {
+            return Err(anyhow!("failed to create tesseract engine"));
+        }
+        let engine = Self { api, handle };
+        let status =
+            unsafe { (api.init2)(handle, ptr::null(), languages_c.as_ptr(), OEM_LSTM_ONLY) };
+        if status != 0 {
+            return Err(anyhow!(
+                "failed to initialise tesseract for languages {}",
+                languages
+            ));
+        }
+        Ok(engine)
+    }
+
+    fn set_image(&mut self, image: &GrayImage, psm: u32) -> Result<()> {
+        let (width, height) = image.dimensions();
+        let width = c_int::try_from(width).map_err(|_| anyhow!("image too wide for OCR"))?;
+        let height = c_int::try_from(height).map_err(|_| anyhow!("image too tall for OCR"))?;
+        unsafe {
+            (self.api.set_page_seg_mode)(self.handle, psm as c_int);
+            (self.api.set_image)(self.handle, image.as_ptr(), width, height, 1, width);
+            (self.api.set_source_resolution)(self.handle, SOURCE_DPI);
+        }
+        Ok(())
+    }
+
+    fn take_text(&self, text: *mut c_char) -> Result<String> {
+        if text.is_null() {
+            return Err(anyhow!("tesseract returned no output"));
+        }
+        let value = unsafe { CStr::from_ptr(text) }
+            .to_string_lossy()
+            .into_owned();
+        unsafe { (self.api.delete_text)(text) };
+        Ok(value)
+    }
+}
+
+impl Drop for TessEngine {
+    fn drop(&mut self) {
+        unsafe { (self.api.delete)(self.handle) };
+    }
+}
+
+/// A warm engine borrowed from the pool; it goes back to the pool when dropped.
+pub(super) struct PooledEngine {
+    languages: String,
+    engine: Option<TessEngine>,
+}
+
+impl PooledEngine {
+    /// Recognises `image` with page segmentation mode `psm` and returns hOCR. The TSV for the
+    /// same recognition is available from `tsv` until the next call.
+    pub(super) fn hocr(&mut self, image: &GrayImage, psm: u32) -> Result<String> {
+        let engine = self.engine()?;
+        engine.set_image(image, psm)?;
+        let text = unsafe { (engine.api.get_hocr_text)(engine.handle, 0) };
+        engine.take_text(text)
+    }
+
+    pub(super) fn tsv(&mut self) -> Result<String> {
+        let engine = self.engine()?;
+        let text = unsafe { (engine.api.get_tsv_text)(engine.handle, 0) };
+        engine.take_text(text)
+    }
+
+    fn engine(&mut self) -> Result<&mut TessEngine> {
+        self.engine
+            .as_mut()
+            .ok_or_else(|| anyhow!("tesseract engine already released"))
+    }
+}
+
+impl Drop for PooledEngine {
+    fn drop(&mut self) {
+        let Some(engine) = self.engine.take() else {
+            return;
+        };
+        let mut guard = match POOL.lock() {
+            Ok(guard) => guard,
+            Err(poisoned) => poisoned.into_inner(),
+        };
+        let idle = guard
+            .get_or_insert_with(HashMap::new)
+            .entry(std::mem::take(&mut self.languages))
+            .or_default();
+        if idle.len() < max_idle_per_languages() {
+            idle.push(engine);
+        }
+    }
+}
+
+/// Returns a warm engine for `languages`, or `None` when libtesseract is not available (or
+/// cannot load these languages) and the CLI should be used instead.
+pub(super) fn checkout(languages: &str) -> Option<PooledEngine> {
+    let api = api()?;
+    let idle = {
+        let mut guard = match POOL.lock() {
+            Ok(guard) => guard,
+            Err(poisoned) => poisoned.into_inner(),
+        };
+        guard
+            .as_mut()
+            .and_then(|pool| pool.get_mut(languages))
+            .and_then(Vec::pop)
+    };
+    let engine = match idle {
+        Some(engine) => engine,
+        None => match TessEngine::new(api, languages) {
+            Ok(engine) => engine,
+            Err(err) => {
+                warn!("ocr: {}; falling back to the tesseract CLI", err);
+                return None;
+            }
+        },
+    };
+    Some(PooledEngine {
+        languages: languages.to_string(),
+        engine: Some(engine),
+    })
+}
+
+fn max_idle_per_languages() -> usize {
+    num_cpus::get().max(1)
+}
@@ -3,7 +3,8 @@ use crate::ocr::{BBoxPx, OcrLine};
 use super::geom::{horizontal_overlap_ratio, iou, union_bbox, vertical_overlap_ratio};
 use super::text::{join_inline, merge_conf};
 
-pub(super) fn merge_lines(mut base: Vec<OcrLine>, extra: Vec<OcrLine>) -> Vec<OcrLine> {
+/// Folds `extra` into `base`, replacing an overlapping line when the new one reads better.
+pub(super) fn merge_lines(base: &mut Vec<OcrLine>, extra: Vec<OcrLine>) {
     for line in extra {
         if let Some(idx) = base
             .iter()
@@ -22,34 +23,22 @@ pub(super) fn merge_lines(mut base: Vec<OcrLine>, extra: Vec<OcrLine>) -> Vec<Oc
             base.push(line);
         }
     }
-    base
 }
 
-pub(super) fn scale_lines(lines: Vec<OcrLine>, scale: f32) -> Vec<OcrLine> {
-    lines
-        .into_iter()
-        .map(|line| {
-            let bbox = BBoxPx {
-                x: ((line.bbox.x as f32) / scale).round() as u32,
-                y: ((line.bbox.y as f32) / scale).round() as u32,
-                w: ((line.bbox.w as f32) / scale).round() as u32,
-                h: ((line.bbox.h as f32) / scale).round() as u32,
-            };
-            OcrLine {
-                text: line.text,
-                bbox,
-                conf: line.conf,
-                font_size: line.font_size / scale,
-            }
-        })
-        .collect()
+pub(super) fn scale_lines(lines: &mut [OcrLine], scale: f32) {
+    for line in lines {
+        line.bbox = BBoxPx {
+            x: ((line.bbox.x as f32) / scale).round() as u32,
+            y: ((line.bbox.y as f32) / scale).round() as u32,
+            w: ((line.bbox.w as f32) / scale).round() as u32,
+            h: ((line.bbox.h as f32) / scale).round() as u32,
+        };
+        line.font_size /= scale;
+    }
 }
 
-pub(super) fn filter_lines(lines: Vec<OcrLine>, width: u32, height: u32) -> Vec<OcrLine> {
-    lines
-        .into_iter()
-        .filter(|line| is_line_valid(line, width, height))
-        .collect()
+pub(super) fn filter_lines(lines: &mut Vec<OcrLine>, width: u32, height: u32) {
+    lines.retain(|line| is_line_valid(line, width, height));
 }
 
 fn is_line_valid(line: &OcrLine, width: u32, height: u32) -> bool {
@@ -139,14 +128,17 @@ fn text_stats(text: &str) -> TextStats {
     stats
 }
 
-pub(super) fn merge_inline_lines(mut lines: Vec<OcrLine>) -> Vec<OcrLine> {
+/// Joins vertically adjacent fragments of the same line, compacting `lines` in place.
+pub(super) fn merge_inline_lines(lines: &mut Vec<OcrLine>) {
     lines.sort_by_key(|line| (line.bbox.y, line.bbox.x));
-    let mut merged: Vec<OcrLine> = Vec::new();
-
-    for line in lines {
-        if let Some(last) = merged.last_mut() {
+    let mut kept = 0usize;
+    for index in 0..lines.len() {
+        if kept > 0 {
+            let (head, tail) = lines.split_at_mut(index);
+            let last = &mut head[kept - 1];
+            let line = &tail[0];
             let same_line = vertical_overlap_ratio(&last.bbox, &line.bbox) > 0.6;
-            if same_line && should_merge_lines(last, &line) {
+            if same_line && should_merge_lines(last, line) {
                 last.text = join_inline(&last.text, &line.text);
                 last.bbox = union_bbox(&last.bbox, &line.bbox);
                 last.conf = merge_conf(last.conf, last.text.len(), line.conf, line.text.len());
@@ -154,10 +146,10 @@ pub(super) fn merge_inline_lines(mut lines: Vec<OcrLine>) -> Vec<OcrLine> {
                 continue;
             }
         }
-        merged.push(line);
+        lines.swap(kept, index);
+        kept += 1;
     }
-
-    merged
+    lines.truncate(kept);
 }
 
 fn should_merge_lines(a: &OcrLine, b: &OcrLine) -> bool {
@@ -168,17 +160,18 @@ fn should_merge_lines(a: &OcrLine, b: &OcrLine) -> bool {
     gap <= max_gap && (overlap > 0.2 || close_x)
 }
 
-pub(super) fn suppress_overlaps(lines: Vec<OcrLine>) -> Vec<OcrLine> {
-    let mut sorted = lines;
-    sorted.sort_by(|a, b| {
-        b.conf
-            .partial_cmp(&a.conf)
-            .unwrap_or(std::cmp::Ordering::Equal)
-    });
-    let mut kept: Vec<OcrLine> = Vec::new();
+/// Drops lines covered by a more confident one. Candidates are visited by index in
+/// confidence order and the survivors are kept in place, then sorted into reading order.
+pub(super) fn suppress_overlaps(lines: &mut Vec<OcrLine>) {
+    let mut order = (0..lines.len()).collect::<Vec<_>>();
+    order.sort_by(|&a, &b| by_conf_desc(&lines[a], &lines[b]));
+    let mut kept: Vec<usize> = Vec::new();
+    let mut keep = vec![false; lines.len()];
 
-    'outer: for line in sorted {
-        for existing in &kept {
+    'outer: for idx in order {
+        let line = &lines[idx];
+        for &existing in &kept {
+            let existing = &lines[existing];
             if iou(&existing.bbox, &line.bbox) > 0.5 {
                 continue 'outer;
             }
@@ -188,10 +181,23 @@ pub(super) fn suppress_overlaps(lines: Vec<OcrLine>) -> Vec<OcrLine> {
                 continue 'outer;
             }
         }
-        kept.push(line);
-    }
-    kept.sort_by_key(|line| (line.bbox.y, line.bbox.x));
-    kept
+        kept.push(idx);
+        keep[idx] = true;
+    }
+    let mut keep = keep.into_iter();
+    lines.retain(|_| keep.next().unwrap_or(false));
+    // Confidence breaks ties so equal positions come out as they did when sorted by it first.
+    lines.sort_by(|a, b| {
+        (a.bbox.y, a.bbox.x)
+            .cmp(&(b.bbox.y, b.bbox.x))
+            .then_with(|| by_conf_desc(a, b))
+    });
+}
+
+fn by_conf_desc(a: &OcrLine, b: &OcrLine) -> std::cmp::Ordering {
+    b.conf
+        .partial_cmp(&a.conf)
+        .unwrap_or(std::cmp::Ordering::Equal)
 }
 
 fn cjk_ratio(text: &str) -> f32 {
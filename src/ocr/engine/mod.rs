@@ -1,17 +1,23 @@
 mod geom;
 mod layout;
+mod libtesseract;
 mod merge;
 mod parse;
 mod preprocess;
 mod tesseract;
 mod text;
 
-use anyhow::{Context, Result};
-use image::GenericImageView;
+use anyhow::{Context, Result, anyhow};
+use image::{GenericImageView, GrayImage};
 use std::io::Write;
+use std::sync::{Condvar, Mutex, MutexGuard, OnceLock};
+use std::thread;
+use tempfile::NamedTempFile;
 
-use crate::ocr::OcrResult;
+use crate::ocr::{OcrLine, OcrResult};
 
+#[cfg(feature = "bench")]
+pub(crate) use parse::{parse_hocr_lines, parse_tsv_lines};
 pub use tesseract::list_tesseract_languages;
 
 pub(crate) use layout::{
@@ -20,41 +26,42 @@ pub(crate) use layout::{
 };
 
 pub fn extract_lines(image_bytes: &[u8], ocr_languages: &str) -> Result<OcrResult> {
+    crate::metrics::time(&crate::metrics::OCR_PAGE, &[], || {
+        extract_page_lines(image_bytes, ocr_languages)
+    })
+}
+
+fn extract_page_lines(image_bytes: &[u8], ocr_languages: &str) -> Result<OcrResult> {
     let image =
         image::load_from_memory(image_bytes).with_context(|| "failed to decode image for OCR")?;
     let (width, height) = image.dimensions();
     let scale = preprocess::ocr_scale(width);
     let languages = tesseract::normalize_ocr_languages(ocr_languages)?;
 
-    let mut lines = Vec::new();
     let variants = preprocess::preprocess_for_ocr_variants(image, scale);
-    for (variant_idx, ocr_image) in variants.into_iter().enumerate() {
-        let mut tmp = tempfile::Builder::new()
-            .suffix(".png")
-            .tempfile()
-            .with_context(|| "failed to create temp file for OCR")?;
-        ocr_image
-            .write_to(&mut tmp, image::ImageFormat::Png)
-            .with_context(|| "failed to write temp image for OCR")?;
-        tmp.flush().ok();
-
-        let psm_list: &[u32] = if variant_idx == 0 { &[6, 4] } else { &[4] };
-        for psm in psm_list {
-            let hocr = tesseract::run_tesseract_hocr(tmp.path(), &languages, *psm)?;
-            let mut parsed = parse::parse_hocr_lines(&hocr)?;
-            if parsed.is_empty() {
-                let tsv = tesseract::run_tesseract_tsv(tmp.path(), &languages, *psm)?;
-                parsed = parse::parse_tsv_lines(&tsv)?;
-            }
-            lines = merge::merge_lines(lines, parsed);
+    let results = match libtesseract::checkout(&languages) {
+        // One warm engine runs the passes in turn: a handle per pass would multiply the
+        // engines (and their model memory) kept per language set, and pages already run
+        // on several workers.
+        Some(mut engine) => {
+            let _slot = PassSlot::acquire();
+            PASSES
+                .iter()
+                .map(|&(variant, psm)| engine_pass(&mut engine, &variants[variant], psm))
+                .collect::<Vec<_>>()
         }
+        None => cli_passes(&variants, &languages),
+    };
+    let mut lines = Vec::new();
+    for parsed in results {
+        merge::merge_lines(&mut lines, parsed?);
     }
     if scale > 1 {
-        lines = merge::scale_lines(lines, scale as f32);
+        merge::scale_lines(&mut lines, scale as f32);
     }
-    lines = merge::filter_lines(lines, width, height);
-    lines = merge::merge_inline_lines(lines);
-    lines = merge::suppress_overlaps(lines);
+    merge::filter_lines(&mut lines, width, height);
+    merge::merge_inline_lines(&mut lines);
+    merge::suppress_overlaps(&mut lines);
 
     Ok(OcrResult {
         width,
@@ -62,3 +69,114 @@ pub fn extract_lines(image_bytes: &[u8], ocr_languages: &str) -> Result<OcrResul
         lines,
     })
 }
+
+/// `(variant, psm)` OCR passes over the preprocessed variants (binarized, then stretched).
+const PASSES: &[(usize, u32)] = &[(0, 6), (0, 4), (1, 4)];
+
+static BUSY_PASSES: Mutex<usize> = Mutex::new(0);
+static PASS_FREED: Condvar = Condvar::new();
+
+/// Caps OCR passes running at once across the process (pages are OCR'd on several worker
+/// threads too) at the number of CPUs.
+struct PassSlot;
+
+impl PassSlot {
+    fn acquire() -> Self {
+        let limit = num_cpus::get().max(1);
+        let mut busy = lock_busy();
+        while *busy >= limit {
+            busy = match PASS_FREED.wait(busy) {
+                Ok(guard) => guard,
+                Err(poisoned) => poisoned.into_inner(),
+            };
+        }
+        *busy += 1;
+        Self
+    }
+}
+
+impl Drop for PassSlot {
+    fn drop(&mut self) {
+        *lock_busy() -= 1;
+        PASS_FREED.notify_one();
+    }
+}
+
+fn lock_busy() -> MutexGuard<'static, usize> {
+    match BUSY_PASSES.lock() {
+        Ok(guard) => guard,
+        Err(poisoned) => poisoned.into_inner(),
+    }
+}
+
+fn engine_pass(
+    engine: &mut libtesseract::PooledEngine,
+    image: &GrayImage,
+    psm: u32,
+) -> Result<Vec<OcrLine>> {
+    let mut parsed = parse::parse_hocr_lines(&engine.hocr(image, psm)?)?;
+    if parsed.is_empty() {
+        parsed = parse::parse_tsv_lines(&engine.tsv()?)?;
+    }
+    Ok(parsed)
+}
+
+/// Runs the passes as tesseract CLI processes side by side; results come back in PASSES
+/// order, so merging them gives the same lines as running them one after another. Each
+/// variant's temp PNG is written once and shared by that variant's passes.
+fn cli_passes(variants: &[GrayImage], languages: &str) -> Vec<Result<Vec<OcrLine>>> {
+    let cli_inputs: Vec<OnceLock<Result<NamedTempFile, String>>> =
+        variants.iter().map(|_| OnceLock::new()).collect();
+    thread::scope(|scope| {
+        let handles = PASSES
+            .iter()
+            .map(|&(variant, psm)| {
+                let image = &variants[variant];
+                let cli_input = &cli_inputs[variant];
+                scope.spawn(move || {
+                    let _slot = PassSlot::acquire();
+                    cli_pass(image, cli_input, languages, psm)
+                })
+            })
+            .collect::<Vec<_>>();
+        handles
+            .into_iter()
+            .map(|handle| {
+                handle
+                    .join()
+                    .unwrap_or_else(|_| Err(anyhow!("OCR pass panicked")))
+            })
+            .collect()
+    })
+}
+
+fn cli_pass(
+    image: &GrayImage,
+    cli_input: &OnceLock<Result<NamedTempFile, String>>,
+    languages: &str,
+    psm: u32,
+) -> Result<Vec<OcrLine>> {
+    let tmp = cli_input
+        .get_or_init(|| write_temp_png(image).map_err(|err| format!("{:#}", err)))
+        .as_ref()
+        .map_err(|err| anyhow!("{}", err))?;
+    let hocr = tesseract::run_tesseract_hocr(tmp.path(), languages, psm)?;
+    let mut parsed = parse::parse_hocr_lines(&hocr)?;
+    if parsed.is_empty() {
+        let tsv = tesseract::run_tesseract_tsv(tmp.path(), languages, psm)?;
+        parsed = parse::parse_tsv_lines(&tsv)?;
+    }
+    Ok(parsed)
+}
+
+fn write_temp_png(image: &GrayImage) -> Result<NamedTempFile> {
+    let mut tmp = tempfile::Builder::new()
+        .suffix(".png")
+        .tempfile()
+        .with_context(|| "failed to create temp file for OCR")?;
+    image
+        .write_to(&mut tmp, image::ImageFormat::Png)
+        .with_context(|| "failed to write temp image for OCR")?;
+    tmp.flush().ok();
+    Ok(tmp)
+}
@@ -1,180 +1,267 @@
 use anyhow::Result;
-use std::collections::HashMap;
+use quick_xml::Reader;
+use quick_xml::events::{BytesStart, Event};
+use std::cell::RefCell;
 
 use crate::ocr::{BBoxPx, OcrLine};
 
 use super::geom::union_bbox;
 use super::text::needs_space;
 
+/// A recognized word. Its text is `text[start..end]` of the arena it was parsed into.
 #[derive(Clone)]
-struct WordToken {
-    text: String,
+struct Word {
+    /// TSV (page, block, paragraph, line) numbers; hOCR words are grouped by their span.
+    line: (i32, i32, i32, i32),
+    start: usize,
+    end: usize,
     bbox: BBoxPx,
     conf: f32,
     len: usize,
 }
 
-pub(super) fn parse_tsv_lines(tsv: &str) -> Result<Vec<OcrLine>> {
-    let mut word_map: HashMap<(i32, i32, i32, i32), Vec<WordToken>> = HashMap::new();
+/// Buffers reused across lines and pages, so a parse allocates little beyond its output.
+struct WordArena {
+    text: String,
+    words: Vec<Word>,
+    heights: Vec<u32>,
+}
 
-    for (idx, row) in tsv.lines().enumerate() {
-        if idx == 0 {
-            continue;
-        }
-        let cols = row.split('\t').collect::<Vec<_>>();
-        if cols.len() < 12 {
-            continue;
-        }
-        let level: i32 = cols[0].parse().unwrap_or(0);
-        if level != 5 {
-            continue;
-        }
-        let page_num: i32 = cols[1].parse().unwrap_or(0);
-        let block_num: i32 = cols[2].parse().unwrap_or(0);
-        let par_num: i32 = cols[3].parse().unwrap_or(0);
-        let line_num: i32 = cols[4].parse().unwrap_or(0);
-        let left: u32 = cols[6].parse().unwrap_or(0);
-        let top: u32 = cols[7].parse().unwrap_or(0);
-        let width: u32 = cols[8].parse().unwrap_or(0);
-        let height: u32 = cols[9].parse().unwrap_or(0);
-        let conf: f32 = cols[10].parse().unwrap_or(-1.0);
-        let text = cols[11].trim();
-        if text.is_empty() || conf < 0.0 {
-            continue;
-        }
+thread_local! {
+    static ARENA: RefCell<WordArena> = const {
+        RefCell::new(WordArena {
+            text: String::new(),
+            words: Vec::new(),
+            heights: Vec::new(),
+        })
+    };
+}
 
-        let word_bbox = BBoxPx {
-            x: left,
-            y: top,
-            w: width,
-            h: height,
-        };
-        let len = text.chars().count().max(1);
-        let key = (page_num, block_num, par_num, line_num);
-        word_map.entry(key).or_default().push(WordToken {
-            text: text.to_string(),
-            bbox: word_bbox,
-            conf,
-            len,
-        });
-    }
+pub(crate) fn parse_tsv_lines(tsv: &str) -> Result<Vec<OcrLine>> {
+    ARENA.with(|arena| {
+        let WordArena {
+            text,
+            words,
+            heights,
+        } = &mut *arena.borrow_mut();
+        text.clear();
+        words.clear();
 
-    let mut lines = Vec::new();
-    for (_, mut words) in word_map {
-        words.sort_by_key(|word| word.bbox.x);
-        for segment in split_word_segments(words) {
-            if let Some(line) = build_line(&segment) {
-                lines.push(line);
+        for row in tsv.lines().skip(1) {
+            let mut cols = [""; 12];
+            let mut count = 0;
+            for (slot, col) in cols.iter_mut().zip(row.split('\t')) {
+                *slot = col;
+                count += 1;
+            }
+            if count < cols.len() {
+                continue;
+            }
+            let level: i32 = cols[0].parse().unwrap_or(0);
+            if level != 5 {
+                continue;
             }
+            let page_num: i32 = cols[1].parse().unwrap_or(0);
+            let block_num: i32 = cols[2].parse().unwrap_or(0);
+            let par_num: i32 = cols[3].parse().unwrap_or(0);
+            let line_num: i32 = cols[4].parse().unwrap_or(0);
+            let left: u32 = cols[6].parse().unwrap_or(0);
+            let top: u32 = cols[7].parse().unwrap_or(0);
+            let width: u32 = cols[8].parse().unwrap_or(0);
+            let height: u32 = cols[9].parse().unwrap_or(0);
+            let conf: f32 = cols[10].parse().unwrap_or(-1.0);
+            let word_text = cols[11].trim();
+            if word_text.is_empty() || conf < 0.0 {
+                continue;
+            }
+
+            let start = text.len();
+            text.push_str(word_text);
+            words.push(Word {
+                line: (page_num, block_num, par_num, line_num),
+                start,
+                end: text.len(),
+                bbox: BBoxPx {
+                    x: left,
+                    y: top,
+                    w: width,
+                    h: height,
+                },
+                conf,
+                len: word_text.chars().count().max(1),
+            });
         }
-    }
 
-    Ok(lines)
+        // Stable, so words at the same x keep their row order.
+        words.sort_by_key(|word| (word.line, word.bbox.x));
+        let mut lines = Vec::new();
+        for line_words in words.chunk_by(|a, b| a.line == b.line) {
+            push_segments(text, line_words, heights, &mut lines);
+        }
+        Ok(lines)
+    })
+}
+
+/// A word span whose closing tag has not been seen yet.
+struct OpenWord {
+    depth: usize,
+    start: usize,
+    bbox: Option<BBoxPx>,
+    conf: Option<f32>,
 }
 
-pub(super) fn parse_hocr_lines(hocr: &str) -> Result<Vec<OcrLine>> {
-    let mut lines = Vec::new();
-    let bytes = hocr.as_bytes();
-    let mut i = 0usize;
-    while let Some(start) = find_subslice(bytes, b"<span", i) {
-        let tag_end = match find_byte(bytes, b'>', start) {
-            Some(end) => end,
-            None => break,
-        };
-        let tag = &hocr[start..tag_end];
-        if !tag.contains("ocr_line") {
-            i = tag_end + 1;
-            continue;
-        }
-        let (inner_start, inner_end) = match find_span_inner(bytes, tag_end + 1) {
-            Some(value) => value,
-            None => break,
-        };
-        let inner = &hocr[inner_start..inner_end];
-        let mut words = parse_hocr_words(inner);
-        if words.is_empty() {
-            i = inner_end + "</span>".len();
-            continue;
-        }
-        words.sort_by_key(|word| word.bbox.x);
-        for segment in split_word_segments(words) {
-            if let Some(line) = build_line(&segment) {
-                lines.push(line);
+/// Single pass over the hOCR events. Word text goes straight into the arena and each
+/// `ocr_line` span is turned into lines as soon as it closes.
+pub(crate) fn parse_hocr_lines(hocr: &str) -> Result<Vec<OcrLine>> {
+    ARENA.with(|arena| {
+        let WordArena {
+            text,
+            words,
+            heights,
+        } = &mut *arena.borrow_mut();
+        let mut lines = Vec::new();
+        let mut reader = Reader::from_str(hocr);
+        reader.trim_text(false);
+        reader.check_end_names(false);
+
+        let mut depth = 0usize;
+        let mut line_depth: Option<usize> = None;
+        let mut word: Option<OpenWord> = None;
+        loop {
+            match reader.read_event() {
+                Ok(Event::Start(tag)) if tag.name().as_ref() == b"span" => {
+                    depth += 1;
+                    if line_depth.is_none() {
+                        if contains_bytes(&tag, b"ocr_line") {
+                            line_depth = Some(depth);
+                            text.clear();
+                            words.clear();
+                        }
+                    } else if word.is_none() && contains_bytes(&tag, b"ocrx_word") {
+                        let (bbox, conf) = parse_word_title(&tag);
+                        word = Some(OpenWord {
+                            depth,
+                            start: text.len(),
+                            bbox,
+                            conf,
+                        });
+                    }
+                }
+                Ok(Event::End(tag)) if tag.name().as_ref() == b"span" => {
+                    if let Some(open) = word.take_if(|open| open.depth == depth) {
+                        finish_word(open, text, words);
+                    }
+                    if line_depth == Some(depth) {
+                        line_depth = None;
+                        words.sort_by_key(|word| word.bbox.x);
+                        push_segments(text, words, heights, &mut lines);
+                    }
+                    depth = depth.saturating_sub(1);
+                }
+                Ok(Event::Text(value)) if word.is_some() => {
+                    let decoded = match value.unescape() {
+                        Ok(decoded) => decoded,
+                        Err(_) => String::from_utf8_lossy(&value),
+                    };
+                    text.extend(
+                        decoded
+                            .chars()
+                            .map(|ch| if ch == '\u{00a0}' { ' ' } else { ch }),
+                    );
+                }
+                // Whatever was complete before malformed markup is kept.
+                Ok(Event::Eof) | Err(_) => break,
+                Ok(_) => {}
             }
         }
-        i = inner_end + "</span>".len();
-    }
-    Ok(lines)
+        Ok(lines)
+    })
 }
 
-fn split_word_segments(words: Vec<WordToken>) -> Vec<Vec<WordToken>> {
-    if words.is_empty() {
-        return Vec::new();
-    }
-    if words.len() == 1 {
-        return vec![words];
+/// Keeps the word's trimmed text in the arena if it passes the filters, else drops it.
+fn finish_word(open: OpenWord, text: &mut String, words: &mut Vec<Word>) {
+    let raw = &text[open.start..];
+    let start = open.start + (raw.len() - raw.trim_start().len());
+    let cleaned = raw.trim();
+    let end = start + cleaned.len();
+    if let (Some(bbox), Some(conf)) = (open.bbox, open.conf)
+        && should_keep_hocr_word(cleaned, conf, &bbox)
+    {
+        let len = cleaned.chars().count().max(1);
+        words.push(Word {
+            line: (0, 0, 0, 0),
+            start,
+            end,
+            bbox,
+            conf,
+            len,
+        });
+        text.truncate(end);
+    } else {
+        text.truncate(open.start);
     }
+}
 
-    let mut heights = words.iter().map(|word| word.bbox.h).collect::<Vec<_>>();
+/// Splits the x-sorted words of one line at large horizontal or vertical jumps and appends a
+/// line per segment.
+fn push_segments(text: &str, words: &[Word], heights: &mut Vec<u32>, lines: &mut Vec<OcrLine>) {
+    let Some(first) = words.first() else {
+        return;
+    };
+    heights.clear();
+    heights.extend(words.iter().map(|word| word.bbox.h));
     heights.sort_unstable();
     let median_h = heights[heights.len() / 2].max(1) as f32;
     let gap_threshold = (median_h * 2.5).clamp(12.0, 120.0);
     let vertical_threshold = (median_h * 0.9).clamp(6.0, 80.0);
 
-    let mut segments: Vec<Vec<WordToken>> = Vec::new();
-    let mut current: Vec<WordToken> = Vec::new();
-    let mut last_right = 0u32;
-    let mut last_center_y = 0f32;
-    for word in words {
-        if current.is_empty() {
-            last_right = word.bbox.x + word.bbox.w;
-            last_center_y = word.bbox.y as f32 + word.bbox.h as f32 * 0.5;
-            current.push(word);
-            continue;
-        }
+    let mut segment_start = 0usize;
+    let mut last_right = first.bbox.x + first.bbox.w;
+    let mut last_center_y = center_y(&first.bbox);
+    for (index, word) in words.iter().enumerate().skip(1) {
         let gap = word.bbox.x.saturating_sub(last_right);
-        let center_y = word.bbox.y as f32 + word.bbox.h as f32 * 0.5;
-        let vertical_gap = (center_y - last_center_y).abs();
+        let center = center_y(&word.bbox);
+        let vertical_gap = (center - last_center_y).abs();
         if (gap as f32) > gap_threshold || vertical_gap > vertical_threshold {
-            segments.push(current);
-            current = vec![word];
-            last_right = current[0].bbox.x + current[0].bbox.w;
-            last_center_y = current[0].bbox.y as f32 + current[0].bbox.h as f32 * 0.5;
+            lines.extend(build_line(text, &words[segment_start..index], heights));
+            segment_start = index;
+            last_right = word.bbox.x + word.bbox.w;
+            last_center_y = center;
         } else {
             last_right = last_right.max(word.bbox.x + word.bbox.w);
-            last_center_y = (last_center_y + (word.bbox.y as f32 + word.bbox.h as f32 * 0.5)) * 0.5;
-            current.push(word);
+            last_center_y = (last_center_y + center) * 0.5;
         }
     }
-    if !current.is_empty() {
-        segments.push(current);
-    }
-    segments
+    lines.extend(build_line(text, &words[segment_start..], heights));
+}
+
+fn center_y(bbox: &BBoxPx) -> f32 {
+    bbox.y as f32 + bbox.h as f32 * 0.5
 }
 
-fn build_line(words: &[WordToken]) -> Option<OcrLine> {
+fn build_line(text: &str, words: &[Word], heights: &mut Vec<u32>) -> Option<OcrLine> {
     if words.is_empty() {
         return None;
     }
 
-    let mut text = String::new();
-    let mut last_token = String::new();
+    let mut line_text = String::new();
+    let mut last_token = "";
     for word in words {
-        if !text.is_empty() && needs_space(&last_token, &word.text) {
-            text.push(' ');
+        let token = &text[word.start..word.end];
+        if !line_text.is_empty() && needs_space(last_token, token) {
+            line_text.push(' ');
         }
-        text.push_str(&word.text);
-        last_token = word.text.clone();
+        line_text.push_str(token);
+        last_token = token;
     }
-    let final_text = text.trim();
-    if final_text.is_empty() {
+    if line_text.trim().is_empty() {
         return None;
     }
 
     let mut bbox_opt: Option<BBoxPx> = None;
     let mut conf_sum = 0.0;
     let mut len_sum = 0.0;
-    let mut heights: Vec<u32> = Vec::new();
+    heights.clear();
     for word in words {
         bbox_opt = Some(if let Some(bbox) = bbox_opt.take() {
             union_bbox(&bbox, &word.bbox)
@@ -197,139 +284,53 @@ fn build_line(words: &[WordToken]) -> Option<OcrLine> {
     let font_size = (median_h * 0.9).clamp(8.0, 96.0);
 
     Some(OcrLine {
-        text: final_text.to_string(),
+        text: line_text,
         bbox,
         conf: avg_conf,
         font_size,
     })
 }
 
-fn find_subslice(haystack: &[u8], needle: &[u8], from: usize) -> Option<usize> {
-    haystack[from..]
+fn contains_bytes(haystack: &[u8], needle: &[u8]) -> bool {
+    haystack
         .windows(needle.len())
-        .position(|win| win == needle)
-        .map(|pos| from + pos)
-}
-
-fn find_byte(haystack: &[u8], needle: u8, from: usize) -> Option<usize> {
-    haystack[from..]
-        .iter()
-        .position(|b| *b == needle)
-        .map(|pos| from + pos)
-}
-
-fn find_span_inner(bytes: &[u8], start: usize) -> Option<(usize, usize)> {
-    let mut depth = 1i32;
-    let mut i = start;
-    while i < bytes.len() {
-        if bytes[i] == b'<' {
-            if bytes[i..].starts_with(b"<span") {
-                depth += 1;
-            } else if bytes[i..].starts_with(b"</span") {
-                depth -= 1;
-                if depth == 0 {
-                    return Some((start, i));
-                }
-            }
-        }
-        i += 1;
-    }
-    None
-}
-
-fn extract_attr(tag: &str, name: &str) -> Option<String> {
-    let needle = format!("{}=", name);
-    let idx = tag.find(&needle)?;
-    let mut rest = &tag[idx + needle.len()..];
-    if rest.starts_with('"') || rest.starts_with('\'') {
-        let quote = rest.chars().next().unwrap();
-        rest = &rest[1..];
-        let end = rest.find(quote)?;
-        return Some(rest[..end].to_string());
-    }
-    None
+        .any(|window| window == needle)
 }
 
-fn strip_tags(value: &str) -> String {
-    let mut out = String::new();
-    let mut in_tag = false;
-    for ch in value.chars() {
-        match ch {
-            '<' => in_tag = true,
-            '>' => in_tag = false,
-            _ => {
-                if !in_tag {
-                    out.push(ch);
-                }
-            }
-        }
-    }
-    out
-}
-
-fn decode_entities(value: &str) -> String {
-    value
-        .replace("&amp;", "&")
-        .replace("&lt;", "<")
-        .replace("&gt;", ">")
-        .replace("&quot;", "\"")
-        .replace("&apos;", "'")
-}
-
-fn parse_hocr_words(inner: &str) -> Vec<WordToken> {
-    let bytes = inner.as_bytes();
-    let mut words = Vec::new();
-    let mut i = 0usize;
-    while let Some(start) = find_subslice(bytes, b"<span", i) {
-        let tag_end = match find_byte(bytes, b'>', start) {
-            Some(end) => end,
-            None => break,
-        };
-        let tag = &inner[start..tag_end];
-        if !tag.contains("ocrx_word") {
-            i = tag_end + 1;
-            continue;
-        }
-        let (inner_start, inner_end) = match find_span_inner(bytes, tag_end + 1) {
-            Some(value) => value,
-            None => break,
-        };
-        let word_text =
-            decode_entities(&strip_tags(&inner[inner_start..inner_end])).replace('\u{00a0}', " ");
-        let word_text = word_text.trim();
-        let bbox = parse_hocr_bbox_from_title(tag);
-        let conf = parse_hocr_conf_from_title(tag);
-        if let (Some(bbox), Some(conf)) = (bbox, conf) {
-            let cleaned = normalize_word_text(word_text);
-            if should_keep_hocr_word(&cleaned, conf, &bbox) {
-                let len = cleaned.chars().count().max(1);
-                words.push(WordToken {
-                    text: cleaned,
-                    bbox,
-                    conf,
-                    len,
-                });
-            }
-        }
-        i = inner_end + "</span>".len();
+/// Bounding box and confidence from a word span's `title`, read in place.
+fn parse_word_title(tag: &BytesStart<'_>) -> (Option<BBoxPx>, Option<f32>) {
+    let title = tag
+        .attributes()
+        .with_checks(false)
+        .flatten()
+        .find(|attr| attr.key.as_ref() == b"title");
+    match title
+        .as_ref()
+        .and_then(|attr| std::str::from_utf8(&attr.value).ok())
+    {
+        Some(title) => (
+            parse_hocr_bbox_from_title(title),
+            parse_hocr_conf_from_title(title),
+        ),
+        None => (None, None),
     }
-    words
 }
 
-fn parse_hocr_bbox_from_title(tag: &str) -> Option<BBoxPx> {
-    let title = extract_attr(tag, "title")?;
+fn parse_hocr_bbox_from_title(title: &str) -> Option<BBoxPx> {
     let bbox_idx = title.find("bbox")?;
     let rest = &title[bbox_idx + 4..];
-    let nums = rest
-        .split([' ', ';'])
-        .filter(|v| !v.is_empty())
-        .take(4)
-        .filter_map(|v| v.parse::<u32>().ok())
-        .collect::<Vec<_>>();
-    if nums.len() != 4 {
+    let mut nums = [0u32; 4];
+    let mut count = 0;
+    for value in rest.split([' ', ';']).filter(|v| !v.is_empty()).take(4) {
+        if let Ok(num) = value.parse::<u32>() {
+            nums[count] = num;
+            count += 1;
+        }
+    }
+    if count != 4 {
         return None;
     }
-    let (x1, y1, x2, y2) = (nums[0], nums[1], nums[2], nums[3]);
+    let [x1, y1, x2, y2] = nums;
     if x2 <= x1 || y2 <= y1 {
         return None;
     }
@@ -341,18 +342,13 @@ fn parse_hocr_bbox_from_title(tag: &str) -> Option<BBoxPx> {
     })
 }
 
-fn parse_hocr_conf_from_title(tag: &str) -> Option<f32> {
-    let title = extract_attr(tag, "title")?;
+fn parse_hocr_conf_from_title(title: &str) -> Option<f32> {
     let idx = title.find("x_wconf")?;
     let rest = &title[idx + "x_wconf".len()..];
     let value = rest.split([' ', ';']).find(|v| !v.is_empty())?;
     value.parse::<f32>().ok()
 }
 
-fn normalize_word_text(value: &str) -> String {
-    value.trim().to_string()
-}
-
 fn should_keep_hocr_word(text: &str, conf: f32, bbox: &BBoxPx) -> bool {
     if text.is_empty() {
         return false;
@@ -382,3 +378,43 @@ fn is_cjk_or_kana(ch: char) -> bool {
         0x4E00..=0x9FFF | 0x3040..=0x30FF | 0x31F0..=0x31FF | 0x3400..=0x4DBF
     )
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn hocr_words_become_lines_split_at_wide_gaps() {
+        let hocr = "<html><body><div class='ocr_page'>\
+            <span class='ocr_line' title='bbox 0 0 900 30'>\
+            <span class='ocrx_word' title='bbox 10 0 80 24; x_wconf 91'>It&#39;s</span> \
+            <span class='ocrx_word' title='bbox 90 0 160 24; x_wconf 88'><strong>fine</strong></span> \
+            <span class='ocrx_word' title='bbox 170 0 180 24; x_wconf 20'>~</span> \
+            <span class='ocrx_word' title='bbox 600 0 700 24; x_wconf 95'>&amp;far</span>\
+            </span></div></body></html>";
+        let lines = parse_hocr_lines(hocr).expect("hocr");
+        let texts = lines
+            .iter()
+            .map(|line| line.text.as_str())
+            .collect::<Vec<_>>();
+        assert_eq!(texts, vec!["It's fine", "&far"]);
+        assert_eq!((lines[0].bbox.x, lines[0].bbox.w), (10, 150));
+        assert!((lines[0].conf - (91.0 * 4.0 + 88.0 * 4.0) / 8.0).abs() < 1e-3);
+    }
+
+    #[test]
+    fn tsv_rows_are_grouped_by_line_key_and_sorted_by_x() {
+        let tsv = "level\tpage_num\tblock_num\tpar_num\tline_num\tword_num\tleft\ttop\twidth\theight\tconf\ttext\n\
+            5\t1\t1\t1\t2\t1\t10\t40\t50\t20\t90\tsecond\n\
+            5\t1\t1\t1\t1\t2\t70\t0\t50\t20\t90\tworld\n\
+            5\t1\t1\t1\t1\t1\t10\t0\t50\t20\t90\thello\n\
+            4\t1\t1\t1\t1\t0\t10\t0\t110\t20\t-1\t\n\
+            5\t1\t1\t1\t2\t2\t70\t40\t50\t20\t-1\tdropped\n";
+        let lines = parse_tsv_lines(tsv).expect("tsv");
+        let texts = lines
+            .iter()
+            .map(|line| line.text.as_str())
+            .collect::<Vec<_>>();
+        assert_eq!(texts, vec!["hello world", "second"]);
+    }
+}
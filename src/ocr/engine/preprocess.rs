@@ -1,37 +1,57 @@
-use image::DynamicImage;
+use image::{DynamicImage, GrayImage};
+use std::cell::RefCell;
 
-pub(super) fn preprocess_for_ocr_variants(image: DynamicImage, scale: u32) -> Vec<DynamicImage> {
-    let rgba = image.to_rgba8();
-    let (width, height) = rgba.dimensions();
-    let mut luma = image::GrayImage::new(width, height);
+const BINARIZE_THRESHOLD: u8 = (0.65 * 255.0) as u8;
 
-    for (x, y, pixel) in rgba.enumerate_pixels() {
-        let [r, g, b, a] = pixel.0;
-        let alpha = a as f32 / 255.0;
-        let r = (r as f32 * alpha + 255.0 * (1.0 - alpha)).round() as u8;
-        let g = (g as f32 * alpha + 255.0 * (1.0 - alpha)).round() as u8;
-        let b = (b as f32 * alpha + 255.0 * (1.0 - alpha)).round() as u8;
-        let value = (0.299 * r as f32 + 0.587 * g as f32 + 0.114 * b as f32).round() as u8;
-        luma.put_pixel(x, y, image::Luma([value]));
-    }
+thread_local! {
+    /// Full-size grayscale scratch reused between pages when the image is upscaled.
+    static LUMA_SCRATCH: RefCell<Vec<u8>> = const { RefCell::new(Vec::new()) };
+}
 
+/// Returns the binarized and the contrast-stretched grayscale variant, in that order.
+///
+/// The kernels below are branch-free loops over raw slices in integer arithmetic so the
+/// compiler vectorizes them, and both variants are written in one pass through lookup
+/// tables instead of stretching, cloning and thresholding separately.
+pub(super) fn preprocess_for_ocr_variants(image: DynamicImage, scale: u32) -> Vec<GrayImage> {
+    let (width, height) = (image.width(), image.height());
     let resized = if scale > 1 {
-        image::imageops::resize(
-            &luma,
-            width.saturating_mul(scale),
-            height.saturating_mul(scale),
-            image::imageops::FilterType::Lanczos3,
-        )
+        LUMA_SCRATCH.with(|scratch| {
+            let mut buffer = std::mem::take(&mut *scratch.borrow_mut());
+            grayscale_on_white(&image, &mut buffer);
+            drop(image);
+            let luma = GrayImage::from_raw(width, height, buffer).expect("luma buffer size");
+            let resized = image::imageops::resize(
+                &luma,
+                width.saturating_mul(scale),
+                height.saturating_mul(scale),
+                image::imageops::FilterType::Lanczos3,
+            );
+            *scratch.borrow_mut() = luma.into_raw();
+            resized
+        })
     } else {
-        luma
+        let mut buffer = Vec::new();
+        grayscale_on_white(&image, &mut buffer);
+        GrayImage::from_raw(width, height, buffer).expect("luma buffer size")
     };
 
-    let stretched = contrast_stretch(&resized);
-    let threshold = (0.65 * 255.0) as u8;
-    let bin = binarize(&stretched, threshold);
+    let (out_width, out_height) = resized.dimensions();
+    let (stretch, binary) = variant_tables(resized.as_raw());
+    let mut stretched = vec![0u8; resized.as_raw().len()];
+    let mut bin = vec![0u8; resized.as_raw().len()];
+    for ((value, stretched), bin) in resized
+        .as_raw()
+        .iter()
+        .zip(stretched.iter_mut())
+        .zip(bin.iter_mut())
+    {
+        *stretched = stretch[*value as usize];
+        *bin = binary[*value as usize];
+    }
     vec![
-        DynamicImage::ImageLuma8(bin),
-        DynamicImage::ImageLuma8(stretched),
+        GrayImage::from_raw(out_width, out_height, bin).expect("variant size"),
+        GrayImage::from_raw(out_width, out_height, stretched).expect("variant size"),
     ]
 }
 
@@ -44,33 +64,121 @@ pub(super) fn ocr_scale(width: u32) -> u32 {
     scale.max(1)
 }
 
-fn contrast_stretch(image: &image::GrayImage) -> image::GrayImage {
-    let mut min = 255u8;
-    let mut max = 0u8;
-    for pixel in image.pixels() {
-        let value = pixel[0];
-        min = min.min(value);
-        max = max.max(value);
+/// Writes BT.601 luma into `out`, compositing transparent pixels onto white.
+fn grayscale_on_white(image: &DynamicImage, out: &mut Vec<u8>) {
+    out.clear();
+    if let DynamicImage::ImageLuma8(gray) = image {
+        out.extend_from_slice(gray.as_raw());
+        return;
+    }
+    let (width, height) = (image.width() as usize, image.height() as usize);
+    out.resize(width * height, 0);
+    match image {
+        DynamicImage::ImageRgb8(rgb) => {
+            for (pixel, value) in rgb.as_raw().chunks_exact(3).zip(out.iter_mut()) {
+                *value = luma(pixel[0] as u32, pixel[1] as u32, pixel[2] as u32);
+            }
+        }
+        DynamicImage::ImageRgba8(rgba) => rgba_luma(rgba.as_raw(), out),
+        other => rgba_luma(other.to_rgba8().as_raw(), out),
     }
+}
 
-    if max <= min {
-        return image.clone();
+fn rgba_luma(rgba: &[u8], out: &mut [u8]) {
+    for (pixel, value) in rgba.chunks_exact(4).zip(out.iter_mut()) {
+        let alpha = pixel[3] as u32;
+        let white = 255 * (255 - alpha);
+        let r = div255(pixel[0] as u32 * alpha + white);
+        let g = div255(pixel[1] as u32 * alpha + white);
+        let b = div255(pixel[2] as u32 * alpha + white);
+        *value = luma(r, g, b);
     }
+}
 
-    let scale = 255.0 / (max as f32 - min as f32);
-    let mut output = image.clone();
-    for pixel in output.pixels_mut() {
-        let value = pixel[0];
-        let stretched = ((value.saturating_sub(min)) as f32 * scale).round() as u8;
-        pixel[0] = stretched;
+/// Rounded `value / 255` for `value <= 255 * 255`.
+#[inline]
+fn div255(value: u32) -> u32 {
+    let value = value + 128;
+    (value + (value >> 8)) >> 8
+}
+
+/// 0.299 R + 0.587 G + 0.114 B in 16-bit fixed point, rounded.
+#[inline]
+fn luma(r: u32, g: u32, b: u32) -> u8 {
+    ((r * 19595 + g * 38470 + b * 7471 + 32768) >> 16) as u8
+}
+
+/// Lookup tables mapping a luma value to its contrast-stretched value and to the
+/// binarized value of that stretched value.
+fn variant_tables(pixels: &[u8]) -> ([u8; 256], [u8; 256]) {
+    // Independent min/max folds compile to packed min/max instructions.
+    let min = pixels.iter().copied().fold(u8::MAX, u8::min);
+    let max = pixels.iter().copied().fold(u8::MIN, u8::max);
+    let mut stretch = [0u8; 256];
+    for (value, slot) in stretch.iter_mut().enumerate() {
+        *slot = if max <= min {
+            value as u8
+        } else {
+            let scale = 255.0 / (max as f32 - min as f32);
+            ((value as u8).saturating_sub(min) as f32 * scale)
+                .round()
+                .min(255.0) as u8
+        };
     }
-    output
+    let mut binary = [0u8; 256];
+    for (slot, stretched) in binary.iter_mut().zip(stretch) {
+        *slot = if stretched > BINARIZE_THRESHOLD {
+            255
+        } else {
+            0
+        };
+    }
+    (stretch, binary)
 }
 
-fn binarize(image: &image::GrayImage, threshold: u8) -> image::GrayImage {
-    let mut output = image.clone();
-    for pixel in output.pixels_mut() {
-        pixel[0] = if pixel[0] > threshold { 255 } else { 0 };
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn variants_match_the_per_pixel_definition() {
+        let rgba = image::RgbaImage::from_fn(7, 3, |x, y| {
+            image::Rgba([
+                (x * 30) as u8,
+                (y * 80) as u8,
+                200,
+                if x == 0 { 0 } else { 255 },
+            ])
+        });
+        let variants = preprocess_for_ocr_variants(DynamicImage::ImageRgba8(rgba.clone()), 1);
+        assert_eq!(variants.len(), 2);
+
+        let expected_luma = rgba
+            .pixels()
+            .map(|pixel| {
+                let [r, g, b, a] = pixel.0;
+                let alpha = a as f32 / 255.0;
+                let blend = |c: u8| (c as f32 * alpha + 255.0 * (1.0 - alpha)).round();
+                (0.299 * blend(r) + 0.587 * blend(g) + 0.114 * blend(b)).round() as i32
+            })
+            .collect::<Vec<_>>();
+        let min = *expected_luma.iter().min().unwrap();
+        let max = *expected_luma.iter().max().unwrap();
+        for (index, luma) in expected_luma.iter().enumerate() {
+            let stretched = ((luma - min) as f32 * 255.0 / (max - min) as f32).round() as i32;
+            let actual = variants[1].as_raw()[index] as i32;
+            assert_eq!(actual, stretched, "pixel {}", index);
+            let bin = variants[0].as_raw()[index];
+            assert_eq!(
+                bin,
+                if actual as u8 > BINARIZE_THRESHOLD {
+                    255
+                } else {
+                    0
+                }
+            );
+        }
+        // Fully transparent pixels become white before stretching.
+        assert_eq!(variants[1].as_raw()[0], 255);
     }
-    output
 }
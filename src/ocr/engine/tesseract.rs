@@ -1,7 +1,19 @@
 use anyhow::{Context, Result, anyhow};
 use std::process::Command;
+use std::sync::OnceLock;
 
+static LANGUAGES: OnceLock<std::result::Result<Vec<String>, String>> = OnceLock::new();
+
+/// Installed tesseract languages. `tesseract --list-langs` runs once per process; the result
+/// (or its error) is reused afterwards.
 pub fn list_tesseract_languages() -> Result<Vec<String>> {
+    LANGUAGES
+        .get_or_init(|| query_tesseract_languages().map_err(|err| format!("{:#}", err)))
+        .clone()
+        .map_err(|err| anyhow!(err))
+}
+
+fn query_tesseract_languages() -> Result<Vec<String>> {
     let output = Command::new("tesseract")
         .arg("--list-langs")
         .output()
@@ -1,10 +1,13 @@
 use anyhow::{Context, Result, anyhow};
+use std::collections::HashMap;
 use std::path::Path;
-use std::sync::Arc;
+use std::sync::{Arc, Mutex, OnceLock};
 use ttf_parser::Face;
 use ttf_parser::name_id;
 use usvg::fontdb;
 
+use crate::util::lock;
+
 #[derive(Clone)]
 pub struct FontMetrics {
     data: Arc<Vec<u8>>,
@@ -12,8 +15,22 @@ pub struct FontMetrics {
     space_advance: u16,
     family: Option<String>,
     face_index: u32,
+    advances: Arc<GlyphAdvances>,
+    font_db: Arc<OnceLock<Arc<fontdb::Database>>>,
+}
+
+/// Horizontal advances in font units. ASCII is filled when the font is loaded; other
+/// characters are looked up on first use and remembered.
+struct GlyphAdvances {
+    ascii: [u16; 128],
+    other: Mutex<HashMap<char, u16>>,
 }
 
+/// Parsed fonts keyed by `path:<file>` or `family:<name>`, so each font file is read and
+/// parsed once per process rather than once per rendered image.
+static METRICS: Mutex<Option<HashMap<String, FontMetrics>>> = Mutex::new(None);
+static SYSTEM_FONTS: OnceLock<Arc<fontdb::Database>> = OnceLock::new();
+
 impl FontMetrics {
     pub fn family(&self) -> Option<&str> {
         self.family.as_deref()
@@ -22,13 +39,74 @@ impl FontMetrics {
     pub fn data(&self) -> &[u8] {
         self.data.as_ref()
     }
+
+    /// The system fonts plus this font, built on first use and shared by every render that
+    /// uses this font. The font bytes are shared with the database, not copied.
+    pub fn font_db(&self) -> Arc<fontdb::Database> {
+        self.font_db
+            .get_or_init(|| {
+                let mut db = system_font_db().as_ref().clone();
+                db.load_font_source(fontdb::Source::Binary(self.data.clone()));
+                Arc::new(db)
+            })
+            .clone()
+    }
+
+    /// Advance of `ch` in font units; characters missing from the font use the space advance.
+    fn advance(&self, ch: char, face: &mut Option<Face<'_>>) -> u16 {
+        if ch.is_ascii() {
+            return self.advances.ascii[ch as usize];
+        }
+        if let Some(advance) = lock(&self.advances.other).get(&ch) {
+            return *advance;
+        }
+        if face.is_none() {
+            *face = Face::parse(&self.data, self.face_index).ok();
+        }
+        let advance = face
+            .as_ref()
+            .and_then(|face| {
+                face.glyph_index(ch)
+                    .map(|glyph| face.glyph_hor_advance(glyph).unwrap_or(self.space_advance))
+            })
+            .unwrap_or(self.space_advance);
+        lock(&self.advances.other).insert(ch, advance);
+        advance
+    }
+}
+
+/// System fonts, scanned once per process.
+pub(crate) fn system_font_db() -> Arc<fontdb::Database> {
+    SYSTEM_FONTS
+        .get_or_init(|| {
+            let mut db = fontdb::Database::new();
+            db.load_system_fonts();
+            Arc::new(db)
+        })
+        .clone()
 }
 
 pub fn load_font_metrics(path: &Path) -> Result<FontMetrics> {
+    let key = format!("path:{}", path.display());
+    if let Some(metrics) = cached_metrics(&key) {
+        return Ok(metrics);
+    }
     let data =
         std::fs::read(path).with_context(|| format!("failed to read font: {}", path.display()))?;
-    load_font_metrics_from_data(&data, None)
-        .map_err(|err| anyhow!("failed to parse font: {} ({})", path.display(), err))
+    let metrics = load_font_metrics_from_data(Arc::new(data), None)
+        .map_err(|err| anyhow!("failed to parse font: {} ({})", path.display(), err))?;
+    store_metrics(key, &metrics);
+    Ok(metrics)
+}
+
+fn cached_metrics(key: &str) -> Option<FontMetrics> {
+    lock(&METRICS).as_ref()?.get(key).cloned()
+}
+
+fn store_metrics(key: String, metrics: &FontMetrics) {
+    lock(&METRICS)
+        .get_or_insert_with(HashMap::new)
+        .insert(key, metrics.clone());
 }
 
 pub struct ResolvedOverlayFont {
@@ -51,8 +129,7 @@ pub fn resolve_overlay_font(
         return Ok(ResolvedOverlayFont { metrics, family });
     }
 
-    let mut db = fontdb::Database::new();
-    db.load_system_fonts();
+    let db = system_font_db();
 
     if let Some(family) = font_family {
         return load_font_metrics_from_family(&db, family);
@@ -68,24 +145,15 @@ pub fn resolve_overlay_font(
 }
 
 pub(crate) fn measure_text_width_px(text: &str, font_size: f32, font: Option<&FontMetrics>) -> f32 {
-    if let Some(font) = font
-        && let Ok(face) = Face::parse(&font.data, font.face_index)
-    {
+    if let Some(font) = font {
+        // Only parsed when a character is not cached yet.
+        let mut face = None;
         let mut advance = 0u32;
         for ch in text.chars() {
             if ch == '\n' {
                 continue;
             }
-            if ch == ' ' {
-                advance = advance.saturating_add(font.space_advance as u32);
-                continue;
-            }
-            if let Some(glyph) = face.glyph_index(ch) {
-                let glyph_advance = face.glyph_hor_advance(glyph).unwrap_or(font.space_advance);
-                advance = advance.saturating_add(glyph_advance as u32);
-            } else {
-                advance = advance.saturating_add(font.space_advance as u32);
-            }
+            advance = advance.saturating_add(font.advance(ch, &mut face) as u32);
         }
         let units = font.units_per_em.max(1) as f32;
         return advance as f32 * (font_size / units);
@@ -114,11 +182,14 @@ fn estimate_text_width_units(text: &str) -> f32 {
     text.chars().map(estimate_char_units_for_width).sum()
 }
 
-fn load_font_metrics_from_data(data: &[u8], preferred_family: Option<&str>) -> Result<FontMetrics> {
+fn load_font_metrics_from_data(
+    data: Arc<Vec<u8>>,
+    preferred_family: Option<&str>,
+) -> Result<FontMetrics> {
     let mut fallback = None;
-    let count = ttf_parser::fonts_in_collection(data).unwrap_or(1);
+    let count = ttf_parser::fonts_in_collection(&data).unwrap_or(1);
     for index in 0..count {
-        if let Ok(face) = Face::parse(data, index) {
+        if let Ok(face) = Face::parse(&data, index) {
             let family = extract_family_name(&face);
             let units_per_em = face.units_per_em().max(1);
             let space_advance = face
@@ -126,11 +197,16 @@ fn load_font_metrics_from_data(data: &[u8], preferred_family: Option<&str>) -> R
                 .and_then(|id| face.glyph_hor_advance(id))
                 .unwrap_or(units_per_em / 2);
             let metrics = FontMetrics {
-                data: Arc::new(data.to_vec()),
+                data: data.clone(),
                 units_per_em,
                 space_advance,
                 family: family.clone(),
                 face_index: index,
+                advances: Arc::new(GlyphAdvances {
+                    ascii: ascii_advances(&face, space_advance),
+                    other: Mutex::new(HashMap::new()),
+                }),
+                font_db: Arc::new(OnceLock::new()),
             };
             if let (Some(preferred), Some(found)) = (preferred_family, &family)
                 && found.eq_ignore_ascii_case(preferred)
@@ -148,10 +224,44 @@ fn load_font_metrics_from_data(data: &[u8], preferred_family: Option<&str>) -> R
     fallback.ok_or_else(|| anyhow!("failed to parse font data"))
 }
 
+fn ascii_advances(face: &Face<'_>, space_advance: u16) -> [u16; 128] {
+    let mut advances = [space_advance; 128];
+    for (code, slot) in advances.iter_mut().enumerate() {
+        let ch = code as u8 as char;
+        if ch == ' ' {
+            continue;
+        }
+        if let Some(glyph) = face.glyph_index(ch) {
+            *slot = face.glyph_hor_advance(glyph).unwrap_or(space_advance);
+        }
+    }
+    advances
+}
+
 fn load_font_metrics_from_family(
     db: &fontdb::Database,
     family: &str,
 ) -> Result<ResolvedOverlayFont> {
+    let key = format!("family:{}", family.to_lowercase());
+    let metrics = match cached_metrics(&key) {
+        Some(metrics) => metrics,
+        None => {
+            let metrics = load_family_metrics(db, family)?;
+            store_metrics(key, &metrics);
+            metrics
+        }
+    };
+    let resolved_family = metrics
+        .family()
+        .map(|name| name.to_string())
+        .unwrap_or_else(|| family.to_string());
+    Ok(ResolvedOverlayFont {
+        metrics,
+        family: resolved_family,
+    })
+}
+
+fn load_family_metrics(db: &fontdb::Database, family: &str) -> Result<FontMetrics> {
     let is_sans =
         family.eq_ignore_ascii_case("sans-serif") || family.eq_ignore_ascii_case("sens-serif");
     let families = if is_sans {
@@ -169,15 +279,7 @@ fn load_font_metrics_from_family(
     let (data, _face_index) = db
         .with_face_data(id, |data, index| (data.to_vec(), index))
         .ok_or_else(|| anyhow!("failed to load font data: {}", family))?;
-    let metrics = load_font_metrics_from_data(&data, Some(family))?;
-    let resolved_family = metrics
-        .family()
-        .map(|name| name.to_string())
-        .unwrap_or_else(|| family.to_string());
-    Ok(ResolvedOverlayFont {
-        metrics,
-        family: resolved_family,
-    })
+    load_font_metrics_from_data(Arc::new(data), Some(family))
 }
 
 fn extract_family_name(face: &Face<'_>) -> Option<String> {
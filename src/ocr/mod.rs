@@ -3,6 +3,8 @@ mod font;
 mod render;
 
 pub use engine::{extract_lines, list_tesseract_languages};
+#[cfg(feature = "bench")]
+pub(crate) use engine::{parse_hocr_lines, parse_tsv_lines};
 pub use font::{FontMetrics, ResolvedOverlayFont, load_font_metrics, resolve_overlay_font};
 pub use render::{RenderOutcome, render_bbox_svg, render_svg, render_svg_bytes};
 
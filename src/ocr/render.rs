@@ -3,16 +3,15 @@ use base64::Engine;
 use base64::engine::general_purpose::STANDARD as BASE64;
 use resvg::render;
 use std::io::Cursor;
-use std::sync::Arc;
 use tiny_skia::Pixmap;
-use usvg::{Options, Tree, fontdb};
+use usvg::{Options, Tree};
 
 use super::{BBoxPx, OcrLine, OverlayStyle, TranslatedLine};
 use crate::ocr::engine::{
     ResolveOverlapConfig, build_avoid_rects, choose_fixed_font_size, fit_text_to_box,
     has_avoid_below, resolve_overlap,
 };
-use crate::ocr::font::measure_text_width_px;
+use crate::ocr::font::{FontMetrics, measure_text_width_px, system_font_db};
 
 pub struct RenderOutcome {
     pub svg: String,
@@ -325,14 +324,13 @@ pub fn render_bbox_svg(
     Ok(svg)
 }
 
-pub fn render_svg_bytes(svg: &str, output_mime: &str, font_data: Option<&[u8]>) -> Result<Vec<u8>> {
-    let mut db = fontdb::Database::new();
-    db.load_system_fonts();
-    if let Some(data) = font_data {
-        db.load_font_data(data.to_vec());
-    }
+pub fn render_svg_bytes(
+    svg: &str,
+    output_mime: &str,
+    font: Option<&FontMetrics>,
+) -> Result<Vec<u8>> {
     let options = Options {
-        fontdb: Arc::new(db),
+        fontdb: font.map_or_else(system_font_db, FontMetrics::font_db),
         ..Options::default()
     };
     let tree = Tree::from_str(svg, &options).with_context(|| "failed to parse SVG")?;
@@ -50,6 +50,14 @@ pub(crate) fn whisper_dir() -> PathBuf {
         .unwrap_or_else(|| PathBuf::from(".local/share/llm-translator-rust/.cache/whisper"))
 }
 
+pub(crate) fn translation_memory_dir() -> PathBuf {
+    if let Some(dir) = base_dir_override() {
+        return dir.join(".cache/memory");
+    }
+    home_join(".local/share/llm-translator-rust/.cache/memory")
+        .unwrap_or_else(|| PathBuf::from(".local/share/llm-translator-rust/.cache/memory"))
+}
+
 pub(crate) fn ocr_debug_dir() -> PathBuf {
     if let Some(dir) = base_dir_override() {
         return dir.join(".cache/ocr");
@@ -7,13 +7,17 @@ use serde_json::json;
 use super::retry::{
     RATE_LIMIT_BASE_DELAY, RATE_LIMIT_MAX_RETRIES, is_rate_limited, retry_after, wait_with_backoff,
 };
+use super::sse::read_events;
 use super::{
-    Message, MessagePart, MessageRole, Provider, ProviderFuture, ProviderResponse, ProviderUsage,
-    ToolSpec,
+    Message, MessagePart, MessageRole, Provider, ProviderFuture, ProviderKind, ProviderResponse,
+    ProviderUsage, StreamSink, ToolSpec,
 };
+use super::{http, scheduler};
 
 const DEFAULT_BASE_URL: &str = "https://api.anthropic.com/v1/messages";
 pub(crate) const DEFAULT_MODEL: &str = "claude-3-5-sonnet-latest";
+/// Completion size requested on every call.
+pub(crate) const MAX_TOKENS: usize = 1024;
 
 #[derive(Debug, Clone)]
 pub struct Claude {
@@ -21,6 +25,7 @@ pub struct Claude {
     model: String,
     messages: Vec<Message>,
     tools: Vec<ToolSpec>,
+    stream: Option<StreamSink>,
 }
 
 impl Claude {
@@ -30,6 +35,7 @@ impl Claude {
             model: DEFAULT_MODEL.to_string(),
             messages: Vec::new(),
             tools: Vec::new(),
+            stream: None,
         }
     }
 
@@ -74,7 +80,7 @@ impl Provider for Claude {
                 .find_tool(&tool_name)
                 .cloned()
                 .ok_or_else(|| anyhow!("tool '{}' not registered", tool_name))?;
-            let client = reqwest::Client::new();
+            let client = http::client();
             let url = base_url();
 
             let (system_inputs, user_inputs): (Vec<Message>, Vec<Message>) = self
@@ -137,9 +143,9 @@ impl Provider for Claude {
                 json!(system)
             };
 
-            let body = json!({
+            let mut body = json!({
                 "model": self.model,
-                "max_tokens": 1024,
+                "max_tokens": MAX_TOKENS,
                 "messages": messages,
                 "system": system_value,
                 "tools": [
@@ -151,11 +157,17 @@ impl Provider for Claude {
                 ],
                 "tool_choice": {"type": "tool", "name": tool.name}
             });
+            if self.stream.is_some() {
+                body["stream"] = json!(true);
+            }
 
+            let tokens = scheduler::estimate_tokens(&body);
             let mut attempt = 0usize;
             let mut delay = RATE_LIMIT_BASE_DELAY;
             loop {
                 attempt += 1;
+                let mut permit =
+                    scheduler::acquire(ProviderKind::Claude.as_str(), &self.model, tokens).await;
                 let response = client
                     .post(&url)
                     .header("x-api-key", self.key.clone())
@@ -165,14 +177,24 @@ impl Provider for Claude {
                     .await?;
 
                 let status = response.status();
+                if status.is_success()
+                    && let Some(stream) = self.stream.as_ref()
+                {
+                    return read_tool_stream(response, &tool_name, &self.model, stream).await;
+                }
                 let retry_after = retry_after(response.headers());
                 let text = response.text().await.unwrap_or_default();
                 if status.is_success() {
                     return extract_tool_response(&text, &tool_name, &self.model);
                 }
-                if is_rate_limited(status, &text) && attempt < RATE_LIMIT_MAX_RETRIES {
-                    delay = wait_with_backoff("Claude", attempt, delay, retry_after).await;
-                    continue;
+                if is_rate_limited(status, &text) {
+                    // Counted even on the last attempt so the back-off and metrics see it.
+                    permit.rate_limited(retry_after);
+                    if attempt < RATE_LIMIT_MAX_RETRIES {
+                        drop(permit);
+                        delay = wait_with_backoff("Claude", attempt, delay, retry_after).await;
+                        continue;
+                    }
                 }
                 return Err(anyhow!(
                     "Claude API error ({}): {}",
@@ -182,6 +204,11 @@ impl Provider for Claude {
             }
         })
     }
+
+    fn with_stream(mut self, sink: StreamSink) -> Self {
+        self.stream = Some(sink);
+        self
+    }
 }
 
 fn base_url() -> String {
@@ -224,6 +251,86 @@ fn extract_tool_response(
     Err(anyhow!("no tool call returned from Claude"))
 }
 
+/// Accumulates a streamed message, forwarding `input_json_delta` fragments of the tool block.
+async fn read_tool_stream(
+    response: reqwest::Response,
+    tool_name: &str,
+    fallback_model: &str,
+    stream: &StreamSink,
+) -> Result<ProviderResponse, anyhow::Error> {
+    let mut tool_index: Option<usize> = None;
+    let mut input = String::new();
+    let mut model: Option<String> = None;
+    let mut input_tokens: Option<u64> = None;
+    let mut output_tokens: Option<u64> = None;
+    read_events(response, |event| {
+        let event: ClaudeStreamEvent = serde_json::from_str(event)
+            .map_err(|err| anyhow!("failed to parse Claude stream event: {}", err))?;
+        match event {
+            ClaudeStreamEvent::MessageStart { message } => {
+                model = message.model.filter(|value| !value.trim().is_empty());
+                if let Some(usage) = message.usage {
+                    input_tokens = usage.input_tokens;
+                    output_tokens = usage.output_tokens;
+                }
+            }
+            ClaudeStreamEvent::ContentBlockStart {
+                index,
+                content_block,
+            } => {
+                if content_block.kind == "tool_use"
+                    && content_block.name.as_deref() == Some(tool_name)
+                {
+                    tool_index = Some(index);
+                }
+            }
+            ClaudeStreamEvent::ContentBlockDelta { index, delta } => {
+                if tool_index == Some(index)
+                    && let Some(partial) = delta.partial_json
+                {
+                    stream.send(&partial);
+                    input.push_str(&partial);
+                }
+            }
+            ClaudeStreamEvent::MessageDelta { usage } => {
+                if let Some(value) = usage.and_then(|usage| usage.output_tokens) {
+                    output_tokens = Some(value);
+                }
+            }
+            ClaudeStreamEvent::Error { error } => {
+                return Err(anyhow!(
+                    "Claude API error: {}",
+                    format_error_parts(error.message, error.kind, None)
+                ));
+            }
+            ClaudeStreamEvent::Other => {}
+        }
+        Ok(())
+    })
+    .await?;
+
+    if tool_index.is_none() {
+        return Err(anyhow!("no tool call returned from Claude"));
+    }
+    let args = if input.trim().is_empty() {
+        json!({})
+    } else {
+        serde_json::from_str(&input)
+            .map_err(|err| anyhow!("failed to parse Claude tool input: {}", err))?
+    };
+    Ok(ProviderResponse {
+        args,
+        model: model.or_else(|| Some(fallback_model.to_string())),
+        usage: Some(ProviderUsage {
+            prompt_tokens: input_tokens,
+            completion_tokens: output_tokens,
+            total_tokens: input_tokens
+                .zip(output_tokens)
+                .map(|(input, output)| input + output),
+        }),
+    })
+}
+
 fn extract_claude_error(body: &str) -> Option<String> {
     #[derive(Deserialize)]
     struct ErrorBody {
@@ -291,6 +398,48 @@ struct ClaudeContent {
     input: Option<serde_json::Value>,
 }
 
+#[derive(Debug, Deserialize)]
+#[serde(tag = "type", rename_all = "snake_case")]
+enum ClaudeStreamEvent {
+    MessageStart {
+        message: ClaudeStreamMessage,
+    },
+    ContentBlockStart {
+        index: usize,
+        content_block: ClaudeContent,
+    },
+    ContentBlockDelta {
+        index: usize,
+        delta: ClaudeStreamDelta,
+    },
+    MessageDelta {
+        usage: Option<ClaudeUsage>,
+    },
+    Error {
+        error: ClaudeStreamError,
+    },
+    #[serde(other)]
+    Other,
+}
+
+#[derive(Debug, Deserialize)]
+struct ClaudeStreamMessage {
+    model: Option<String>,
+    usage: Option<ClaudeUsage>,
+}
+
+#[derive(Debug, Deserialize)]
+struct ClaudeStreamDelta {
+    partial_json: Option<String>,
+}
+
+#[derive(Debug, Deserialize)]
+struct ClaudeStreamError {
+    #[serde(rename = "type")]
+    kind: Option<String>,
+    message: Option<String>,
+}
+
 #[cfg(test)]
 mod tests {
     use super::extract_tool_response;
@@ -8,9 +8,10 @@ use super::retry::{
     RATE_LIMIT_BASE_DELAY, RATE_LIMIT_MAX_RETRIES, is_rate_limited, retry_after, wait_with_backoff,
 };
 use super::{
-    Message, MessagePart, MessageRole, Provider, ProviderFuture, ProviderResponse, ProviderUsage,
-    ToolSpec,
+    Message, MessagePart, MessageRole, Provider, ProviderFuture, ProviderKind, ProviderResponse,
+    ProviderUsage, StreamSink, ToolSpec,
 };
+use super::{http, scheduler};
 
 const BASE_URL: &str = "https://generativelanguage.googleapis.com/v1beta/models";
 pub(crate) const DEFAULT_MODEL: &str = "gemini-1.5-flash";
@@ -21,6 +22,7 @@ pub struct Gemini {
     model: String,
     messages: Vec<Message>,
     tools: Vec<ToolSpec>,
+    stream: Option<StreamSink>,
 }
 
 impl Gemini {
@@ -30,6 +32,7 @@ impl Gemini {
             model: DEFAULT_MODEL.to_string(),
             messages: Vec::new(),
             tools: Vec::new(),
+            stream: None,
         }
     }
 
@@ -74,7 +77,7 @@ impl Provider for Gemini {
                 .find_tool(&tool_name)
                 .cloned()
                 .ok_or_else(|| anyhow!("tool '{}' not registered", tool_name))?;
-            let client = reqwest::Client::new();
+            let client = http::client();
             let url = format!("{}/{}:generateContent", BASE_URL, self.model);
 
             let (system_inputs, user_inputs): (Vec<Message>, Vec<Message>) = self
@@ -140,10 +143,13 @@ impl Provider for Gemini {
                 }
             });
 
+            let tokens = scheduler::estimate_tokens(&body);
             let mut attempt = 0usize;
             let mut delay = RATE_LIMIT_BASE_DELAY;
             loop {
                 attempt += 1;
+                let mut permit =
+                    scheduler::acquire(ProviderKind::Gemini.as_str(), &self.model, tokens).await;
                 let response = client
                     .post(&url)
                     .header("x-goog-api-key", self.key.clone())
@@ -155,11 +161,22 @@ impl Provider for Gemini {
                 let retry_after = retry_after(response.headers());
                 let text = response.text().await.unwrap_or_default();
                 if status.is_success() {
-                    return extract_tool_response(&text, &tool_name, &self.model);
+                    // Gemini returns function-call args whole, so there is nothing to stream
+                    // incrementally; hand the sink the complete arguments instead.
+                    let response = extract_tool_response(&text, &tool_name, &self.model)?;
+                    if let Some(stream) = self.stream.as_ref() {
+                        stream.send(&response.args.to_string());
+                    }
+                    return Ok(response);
                 }
-                if is_rate_limited(status, &text) && attempt < RATE_LIMIT_MAX_RETRIES {
-                    delay = wait_with_backoff("Gemini", attempt, delay, retry_after).await;
-                    continue;
+                if is_rate_limited(status, &text) {
+                    // Counted even on the last attempt so the back-off and metrics see it.
+                    permit.rate_limited(retry_after);
+                    if attempt < RATE_LIMIT_MAX_RETRIES {
+                        drop(permit);
+                        delay = wait_with_backoff("Gemini", attempt, delay, retry_after).await;
+                        continue;
+                    }
                 }
                 return Err(anyhow!(
                     "Gemini API error ({}): {}",
@@ -169,6 +186,11 @@ impl Provider for Gemini {
             }
         })
     }
+
+    fn with_stream(mut self, sink: StreamSink) -> Self {
+        self.stream = Some(sink);
+        self
+    }
 }
 
 fn extract_tool_response(
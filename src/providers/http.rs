@@ -0,0 +1,104 @@
+use std::sync::Mutex;
+use std::time::Duration;
+
+use tracing::warn;
+
+use crate::settings::Settings;
+
+/// Connection settings for the process-wide HTTP client (see `[http]` in settings.toml).
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(crate) struct HttpOptions {
+    pool_max_idle_per_host: usize,
+    pool_idle_timeout: Option<Duration>,
+    connect_timeout: Duration,
+    read_timeout: Option<Duration>,
+    tcp_keepalive: Option<Duration>,
+}
+
+impl HttpOptions {
+    pub(crate) fn from_settings(settings: &Settings) -> Self {
+        let secs = |value: u64| (value > 0).then(|| Duration::from_secs(value));
+        Self {
+            pool_max_idle_per_host: settings.http_pool_max_idle_per_host,
+            pool_idle_timeout: secs(settings.http_pool_idle_timeout_secs),
+            connect_timeout: Duration::from_secs(settings.http_connect_timeout_secs.max(1)),
+            read_timeout: secs(settings.http_read_timeout_secs),
+            tcp_keepalive: secs(settings.http_tcp_keepalive_secs),
+        }
+    }
+
+    fn build(&self) -> reqwest::Client {
+        let mut builder = reqwest::Client::builder()
+            .pool_max_idle_per_host(self.pool_max_idle_per_host)
+            .pool_idle_timeout(self.pool_idle_timeout)
+            .connect_timeout(self.connect_timeout)
+            .tcp_keepalive(self.tcp_keepalive)
+            .tcp_nodelay(true);
+        if let Some(timeout) = self.read_timeout {
+            builder = builder.read_timeout(timeout);
+        }
+        builder.build().unwrap_or_else(|err| {
+            warn!("failed to build HTTP client ({}); using defaults", err);
+            reqwest::Client::new()
+        })
+    }
+}
+
+impl Default for HttpOptions {
+    fn default() -> Self {
+        Self::from_settings(&Settings::default())
+    }
+}
+
+static CLIENT: Mutex<Option<(HttpOptions, reqwest::Client)>> = Mutex::new(None);
+
+/// Applies `[http]` settings to the shared client. Connections are only dropped when the
+/// options actually change.
+pub(crate) fn configure(settings: &Settings) {
+    let options = HttpOptions::from_settings(settings);
+    let Ok(mut guard) = CLIENT.lock() else {
+        return;
+    };
+    if guard
+        .as_ref()
+        .is_some_and(|(current, _)| *current == options)
+    {
+        return;
+    }
+    *guard = Some((options, options.build()));
+}
+
+/// Returns the shared, keep-alive HTTP client. Cloning is cheap; all clones share one pool.
+pub(crate) fn client() -> reqwest::Client {
+    let mut guard = match CLIENT.lock() {
+        Ok(guard) => guard,
+        Err(poisoned) => poisoned.into_inner(),
+    };
+    guard
+        .get_or_insert_with(|| {
+            let options = HttpOptions::default();
+            (options, options.build())
+        })
+        .1
+        .clone()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn zero_durations_disable_timeouts() {
+        let settings = Settings {
+            http_read_timeout_secs: 0,
+            http_tcp_keepalive_secs: 0,
+            http_connect_timeout_secs: 0,
+            ..Settings::default()
+        };
+        let options = HttpOptions::from_settings(&settings);
+        assert_eq!(options.read_timeout, None);
+        assert_eq!(options.tcp_keepalive, None);
+        assert_eq!(options.connect_timeout, Duration::from_secs(1));
+        assert_eq!(options.pool_idle_timeout, Some(Duration::from_secs(90)));
+    }
+}
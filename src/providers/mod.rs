@@ -1,16 +1,22 @@
 use anyhow::{Result, anyhow};
 use serde::Serialize;
+use std::fmt;
 use std::future::Future;
 use std::pin::Pin;
+use std::sync::Arc;
 
 use crate::data::DataAttachment;
 
 mod claude;
 mod gemini;
+pub(crate) mod http;
 mod openai;
 pub(crate) mod retry;
+pub(crate) mod scheduler;
+mod sse;
 
 pub use claude::Claude;
+pub(crate) use claude::MAX_TOKENS as CLAUDE_MAX_TOKENS;
 pub use gemini::Gemini;
 pub use openai::OpenAI;
 
@@ -107,12 +113,55 @@ impl Message {
 
 pub type ProviderFuture = Pin<Box<dyn Future<Output = Result<ProviderResponse>> + Send>>;
 
+/// Receives raw tool-argument JSON fragments while a streamed tool call is in flight.
+///
+/// Concatenating every fragment yields the final arguments JSON; providers that cannot
+/// stream send the whole arguments once the call completes.
+#[derive(Clone)]
+pub struct StreamSink(Arc<dyn Fn(&str) + Send + Sync>);
+
+impl StreamSink {
+    pub fn new(sink: impl Fn(&str) + Send + Sync + 'static) -> Self {
+        Self(Arc::new(sink))
+    }
+
+    pub fn send(&self, fragment: &str) {
+        if !fragment.is_empty() {
+            (self.0)(fragment);
+        }
+    }
+}
+
+impl fmt::Debug for StreamSink {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.write_str("StreamSink")
+    }
+}
+
 pub trait Provider: Clone + Send + Sync {
     fn append_system_input(self, input: String) -> Self;
     fn append_user_input(self, input: String) -> Self;
     fn append_user_data(self, data: DataAttachment) -> Self;
     fn register_tool(self, tool: ToolSpec) -> Self;
     fn call_tool(self, tool_name: &str) -> ProviderFuture;
+
+    /// Streams the next tool call's arguments to `sink`; providers without streaming ignore it.
+    fn with_stream(self, _sink: StreamSink) -> Self {
+        self
+    }
+}
+
+pub(crate) fn merge_usage(total: ProviderUsage, next: Option<ProviderUsage>) -> ProviderUsage {
+    let Some(next) = next else {
+        return total;
+    };
+    ProviderUsage {
+        prompt_tokens: Some(total.prompt_tokens.unwrap_or(0) + next.prompt_tokens.unwrap_or(0)),
+        completion_tokens: Some(
+            total.completion_tokens.unwrap_or(0) + next.completion_tokens.unwrap_or(0),
+        ),
+        total_tokens: Some(total.total_tokens.unwrap_or(0) + next.total_tokens.unwrap_or(0)),
+    }
 }
 
 #[derive(Debug, Clone)]
@@ -168,10 +217,27 @@ impl Provider for ProviderImpl {
     }
 
     fn call_tool(self, tool_name: &str) -> ProviderFuture {
+        let (kind, call) = match self {
+            ProviderImpl::OpenAI(provider) => (ProviderKind::OpenAI, provider.call_tool(tool_name)),
+            ProviderImpl::Gemini(provider) => (ProviderKind::Gemini, provider.call_tool(tool_name)),
+            ProviderImpl::Claude(provider) => (ProviderKind::Claude, provider.call_tool(tool_name)),
+        };
+        Box::pin(async move {
+            let response = call.await?;
+            crate::metrics::record_usage(
+                kind.as_str(),
+                response.model.as_deref(),
+                response.usage.as_ref(),
+            );
+            Ok(response)
+        })
+    }
+
+    fn with_stream(self, sink: StreamSink) -> Self {
         match self {
-            ProviderImpl::OpenAI(provider) => provider.call_tool(tool_name),
-            ProviderImpl::Gemini(provider) => provider.call_tool(tool_name),
-            ProviderImpl::Claude(provider) => provider.call_tool(tool_name),
+            ProviderImpl::OpenAI(provider) => ProviderImpl::OpenAI(provider.with_stream(sink)),
+            ProviderImpl::Gemini(provider) => ProviderImpl::Gemini(provider.with_stream(sink)),
+            ProviderImpl::Claude(provider) => ProviderImpl::Claude(provider.with_stream(sink)),
         }
     }
 }
@@ -7,10 +7,12 @@ use serde_json::json;
 use super::retry::{
     RATE_LIMIT_BASE_DELAY, RATE_LIMIT_MAX_RETRIES, is_rate_limited, retry_after, wait_with_backoff,
 };
+use super::sse::read_events;
 use super::{
-    Message, MessagePart, MessageRole, Provider, ProviderFuture, ProviderResponse, ProviderUsage,
-    ToolSpec,
+    Message, MessagePart, MessageRole, Provider, ProviderFuture, ProviderKind, ProviderResponse,
+    ProviderUsage, StreamSink, ToolSpec,
 };
+use super::{http, scheduler};
 
 const DEFAULT_BASE_URL: &str = "https://api.openai.com/v1";
 pub(crate) const DEFAULT_MODEL: &str = "gpt-5.2";
@@ -21,6 +23,7 @@ pub struct OpenAI {
     model: String,
     messages: Vec<Message>,
     tools: Vec<ToolSpec>,
+    stream: Option<StreamSink>,
 }
 
 impl OpenAI {
@@ -30,6 +33,7 @@ impl OpenAI {
             model: DEFAULT_MODEL.to_string(),
             messages: Vec::new(),
             tools: Vec::new(),
+            stream: None,
         }
     }
 
@@ -75,12 +79,22 @@ impl Provider for OpenAI {
         Box::pin(async move {
             let tool = self.find_tool(&tool_name)?.clone();
             if has_data(&self.messages) {
-                call_with_responses(self, tool, &tool_name).await
+                let stream = self.stream.clone();
+                let response = call_with_responses(self, tool, &tool_name).await?;
+                if let Some(stream) = stream {
+                    stream.send(&response.args.to_string());
+                }
+                Ok(response)
             } else {
                 call_with_chat_completions(self, tool, &tool_name).await
             }
         })
     }
+
+    fn with_stream(mut self, sink: StreamSink) -> Self {
+        self.stream = Some(sink);
+        self
+    }
 }
 
 fn base_url() -> String {
@@ -119,7 +133,7 @@ async fn call_with_chat_completions(
     tool: ToolSpec,
     tool_name: &str,
 ) -> Result<ProviderResponse> {
-    let client = reqwest::Client::new();
+    let client = http::client();
     let url = format!("{}/chat/completions", base_url());
 
     let messages = provider
@@ -137,7 +151,7 @@ async fn call_with_chat_completions(
         })
         .collect::<Result<Vec<_>>>()?;
 
-    let body = json!({
+    let mut body = json!({
         "model": provider.model,
         "messages": messages,
         "tools": [
@@ -152,11 +166,18 @@ async fn call_with_chat_completions(
         ],
         "tool_choice": {"type": "function", "function": {"name": tool.name}}
     });
+    if provider.stream.is_some() {
+        body["stream"] = json!(true);
+        body["stream_options"] = json!({"include_usage": true});
+    }
 
+    let tokens = scheduler::estimate_tokens(&body);
     let mut attempt = 0usize;
     let mut delay = RATE_LIMIT_BASE_DELAY;
     loop {
         attempt += 1;
+        let mut permit =
+            scheduler::acquire(ProviderKind::OpenAI.as_str(), &provider.model, tokens).await;
         let response = client
             .post(&url)
             .bearer_auth(provider.key.clone())
@@ -165,14 +186,24 @@ async fn call_with_chat_completions(
             .await?;
 
         let status = response.status();
+        if status.is_success()
+            && let Some(stream) = provider.stream.as_ref()
+        {
+            return read_chat_stream(response, tool_name, &provider.model, stream).await;
+        }
         let retry_after = retry_after(response.headers());
         let text = response.text().await.unwrap_or_default();
         if status.is_success() {
             return extract_tool_response(&text, tool_name, &provider.model);
         }
-        if is_rate_limited(status, &text) && attempt < RATE_LIMIT_MAX_RETRIES {
-            delay = wait_with_backoff("OpenAI", attempt, delay, retry_after).await;
-            continue;
+        if is_rate_limited(status, &text) {
+            // Counted even on the last attempt so the back-off and metrics see it.
+            permit.rate_limited(retry_after);
+            if attempt < RATE_LIMIT_MAX_RETRIES {
+                drop(permit);
+                delay = wait_with_backoff("OpenAI", attempt, delay, retry_after).await;
+                continue;
+            }
         }
         return Err(anyhow!(
             "OpenAI API error ({}): {}",
@@ -187,7 +218,7 @@ async fn call_with_responses(
     tool: ToolSpec,
     tool_name: &str,
 ) -> Result<ProviderResponse> {
-    let client = reqwest::Client::new();
+    let client = http::client();
     let url = format!("{}/responses", base_url());
 
     let system = system_text(&provider.messages)?;
@@ -237,10 +268,13 @@ async fn call_with_responses(
         body["instructions"] = json!(system);
     }
 
+    let tokens = scheduler::estimate_tokens(&body);
     let mut attempt = 0usize;
     let mut delay = RATE_LIMIT_BASE_DELAY;
     loop {
         attempt += 1;
+        let mut permit =
+            scheduler::acquire(ProviderKind::OpenAI.as_str(), &provider.model, tokens).await;
         let response = client
             .post(&url)
             .bearer_auth(provider.key.clone())
@@ -254,9 +288,14 @@ async fn call_with_responses(
         if status.is_success() {
             return extract_response_tool_call(&text, tool_name, &provider.model);
         }
-        if is_rate_limited(status, &text) && attempt < RATE_LIMIT_MAX_RETRIES {
-            delay = wait_with_backoff("OpenAI", attempt, delay, retry_after).await;
-            continue;
+        if is_rate_limited(status, &text) {
+            // Counted even on the last attempt so the back-off and metrics see it.
+            permit.rate_limited(retry_after);
+            if attempt < RATE_LIMIT_MAX_RETRIES {
+                drop(permit);
+                delay = wait_with_backoff("OpenAI", attempt, delay, retry_after).await;
+                continue;
+            }
         }
         return Err(anyhow!(
             "OpenAI API error ({}): {}",
@@ -300,6 +339,64 @@ fn extract_tool_response(
     Ok(ProviderResponse { args, model, usage })
 }
 
+/// Accumulates a streamed chat completion, forwarding argument deltas to `stream`.
+async fn read_chat_stream(
+    response: reqwest::Response,
+    tool_name: &str,
+    fallback_model: &str,
+    stream: &StreamSink,
+) -> Result<ProviderResponse> {
+    let mut name: Option<String> = None;
+    let mut arguments = String::new();
+    let mut model: Option<String> = None;
+    let mut usage: Option<ProviderUsage> = None;
+    read_events(response, |event| {
+        let chunk: OpenAIStreamChunk =
+            serde_json::from_str(event).with_context(|| "failed to parse OpenAI stream chunk")?;
+        if let Some(value) = chunk.model.filter(|value| !value.trim().is_empty()) {
+            model = Some(value);
+        }
+        if let Some(value) = chunk.usage {
+            usage = Some(ProviderUsage {
+                prompt_tokens: value.prompt_tokens,
+                completion_tokens: value.completion_tokens,
+                total_tokens: value.total_tokens,
+            });
+        }
+        let calls = chunk
+            .choices
+            .into_iter()
+            .filter_map(|choice| choice.delta.tool_calls)
+            .flatten();
+        for call in calls.filter(|call| call.index.unwrap_or(0) == 0) {
+            let Some(function) = call.function else {
+                continue;
+            };
+            if let Some(value) = function.name {
+                name = Some(value);
+            }
+            if let Some(delta) = function.arguments {
+                stream.send(&delta);
+                arguments.push_str(&delta);
+            }
+        }
+        Ok(())
+    })
+    .await?;
+
+    let name = name.ok_or_else(|| anyhow!("no tool call returned from OpenAI"))?;
+    if name != tool_name {
+        return Err(anyhow!("unexpected tool name '{}' from OpenAI", name));
+    }
+    let args: serde_json::Value = serde_json::from_str(&arguments)
+        .with_context(|| "failed to parse OpenAI tool arguments")?;
+    Ok(ProviderResponse {
+        args,
+        model: model.or_else(|| Some(fallback_model.to_string())),
+        usage,
+    })
+}
+
 fn extract_openai_error(body: &str) -> Option<String> {
     #[derive(Deserialize)]
     struct ErrorBody {
@@ -415,6 +512,36 @@ struct OpenAIUsage {
     total_tokens: Option<u64>,
 }
 
+#[derive(Debug, Deserialize)]
+struct OpenAIStreamChunk {
+    model: Option<String>,
+    #[serde(default)]
+    choices: Vec<OpenAIStreamChoice>,
+    usage: Option<OpenAIUsage>,
+}
+
+#[derive(Debug, Deserialize)]
+struct OpenAIStreamChoice {
+    delta: OpenAIStreamDelta,
+}
+
+#[derive(Debug, Deserialize)]
+struct OpenAIStreamDelta {
+    tool_calls: Option<Vec<OpenAIStreamToolCall>>,
+}
+
+#[derive(Debug, Deserialize)]
+struct OpenAIStreamToolCall {
+    index: Option<usize>,
+    function: Option<OpenAIStreamFunction>,
+}
+
+#[derive(Debug, Deserialize)]
+struct OpenAIStreamFunction {
+    name: Option<String>,
+    arguments: Option<String>,
+}
+
 #[derive(Debug, Deserialize)]
 struct ResponseApiResponse {
     model: Option<String>,
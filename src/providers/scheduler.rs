@@ -0,0 +1,407 @@
+use std::collections::HashMap;
+use std::future::Future;
+use std::sync::{Arc, Mutex, MutexGuard};
+use std::time::{Duration, Instant};
+
+use tokio::sync::Notify;
+
+use crate::metrics;
+use crate::settings::Settings;
+use crate::util::lock;
+
+/// Callers that wait in the bulk lane only start when no interactive caller is waiting.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(crate) enum Lane {
+    Interactive,
+    Bulk,
+}
+
+tokio::task_local! {
+    static LANE: Lane;
+}
+
+/// Runs `future` with its provider calls in the bulk lane (directory jobs and other
+/// background work). Calls made outside this scope are interactive.
+pub(crate) async fn bulk<F: Future>(future: F) -> F::Output {
+    LANE.scope(Lane::Bulk, future).await
+}
+
+fn current_lane() -> Lane {
+    LANE.try_with(|lane| *lane).unwrap_or(Lane::Interactive)
+}
+
+/// Limits shared by every provider/model pair (see `[rate_limit]` in settings.toml).
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+struct LimitConfig {
+    max_concurrency: usize,
+    requests_per_minute: u64,
+    tokens_per_minute: u64,
+}
+
+impl LimitConfig {
+    fn from_settings(settings: &Settings) -> Self {
+        Self {
+            max_concurrency: settings.rate_limit_max_concurrency.max(1),
+            requests_per_minute: settings.rate_limit_requests_per_minute,
+            tokens_per_minute: settings.rate_limit_tokens_per_minute,
+        }
+    }
+}
+
+impl Default for LimitConfig {
+    fn default() -> Self {
+        Self::from_settings(&Settings::default())
+    }
+}
+
+/// Token bucket refilled continuously; a zero rate means unlimited.
+#[derive(Debug)]
+struct TokenBucket {
+    capacity: f64,
+    available: f64,
+    updated: Instant,
+}
+
+impl TokenBucket {
+    fn new(per_minute: u64, now: Instant) -> Self {
+        Self {
+            capacity: per_minute as f64,
+            available: per_minute as f64,
+            updated: now,
+        }
+    }
+
+    fn set_rate(&mut self, per_minute: u64) {
+        self.capacity = per_minute as f64;
+        self.available = self.available.min(self.capacity);
+    }
+
+    fn refill(&mut self, now: Instant) {
+        let elapsed = now.saturating_duration_since(self.updated).as_secs_f64();
+        self.available = (self.available + elapsed * self.capacity / 60.0).min(self.capacity);
+        self.updated = now;
+    }
+
+    /// How long until `amount` is available, or `None` when it can be taken now.
+    fn wait_for(&mut self, amount: f64, now: Instant) -> Option<Duration> {
+        if self.capacity <= 0.0 {
+            return None;
+        }
+        self.refill(now);
+        let amount = amount.min(self.capacity);
+        if self.available >= amount {
+            return None;
+        }
+        let missing = amount - self.available;
+        Some(Duration::from_secs_f64(missing * 60.0 / self.capacity))
+    }
+
+    fn take(&mut self, amount: f64) {
+        if self.capacity > 0.0 {
+            self.available -= amount.min(self.capacity);
+        }
+    }
+}
+
+enum Admission {
+    Start,
+    Sleep(Duration),
+    Wait,
+}
+
+/// Concurrency starts at `max_concurrency`, halves on every rate-limit response and grows
+/// back by roughly one slot per window of successful calls (AIMD).
+#[derive(Debug)]
+struct LimiterState {
+    config: LimitConfig,
+    limit: f64,
+    in_flight: usize,
+    waiting_interactive: usize,
+    paused_until: Option<Instant>,
+    requests: TokenBucket,
+    tokens: TokenBucket,
+}
+
+impl LimiterState {
+    fn new(config: LimitConfig, now: Instant) -> Self {
+        Self {
+            config,
+            limit: config.max_concurrency as f64,
+            in_flight: 0,
+            waiting_interactive: 0,
+            paused_until: None,
+            requests: TokenBucket::new(config.requests_per_minute, now),
+            tokens: TokenBucket::new(config.tokens_per_minute, now),
+        }
+    }
+
+    fn reconfigure(&mut self, config: LimitConfig) {
+        self.config = config;
+        self.limit = self.limit.min(config.max_concurrency as f64);
+        self.requests.set_rate(config.requests_per_minute);
+        self.tokens.set_rate(config.tokens_per_minute);
+    }
+
+    fn admit(&mut self, lane: Lane, tokens: u64, now: Instant) -> Admission {
+        if let Some(until) = self.paused_until {
+            if until > now {
+                return Admission::Sleep(until - now);
+            }
+            self.paused_until = None;
+        }
+        if lane == Lane::Bulk && self.waiting_interactive > 0 {
+            return Admission::Wait;
+        }
+        if self.in_flight >= (self.limit.floor() as usize).max(1) {
+            return Admission::Wait;
+        }
+        if let Some(wait) = self.requests.wait_for(1.0, now) {
+            return Admission::Sleep(wait);
+        }
+        if let Some(wait) = self.tokens.wait_for(tokens as f64, now) {
+            return Admission::Sleep(wait);
+        }
+        self.requests.take(1.0);
+        self.tokens.take(tokens as f64);
+        self.in_flight += 1;
+        Admission::Start
+    }
+
+    fn release(&mut self, outcome: Outcome, now: Instant) {
+        self.in_flight = self.in_flight.saturating_sub(1);
+        let max = self.config.max_concurrency as f64;
+        match outcome {
+            Outcome::Done => {
+                self.limit = (self.limit + 1.0 / self.limit.max(1.0)).min(max);
+            }
+            Outcome::RateLimited(retry_after) => {
+                self.limit = (self.limit / 2.0).max(1.0);
+                if let Some(wait) = retry_after {
+                    let until = now + wait;
+                    if self.paused_until.is_none_or(|current| current < until) {
+                        self.paused_until = Some(until);
+                    }
+                }
+            }
+        }
+    }
+}
+
+#[derive(Debug, Clone, Copy)]
+enum Outcome {
+    Done,
+    RateLimited(Option<Duration>),
+}
+
+struct Limiter {
+    provider: String,
+    model: String,
+    state: Mutex<LimiterState>,
+    notify: Notify,
+}
+
+impl Limiter {
+    fn labels(&self) -> [(&'static str, &str); 2] {
+        [("provider", &self.provider), ("model", &self.model)]
+    }
+
+    fn lock(&self) -> MutexGuard<'_, LimiterState> {
+        match self.state.lock() {
+            Ok(guard) => guard,
+            Err(poisoned) => poisoned.into_inner(),
+        }
+    }
+}
+
+static CONFIG: Mutex<Option<LimitConfig>> = Mutex::new(None);
+static LIMITERS: Mutex<Option<HashMap<String, Arc<Limiter>>>> = Mutex::new(None);
+
+/// Applies `[rate_limit]` settings to every provider/model limiter.
+pub(crate) fn configure(settings: &Settings) {
+    let config = LimitConfig::from_settings(settings);
+    *lock(&CONFIG) = Some(config);
+    if let Some(limiters) = lock(&LIMITERS).as_ref() {
+        for limiter in limiters.values() {
+            limiter.lock().reconfigure(config);
+            limiter.notify.notify_waiters();
+        }
+    }
+}
+
+fn limiter(provider: &str, model: &str) -> Arc<Limiter> {
+    let config = lock(&CONFIG).unwrap_or_default();
+    lock(&LIMITERS)
+        .get_or_insert_with(HashMap::new)
+        .entry(format!("{}:{}", provider, model))
+        .or_insert_with(|| {
+            Arc::new(Limiter {
+                provider: provider.to_string(),
+                model: model.to_string(),
+                state: Mutex::new(LimiterState::new(config, Instant::now())),
+                notify: Notify::new(),
+            })
+        })
+        .clone()
+}
+
+/// A started provider call. Dropping it frees the slot, records the call's latency and
+/// counts as a success unless `rate_limited` was called.
+pub(crate) struct Permit {
+    limiter: Arc<Limiter>,
+    outcome: Outcome,
+    started: Instant,
+}
+
+impl Permit {
+    /// Records a 429/503-style response: concurrency for this model is halved and, with a
+    /// `retry-after`, every caller waits it out instead of only this one.
+    pub(crate) fn rate_limited(&mut self, retry_after: Option<Duration>) {
+        self.outcome = Outcome::RateLimited(retry_after);
+        metrics::add(&metrics::PROVIDER_RATE_LIMITED, &self.limiter.labels(), 1);
+    }
+}
+
+impl Drop for Permit {
+    fn drop(&mut self) {
+        metrics::observe(
+            &metrics::PROVIDER_LATENCY,
+            &self.limiter.labels(),
+            self.started.elapsed().as_secs_f64(),
+        );
+        self.limiter.lock().release(self.outcome, Instant::now());
+        self.limiter.notify.notify_waiters();
+    }
+}
+
+struct InteractiveWaiter<'a>(&'a Limiter);
+
+/// Counts a caller in the queue-depth gauge until it starts or is cancelled.
+struct Queued<'a>(&'a Limiter);
+
+impl<'a> Queued<'a> {
+    fn new(limiter: &'a Limiter) -> Self {
+        metrics::gauge_add(&metrics::PROVIDER_QUEUE_DEPTH, &limiter.labels(), 1);
+        Self(limiter)
+    }
+}
+
+impl Drop for Queued<'_> {
+    fn drop(&mut self) {
+        metrics::gauge_add(&metrics::PROVIDER_QUEUE_DEPTH, &self.0.labels(), -1);
+    }
+}
+
+impl Drop for InteractiveWaiter<'_> {
+    fn drop(&mut self) {
+        let mut state = self.0.lock();
+        state.waiting_interactive = state.waiting_interactive.saturating_sub(1);
+        drop(state);
+        self.0.notify.notify_waiters();
+    }
+}
+
+/// Waits until `provider`/`model` has a free slot and budget for a request of about
+/// `tokens` tokens. One limiter is shared per pair across the whole process, so the CLI,
+/// server, directory jobs and C ABI callers all draw from the same limits.
+pub(crate) async fn acquire(provider: &str, model: &str, tokens: u64) -> Permit {
+    let limiter = limiter(provider, model);
+    let lane = current_lane();
+    // Counted until this call starts or is cancelled, so bulk callers hold back meanwhile.
+    let _waiter = (lane == Lane::Interactive).then(|| {
+        limiter.lock().waiting_interactive += 1;
+        InteractiveWaiter(&limiter)
+    });
+    let _queued = Queued::new(&limiter);
+    loop {
+        let notified = limiter.notify.notified();
+        tokio::pin!(notified);
+        notified.as_mut().enable();
+        let admission = limiter.lock().admit(lane, tokens, Instant::now());
+        match admission {
+            Admission::Start => {
+                return Permit {
+                    limiter: limiter.clone(),
+                    outcome: Outcome::Done,
+                    started: Instant::now(),
+                };
+            }
+            Admission::Sleep(wait) => {
+                tokio::select! {
+                    _ = tokio::time::sleep(wait) => {}
+                    _ = &mut notified => {}
+                }
+            }
+            Admission::Wait => notified.await,
+        }
+    }
+}
+
+/// Rough request size for the tokens-per-minute budget: about four bytes per token.
+pub(crate) fn estimate_tokens(body: &serde_json::Value) -> u64 {
+    (body.to_string().len() as u64 / 4).max(1)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn config(max_concurrency: usize, rpm: u64, tpm: u64) -> LimitConfig {
+        LimitConfig {
+            max_concurrency,
+            requests_per_minute: rpm,
+            tokens_per_minute: tpm,
+        }
+    }
+
+    #[test]
+    fn halves_on_rate_limit_and_recovers_additively() {
+        let now = Instant::now();
+        let mut state = LimiterState::new(config(8, 0, 0), now);
+        for _ in 0..8 {
+            assert!(matches!(state.admit(Lane::Bulk, 10, now), Admission::Start));
+        }
+        assert!(matches!(state.admit(Lane::Bulk, 10, now), Admission::Wait));
+
+        state.release(Outcome::RateLimited(Some(Duration::from_secs(5))), now);
+        assert_eq!(state.limit, 4.0);
+        assert!(matches!(
+            state.admit(Lane::Bulk, 10, now + Duration::from_secs(1)),
+            Admission::Sleep(wait) if wait == Duration::from_secs(4)
+        ));
+        for _ in 0..7 {
+            state.release(Outcome::Done, now);
+        }
+        assert!(state.limit > 5.0 && state.limit < 6.0, "{}", state.limit);
+        assert_eq!(state.in_flight, 0);
+    }
+
+    #[test]
+    fn token_buckets_delay_and_interactive_goes_first() {
+        let now = Instant::now();
+        let mut state = LimiterState::new(config(4, 2, 1000), now);
+        assert!(matches!(
+            state.admit(Lane::Interactive, 600, now),
+            Admission::Start
+        ));
+        // 400 tokens left; 600 more need 200 tokens at 1000/min = 12 s.
+        assert!(matches!(
+            state.admit(Lane::Interactive, 600, now),
+            Admission::Sleep(wait) if (wait.as_secs_f64() - 12.0).abs() < 0.01
+        ));
+        assert!(matches!(
+            state.admit(Lane::Interactive, 100, now),
+            Admission::Start
+        ));
+        // Two requests per minute are used up.
+        assert!(matches!(
+            state.admit(Lane::Interactive, 1, now),
+            Admission::Sleep(_)
+        ));
+
+        state.waiting_interactive = 1;
+        assert!(matches!(
+            state.admit(Lane::Bulk, 1, now + Duration::from_secs(60)),
+            Admission::Wait
+        ));
+    }
+}
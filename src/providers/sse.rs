@@ -0,0 +1,75 @@
+use anyhow::Result;
+use futures_util::StreamExt;
+
+/// Splits a `text/event-stream` body into `data:` payloads.
+///
+/// Only single-line `data:` fields are needed for the provider streams we consume, so events
+/// are yielded per line; `[DONE]` markers are dropped.
+#[derive(Debug, Default)]
+pub(crate) struct SseDecoder {
+    buffer: Vec<u8>,
+}
+
+impl SseDecoder {
+    pub(crate) fn push(&mut self, chunk: &[u8]) -> Vec<String> {
+        self.buffer.extend_from_slice(chunk);
+        let mut events = Vec::new();
+        while let Some(end) = self.buffer.iter().position(|byte| *byte == b'\n') {
+            let line = self.buffer.drain(..=end).collect::<Vec<_>>();
+            if let Some(event) = parse_line(&line) {
+                events.push(event);
+            }
+        }
+        events
+    }
+
+    pub(crate) fn finish(&mut self) -> Option<String> {
+        let line = std::mem::take(&mut self.buffer);
+        parse_line(&line)
+    }
+}
+
+fn parse_line(line: &[u8]) -> Option<String> {
+    let line = String::from_utf8_lossy(line);
+    let line = line.trim_end_matches(['\r', '\n']);
+    let data = line.strip_prefix("data:")?.trim_start();
+    if data.is_empty() || data == "[DONE]" {
+        return None;
+    }
+    Some(data.to_string())
+}
+
+/// Feeds every `data:` payload of a streamed response to `on_event`.
+pub(crate) async fn read_events(
+    response: reqwest::Response,
+    mut on_event: impl FnMut(&str) -> Result<()>,
+) -> Result<()> {
+    let mut decoder = SseDecoder::default();
+    let mut body = response.bytes_stream();
+    while let Some(chunk) = body.next().await {
+        for event in decoder.push(&chunk?) {
+            on_event(&event)?;
+        }
+    }
+    if let Some(event) = decoder.finish() {
+        on_event(&event)?;
+    }
+    Ok(())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::SseDecoder;
+
+    #[test]
+    fn decoder_joins_split_chunks_and_skips_done() {
+        let mut decoder = SseDecoder::default();
+        assert!(decoder.push(b"event: delta\r\ndata: {\"a\"").is_empty());
+        assert_eq!(
+            decoder.push(b":1}\r\n\r\ndata: [DONE]\n"),
+            vec!["{\"a\":1}"]
+        );
+        assert!(decoder.push(b"data: tail").is_empty());
+        assert_eq!(decoder.finish().as_deref(), Some("tail"));
+    }
+}
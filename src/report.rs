@@ -569,11 +569,10 @@ fn analysis_tool_spec() -> ToolSpec {
 }
 
 fn render_report_prompt(target_lang: &str) -> Result<String> {
-    let template = load_prompt_template("report_prompt.tera")?;
     let mut context = tera::Context::new();
     context.insert("keyword_target_lang", target_lang);
     context.insert("tool_name", ANALYSIS_TOOL_NAME);
-    tera::Tera::one_off(&template, &context, false)
+    translations::render_prompt("report_prompt.tera", &context)
         .with_context(|| "failed to render report prompt")
 }
 
@@ -623,21 +622,6 @@ fn cluster_total(cluster: &Cluster) -> usize {
     cluster.items.iter().map(|item| item.count).sum()
 }
 
-fn load_prompt_template(name: &str) -> Result<String> {
-    let path = prompt_path(name)?;
-    std::fs::read_to_string(&path)
-        .with_context(|| format!("failed to read prompt: {}", path.display()))
-}
-
-fn prompt_path(name: &str) -> Result<PathBuf> {
-    let base = PathBuf::from(env!("CARGO_MANIFEST_DIR"))
-        .join("src")
-        .join("translations")
-        .join("prompts")
-        .join(name);
-    Ok(base)
-}
-
 fn counts_from_map(map: HashMap<String, usize>) -> Vec<CountItem> {
     let mut items = map
         .into_iter()
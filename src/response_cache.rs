@@ -0,0 +1,245 @@
+use std::collections::{BTreeMap, HashMap};
+use std::sync::Mutex;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::{Duration, Instant};
+use tokio::sync::watch;
+
+use crate::settings::Settings;
+use crate::util::lock;
+
+static CACHE: Mutex<Option<ResponseCache>> = Mutex::new(None);
+static IN_FLIGHT: Mutex<Option<HashMap<String, FlightReceiver>>> = Mutex::new(None);
+static HITS: AtomicU64 = AtomicU64::new(0);
+static MISSES: AtomicU64 = AtomicU64::new(0);
+static COALESCED: AtomicU64 = AtomicU64::new(0);
+
+/// A plain-text translation as served to callers that did not make the provider call.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub(crate) struct CachedTranslation {
+    pub(crate) text: String,
+    pub(crate) model: Option<String>,
+}
+
+type FlightResult = Option<Result<CachedTranslation, String>>;
+type FlightReceiver = watch::Receiver<FlightResult>;
+
+/// Process-wide response cache counters since start-up. `coalesced` counts requests that
+/// waited for an identical in-flight request instead of calling the provider.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct CacheStats {
+    pub hits: u64,
+    pub misses: u64,
+    pub coalesced: u64,
+}
+
+pub fn stats() -> CacheStats {
+    CacheStats {
+        hits: HITS.load(Ordering::Relaxed),
+        misses: MISSES.load(Ordering::Relaxed),
+        coalesced: COALESCED.load(Ordering::Relaxed),
+    }
+}
+
+/// Sizes the process-wide cache from `[memory] response_cache_entries/response_cache_ttl_secs`.
+/// Resizing keeps the most recently used entries.
+pub(crate) fn configure(settings: &Settings) {
+    let capacity = settings.response_cache_entries;
+    let ttl = Duration::from_secs(settings.response_cache_ttl_secs);
+    let mut guard = lock(&CACHE);
+    match guard.as_mut() {
+        Some(cache) if cache.capacity == capacity && cache.ttl == ttl => {}
+        Some(cache) => {
+            cache.capacity = capacity;
+            cache.ttl = ttl;
+            cache.evict_to_capacity();
+        }
+        None => *guard = Some(ResponseCache::new(capacity, ttl)),
+    }
+}
+
+pub(crate) fn lookup(key: &str) -> Option<CachedTranslation> {
+    let mut guard = lock(&CACHE);
+    let cache = guard.as_mut().filter(|cache| cache.capacity > 0)?;
+    let found = cache.get(key, Instant::now());
+    let counter = if found.is_some() { &HITS } else { &MISSES };
+    counter.fetch_add(1, Ordering::Relaxed);
+    found
+}
+
+pub(crate) fn store(key: &str, value: CachedTranslation) {
+    if let Some(cache) = lock(&CACHE).as_mut() {
+        cache.insert(key.to_string(), value, Instant::now());
+    }
+}
+
+/// The caller's role for one key: the first caller makes the provider call, later callers
+/// with the same key wait for its result.
+pub(crate) enum Flight {
+    Leader(FlightLeader),
+    Follower(FlightReceiver),
+}
+
+pub(crate) fn begin(key: &str) -> Flight {
+    let mut guard = lock(&IN_FLIGHT);
+    let flights = guard.get_or_insert_with(HashMap::new);
+    if let Some(receiver) = flights.get(key) {
+        COALESCED.fetch_add(1, Ordering::Relaxed);
+        return Flight::Follower(receiver.clone());
+    }
+    let (sender, receiver) = watch::channel(None);
+    flights.insert(key.to_string(), receiver);
+    Flight::Leader(FlightLeader {
+        key: key.to_string(),
+        sender,
+    })
+}
+
+/// Waits for the leader's result. `None` means the leader was dropped before finishing
+/// (its caller went away) and the follower should make the call itself.
+pub(crate) async fn wait(mut receiver: FlightReceiver) -> FlightResult {
+    match receiver.wait_for(Option::is_some).await {
+        Ok(result) => result.clone(),
+        Err(_) => None,
+    }
+}
+
+/// Held by the caller making the provider call; dropping it releases the key.
+pub(crate) struct FlightLeader {
+    key: String,
+    sender: watch::Sender<FlightResult>,
+}
+
+impl FlightLeader {
+    pub(crate) fn finish(self, result: Result<CachedTranslation, String>) {
+        self.sender.send_replace(Some(result));
+    }
+}
+
+impl Drop for FlightLeader {
+    fn drop(&mut self) {
+        if let Some(flights) = lock(&IN_FLIGHT).as_mut() {
+            flights.remove(&self.key);
+        }
+    }
+}
+
+struct CacheEntry {
+    value: CachedTranslation,
+    stored: Instant,
+    tick: u64,
+}
+
+/// Bounded LRU with a TTL; `recency` maps each entry's last-use tick to its key.
+struct ResponseCache {
+    capacity: usize,
+    ttl: Duration,
+    entries: HashMap<String, CacheEntry>,
+    recency: BTreeMap<u64, String>,
+    tick: u64,
+}
+
+impl ResponseCache {
+    fn new(capacity: usize, ttl: Duration) -> Self {
+        Self {
+            capacity,
+            ttl,
+            entries: HashMap::new(),
+            recency: BTreeMap::new(),
+            tick: 0,
+        }
+    }
+
+    fn get(&mut self, key: &str, now: Instant) -> Option<CachedTranslation> {
+        let entry = self.entries.get_mut(key)?;
+        if !self.ttl.is_zero() && now.saturating_duration_since(entry.stored) > self.ttl {
+            let tick = entry.tick;
+            self.entries.remove(key);
+            self.recency.remove(&tick);
+            return None;
+        }
+        self.tick += 1;
+        self.recency.remove(&entry.tick);
+        entry.tick = self.tick;
+        self.recency.insert(self.tick, key.to_string());
+        Some(entry.value.clone())
+    }
+
+    fn insert(&mut self, key: String, value: CachedTranslation, now: Instant) {
+        if self.capacity == 0 {
+            return;
+        }
+        self.tick += 1;
+        if let Some(old) = self.entries.insert(
+            key.clone(),
+            CacheEntry {
+                value,
+                stored: now,
+                tick: self.tick,
+            },
+        ) {
+            self.recency.remove(&old.tick);
+        }
+        self.recency.insert(self.tick, key);
+        self.evict_to_capacity();
+    }
+
+    fn evict_to_capacity(&mut self) {
+        while self.entries.len() > self.capacity {
+            let Some((_, key)) = self.recency.pop_first() else {
+                break;
+            };
+            self.entries.remove(&key);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn value(text: &str) -> CachedTranslation {
+        CachedTranslation {
+            text: text.to_string(),
+            model: None,
+        }
+    }
+
+    #[test]
+    fn evicts_least_recently_used_and_expired_entries() {
+        let start = Instant::now();
+        let mut cache = ResponseCache::new(2, Duration::from_secs(10));
+        cache.insert("a".to_string(), value("A"), start);
+        cache.insert("b".to_string(), value("B"), start);
+        assert_eq!(cache.get("a", start), Some(value("A")));
+        cache.insert("c".to_string(), value("C"), start);
+        assert_eq!(cache.get("b", start), None);
+        assert_eq!(cache.get("a", start), Some(value("A")));
+        assert_eq!(cache.get("c", start + Duration::from_secs(11)), None);
+        assert_eq!(cache.entries.len(), 1);
+        assert_eq!(cache.recency.len(), 1);
+    }
+
+    #[tokio::test]
+    async fn followers_share_the_leaders_result() {
+        let key = "response-cache-test-flight";
+        let Flight::Leader(leader) = begin(key) else {
+            panic!("first caller leads");
+        };
+        let Flight::Follower(receiver) = begin(key) else {
+            panic!("second caller follows");
+        };
+        let waiter = tokio::spawn(wait(receiver));
+        leader.finish(Ok(value("shared")));
+        assert_eq!(waiter.await.expect("join"), Some(Ok(value("shared"))));
+        assert!(matches!(begin(key), Flight::Leader(_)));
+
+        let Flight::Leader(leader) = begin("response-cache-test-cancel") else {
+            panic!("leader");
+        };
+        let Flight::Follower(receiver) = begin("response-cache-test-cancel") else {
+            panic!("follower");
+        };
+        drop(leader);
+        assert_eq!(wait(receiver).await, None);
+    }
+}
@@ -1,6 +1,6 @@
 use anyhow::{Context, Result};
 use axum::body::Body;
-use axum::extract::{Query, State};
+use axum::extract::{DefaultBodyLimit, Query, State};
 use axum::http::{HeaderMap, HeaderValue, Method, Request, Response, StatusCode};
 use axum::middleware::Next;
 use axum::response::IntoResponse;
@@ -12,26 +12,32 @@ use crate::settings;
 use base64::Engine;
 use base64::engine::general_purpose::STANDARD as BASE64;
 
-use super::models::{ErrorResponse, ServerRequest, ServerResponse};
+use super::models::{ErrorResponse, ServerFile, ServerReply};
 use super::state::ServerState;
 use super::translate::translate_request;
+use super::upload::read_translate_request;
 use crate::model_registry;
 use std::collections::HashMap;
 use std::path::PathBuf;
 
 pub async fn run_server(settings: settings::Settings, addr: String) -> Result<()> {
+    crate::providers::http::configure(&settings);
+    crate::providers::scheduler::configure(&settings);
+    let body_limit = upload_limit(&settings);
     let state = Arc::new(ServerState {
         settings,
         registry: crate::languages::LanguageRegistry::load()?,
     });
     let app = Router::new()
         .route("/health", get(health))
+        .route("/metrics", get(metrics))
         .route("/translate", post(translate))
         .route("/histories", get(histories))
         .route("/history-content", get(history_content))
         .route("/trend", get(trend))
         .route("/settings", get(settings_info))
         .with_state(state)
+        .layer(DefaultBodyLimit::max(body_limit))
         .layer(axum::middleware::from_fn(cors_middleware));
     let listener = tokio::net::TcpListener::bind(addr)
         .await
@@ -41,7 +47,35 @@ pub async fn run_server(settings: settings::Settings, addr: String) -> Result<()
 }
 
 async fn health() -> impl IntoResponse {
-    (StatusCode::OK, Json(serde_json::json!({ "status": "ok" })))
+    let cache = crate::response_cache::stats();
+    let lookups = cache.hits + cache.misses;
+    let hit_ratio = if lookups > 0 {
+        cache.hits as f64 / lookups as f64
+    } else {
+        0.0
+    };
+    (
+        StatusCode::OK,
+        Json(serde_json::json!({
+            "status": "ok",
+            "cache": {
+                "hits": cache.hits,
+                "misses": cache.misses,
+                "hit_ratio": hit_ratio,
+                "coalesced": cache.coalesced,
+            },
+        })),
+    )
+}
+
+async fn metrics() -> impl IntoResponse {
+    (
+        [(
+            "content-type",
+            HeaderValue::from_static("text/plain; version=0.0.4; charset=utf-8"),
+        )],
+        crate::metrics::render_prometheus(),
+    )
 }
 
 async fn cors_middleware(req: Request<Body>, next: Next) -> Result<Response<Body>, StatusCode> {
@@ -70,8 +104,11 @@ fn apply_cors_headers(headers: &mut HeaderMap) {
 
 async fn translate(
     State(state): State<Arc<ServerState>>,
-    Json(payload): Json<ServerRequest>,
-) -> Result<Json<ServerResponse>, (StatusCode, Json<ErrorResponse>)> {
+    request: Request<Body>,
+) -> Result<Response<Body>, (StatusCode, Json<ErrorResponse>)> {
+    let payload = read_translate_request(request, upload_limit(&state.settings))
+        .await
+        .map_err(|err| (err.status, Json(ErrorResponse { error: err.message })))?;
     let state = state.clone();
     let handle = tokio::runtime::Handle::current();
     let result = tokio::task::spawn_blocking(move || {
@@ -88,11 +125,34 @@ async fn translate(
     })?;
 
     match result {
-        Ok(response) => Ok(Json(response)),
+        Ok(ServerReply::Json(response)) => Ok(Json(response).into_response()),
+        Ok(ServerReply::File(file)) => Ok(file_response(file)),
         Err(err) => Err((err.status, Json(ErrorResponse { error: err.message }))),
     }
 }
 
+fn upload_limit(settings: &settings::Settings) -> usize {
+    match settings.server_max_upload_mb {
+        0 => usize::MAX,
+        mb => usize::try_from(mb.saturating_mul(1024 * 1024)).unwrap_or(usize::MAX),
+    }
+}
+
+fn file_response(file: ServerFile) -> Response<Body> {
+    let mut response = Response::new(Body::from(file.bytes));
+    let headers = response.headers_mut();
+    headers.insert(
+        "content-type",
+        HeaderValue::from_str(&file.mime)
+            .unwrap_or_else(|_| HeaderValue::from_static("application/octet-stream")),
+    );
+    let name = file.name.replace(['"', '\\', '\r', '\n'], "_");
+    if let Ok(value) = HeaderValue::from_str(&format!("attachment; filename=\"{}\"", name)) {
+        headers.insert("content-disposition", value);
+    }
+    response
+}
+
 async fn histories(
     State(state): State<Arc<ServerState>>,
 ) -> Result<Json<Vec<model_registry::HistoryEntry>>, (StatusCode, Json<ErrorResponse>)> {
@@ -161,14 +221,10 @@ async fn history_content(
         )
     })?;
     let data_base64 = BASE64.encode(&bytes);
-    let mime = model_registry::get_histories()
+    let mime = model_registry::find_history_by_dest(raw_path)
         .ok()
-        .and_then(|items| {
-            items
-                .into_iter()
-                .find(|item| item.dest == raw_path)
-                .map(|item| item.mime)
-        })
+        .flatten()
+        .map(|item| item.mime)
         .unwrap_or_else(|| "application/octet-stream".to_string());
     Ok(Json(HistoryContentResponse { data_base64, mime }))
 }
@@ -3,6 +3,7 @@ mod handlers;
 mod models;
 mod state;
 mod translate;
+mod upload;
 mod util;
 
 pub use client::run_client;
@@ -22,6 +22,31 @@ pub(crate) struct ServerRequest {
     pub(crate) whisper_model: Option<String>,
     pub(crate) correction: Option<bool>,
     pub(crate) response_format: Option<String>,
+    pub(crate) skip_history_tags: Option<bool>,
+    /// File sent as the request body (raw or multipart) instead of `data_base64`.
+    #[serde(skip)]
+    pub(crate) upload: Option<Vec<u8>>,
+}
+
+/// What `/translate` sends back: the JSON envelope, or the translated file itself for
+/// `response_format = "binary"`.
+#[derive(Debug)]
+pub(crate) enum ServerReply {
+    Json(ServerResponse),
+    File(ServerFile),
+}
+
+impl From<ServerResponse> for ServerReply {
+    fn from(response: ServerResponse) -> Self {
+        ServerReply::Json(response)
+    }
+}
+
+#[derive(Debug)]
+pub(crate) struct ServerFile {
+    pub(crate) mime: String,
+    pub(crate) name: String,
+    pub(crate) bytes: Vec<u8>,
 }
 
 #[derive(Debug, Serialize)]
@@ -1,29 +1,30 @@
 use anyhow::{Context, Result};
-use futures_util::stream::{self, StreamExt};
+use futures_util::future;
+use futures_util::stream::StreamExt;
 use std::path::{Path, PathBuf};
 
 use crate::attachments;
 use crate::correction;
 use crate::data;
-use crate::history_tags;
 use crate::model_registry;
 use crate::providers;
 use crate::settings;
 use crate::translations::TranslateOptions;
 use crate::{
     Config, HistoryRecordInput, ProviderKind, Translator, normalize_formality_for_history,
-    normalize_lang_for_history, record_history, resolve_model, resolve_ocr_languages,
+    normalize_lang_for_history, record_translation, resolve_model, resolve_ocr_languages,
     validate_lang_codes,
 };
 
 use base64::Engine;
 use base64::engine::general_purpose::STANDARD as BASE64;
 
-use super::models::{CorrectionPayload, ServerContent, ServerRequest, ServerResponse};
+use super::models::{
+    CorrectionPayload, ServerContent, ServerFile, ServerReply, ServerRequest, ServerResponse,
+};
 use super::state::ServerState;
 use super::util::{
-    build_translation_ignore, collect_directory_files, decode_text, is_text_mime, resolve_tmp_dir,
-    write_temp_file,
+    build_translation_ignore, decode_text, is_text_mime, resolve_tmp_dir, write_temp_file,
 };
 
 #[derive(Debug)]
@@ -36,6 +37,7 @@ pub(crate) struct ServerError {
 enum ResponseFormat {
     Path,
     Base64,
+    Binary,
 }
 
 fn resolve_response_format(request: &ServerRequest) -> ResponseFormat {
@@ -46,12 +48,13 @@ fn resolve_response_format(request: &ServerRequest) -> ResponseFormat {
         .as_deref()
     {
         Some("base64") => ResponseFormat::Base64,
+        Some("binary") => ResponseFormat::Binary,
         _ => ResponseFormat::Path,
     }
 }
 
 impl ServerError {
-    fn bad_request(message: impl Into<String>) -> Self {
+    pub(crate) fn bad_request(message: impl Into<String>) -> Self {
         Self {
             status: axum::http::StatusCode::BAD_REQUEST,
             message: message.into(),
@@ -74,19 +77,9 @@ impl From<anyhow::Error> for ServerError {
 
 pub(crate) async fn translate_request(
     state: &ServerState,
-    request: ServerRequest,
-) -> Result<ServerResponse, ServerError> {
-    let has_data = request.data.is_some() || request.data_base64.is_some();
-    if request.text.is_some() && has_data {
-        return Err(ServerError::bad_request(
-            "text and data cannot be provided together",
-        ));
-    }
-    if request.data.is_some() && request.data_base64.is_some() {
-        return Err(ServerError::bad_request(
-            "data and data_base64 cannot be provided together",
-        ));
-    }
+    mut request: ServerRequest,
+) -> Result<ServerReply, ServerError> {
+    check_inputs(&request)?;
 
     let config = config_from_request(&request);
     let registry = state.registry.clone();
@@ -99,8 +92,9 @@ pub(crate) async fn translate_request(
 
     validate_lang_codes(&config, &registry)
         .map_err(|err| ServerError::bad_request(err.to_string()))?;
-    let ocr_languages = resolve_ocr_languages(&settings, &config.source_lang, &config.lang)
-        .map_err(|err| ServerError::bad_request(err.to_string()))?;
+    let ocr_languages =
+        resolve_ocr_languages(&settings, &config.source_lang, &config.ocr_hint_langs())
+            .map_err(|err| ServerError::bad_request(err.to_string()))?;
 
     let selection = if let Some(model_arg) = config.model.as_deref() {
         providers::resolve_provider_selection(Some(model_arg), config.key.as_deref())
@@ -127,7 +121,7 @@ pub(crate) async fn translate_request(
     let provider_kind = selection.provider;
     let model_name = model.clone();
     let provider = providers::build_provider(selection.provider, key, model.clone());
-    let translator = Translator::new(provider, settings.clone(), registry);
+    let translator = Translator::new(provider, settings.clone(), registry).with_memory(&model_name);
     let response_format = resolve_response_format(&request);
     let options = TranslateOptions {
         lang: config.lang.clone(),
@@ -137,7 +131,7 @@ pub(crate) async fn translate_request(
     };
 
     if config.correction {
-        if request.data.is_some() {
+        if has_data {
             return Err(ServerError::bad_request(
                 "correction only supports text input",
             ));
@@ -148,12 +142,19 @@ pub(crate) async fn translate_request(
         if text.trim().is_empty() {
             return Err(ServerError::bad_request("text is empty"));
         }
-        return translate_correction(&translator, &options, text).await;
+        return translate_correction(&translator, &options, text)
+            .await
+            .map(ServerReply::from);
     }
 
-    if let Some(data_base64) = request.data_base64.as_deref() {
-        let attachment = load_attachment_from_base64(
-            data_base64,
+    let upload = match (request.upload.take(), request.data_base64.as_deref()) {
+        (Some(bytes), _) => Some(bytes),
+        (None, Some(data_base64)) => Some(decode_base64(data_base64)?),
+        (None, None) => None,
+    };
+    if let Some(bytes) = upload {
+        let attachment = load_attachment_from_bytes(
+            bytes,
             request.data_name.as_deref(),
             config.data_mime.as_deref(),
             config.force_translation,
@@ -189,6 +190,17 @@ pub(crate) async fn translate_request(
             tracing::warn!("failed to record history: {}", err.message);
         }
 
+        if matches!(response_format, ResponseFormat::Binary) {
+            return Ok(ServerReply::File(ServerFile {
+                name: translated_file_name(
+                    attachment.name.as_deref(),
+                    &output.mime,
+                    &settings.translated_suffix,
+                ),
+                mime: output.mime,
+                bytes: output.bytes,
+            }));
+        }
         let content = content_from_attachment(
             &attachment,
             &output,
@@ -198,7 +210,8 @@ pub(crate) async fn translate_request(
         )?;
         return Ok(ServerResponse {
             contents: vec![content],
-        });
+        }
+        .into());
     }
 
     if let Some(path) = config.data.as_deref() {
@@ -219,7 +232,7 @@ pub(crate) async fn translate_request(
                 response_format,
             )
             .await?;
-            return Ok(ServerResponse { contents });
+            return Ok(ServerResponse { contents }.into());
         }
 
         let content = translate_file(
@@ -236,7 +249,8 @@ pub(crate) async fn translate_request(
         .await?;
         return Ok(ServerResponse {
             contents: vec![content],
-        });
+        }
+        .into());
     }
 
     let Some(text) = request.text else {
@@ -250,43 +264,23 @@ pub(crate) async fn translate_request(
         .await
         .map_err(ServerError::from)?;
 
-    let mut tags: Option<Vec<String>> = None;
-    match history_tags::generate_history_tags(
+    if let Err(err) = record_translation(
         &translator,
-        text.as_str(),
-        &config.source_lang,
-        &config.lang,
-    )
-    .await
-    {
-        Ok(result) => {
-            if (!result.categories.is_empty() || !result.keywords.is_empty())
-                && let Err(err) = model_registry::update_trend(&result.categories, &result.keywords)
-            {
-                tracing::warn!("failed to update trend meta: {}", err);
-            }
-            if !result.tags.is_empty() {
-                tags = Some(result.tags);
-            }
-        }
-        Err(err) => {
-            tracing::warn!("failed to generate history tags: {}", err);
-        }
-    }
-
-    if let Err(err) = record_history(HistoryRecordInput {
-        provider: provider_kind,
-        model: &model_name,
-        src_path: None,
-        history_limit: settings.history_limit,
-        input_text: text.as_str(),
-        attachment_mime: None,
-        output_text: &exec.text,
-        source_lang: &config.source_lang,
-        target_lang: &config.lang,
-        formal: &config.formal,
-        tags,
-    }) {
+        HistoryRecordInput {
+            provider: provider_kind,
+            model: &model_name,
+            src_path: None,
+            history_limit: settings.history_limit,
+            input_text: text.as_str(),
+            attachment_mime: None,
+            output_text: &exec.text,
+            source_lang: &config.source_lang,
+            target_lang: &config.lang,
+            formal: &config.formal,
+            tags: None,
+        },
+        config.skip_history_tags,
+    ) {
         tracing::warn!("failed to record history: {}", err);
     }
     Ok(ServerResponse {
@@ -297,12 +291,14 @@ pub(crate) async fn translate_request(
             translated: exec.text,
             correction: None,
         }],
-    })
+    }
+    .into())
 }
 
 fn config_from_request(request: &ServerRequest) -> Config {
     Config {
         lang: request.lang.clone().unwrap_or_else(|| "en".to_string()),
+        extra_langs: Vec::new(),
         model: request.model.clone(),
         key: request.key.clone(),
         formal: request
@@ -341,6 +337,7 @@ fn config_from_request(request: &ServerRequest) -> Config {
         debug_ocr: request.debug_ocr.unwrap_or(false),
         verbose: false,
         whisper_model: request.whisper_model.clone(),
+        skip_history_tags: request.skip_history_tags.unwrap_or(false),
     }
 }
 
@@ -411,28 +408,31 @@ async fn translate_directory<P: providers::Provider + Clone>(
     model: &str,
     response_format: ResponseFormat,
 ) -> Result<Vec<ServerContent>, ServerError> {
-    let files = collect_directory_files(path).map_err(ServerError::from)?;
     let ignore = build_translation_ignore(
         path,
         settings.translation_ignore_file.as_str(),
         &config.ignore_translation_files,
     )
     .map_err(ServerError::from)?;
+    let tmp_dir = resolve_tmp_dir(settings)?;
+    let files = crate::dir_walk::walk_files(path, ignore, &[tmp_dir.as_path()])
+        .map_err(ServerError::from)?;
     let concurrency = config
         .directory_translation_threads
         .unwrap_or(settings.directory_translation_threads)
         .max(1);
-    let tmp_dir = resolve_tmp_dir(settings)?;
 
-    let results: Vec<Result<Option<ServerContent>, ServerError>> = stream::iter(files)
-        .map(|file| {
+    // Ignored files are dropped by the walk itself, before any file I/O.
+    let results: Vec<Result<Option<ServerContent>, ServerError>> = files
+        .filter(|entry| future::ready(!matches!(entry, Ok(file) if file.ignored)))
+        .map(|entry| {
             let translator = translator.clone();
             let options = options.clone();
-            let ignore = ignore.clone();
             let tmp_dir = tmp_dir.clone();
-            async move {
-                if let Some(ignore) = ignore
-                    && ignore.is_ignored(&file)
+            providers::scheduler::bulk(async move {
+                let file = entry.map_err(ServerError::from)?.path;
+                if let Ok(mime) = data::resolve_file_mime(&file, config.data_mime.as_deref())
+                    && !attachments::supports_mime(&mime)
                 {
                     return Ok(None);
                 }
@@ -483,7 +483,7 @@ async fn translate_directory<P: providers::Provider + Clone>(
                     response_format,
                 )?;
                 Ok(Some(content))
-            }
+            })
         })
         .buffer_unordered(concurrency)
         .collect()
@@ -552,21 +552,51 @@ async fn load_attachment_with_detection<P: providers::Provider + Clone>(
     }
 }
 
-async fn load_attachment_from_base64<P: providers::Provider + Clone>(
-    data_base64: &str,
-    name: Option<&str>,
-    mime_hint: Option<&str>,
-    force_translation: bool,
-    translator: &Translator<P>,
-) -> Result<data::DataAttachment, ServerError> {
+/// At most one of `text`, `data`, `data_base64` and an uploaded file may be given.
+fn check_inputs(request: &ServerRequest) -> Result<(), ServerError> {
+    let has_data =
+        request.data.is_some() || request.data_base64.is_some() || request.upload.is_some();
+    if request.text.is_some() && has_data {
+        return Err(ServerError::bad_request(
+            "text and data cannot be provided together",
+        ));
+    }
+    if request.data.is_some() && request.data_base64.is_some() {
+        return Err(ServerError::bad_request(
+            "data and data_base64 cannot be provided together",
+        ));
+    }
+    if request.data.is_some() && request.upload.is_some() {
+        return Err(ServerError::bad_request(
+            "data cannot be combined with an uploaded file",
+        ));
+    }
+    if request.data_base64.is_some() && request.upload.is_some() {
+        return Err(ServerError::bad_request(
+            "data_base64 cannot be combined with an uploaded file",
+        ));
+    }
+    Ok(())
+}
+
+fn decode_base64(data_base64: &str) -> Result<Vec<u8>, ServerError> {
     let raw = data_base64.trim();
     let payload = raw
         .split_once("base64,")
         .map(|(_, value)| value)
         .unwrap_or(raw);
-    let bytes = BASE64
+    BASE64
         .decode(payload)
-        .map_err(|_| ServerError::bad_request("failed to decode base64 data"))?;
+        .map_err(|_| ServerError::bad_request("failed to decode base64 data"))
+}
+
+async fn load_attachment_from_bytes<P: providers::Provider + Clone>(
+    bytes: Vec<u8>,
+    name: Option<&str>,
+    mime_hint: Option<&str>,
+    force_translation: bool,
+    translator: &Translator<P>,
+) -> Result<data::DataAttachment, ServerError> {
     let name = name.map(|value| value.to_string());
     let mut attachment = data::DataAttachment {
         bytes,
@@ -656,6 +686,9 @@ fn content_from_attachment(
     }
 
     match response_format {
+        ResponseFormat::Binary => Err(ServerError::bad_request(
+            "response_format binary requires an uploaded file",
+        )),
         ResponseFormat::Base64 => {
             let encoded = BASE64.encode(&output.bytes);
             Ok(ServerContent {
@@ -680,6 +713,19 @@ fn content_from_attachment(
     }
 }
 
+/// `report.pdf` becomes `report_translated.pdf`; the extension follows the output mime.
+fn translated_file_name(name: Option<&str>, mime: &str, suffix: &str) -> String {
+    let path = Path::new(name.unwrap_or("upload"));
+    let stem = path
+        .file_stem()
+        .and_then(|value| value.to_str())
+        .unwrap_or("upload");
+    let ext = data::extension_from_mime(mime)
+        .or_else(|| path.extension().and_then(|value| value.to_str()))
+        .unwrap_or("bin");
+    format!("{}{}.{}", stem, suffix, ext)
+}
+
 async fn translate_correction<P: providers::Provider + Clone>(
     translator: &Translator<P>,
     options: &TranslateOptions,
@@ -797,4 +843,41 @@ mod tests {
         let value = serde_json::to_value(&output).expect("serialize");
         assert!(value["contents"][0]["correction"].is_object());
     }
+
+    #[test]
+    fn each_conflicting_input_pair_has_its_own_error() {
+        let message =
+            |request: ServerRequest| check_inputs(&request).expect_err("conflict").message;
+        assert_eq!(
+            message(ServerRequest {
+                data: Some("notes.txt".to_string()),
+                upload: Some(b"hello".to_vec()),
+                ..ServerRequest::default()
+            }),
+            "data cannot be combined with an uploaded file"
+        );
+        assert_eq!(
+            message(ServerRequest {
+                data: Some("notes.txt".to_string()),
+                data_base64: Some("aGVsbG8=".to_string()),
+                ..ServerRequest::default()
+            }),
+            "data and data_base64 cannot be provided together"
+        );
+        assert_eq!(
+            message(ServerRequest {
+                data_base64: Some("aGVsbG8=".to_string()),
+                upload: Some(b"hello".to_vec()),
+                ..ServerRequest::default()
+            }),
+            "data_base64 cannot be combined with an uploaded file"
+        );
+        assert!(
+            check_inputs(&ServerRequest {
+                upload: Some(b"hello".to_vec()),
+                ..ServerRequest::default()
+            })
+            .is_ok()
+        );
+    }
 }
@@ -0,0 +1,216 @@
+use axum::body::{Body, to_bytes};
+use axum::extract::{FromRequest, Multipart, Query};
+use axum::http::{Request, header};
+
+use super::models::ServerRequest;
+use super::translate::ServerError;
+
+/// Reads a `/translate` request body.
+///
+/// JSON bodies are parsed as before. `multipart/form-data` takes the file from the part that
+/// has a filename (or is named `file`) and the options from the other parts; any other
+/// content type is the file itself, with options in the query string. Uploaded bytes are
+/// collected straight from the body chunks, so nothing is base64 encoded on either side,
+/// and the response defaults to the translated file as the body.
+pub(crate) async fn read_translate_request(
+    request: Request<Body>,
+    limit: usize,
+) -> Result<ServerRequest, ServerError> {
+    let content_type = request
+        .headers()
+        .get(header::CONTENT_TYPE)
+        .and_then(|value| value.to_str().ok())
+        .map(|value| value.to_ascii_lowercase())
+        .unwrap_or_default();
+    let essence = content_type
+        .split(';')
+        .next()
+        .unwrap_or_default()
+        .trim()
+        .to_string();
+
+    if essence.is_empty() || essence == "application/json" {
+        let bytes = to_bytes(request.into_body(), limit)
+            .await
+            .map_err(|err| ServerError::bad_request(format!("failed to read body: {}", err)))?;
+        return serde_json::from_slice(&bytes)
+            .map_err(|err| ServerError::bad_request(format!("invalid JSON request: {}", err)));
+    }
+
+    let query = Query::<Vec<(String, String)>>::try_from_uri(request.uri())
+        .map_err(|err| ServerError::bad_request(format!("invalid query string: {}", err)))?;
+    let mut fields = query.0;
+
+    let mut upload = None;
+    let mut upload_name = None;
+    let mut upload_mime = None;
+    if essence == "multipart/form-data" {
+        let mut multipart = Multipart::from_request(request, &())
+            .await
+            .map_err(|err| ServerError::bad_request(err.body_text()))?;
+        while let Some(mut field) = multipart
+            .next_field()
+            .await
+            .map_err(|err| ServerError::bad_request(err.body_text()))?
+        {
+            let name = field.name().unwrap_or_default().to_string();
+            if field.file_name().is_none() && name != "file" {
+                let value = field
+                    .text()
+                    .await
+                    .map_err(|err| ServerError::bad_request(err.body_text()))?;
+                fields.push((name, value));
+                continue;
+            }
+            upload_name = field.file_name().map(|value| value.to_string());
+            upload_mime = field.content_type().map(|value| value.to_string());
+            let mut bytes = Vec::new();
+            while let Some(chunk) = field
+                .chunk()
+                .await
+                .map_err(|err| ServerError::bad_request(err.body_text()))?
+            {
+                bytes.extend_from_slice(&chunk);
+            }
+            upload = Some(bytes);
+        }
+    } else {
+        upload_mime = Some(essence);
+        let bytes = to_bytes(request.into_body(), limit)
+            .await
+            .map_err(|err| ServerError::bad_request(format!("failed to read body: {}", err)))?;
+        upload = Some(Vec::from(bytes));
+    }
+
+    let mut request = request_from_fields(fields)?;
+    let Some(upload) = upload else {
+        return Ok(request);
+    };
+    if request.data_name.is_none() {
+        request.data_name = upload_name;
+    }
+    if request.data_mime.is_none() {
+        request.data_mime = upload_mime
+            .map(|mime| {
+                mime.split(';')
+                    .next()
+                    .unwrap_or_default()
+                    .trim()
+                    .to_string()
+            })
+            .filter(|mime| !mime.is_empty() && mime != "application/octet-stream");
+    }
+    if request.response_format.is_none() {
+        request.response_format = Some("binary".to_string());
+    }
+    request.upload = Some(upload);
+    Ok(request)
+}
+
+/// Builds a request from form fields or query parameters named like the JSON keys.
+/// `ignore_translation_files` may be repeated.
+fn request_from_fields(fields: Vec<(String, String)>) -> Result<ServerRequest, ServerError> {
+    let mut request = ServerRequest::default();
+    for (key, value) in fields {
+        match key.as_str() {
+            "text" => request.text = Some(value),
+            "data" => request.data = Some(value),
+            "data_mime" => request.data_mime = Some(value),
+            "data_name" => request.data_name = Some(value),
+            "lang" => request.lang = Some(value),
+            "model" => request.model = Some(value),
+            "key" => request.key = Some(value),
+            "formal" => request.formal = Some(value),
+            "source_lang" => request.source_lang = Some(value),
+            "whisper_model" => request.whisper_model = Some(value),
+            "response_format" => request.response_format = Some(value),
+            "slang" => request.slang = Some(parse_bool(&key, &value)?),
+            "with_commentout" => request.with_commentout = Some(parse_bool(&key, &value)?),
+            "debug_ocr" => request.debug_ocr = Some(parse_bool(&key, &value)?),
+            "force_translation" => request.force_translation = Some(parse_bool(&key, &value)?),
+            "correction" => request.correction = Some(parse_bool(&key, &value)?),
+            "skip_history_tags" => request.skip_history_tags = Some(parse_bool(&key, &value)?),
+            "directory_translation_threads" => {
+                let threads = value
+                    .trim()
+                    .parse()
+                    .map_err(|_| ServerError::bad_request(format!("invalid {}: {}", key, value)))?;
+                request.directory_translation_threads = Some(threads);
+            }
+            "ignore_translation_files" => request
+                .ignore_translation_files
+                .get_or_insert_with(Vec::new)
+                .push(value),
+            _ => {}
+        }
+    }
+    Ok(request)
+}
+
+fn parse_bool(key: &str, value: &str) -> Result<bool, ServerError> {
+    match value.trim().to_ascii_lowercase().as_str() {
+        "" | "1" | "true" | "yes" | "on" => Ok(true),
+        "0" | "false" | "no" | "off" => Ok(false),
+        _ => Err(ServerError::bad_request(format!(
+            "invalid {}: {}",
+            key, value
+        ))),
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[tokio::test]
+    async fn reads_raw_and_multipart_uploads() {
+        let raw = Request::post("/translate?lang=ja&slang=true&data_name=deck.pptx")
+            .header(header::CONTENT_TYPE, "application/pdf")
+            .body(Body::from(vec![1u8, 2, 3]))
+            .expect("raw request");
+        let request = read_translate_request(raw, 1024).await.expect("raw");
+        assert_eq!(request.upload.as_deref(), Some(&[1u8, 2, 3][..]));
+        assert_eq!(request.lang.as_deref(), Some("ja"));
+        assert_eq!(request.slang, Some(true));
+        assert_eq!(request.data_name.as_deref(), Some("deck.pptx"));
+        assert_eq!(request.data_mime.as_deref(), Some("application/pdf"));
+        assert_eq!(request.response_format.as_deref(), Some("binary"));
+
+        let body = concat!(
+            "--XBOUNDARY\r\n",
+            "Content-Disposition: form-data; name=\"lang\"\r\n\r\n",
+            "fr\r\n",
+            "--XBOUNDARY\r\n",
+            "Content-Disposition: form-data; name=\"response_format\"\r\n\r\n",
+            "path\r\n",
+            "--XBOUNDARY\r\n",
+            "Content-Disposition: form-data; name=\"upload\"; filename=\"notes.md\"\r\n",
+            "Content-Type: text/markdown\r\n\r\n",
+            "# Hello\r\n",
+            "--XBOUNDARY--\r\n",
+        );
+        let multipart = Request::post("/translate")
+            .header(
+                header::CONTENT_TYPE,
+                "multipart/form-data; boundary=XBOUNDARY",
+            )
+            .body(Body::from(body))
+            .expect("multipart request");
+        let request = read_translate_request(multipart, 1024)
+            .await
+            .expect("multipart");
+        assert_eq!(request.upload.as_deref(), Some(&b"# Hello"[..]));
+        assert_eq!(request.lang.as_deref(), Some("fr"));
+        assert_eq!(request.data_name.as_deref(), Some("notes.md"));
+        assert_eq!(request.data_mime.as_deref(), Some("text/markdown"));
+        assert_eq!(request.response_format.as_deref(), Some("path"));
+
+        let json = Request::post("/translate")
+            .header(header::CONTENT_TYPE, "application/json")
+            .body(Body::from(r#"{"text":"Hello","lang":"ja"}"#))
+            .expect("json request");
+        let request = read_translate_request(json, 1024).await.expect("json");
+        assert_eq!(request.text.as_deref(), Some("Hello"));
+        assert!(request.upload.is_none());
+    }
+}
@@ -56,29 +56,6 @@ pub(crate) fn is_text_mime(mime: &str) -> bool {
     )
 }
 
-pub(crate) fn collect_directory_files(root: &Path) -> Result<Vec<PathBuf>> {
-    let mut files = Vec::new();
-    let mut stack = vec![root.to_path_buf()];
-    while let Some(dir) = stack.pop() {
-        let entries = std::fs::read_dir(&dir)
-            .with_context(|| format!("failed to read directory: {}", dir.display()))?;
-        for entry in entries {
-            let entry = entry.with_context(|| "failed to read directory entry")?;
-            let path = entry.path();
-            let file_type = entry
-                .file_type()
-                .with_context(|| "failed to read file type")?;
-            if file_type.is_dir() {
-                stack.push(path);
-            } else if file_type.is_file() {
-                files.push(path);
-            }
-        }
-    }
-    files.sort();
-    Ok(files)
-}
-
 pub(crate) fn build_translation_ignore(
     src_dir: &Path,
     ignore_file_name: &str,
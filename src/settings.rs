@@ -24,12 +24,29 @@ pub struct Settings {
     pub overlay_font_family: Option<String>,
     pub overlay_font_path: Option<String>,
     pub ocr_normalize: bool,
+    pub pdf_page_workers: usize,
+    pub pdf_max_inflight_mb: u64,
     pub whisper_model: Option<String>,
+    pub whisper_pool_size: usize,
+    pub whisper_threads_per_job: usize,
     pub server_host: String,
     pub server_port: u16,
     pub server_tmp_dir: Option<String>,
+    pub server_max_upload_mb: u64,
     pub client_host: String,
     pub client_port: u16,
+    pub http_pool_max_idle_per_host: usize,
+    pub http_pool_idle_timeout_secs: u64,
+    pub http_connect_timeout_secs: u64,
+    pub http_read_timeout_secs: u64,
+    pub http_tcp_keepalive_secs: u64,
+    pub rate_limit_max_concurrency: usize,
+    pub rate_limit_requests_per_minute: u64,
+    pub rate_limit_tokens_per_minute: u64,
+    pub translation_memory_enabled: bool,
+    pub translation_memory_max_mb: u64,
+    pub response_cache_entries: usize,
+    pub response_cache_ttl_secs: u64,
 }
 
 impl Default for Settings {
@@ -49,12 +66,29 @@ impl Default for Settings {
             overlay_font_family: None,
             overlay_font_path: None,
             ocr_normalize: true,
+            pdf_page_workers: 0,
+            pdf_max_inflight_mb: 512,
             whisper_model: None,
+            whisper_pool_size: 2,
+            whisper_threads_per_job: 0,
             server_host: "0.0.0.0".to_string(),
             server_port: 11223,
             server_tmp_dir: None,
+            server_max_upload_mb: 512,
             client_host: "0.0.0.0".to_string(),
             client_port: 11222,
+            http_pool_max_idle_per_host: 32,
+            http_pool_idle_timeout_secs: 90,
+            http_connect_timeout_secs: 10,
+            http_read_timeout_secs: 300,
+            http_tcp_keepalive_secs: 60,
+            rate_limit_max_concurrency: 16,
+            rate_limit_requests_per_minute: 0,
+            rate_limit_tokens_per_minute: 0,
+            translation_memory_enabled: true,
+            translation_memory_max_mb: 64,
+            response_cache_entries: 1024,
+            response_cache_ttl_secs: 600,
         }
     }
 }
@@ -64,9 +98,13 @@ struct SettingsFile {
     formally: Option<HashMap<String, String>>,
     system: Option<SystemSettings>,
     ocr: Option<OcrSettings>,
+    pdf: Option<PdfSettings>,
     whisper: Option<WhisperSettings>,
     server: Option<ServerSettings>,
     client: Option<ClientSettings>,
+    http: Option<HttpSettings>,
+    rate_limit: Option<RateLimitSettings>,
+    memory: Option<MemorySettings>,
 }
 
 #[derive(Debug, Default, Deserialize)]
@@ -90,9 +128,17 @@ struct OcrSettings {
     normalize: Option<bool>,
 }
 
+#[derive(Debug, Default, Deserialize)]
+struct PdfSettings {
+    workers: Option<usize>,
+    max_inflight_mb: Option<u64>,
+}
+
 #[derive(Debug, Default, Deserialize)]
 struct WhisperSettings {
     model: Option<String>,
+    pool_size: Option<usize>,
+    threads_per_job: Option<usize>,
 }
 
 #[derive(Debug, Default, Deserialize)]
@@ -100,6 +146,7 @@ struct ServerSettings {
     host: Option<String>,
     port: Option<u16>,
     tmp_dir: Option<String>,
+    max_upload_mb: Option<u64>,
 }
 
 #[derive(Debug, Default, Deserialize)]
@@ -108,6 +155,30 @@ struct ClientSettings {
     port: Option<u16>,
 }
 
+#[derive(Debug, Default, Deserialize)]
+struct HttpSettings {
+    pool_max_idle_per_host: Option<usize>,
+    pool_idle_timeout_secs: Option<u64>,
+    connect_timeout_secs: Option<u64>,
+    read_timeout_secs: Option<u64>,
+    tcp_keepalive_secs: Option<u64>,
+}
+
+#[derive(Debug, Default, Deserialize)]
+struct RateLimitSettings {
+    max_concurrency: Option<usize>,
+    requests_per_minute: Option<u64>,
+    tokens_per_minute: Option<u64>,
+}
+
+#[derive(Debug, Default, Deserialize)]
+struct MemorySettings {
+    enabled: Option<bool>,
+    max_size_mb: Option<u64>,
+    response_cache_entries: Option<usize>,
+    response_cache_ttl_secs: Option<u64>,
+}
+
 pub fn load_settings(extra_path: Option<&Path>) -> Result<Settings> {
     let mut settings = Settings::default();
     ensure_settings_file()?;
@@ -212,11 +283,28 @@ impl Settings {
                 self.ocr_normalize = normalize;
             }
         }
-        if let Some(whisper) = incoming.whisper
-            && let Some(model) = whisper.model
-            && !model.trim().is_empty()
-        {
-            self.whisper_model = Some(model);
+        if let Some(pdf) = incoming.pdf {
+            if let Some(workers) = pdf.workers {
+                self.pdf_page_workers = workers;
+            }
+            if let Some(size) = pdf.max_inflight_mb {
+                self.pdf_max_inflight_mb = size;
+            }
+        }
+        if let Some(whisper) = incoming.whisper {
+            if let Some(model) = whisper.model
+                && !model.trim().is_empty()
+            {
+                self.whisper_model = Some(model);
+            }
+            if let Some(pool_size) = whisper.pool_size
+                && pool_size > 0
+            {
+                self.whisper_pool_size = pool_size;
+            }
+            if let Some(threads) = whisper.threads_per_job {
+                self.whisper_threads_per_job = threads;
+            }
         }
         if let Some(server) = incoming.server {
             if let Some(host) = server.host
@@ -234,6 +322,9 @@ impl Settings {
             {
                 self.server_tmp_dir = Some(tmp_dir);
             }
+            if let Some(size) = server.max_upload_mb {
+                self.server_max_upload_mb = size;
+            }
         }
         if let Some(client) = incoming.client {
             if let Some(host) = client.host
@@ -247,6 +338,52 @@ impl Settings {
                 self.client_port = port;
             }
         }
+        if let Some(http) = incoming.http {
+            if let Some(size) = http.pool_max_idle_per_host {
+                self.http_pool_max_idle_per_host = size;
+            }
+            if let Some(secs) = http.pool_idle_timeout_secs {
+                self.http_pool_idle_timeout_secs = secs;
+            }
+            if let Some(secs) = http.connect_timeout_secs
+                && secs > 0
+            {
+                self.http_connect_timeout_secs = secs;
+            }
+            if let Some(secs) = http.read_timeout_secs {
+                self.http_read_timeout_secs = secs;
+            }
+            if let Some(secs) = http.tcp_keepalive_secs {
+                self.http_tcp_keepalive_secs = secs;
+            }
+        }
+        if let Some(rate_limit) = incoming.rate_limit {
+            if let Some(concurrency) = rate_limit.max_concurrency
+                && concurrency > 0
+            {
+                self.rate_limit_max_concurrency = concurrency;
+            }
+            if let Some(requests) = rate_limit.requests_per_minute {
+                self.rate_limit_requests_per_minute = requests;
+            }
+            if let Some(tokens) = rate_limit.tokens_per_minute {
+                self.rate_limit_tokens_per_minute = tokens;
+            }
+        }
+        if let Some(memory) = incoming.memory {
+            if let Some(enabled) = memory.enabled {
+                self.translation_memory_enabled = enabled;
+            }
+            if let Some(size) = memory.max_size_mb {
+                self.translation_memory_max_mb = size;
+            }
+            if let Some(entries) = memory.response_cache_entries {
+                self.response_cache_entries = entries;
+            }
+            if let Some(ttl) = memory.response_cache_ttl_secs {
+                self.response_cache_ttl_secs = ttl;
+            }
+        }
     }
 }
 
@@ -285,4 +422,25 @@ histories = 42
             assert_eq!(settings.history_limit, 42);
         });
     }
+
+    #[test]
+    fn settings_override_http_pool() {
+        with_temp_home(|home| {
+            let custom_path = home.join("override.toml");
+            let content = r#"
+[http]
+pool_max_idle_per_host = 4
+connect_timeout_secs = 3
+read_timeout_secs = 0
+"#;
+            fs::write(&custom_path, content).expect("write settings");
+
+            let settings = load_settings(Some(&custom_path)).expect("load settings");
+            assert_eq!(settings.http_pool_max_idle_per_host, 4);
+            assert_eq!(settings.http_connect_timeout_secs, 3);
+            assert_eq!(settings.http_read_timeout_secs, 0);
+            assert_eq!(settings.http_pool_idle_timeout_secs, 90);
+            assert!(settings.translation_memory_enabled);
+        });
+    }
 }
@@ -0,0 +1,277 @@
+use std::ops::Range;
+
+/// Source text carried from the previous chunk as context, in estimated tokens.
+const CONTEXT_TOKENS: usize = 150;
+
+/// A piece of the input translated on its own. `range` indexes the original text; the text
+/// between consecutive ranges (blank lines, line breaks) is copied through untouched.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub(crate) struct Chunk {
+    pub(crate) range: Range<usize>,
+    /// Tail of the previous chunk's source, given to the model for consistency only.
+    pub(crate) context: Option<Range<usize>>,
+}
+
+/// Rough token count: about four ASCII bytes per token, one per other character (CJK text
+/// is close to one token per character, which makes this conservative elsewhere).
+pub(crate) fn estimate_tokens(text: &str) -> usize {
+    let ascii = text.bytes().filter(u8::is_ascii).count();
+    let other = text.chars().filter(|ch| !ch.is_ascii()).count();
+    ascii.div_ceil(4) + other
+}
+
+/// Splits `text` into chunks of at most `max_tokens` (estimated), breaking at blank lines
+/// and before Markdown headings, never inside a fenced code block unless the block alone is
+/// over budget. Blocks still over budget are split at line breaks, then at characters.
+pub(crate) fn split_chunks(text: &str, max_tokens: usize) -> Vec<Chunk> {
+    let max_tokens = max_tokens.max(1);
+    let mut ranges: Vec<Range<usize>> = Vec::new();
+    let mut current: Option<(Range<usize>, usize)> = None;
+    for block in blocks(text) {
+        let tokens = estimate_tokens(&text[block.range.clone()]);
+        if let Some((range, used)) = current.as_mut() {
+            let over_budget = *used + tokens > max_tokens;
+            // Prefer starting a fresh chunk at a heading once this one is reasonably full.
+            let section_break = block.heading && *used * 2 >= max_tokens;
+            if !over_budget && !section_break {
+                range.end = block.range.end;
+                *used += tokens;
+                continue;
+            }
+            ranges.push(range.clone());
+            current = None;
+        }
+        if tokens > max_tokens {
+            ranges.extend(split_oversized(text, block.range, max_tokens));
+        } else {
+            current = Some((block.range, tokens));
+        }
+    }
+    if let Some((range, _)) = current {
+        ranges.push(range);
+    }
+
+    let mut chunks = Vec::with_capacity(ranges.len());
+    for (index, range) in ranges.iter().enumerate() {
+        let context = index
+            .checked_sub(1)
+            .map(|previous| context_tail(text, ranges[previous].clone()))
+            .filter(|context| !context.is_empty());
+        chunks.push(Chunk {
+            range: range.clone(),
+            context,
+        });
+    }
+    chunks
+}
+
+/// Rebuilds the document from translated chunks, keeping the original separators.
+pub(crate) fn stitch(text: &str, chunks: &[Chunk], translated: &[String]) -> String {
+    let mut out = String::with_capacity(text.len());
+    let mut cursor = 0;
+    for (chunk, translation) in chunks.iter().zip(translated) {
+        out.push_str(&text[cursor..chunk.range.start]);
+        out.push_str(translation.trim_matches('\n'));
+        cursor = chunk.range.end;
+    }
+    out.push_str(&text[cursor..]);
+    out
+}
+
+struct Block {
+    range: Range<usize>,
+    heading: bool,
+}
+
+/// Runs of non-blank lines; a fenced code block is kept whole even across blank lines.
+fn blocks(text: &str) -> Vec<Block> {
+    let mut blocks = Vec::new();
+    let mut current: Option<Block> = None;
+    let mut fence: Option<&str> = None;
+    let mut offset = 0;
+    for line in text.split_inclusive('\n') {
+        let start = offset;
+        offset += line.len();
+        let content = line.trim_end_matches(['\n', '\r']);
+        let end = start + content.len();
+        let trimmed = content.trim_start();
+
+        if let Some(marker) = fence {
+            if trimmed.starts_with(marker) {
+                fence = None;
+            }
+            if let Some(block) = current.as_mut() {
+                block.range.end = end;
+            }
+            continue;
+        }
+        if trimmed.is_empty() {
+            blocks.extend(current.take());
+            continue;
+        }
+        let heading = trimmed.starts_with('#');
+        if heading {
+            blocks.extend(current.take());
+        }
+        if trimmed.starts_with("```") || trimmed.starts_with("~~~") {
+            fence = Some(&trimmed[..3]);
+        }
+        match current.as_mut() {
+            Some(block) => block.range.end = end,
+            None => {
+                current = Some(Block {
+                    range: start..end,
+                    heading,
+                })
+            }
+        }
+    }
+    blocks.extend(current);
+    blocks
+}
+
+fn split_oversized(text: &str, range: Range<usize>, max_tokens: usize) -> Vec<Range<usize>> {
+    let mut pieces = Vec::new();
+    let mut current: Option<(Range<usize>, usize)> = None;
+    let mut offset = range.start;
+    for line in text[range.clone()].split_inclusive('\n') {
+        let start = offset;
+        offset += line.len();
+        let end = start + line.trim_end_matches(['\n', '\r']).len();
+        let tokens = estimate_tokens(&text[start..end]);
+        if let Some((piece, used)) = current.as_mut() {
+            if *used + tokens <= max_tokens {
+                piece.end = end;
+                *used += tokens;
+                continue;
+            }
+            pieces.push(piece.clone());
+            current = None;
+        }
+        if tokens > max_tokens {
+            pieces.extend(split_line(text, start..end, max_tokens));
+        } else {
+            current = Some((start..end, tokens));
+        }
+    }
+    pieces.extend(current.map(|(piece, _)| piece));
+    pieces
+}
+
+/// Splits one long line after the last space or CJK sentence end that fits, else at the last
+/// character that fits. Spaces at split points stay between the pieces.
+fn split_line(text: &str, range: Range<usize>, max_tokens: usize) -> Vec<Range<usize>> {
+    // Budget in quarter tokens, matching `estimate_tokens`.
+    let budget = max_tokens * 4;
+    let mut pieces = Vec::new();
+    let mut start = range.start;
+    let mut used = 0;
+    let mut soft: Option<(usize, usize)> = None;
+    for (index, ch) in text[range.clone()].char_indices() {
+        let at = range.start + index;
+        if used + quarter_tokens(ch) > budget && at > start {
+            let (end, next) = soft.unwrap_or((at, at));
+            pieces.push(start..end);
+            start = next;
+            used = text[start..at].chars().map(quarter_tokens).sum();
+            soft = None;
+        }
+        used += quarter_tokens(ch);
+        if ch == ' ' && at > start {
+            soft = Some((at, at + 1));
+        } else if matches!(ch, '。' | '！' | '？') {
+            soft = Some((at + ch.len_utf8(), at + ch.len_utf8()));
+        }
+    }
+    if start < range.end {
+        pieces.push(start..range.end);
+    }
+    pieces
+}
+
+fn quarter_tokens(ch: char) -> usize {
+    if ch.is_ascii() { 1 } else { 4 }
+}
+
+/// The last lines of `range` that fit in `CONTEXT_TOKENS`, or its last characters when even
+/// the final line is longer.
+fn context_tail(text: &str, range: Range<usize>) -> Range<usize> {
+    let body = &text[range.clone()];
+    let mut start = body.len();
+    if estimate_tokens(body) <= CONTEXT_TOKENS {
+        start = 0;
+    } else {
+        for (index, _) in body.rmatch_indices('\n') {
+            if estimate_tokens(&body[index + 1..]) > CONTEXT_TOKENS {
+                break;
+            }
+            start = index + 1;
+        }
+    }
+    if start == body.len() {
+        start = body
+            .char_indices()
+            .rev()
+            .take(CONTEXT_TOKENS * 2)
+            .last()
+            .map(|(index, _)| index)
+            .unwrap_or(0);
+    }
+    let tail = &body[start..];
+    let start = range.start + start + tail.len() - tail.trim_start().len();
+    start..range.end
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn chunk_texts<'a>(text: &'a str, chunks: &[Chunk]) -> Vec<&'a str> {
+        chunks
+            .iter()
+            .map(|chunk| &text[chunk.range.clone()])
+            .collect()
+    }
+
+    #[test]
+    fn splits_at_paragraphs_and_headings_and_keeps_fences_whole() {
+        let text = "# Intro\n\nalpha beta gamma delta\n\nsecond paragraph here\n\
+                    \n```\ncode one\n\ncode two\n```\n# Next\nclosing words\n";
+        let chunks = split_chunks(text, 12);
+        assert_eq!(
+            chunk_texts(text, &chunks),
+            vec![
+                "# Intro\n\nalpha beta gamma delta",
+                "second paragraph here",
+                "```\ncode one\n\ncode two\n```",
+                "# Next\nclosing words",
+            ]
+        );
+        assert_eq!(chunks[0].context, None);
+        assert_eq!(
+            chunks[1].context.clone().map(|range| &text[range]),
+            Some("# Intro\n\nalpha beta gamma delta")
+        );
+
+        let translated = chunks
+            .iter()
+            .map(|chunk| text[chunk.range.clone()].to_uppercase())
+            .collect::<Vec<_>>();
+        assert_eq!(stitch(text, &chunks, &translated), text.to_uppercase());
+    }
+
+    #[test]
+    fn oversized_blocks_fall_back_to_lines_and_characters() {
+        let text = format!("{}\n{}", "word ".repeat(30).trim_end(), "字".repeat(25));
+        let chunks = split_chunks(&text, 10);
+        assert!(chunks.len() > 3);
+        for chunk in &chunks {
+            assert!(estimate_tokens(&text[chunk.range.clone()]) <= 10);
+        }
+        let translated = chunks
+            .iter()
+            .map(|chunk| text[chunk.range.clone()].to_string())
+            .collect::<Vec<_>>();
+        assert_eq!(stitch(&text, &chunks, &translated), text);
+    }
+}
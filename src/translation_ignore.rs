@@ -6,6 +6,7 @@ use std::path::{Path, PathBuf};
 pub(crate) struct TranslationIgnore {
     root: PathBuf,
     patterns: Vec<IgnorePattern>,
+    digest: String,
 }
 
 #[derive(Clone)]
@@ -19,8 +20,8 @@ struct IgnorePattern {
 impl TranslationIgnore {
     pub(crate) fn new(root: &Path, patterns: Vec<String>) -> Result<Option<Self>> {
         let mut compiled = Vec::new();
-        for raw in patterns {
-            if let Some(pattern) = parse_pattern(&raw)? {
+        for raw in &patterns {
+            if let Some(pattern) = parse_pattern(raw)? {
                 compiled.push(pattern);
             }
         }
@@ -30,9 +31,16 @@ impl TranslationIgnore {
         Ok(Some(Self {
             root: root.to_path_buf(),
             patterns: compiled,
+            digest: format!("{:x}", md5::compute(patterns.join("\n").as_bytes())),
         }))
     }
 
+    /// Digest of the raw rules (ignore file lines and CLI patterns), so directory runs can
+    /// tell when the rules changed.
+    pub(crate) fn digest(&self) -> &str {
+        &self.digest
+    }
+
     pub(crate) fn is_ignored(&self, path: &Path) -> bool {
         let rel = path.strip_prefix(&self.root).unwrap_or(path);
         let rel_str = normalize_path(rel);
@@ -0,0 +1,581 @@
+use anyhow::{Context, Result};
+use serde::{Deserialize, Serialize};
+use std::collections::{HashMap, HashSet};
+use std::fs::{self, File, OpenOptions};
+use std::io::{BufRead, BufReader, Read, Seek, SeekFrom, Write};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::{SystemTime, UNIX_EPOCH};
+use tracing::warn;
+
+use crate::paths;
+use crate::settings::Settings;
+use crate::translations::TranslateOptions;
+use crate::util::lock;
+
+const FILE_NAME: &str = "memory.jsonl";
+const LOCK_NAME: &str = "memory.lock";
+/// Hits only re-stamp an entry on disk once per interval, to keep the log from growing on reads.
+const TOUCH_INTERVAL_SECS: u64 = 60 * 60;
+/// A compaction lock older than this is assumed to belong to a crashed process.
+const STALE_LOCK_SECS: u64 = 60;
+
+static MEMORY: Mutex<Option<Arc<TranslationMemory>>> = Mutex::new(None);
+static HITS: AtomicU64 = AtomicU64::new(0);
+static MISSES: AtomicU64 = AtomicU64::new(0);
+
+/// Process-wide translation memory lookups since start-up.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct MemoryStats {
+    pub hits: u64,
+    pub misses: u64,
+}
+
+pub fn stats() -> MemoryStats {
+    MemoryStats {
+        hits: HITS.load(Ordering::Relaxed),
+        misses: MISSES.load(Ordering::Relaxed),
+    }
+}
+
+/// Builds the memory key for a plain-text translation of `text` under the rendered
+/// `system_prompt`, so edited or reloaded prompts do not reuse old translations.
+pub(crate) fn key(
+    model: &str,
+    options: &TranslateOptions,
+    system_prompt: &str,
+    text: &str,
+) -> String {
+    let slang = if options.slang { "slang" } else { "plain" };
+    let prompt = format!("{:x}", md5::compute(system_prompt.as_bytes()));
+    let input = [
+        model.trim(),
+        options.source_lang.trim(),
+        options.lang.trim(),
+        options.formality.trim(),
+        slang,
+        &prompt,
+        text,
+    ]
+    .join("\u{0}");
+    format!("{:x}", md5::compute(input.as_bytes()))
+}
+
+/// Points the process-wide memory at the current data directory and size cap.
+pub(crate) fn configure(settings: &Settings) {
+    let dir = paths::translation_memory_dir();
+    let max_bytes = settings
+        .translation_memory_max_mb
+        .saturating_mul(1024 * 1024);
+    let mut guard = lock(&MEMORY);
+    if guard
+        .as_ref()
+        .is_some_and(|memory| memory.dir == dir && memory.max_bytes == max_bytes)
+    {
+        return;
+    }
+    *guard = Some(Arc::new(TranslationMemory::new(dir, max_bytes)));
+}
+
+fn current() -> Option<Arc<TranslationMemory>> {
+    lock(&MEMORY).clone()
+}
+
+/// Looks `key` up in memory. On a miss the log is re-read on a blocking worker, and only
+/// when its size or modification time changed since the last look.
+pub(crate) async fn lookup(key: &str) -> Option<String> {
+    let memory = current()?;
+    let now = now_secs();
+    let mut found = memory.get(key, now);
+    if found.is_none() {
+        let reader = memory.clone();
+        match tokio::task::spawn_blocking(move || reader.refresh()).await {
+            Ok(Ok(())) => found = memory.get(key, now),
+            Ok(Err(err)) => warn!("failed to read translation memory: {}", err),
+            Err(err) => warn!("translation memory reader failed: {}", err),
+        }
+    }
+    let counter = if found.is_some() { &HITS } else { &MISSES };
+    counter.fetch_add(1, Ordering::Relaxed);
+    let (value, touch) = found?;
+    if let Some(touch) = touch {
+        write_behind(memory, touch);
+    }
+    Some(value)
+}
+
+/// Visible to lookups right away; the append happens on a blocking worker.
+pub(crate) fn store(key: &str, value: &str) {
+    let Some(memory) = current() else {
+        return;
+    };
+    if let Some(line) = memory.insert(key, value, now_secs()) {
+        write_behind(memory, line);
+    }
+}
+
+/// Appends `line` off the async workers. Without a runtime (tests, plain threads) it is
+/// written right away.
+fn write_behind(memory: Arc<TranslationMemory>, line: Line) {
+    let write = move || {
+        if let Err(err) = memory.append(&line) {
+            warn!("failed to update translation memory: {}", err);
+        }
+    };
+    match tokio::runtime::Handle::try_current() {
+        Ok(handle) => {
+            handle.spawn_blocking(write);
+        }
+        Err(_) => write(),
+    }
+}
+
+/// One line of `memory.jsonl`: a generation header, an entry (`v` set) or a touch (`v` unset).
+#[derive(Debug, Default, Serialize, Deserialize)]
+struct Line {
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    generation: Option<String>,
+    #[serde(rename = "k", default, skip_serializing_if = "Option::is_none")]
+    key: Option<String>,
+    #[serde(rename = "t", default, skip_serializing_if = "is_zero")]
+    used: u64,
+    #[serde(rename = "v", default, skip_serializing_if = "Option::is_none")]
+    value: Option<String>,
+}
+
+fn is_zero(value: &u64) -> bool {
+    *value == 0
+}
+
+#[derive(Debug, Clone)]
+struct Entry {
+    value: String,
+    used: u64,
+}
+
+/// Append-only key/value log shared by every process using the same data directory.
+///
+/// Writers append whole lines with `O_APPEND`, so concurrent appends never interleave; readers
+/// replay only the bytes appended since their last look and ignore a trailing partial line.
+/// When the log outgrows `max_bytes`, one process (holding `memory.lock`) rewrites it with the
+/// most recently used entries under a new generation header and renames it into place; other
+/// processes notice the new generation and reload. Appends that race a compaction can be lost,
+/// which only costs a future cache miss.
+///
+/// `entries` is only locked for map operations. File I/O happens under `log`, on blocking
+/// workers, so lookups of entries already in memory never wait for the disk.
+#[derive(Debug)]
+struct TranslationMemory {
+    dir: PathBuf,
+    max_bytes: u64,
+    entries: Mutex<HashMap<String, Entry>>,
+    log: Mutex<LogState>,
+}
+
+#[derive(Debug, Default)]
+struct LogState {
+    generation: Option<String>,
+    offset: u64,
+    file_len: u64,
+    /// Size and modification time seen by the last refresh; an unchanged file is not read.
+    seen: Option<(u64, SystemTime)>,
+}
+
+impl TranslationMemory {
+    fn new(dir: PathBuf, max_bytes: u64) -> Self {
+        Self {
+            dir,
+            max_bytes,
+            entries: Mutex::new(HashMap::new()),
+            log: Mutex::new(LogState::default()),
+        }
+    }
+
+    fn path(&self) -> PathBuf {
+        self.dir.join(FILE_NAME)
+    }
+
+    /// The value for `key` if it is in memory, with a touch line to append when the entry
+    /// has not been stamped for a while.
+    fn get(&self, key: &str, now: u64) -> Option<(String, Option<Line>)> {
+        let mut entries = lock(&self.entries);
+        let entry = entries.get_mut(key)?;
+        let value = entry.value.clone();
+        if now.saturating_sub(entry.used) < TOUCH_INTERVAL_SECS {
+            return Some((value, None));
+        }
+        entry.used = now;
+        let touch = Line {
+            key: Some(key.to_string()),
+            used: now,
+            ..Line::default()
+        };
+        Some((value, Some(touch)))
+    }
+
+    /// Records `value` in memory and returns the line to append, or `None` if it is already
+    /// stored.
+    fn insert(&self, key: &str, value: &str, now: u64) -> Option<Line> {
+        let mut entries = lock(&self.entries);
+        if entries.get(key).is_some_and(|entry| entry.value == value) {
+            return None;
+        }
+        entries.insert(
+            key.to_string(),
+            Entry {
+                value: value.to_string(),
+                used: now,
+            },
+        );
+        Some(Line {
+            key: Some(key.to_string()),
+            used: now,
+            value: Some(value.to_string()),
+            ..Line::default()
+        })
+    }
+
+    /// Replays whatever other processes appended since the last call.
+    fn refresh(&self) -> Result<()> {
+        self.refresh_locked(&mut lock(&self.log))
+    }
+
+    fn refresh_locked(&self, log: &mut LogState) -> Result<()> {
+        let path = self.path();
+        let file = match File::open(&path) {
+            Ok(file) => file,
+            Err(err) if err.kind() == std::io::ErrorKind::NotFound => {
+                if log.generation.is_some() || log.offset > 0 {
+                    *log = LogState::default();
+                    lock(&self.entries).clear();
+                }
+                return Ok(());
+            }
+            Err(err) => {
+                return Err(err)
+                    .with_context(|| format!("failed to open {}", path.to_string_lossy()));
+            }
+        };
+        let metadata = file
+            .metadata()
+            .with_context(|| "failed to stat translation memory")?;
+        let len = metadata.len();
+        let seen = metadata.modified().ok().map(|modified| (len, modified));
+        if seen.is_some() && seen == log.seen {
+            return Ok(());
+        }
+        let mut reader = BufReader::new(file);
+        let mut first = String::new();
+        reader
+            .read_line(&mut first)
+            .with_context(|| "failed to read translation memory")?;
+        let generation = serde_json::from_str::<Line>(&first)
+            .ok()
+            .and_then(|line| line.generation);
+        let reload = generation != log.generation || len < log.offset;
+        if reload {
+            log.generation = generation;
+            log.offset = 0;
+        }
+        log.file_len = len;
+        let mut lines = Vec::new();
+        if len > log.offset {
+            reader
+                .seek(SeekFrom::Start(log.offset))
+                .with_context(|| "failed to seek translation memory")?;
+            let mut tail = Vec::new();
+            reader
+                .take(len - log.offset)
+                .read_to_end(&mut tail)
+                .with_context(|| "failed to read translation memory")?;
+            if let Some(end) = tail.iter().rposition(|byte| *byte == b'\n') {
+                lines = tail[..end]
+                    .split(|byte| *byte == b'\n')
+                    .filter_map(|raw| serde_json::from_slice::<Line>(raw).ok())
+                    .collect();
+                log.offset += end as u64 + 1;
+            }
+        }
+        // A trailing partial line is read again next time, so the file counts as unseen.
+        log.seen = seen.filter(|_| log.offset == len);
+
+        let mut entries = lock(&self.entries);
+        if reload {
+            entries.clear();
+        }
+        for line in lines {
+            apply(&mut entries, line);
+        }
+        Ok(())
+    }
+
+    fn append(&self, line: &Line) -> Result<()> {
+        fs::create_dir_all(&self.dir)
+            .with_context(|| "failed to create translation memory directory")?;
+        let path = self.path();
+        let mut log = lock(&self.log);
+        if !path.exists() {
+            self.create(&path, &mut log)?;
+        }
+        let mut bytes = serde_json::to_vec(line)?;
+        bytes.push(b'\n');
+        let mut file = OpenOptions::new()
+            .append(true)
+            .open(&path)
+            .with_context(|| format!("failed to open {}", path.to_string_lossy()))?;
+        file.write_all(&bytes)
+            .with_context(|| "failed to append translation memory")?;
+        log.file_len += bytes.len() as u64;
+        if self.max_bytes > 0 && log.file_len > self.max_bytes {
+            self.compact(&mut log)?;
+        }
+        Ok(())
+    }
+
+    fn create(&self, path: &Path, log: &mut LogState) -> Result<()> {
+        let generation = new_generation();
+        let mut header = serde_json::to_vec(&Line {
+            generation: Some(generation.clone()),
+            ..Line::default()
+        })?;
+        header.push(b'\n');
+        let mut file = match OpenOptions::new().append(true).create_new(true).open(path) {
+            Ok(file) => file,
+            // Another process created it first; its header wins on the next refresh.
+            Err(err) if err.kind() == std::io::ErrorKind::AlreadyExists => return Ok(()),
+            Err(err) => {
+                return Err(err)
+                    .with_context(|| format!("failed to create {}", path.to_string_lossy()));
+            }
+        };
+        file.write_all(&header)
+            .with_context(|| "failed to write translation memory header")?;
+        log.generation = Some(generation);
+        log.offset = header.len() as u64;
+        log.file_len = log.offset;
+        log.seen = None;
+        Ok(())
+    }
+
+    /// Rewrites the log with the most recently used entries, down to 90% of `max_bytes`.
+    fn compact(&self, log: &mut LogState) -> Result<()> {
+        let Some(_lock) = CompactionLock::acquire(&self.dir.join(LOCK_NAME)) else {
+            return Ok(());
+        };
+        self.refresh_locked(log)?;
+
+        let snapshot = {
+            let mut ranked = lock(&self.entries)
+                .iter()
+                .map(|(key, entry)| (key.clone(), entry.clone()))
+                .collect::<Vec<_>>();
+            ranked.sort_by(|a, b| b.1.used.cmp(&a.1.used));
+            ranked
+        };
+
+        let generation = new_generation();
+        let mut out = serde_json::to_vec(&Line {
+            generation: Some(generation.clone()),
+            ..Line::default()
+        })?;
+        out.push(b'\n');
+        let budget = self.max_bytes / 10 * 9;
+        let mut dropped = HashSet::new();
+        for (key, entry) in snapshot {
+            let mut line = serde_json::to_vec(&Line {
+                key: Some(key.clone()),
+                used: entry.used,
+                value: Some(entry.value),
+                ..Line::default()
+            })?;
+            line.push(b'\n');
+            if !dropped.is_empty() || (out.len() + line.len()) as u64 > budget {
+                dropped.insert(key);
+                continue;
+            }
+            out.extend_from_slice(&line);
+        }
+
+        let tmp = self
+            .dir
+            .join(format!("{}.{}.tmp", FILE_NAME, std::process::id()));
+        fs::write(&tmp, &out).with_context(|| "failed to write translation memory")?;
+        fs::rename(&tmp, self.path()).with_context(|| "failed to replace translation memory")?;
+        // Entries stored since the snapshot are kept; their lines go to the new file.
+        lock(&self.entries).retain(|key, _| !dropped.contains(key));
+        log.generation = Some(generation);
+        log.offset = out.len() as u64;
+        log.file_len = log.offset;
+        log.seen = None;
+        Ok(())
+    }
+
+    /// Synchronous lookup for tests: memory first, then the log.
+    #[cfg(test)]
+    fn lookup_now(&self, key: &str, now: u64) -> Option<String> {
+        if self.get(key, now).is_none() {
+            self.refresh().expect("refresh");
+        }
+        let (value, touch) = self.get(key, now)?;
+        if let Some(touch) = touch {
+            self.append(&touch).expect("touch");
+        }
+        Some(value)
+    }
+
+    #[cfg(test)]
+    fn store_now(&self, key: &str, value: &str, now: u64) -> Result<()> {
+        match self.insert(key, value, now) {
+            Some(line) => self.append(&line),
+            None => Ok(()),
+        }
+    }
+}
+
+fn apply(entries: &mut HashMap<String, Entry>, line: Line) {
+    let Some(key) = line.key else {
+        return;
+    };
+    match line.value {
+        Some(value) => {
+            entries.insert(
+                key,
+                Entry {
+                    value,
+                    used: line.used,
+                },
+            );
+        }
+        None => {
+            if let Some(entry) = entries.get_mut(&key) {
+                entry.used = entry.used.max(line.used);
+            }
+        }
+    }
+}
+
+struct CompactionLock {
+    path: PathBuf,
+}
+
+impl CompactionLock {
+    fn acquire(path: &Path) -> Option<Self> {
+        for _ in 0..2 {
+            match OpenOptions::new().write(true).create_new(true).open(path) {
+                Ok(_) => {
+                    return Some(Self {
+                        path: path.to_path_buf(),
+                    });
+                }
+                Err(err) if err.kind() == std::io::ErrorKind::AlreadyExists => {
+                    let stale = fs::metadata(path)
+                        .and_then(|meta| meta.modified())
+                        .ok()
+                        .and_then(|modified| modified.elapsed().ok())
+                        .is_some_and(|age| age.as_secs() >= STALE_LOCK_SECS);
+                    if !stale || fs::remove_file(path).is_err() {
+                        return None;
+                    }
+                }
+                Err(_) => return None,
+            }
+        }
+        None
+    }
+}
+
+impl Drop for CompactionLock {
+    fn drop(&mut self) {
+        let _ = fs::remove_file(&self.path);
+    }
+}
+
+fn new_generation() -> String {
+    let nanos = SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .unwrap_or_default()
+        .as_nanos();
+    format!("{}-{}", nanos, std::process::id())
+}
+
+fn now_secs() -> u64 {
+    SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .unwrap_or_default()
+        .as_secs()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn entries_are_visible_to_other_readers() {
+        let dir = tempfile::tempdir().expect("tempdir");
+        let writer = TranslationMemory::new(dir.path().to_path_buf(), 0);
+        let reader = TranslationMemory::new(dir.path().to_path_buf(), 0);
+
+        assert_eq!(reader.lookup_now("a", 1), None);
+        writer.store_now("a", "first", 1).expect("store");
+        assert_eq!(reader.lookup_now("a", 1).as_deref(), Some("first"));
+
+        writer.store_now("a", "second", 2).expect("store");
+        writer.store_now("b", "other", 2).expect("store");
+        assert_eq!(reader.lookup_now("b", 2).as_deref(), Some("other"));
+        assert_eq!(reader.lookup_now("a", 2).as_deref(), Some("second"));
+    }
+
+    #[test]
+    fn compaction_evicts_least_recently_used() {
+        let dir = tempfile::tempdir().expect("tempdir");
+        let value = "x".repeat(250);
+        let memory = TranslationMemory::new(dir.path().to_path_buf(), 1000);
+        memory.store_now("a", &value, 1).expect("store");
+        memory.store_now("b", &value, 2).expect("store");
+        assert!(memory.lookup_now("a", 5000).is_some());
+        memory.store_now("c", &value, 5001).expect("store");
+        memory.store_now("d", &value, 5002).expect("store");
+
+        assert!(lock(&memory.log).file_len <= 1000);
+        let reader = TranslationMemory::new(dir.path().to_path_buf(), 1000);
+        assert!(reader.lookup_now("b", 5003).is_none());
+        for key in ["a", "c", "d"] {
+            assert!(reader.lookup_now(key, 5003).is_some(), "missing {}", key);
+        }
+    }
+
+    #[test]
+    fn unchanged_log_is_not_reread() {
+        let dir = tempfile::tempdir().expect("tempdir");
+        let writer = TranslationMemory::new(dir.path().to_path_buf(), 0);
+        let reader = TranslationMemory::new(dir.path().to_path_buf(), 0);
+        writer.store_now("a", "first", 1).expect("store");
+        assert!(reader.lookup_now("a", 1).is_some());
+
+        lock(&reader.entries).clear();
+        reader.refresh().expect("refresh");
+        assert!(lock(&reader.entries).is_empty());
+        writer.store_now("b", "second", 2).expect("store");
+        assert_eq!(reader.lookup_now("b", 2).as_deref(), Some("second"));
+    }
+
+    #[test]
+    fn key_depends_on_style_model_and_prompt() {
+        let options = TranslateOptions {
+            lang: "ja".to_string(),
+            formality: "formal".to_string(),
+            source_lang: "en".to_string(),
+            slang: false,
+        };
+        let base = key("gpt-4o", &options, "prompt", "Hello");
+        assert_eq!(base, key("gpt-4o", &options, "prompt", "Hello"));
+        assert_ne!(base, key("gpt-4o-mini", &options, "prompt", "Hello"));
+        let slang = TranslateOptions {
+            slang: true,
+            ..options.clone()
+        };
+        assert_ne!(base, key("gpt-4o", &slang, "prompt", "Hello"));
+        assert_ne!(base, key("gpt-4o", &options, "edited prompt", "Hello"));
+    }
+}
@@ -1,15 +1,20 @@
 use anyhow::{Context, Result, anyhow};
 use serde::{Deserialize, Serialize};
 use serde_json::{Value, json};
-use std::fs;
-use std::path::PathBuf;
-use tera::{Context as TeraContext, Tera};
+use tera::Context as TeraContext;
 
 use crate::data::DataInfo;
 use crate::languages::{LanguagePack, LanguageRegistry};
 use crate::providers::ToolSpec;
 use crate::settings::Settings;
 
+mod prompt_registry;
+mod stream;
+
+pub use prompt_registry::reload_prompts;
+pub(crate) use prompt_registry::render_prompt;
+pub use stream::TranslationStreamParser;
+
 pub const TOOL_NAME: &str = "deliver_translation";
 pub const MIME_TOOL_NAME: &str = "detect_mime";
 
@@ -36,6 +41,12 @@ pub struct Segment {
     pub bbox: BBox,
 }
 
+#[derive(Debug, Clone, Deserialize, Serialize)]
+pub struct BatchItem {
+    pub id: usize,
+    pub translated: String,
+}
+
 #[derive(Debug, Clone, Deserialize, Serialize)]
 pub struct BBox {
     pub x: f64,
@@ -85,6 +96,39 @@ pub fn tool_spec(tool_name: &str) -> ToolSpec {
     }
 }
 
+pub fn batch_tool_spec(tool_name: &str) -> ToolSpec {
+    let mut spec = tool_spec(tool_name);
+    spec.description = "Return one translation per input item with metadata.".to_string();
+    if let Some(properties) = spec
+        .parameters
+        .get_mut("properties")
+        .and_then(Value::as_object_mut)
+    {
+        properties.insert(
+            "items".to_string(),
+            json!({
+                "type": "array",
+                "items": {
+                    "type": "object",
+                    "properties": {
+                        "id": {"type": "integer"},
+                        "translated": {"type": "string"}
+                    },
+                    "required": ["id", "translated"]
+                }
+            }),
+        );
+    }
+    if let Some(required) = spec
+        .parameters
+        .get_mut("required")
+        .and_then(Value::as_array_mut)
+    {
+        required.push(json!("items"));
+    }
+    spec
+}
+
 pub fn mime_tool_spec(tool_name: &str) -> ToolSpec {
     let base = json!({
         "type": "object",
@@ -115,7 +159,36 @@ pub fn render_system_prompt_with_data(
     settings: &Settings,
     data: Option<&DataInfo>,
 ) -> Result<String> {
-    let template = load_prompt_template("system_prompt.tera")?;
+    render_translation_prompt(options, tool_name, settings, data, false, None)
+}
+
+/// System prompt for one part of a long text split by the translator; `preceding` is the
+/// source text just before this part, passed for consistency but not translated.
+pub fn render_chunk_system_prompt(
+    options: &TranslateOptions,
+    tool_name: &str,
+    settings: &Settings,
+    preceding: &str,
+) -> Result<String> {
+    render_translation_prompt(options, tool_name, settings, None, false, Some(preceding))
+}
+
+pub fn render_batch_system_prompt(
+    options: &TranslateOptions,
+    tool_name: &str,
+    settings: &Settings,
+) -> Result<String> {
+    render_translation_prompt(options, tool_name, settings, None, true, None)
+}
+
+fn render_translation_prompt(
+    options: &TranslateOptions,
+    tool_name: &str,
+    settings: &Settings,
+    data: Option<&DataInfo>,
+    batch: bool,
+    chunk_context: Option<&str>,
+) -> Result<String> {
     let mut context = TeraContext::new();
     let style = options.formality.trim();
     context.insert("source_lang", options.source_lang.as_str());
@@ -126,12 +199,14 @@ pub fn render_system_prompt_with_data(
     context.insert("slang", &options.slang);
     context.insert("tool_name", tool_name);
     context.insert("has_data", &data.is_some());
+    context.insert("batch", &batch);
+    context.insert("chunk_context", chunk_context.unwrap_or(""));
     if let Some(data) = data {
         context.insert("data_mime", data.mime.as_str());
         context.insert("data_name", &data.name);
     }
 
-    Tera::one_off(&template, &context, false).with_context(|| "failed to render system prompt")
+    render_prompt("system_prompt.tera", &context).with_context(|| "failed to render system prompt")
 }
 
 pub fn render_ocr_normalize_prompt(source_lang: &str, tool_name: &str) -> Result<String> {
@@ -147,13 +222,12 @@ pub fn render_mime_prompt(
     data_name: Option<&str>,
     supported_mimes: &[&str],
 ) -> Result<String> {
-    let template = load_prompt_template("mime_prompt.tera")?;
     let mut context = TeraContext::new();
     context.insert("tool_name", tool_name);
     let mimes: Vec<&str> = supported_mimes.to_vec();
     context.insert("supported_mimes", &mimes);
     context.insert("data_name", &data_name);
-    Tera::one_off(&template, &context, false).with_context(|| "failed to render mime prompt")
+    render_prompt("mime_prompt.tera", &context).with_context(|| "failed to render mime prompt")
 }
 
 pub fn parse_tool_args(
@@ -175,34 +249,67 @@ pub fn parse_tool_args(
     })
 }
 
-fn load_prompt_template(name: &str) -> Result<String> {
-    let path = prompt_path(name)?;
-    fs::read_to_string(&path).with_context(|| format!("failed to read prompt: {}", path.display()))
+#[derive(Debug, Serialize)]
+struct BatchInput<'a> {
+    items: Vec<BatchInputItem<'a>>,
+}
+
+#[derive(Debug, Serialize)]
+struct BatchInputItem<'a> {
+    id: usize,
+    text: &'a str,
+}
+
+pub fn format_batch_input(texts: &[&str]) -> Result<String> {
+    let items = texts
+        .iter()
+        .copied()
+        .enumerate()
+        .map(|(id, text)| BatchInputItem { id, text })
+        .collect();
+    serde_json::to_string(&BatchInput { items }).with_context(|| "failed to format batch input")
+}
+
+/// Parses a batch tool call. Items with unknown ids or empty translations are dropped so
+/// the caller can retry them individually.
+pub fn parse_batch_tool_args(
+    value: Value,
+    options: &TranslateOptions,
+    registry: &LanguageRegistry,
+    expected_len: usize,
+) -> Result<Vec<BatchItem>> {
+    let expected = ExpectedMeta::from_options(options);
+    let args: ToolArgs = serde_json::from_value(value)?;
+    validate_tool_meta(&args, &expected, registry)?;
+    let mut items = args.items.unwrap_or_default();
+    if items.is_empty() && expected_len == 1 && !args.translation.trim().is_empty() {
+        items.push(BatchItem {
+            id: 0,
+            translated: args.translation,
+        });
+    }
+    items.retain(|item| item.id < expected_len && !item.translated.trim().is_empty());
+    if items.is_empty() {
+        return Err(anyhow!("batch items are empty"));
+    }
+    Ok(items)
 }
 
 fn render_simple_prompt(name: &str, source_lang: &str, tool_name: &str) -> Result<String> {
-    let template = load_prompt_template(name)?;
     let mut context = TeraContext::new();
     context.insert("source_lang", source_lang);
     context.insert("tool_name", tool_name);
-    Tera::one_off(&template, &context, false)
-        .with_context(|| format!("failed to render prompt {}", name))
-}
-
-fn prompt_path(name: &str) -> Result<PathBuf> {
-    let base = PathBuf::from(env!("CARGO_MANIFEST_DIR"))
-        .join("src")
-        .join("translations")
-        .join("prompts")
-        .join(name);
-    Ok(base)
+    render_prompt(name, &context)
 }
 
 #[derive(Debug, Deserialize)]
 struct ToolArgs {
+    #[serde(default)]
     translation: String,
     #[serde(default)]
     segments: Option<Vec<Segment>>,
+    #[serde(default)]
+    items: Option<Vec<BatchItem>>,
     source_language: String,
     target_language: String,
     style: String,
@@ -239,6 +346,31 @@ fn validate_tool_args(
     if args.translation.trim().is_empty() && !has_segments {
         return Err(anyhow!("translation is empty"));
     }
+    validate_tool_meta(args, expected, registry)?;
+
+    if image_mode && !has_segments {
+        return Err(anyhow!(
+            "image attachments require segments with bbox (got none)"
+        ));
+    }
+
+    for (idx, segment) in segments.iter().enumerate() {
+        if segment.original.trim().is_empty() {
+            return Err(anyhow!("segment {} original is empty", idx + 1));
+        }
+        if segment.translated.trim().is_empty() {
+            return Err(anyhow!("segment {} translated is empty", idx + 1));
+        }
+        validate_bbox(&segment.bbox).with_context(|| format!("segment {}", idx + 1))?;
+    }
+    Ok(())
+}
+
+fn validate_tool_meta(
+    args: &ToolArgs,
+    expected: &ExpectedMeta,
+    registry: &LanguageRegistry,
+) -> Result<()> {
     if args.source_language.trim().is_empty() {
         return Err(anyhow!("source_language is empty"));
     }
@@ -294,22 +426,6 @@ fn validate_tool_args(
             args.slang
         ));
     }
-
-    if image_mode && !has_segments {
-        return Err(anyhow!(
-            "image attachments require segments with bbox (got none)"
-        ));
-    }
-
-    for (idx, segment) in segments.iter().enumerate() {
-        if segment.original.trim().is_empty() {
-            return Err(anyhow!("segment {} original is empty", idx + 1));
-        }
-        if segment.translated.trim().is_empty() {
-            return Err(anyhow!("segment {} translated is empty", idx + 1));
-        }
-        validate_bbox(&segment.bbox).with_context(|| format!("segment {}", idx + 1))?;
-    }
     Ok(())
 }
 
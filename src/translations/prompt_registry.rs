@@ -0,0 +1,106 @@
+use anyhow::{Context, Result, anyhow};
+use std::fs;
+use std::path::PathBuf;
+use std::sync::{Arc, RwLock};
+use tera::{Context as TeraContext, Tera};
+
+static PROMPTS: RwLock<Option<Arc<Tera>>> = RwLock::new(None);
+
+/// Renders `name` from `src/translations/prompts` with the process-wide compiled templates.
+///
+/// The directory is read and parsed on first use only; call `reload_prompts` to pick up
+/// edited templates without restarting.
+pub(crate) fn render_prompt(name: &str, context: &TeraContext) -> Result<String> {
+    let tera = compiled()?;
+    crate::metrics::time(&crate::metrics::PROMPT_RENDER, &[("prompt", name)], || {
+        tera.render(name, context)
+    })
+    .with_context(|| format!("failed to render prompt {}", name))
+}
+
+/// Re-reads every prompt template from disk. The previous set stays in use if parsing fails.
+pub fn reload_prompts() -> Result<()> {
+    let tera = Arc::new(load()?);
+    *write_lock() = Some(tera);
+    Ok(())
+}
+
+fn compiled() -> Result<Arc<Tera>> {
+    if let Some(tera) = read_lock().as_ref() {
+        return Ok(tera.clone());
+    }
+    let mut guard = write_lock();
+    if let Some(tera) = guard.as_ref() {
+        return Ok(tera.clone());
+    }
+    let tera = Arc::new(load()?);
+    *guard = Some(tera.clone());
+    Ok(tera)
+}
+
+fn load() -> Result<Tera> {
+    let dir = prompts_dir();
+    let mut templates = Vec::new();
+    for entry in fs::read_dir(&dir)
+        .with_context(|| format!("failed to read prompt directory: {}", dir.display()))?
+    {
+        let path = entry?.path();
+        if path.extension().and_then(|ext| ext.to_str()) != Some("tera") {
+            continue;
+        }
+        let Some(name) = path.file_name().and_then(|name| name.to_str()) else {
+            continue;
+        };
+        let content = fs::read_to_string(&path)
+            .with_context(|| format!("failed to read prompt: {}", path.display()))?;
+        templates.push((name.to_string(), content));
+    }
+    if templates.is_empty() {
+        return Err(anyhow!("no prompt templates found in {}", dir.display()));
+    }
+    let mut tera = Tera::default();
+    tera.autoescape_on(Vec::new());
+    tera.add_raw_templates(templates)
+        .with_context(|| "failed to parse prompt templates")?;
+    Ok(tera)
+}
+
+fn prompts_dir() -> PathBuf {
+    PathBuf::from(env!("CARGO_MANIFEST_DIR"))
+        .join("src")
+        .join("translations")
+        .join("prompts")
+}
+
+fn read_lock() -> std::sync::RwLockReadGuard<'static, Option<Arc<Tera>>> {
+    match PROMPTS.read() {
+        Ok(guard) => guard,
+        Err(poisoned) => poisoned.into_inner(),
+    }
+}
+
+fn write_lock() -> std::sync::RwLockWriteGuard<'static, Option<Arc<Tera>>> {
+    match PROMPTS.write() {
+        Ok(guard) => guard,
+        Err(poisoned) => poisoned.into_inner(),
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn renders_prompts_without_escaping_and_reloads() {
+        let mut context = TeraContext::new();
+        context.insert("source_lang", "en");
+        context.insert("tool_name", "<tool>");
+        let first = render_prompt("ocr_normalize_prompt.tera", &context).expect("render");
+        assert!(first.contains("<tool>"));
+
+        reload_prompts().expect("reload");
+        let second = render_prompt("ocr_normalize_prompt.tera", &context).expect("render");
+        assert_eq!(first, second);
+        assert!(render_prompt("missing.tera", &context).is_err());
+    }
+}
@@ -0,0 +1,183 @@
+/// Incrementally extracts the `translation` string from streamed tool-argument JSON.
+///
+/// Fragments are fed in arrival order; each `push` returns the newly decoded part of the
+/// value (if any). Only the top-level `translation` key is tracked; other fields are ignored.
+#[derive(Debug, Default)]
+pub struct TranslationStreamParser {
+    raw: String,
+    state: ParserState,
+}
+
+#[derive(Debug, Default)]
+enum ParserState {
+    #[default]
+    Searching,
+    InValue(usize),
+    Done,
+}
+
+const KEY: &str = "\"translation\"";
+
+impl TranslationStreamParser {
+    pub fn push(&mut self, fragment: &str) -> Option<String> {
+        if matches!(self.state, ParserState::Done) {
+            return None;
+        }
+        self.raw.push_str(fragment);
+        if matches!(self.state, ParserState::Searching) {
+            let start = self.find_value_start()?;
+            self.state = ParserState::InValue(start);
+        }
+        let ParserState::InValue(pos) = self.state else {
+            return None;
+        };
+        let (decoded, next, closed) = decode_partial(&self.raw[pos..]);
+        self.state = if closed {
+            ParserState::Done
+        } else {
+            ParserState::InValue(pos + next)
+        };
+        if decoded.is_empty() {
+            None
+        } else {
+            Some(decoded)
+        }
+    }
+
+    /// Returns the byte offset just past the opening quote of the value, once it has arrived.
+    fn find_value_start(&self) -> Option<usize> {
+        let mut from = 0;
+        while let Some(offset) = self.raw[from..].find(KEY) {
+            let after_key = from + offset + KEY.len();
+            let rest = &self.raw[after_key..];
+            let trimmed = rest.trim_start();
+            let Some(after_colon) = trimmed.strip_prefix(':') else {
+                if trimmed.is_empty() {
+                    return None;
+                }
+                // `"translation"` appeared as a value, not a key.
+                from = after_key;
+                continue;
+            };
+            let value = after_colon.trim_start();
+            if value.is_empty() {
+                return None;
+            }
+            if !value.starts_with('"') {
+                return None;
+            }
+            return Some(self.raw.len() - value.len() + 1);
+        }
+        None
+    }
+}
+
+/// Decodes as much of a JSON string body as is complete. Returns the decoded text, the number of
+/// bytes consumed, and whether the closing quote was reached.
+fn decode_partial(input: &str) -> (String, usize, bool) {
+    let bytes = input.as_bytes();
+    let mut out = String::new();
+    let mut index = 0;
+    while index < bytes.len() {
+        match bytes[index] {
+            b'"' => return (out, index + 1, true),
+            b'\\' => {
+                let Some(&escape) = bytes.get(index + 1) else {
+                    break;
+                };
+                let simple = match escape {
+                    b'"' => Some('"'),
+                    b'\\' => Some('\\'),
+                    b'/' => Some('/'),
+                    b'b' => Some('\u{08}'),
+                    b'f' => Some('\u{0c}'),
+                    b'n' => Some('\n'),
+                    b'r' => Some('\r'),
+                    b't' => Some('\t'),
+                    _ => None,
+                };
+                if let Some(ch) = simple {
+                    out.push(ch);
+                    index += 2;
+                    continue;
+                }
+                if escape != b'u' {
+                    // Invalid escape; keep it verbatim rather than stalling the stream.
+                    out.push(escape as char);
+                    index += 2;
+                    continue;
+                }
+                let Some(high) = parse_hex4(input, index + 2) else {
+                    break;
+                };
+                if (0xD800..0xDC00).contains(&high) {
+                    if bytes.len() < index + 12 {
+                        break;
+                    }
+                    let low = if input.get(index + 6..index + 8) == Some("\\u") {
+                        parse_hex4(input, index + 8)
+                    } else {
+                        None
+                    };
+                    match low {
+                        Some(low) if (0xDC00..0xE000).contains(&low) => {
+                            let code = 0x10000 + ((high - 0xD800) << 10) + (low - 0xDC00);
+                            out.push(char::from_u32(code).unwrap_or('\u{fffd}'));
+                            index += 12;
+                        }
+                        _ => {
+                            out.push('\u{fffd}');
+                            index += 6;
+                        }
+                    }
+                    continue;
+                }
+                out.push(char::from_u32(high).unwrap_or('\u{fffd}'));
+                index += 6;
+            }
+            _ => {
+                let ch = input[index..].chars().next().unwrap_or_default();
+                out.push(ch);
+                index += ch.len_utf8();
+            }
+        }
+    }
+    (out, index, false)
+}
+
+fn parse_hex4(input: &str, start: usize) -> Option<u32> {
+    let digits = input.get(start..start + 4)?;
+    u32::from_str_radix(digits, 16).ok()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::TranslationStreamParser;
+
+    fn feed(fragments: &[&str]) -> String {
+        let mut parser = TranslationStreamParser::default();
+        fragments
+            .iter()
+            .filter_map(|fragment| parser.push(fragment))
+            .collect()
+    }
+
+    #[test]
+    fn extracts_translation_across_fragments() {
+        let output = feed(&[
+            "{\"source_language\":\"en\",\"transl",
+            "ation\" : \"Hel",
+            "lo\\",
+            "n\\u00e9",
+            "\\ud83d",
+            "\\ude00!\",\"style\":\"translation\"}",
+        ]);
+        assert_eq!(output, "Hello\né😀!");
+    }
+
+    #[test]
+    fn ignores_translation_used_as_value() {
+        let output = feed(&["{\"note\":\"translation\",", "\"translation\":\"ok\"}"]);
+        assert_eq!(output, "ok");
+    }
+}
@@ -1,17 +1,39 @@
-use anyhow::Result;
-use tracing::info;
+use anyhow::{Context, Result, anyhow};
+use futures_util::FutureExt;
+use futures_util::future::BoxFuture;
+use futures_util::stream::{self, StreamExt};
+use std::collections::HashMap;
+use std::sync::Mutex;
+use tracing::{info, warn};
 
 use crate::data::{DataAttachment, DataInfo};
 use crate::languages::LanguageRegistry;
-use crate::providers::{Provider, ProviderResponse, ProviderUsage, ToolSpec};
+use crate::model_registry;
+use crate::providers::{
+    Provider, ProviderResponse, ProviderUsage, StreamSink, ToolSpec, merge_usage,
+};
+use crate::response_cache::{self, CachedTranslation, Flight};
 use crate::settings::Settings;
-use crate::translations::{self, TOOL_NAME, TranslateOptions, tool_spec};
+use crate::text_chunks::{self, Chunk};
+use crate::translation_memory;
+use crate::translations::{self, TOOL_NAME, TranslateOptions, batch_tool_spec, tool_spec};
+
+const BATCH_MAX_ITEMS: usize = 50;
+const BATCH_MAX_CHARS: usize = 8_000;
+const BATCH_CONCURRENCY: usize = 4;
+/// Upper bound for one chunk of a long text, even on models with large outputs, so long
+/// documents are spread over parallel requests instead of a few slow ones.
+const MAX_CHUNK_TOKENS: usize = 4_000;
+const MIN_CHUNK_TOKENS: usize = 256;
+const CHUNK_CONCURRENCY: usize = 4;
 
 #[derive(Debug, Clone)]
 pub struct Translator<P: Provider + Clone> {
     provider: P,
     settings: Settings,
     registry: LanguageRegistry,
+    memory_model: Option<String>,
+    memory_enabled: bool,
 }
 
 #[derive(Debug, Clone)]
@@ -21,6 +43,34 @@ pub struct ExecutionOutput {
     pub usage: Option<ProviderUsage>,
 }
 
+#[derive(Debug, Clone)]
+pub struct BatchExecutionOutput {
+    /// One entry per input, in input order; `Err` carries the per-item error message.
+    pub items: Vec<std::result::Result<String, String>>,
+    pub model: Option<String>,
+    pub usage: Option<ProviderUsage>,
+}
+
+struct BatchChunkOutput {
+    items: Vec<(usize, std::result::Result<String, String>)>,
+    model: Option<String>,
+    usage: Option<ProviderUsage>,
+}
+
+impl BatchChunkOutput {
+    /// Takes over `other`'s items, keeping the first model seen and adding up usage.
+    fn merge(&mut self, other: BatchChunkOutput) {
+        self.items.extend(other.items);
+        if self.model.is_none() {
+            self.model = other.model;
+        }
+        if other.usage.is_some() {
+            let total = self.usage.take().unwrap_or_else(empty_usage);
+            self.usage = Some(merge_usage(total, other.usage));
+        }
+    }
+}
+
 #[derive(Debug, Clone)]
 pub struct TranslationInput {
     pub text: String,
@@ -33,7 +83,97 @@ impl<P: Provider + Clone> Translator<P> {
             provider,
             settings,
             registry,
+            memory_model: None,
+            memory_enabled: false,
+        }
+    }
+
+    /// Reuses plain-text translations keyed by `model` together with the languages, style and
+    /// slang flag: identical concurrent requests share one provider call, recent results come
+    /// from the in-process response cache, and (when enabled in settings) older ones from the
+    /// persistent translation memory.
+    pub fn with_memory(mut self, model: &str) -> Self {
+        response_cache::configure(&self.settings);
+        if self.settings.translation_memory_enabled {
+            translation_memory::configure(&self.settings);
+            self.memory_enabled = true;
         }
+        self.memory_model = Some(model.to_string());
+        self
+    }
+
+    fn memory_key(
+        &self,
+        text: &str,
+        options: &TranslateOptions,
+        system_prompt: &str,
+    ) -> Option<String> {
+        let model = self.memory_model.as_deref()?;
+        Some(translation_memory::key(model, options, system_prompt, text))
+    }
+
+    /// Text for `key` from the response cache, falling back to the translation memory.
+    async fn lookup_memory(&self, key: &str) -> Option<String> {
+        if let Some(hit) = response_cache::lookup(key) {
+            return Some(hit.text);
+        }
+        if !self.memory_enabled {
+            return None;
+        }
+        let text = translation_memory::lookup(key).await?;
+        response_cache::store(
+            key,
+            CachedTranslation {
+                text: text.clone(),
+                model: self.memory_model.clone(),
+            },
+        );
+        Some(text)
+    }
+
+    fn store_memory(&self, key: &str, text: &str, model: Option<String>) {
+        if self.memory_enabled {
+            translation_memory::store(key, text);
+        }
+        response_cache::store(
+            key,
+            CachedTranslation {
+                text: text.to_string(),
+                model,
+            },
+        );
+    }
+
+    /// Cache key for a `kind` of lookup other than plain translation (e.g. dictionary
+    /// entries), kept apart from translations of the same text.
+    pub(crate) fn result_key(
+        &self,
+        kind: &str,
+        system_prompt: &str,
+        text: &str,
+        options: &TranslateOptions,
+    ) -> Option<String> {
+        let model = self.memory_model.as_deref()?;
+        Some(translation_memory::key(
+            &format!("{}#{}", model, kind),
+            options,
+            system_prompt,
+            text,
+        ))
+    }
+
+    /// A result stored under `key` by `store_result`, from this process or the memory.
+    pub(crate) async fn cached_result(&self, key: &str) -> Option<ExecutionOutput> {
+        let text = self.lookup_memory(key).await?;
+        Some(ExecutionOutput {
+            text,
+            model: self.memory_model.clone(),
+            usage: None,
+        })
+    }
+
+    pub(crate) fn store_result(&self, key: &str, output: &ExecutionOutput) {
+        self.store_memory(key, &output.text, output.model.clone());
     }
 
     pub fn settings(&self) -> &Settings {
@@ -93,7 +233,6 @@ impl<P: Provider + Clone> Translator<P> {
                 .map(|d| d.mime.as_str())
                 .unwrap_or("none")
         );
-        let tool = tool_spec(TOOL_NAME);
         let data_info: Option<DataInfo> = input.data.as_ref().map(|data| data.info());
         let system_prompt = translations::render_system_prompt_with_data(
             &options,
@@ -102,17 +241,221 @@ impl<P: Provider + Clone> Translator<P> {
             data_info.as_ref(),
         )?;
 
+        self.exec_with_system_prompt(input, options, system_prompt)
+            .await
+    }
+
+    /// Like `exec_with_data`, but reuses a system prompt rendered by the caller
+    /// (see `translations::render_system_prompt_with_data`).
+    ///
+    /// Plain text longer than the model's chunk budget is split and translated in parts (see
+    /// `exec_chunked`); `system_prompt` is used for the first part.
+    pub async fn exec_with_system_prompt(
+        &self,
+        input: TranslationInput,
+        options: TranslateOptions,
+        system_prompt: String,
+    ) -> Result<ExecutionOutput> {
+        let chunk_tokens = self.chunk_tokens();
+        if input.data.is_none() && text_chunks::estimate_tokens(&input.text) > chunk_tokens {
+            return self
+                .exec_chunked(&input.text, options, system_prompt, chunk_tokens)
+                .await;
+        }
+        self.exec_prompted(input, options, system_prompt, None)
+            .await
+    }
+
+    /// Input budget per request: half the model's output limit (translations can run longer
+    /// than their source, and the reply is JSON), within `MIN/MAX_CHUNK_TOKENS`.
+    fn chunk_tokens(&self) -> usize {
+        let limit = self
+            .memory_model
+            .as_deref()
+            .map(model_registry::output_token_limit)
+            .unwrap_or(4_096);
+        (limit / 2).clamp(MIN_CHUNK_TOKENS, MAX_CHUNK_TOKENS)
+    }
+
+    /// Translates a long text as paragraph/heading-aligned chunks, up to `CHUNK_CONCURRENCY`
+    /// at a time, and stitches the results back in order with the original separators.
+    ///
+    /// Every chunk after the first also sees the tail of the preceding source text in its
+    /// system prompt to keep terminology consistent. Chunks go through the translation
+    /// memory like any other text, so a failed run resumes without re-translating
+    /// finished parts.
+    async fn exec_chunked(
+        &self,
+        text: &str,
+        options: TranslateOptions,
+        system_prompt: String,
+        chunk_tokens: usize,
+    ) -> Result<ExecutionOutput> {
+        let chunks = text_chunks::split_chunks(text, chunk_tokens);
+        info!(
+            "translate long text in {} chunks (budget={} tokens)",
+            chunks.len(),
+            chunk_tokens
+        );
+        let total = chunks.len();
+        let outputs: Vec<Result<ExecutionOutput>> = stream::iter(chunks.iter().enumerate())
+            .map(|(index, chunk)| {
+                self.exec_chunk(text, chunk, options.clone(), &system_prompt)
+                    .map(move |result| {
+                        result.with_context(|| {
+                            format!("failed to translate part {} of {}", index + 1, total)
+                        })
+                    })
+            })
+            .buffered(CHUNK_CONCURRENCY)
+            .collect()
+            .await;
+
+        let mut translated = Vec::with_capacity(outputs.len());
+        let mut model = None;
+        let mut usage: Option<ProviderUsage> = None;
+        for output in outputs {
+            let output = output?;
+            if model.is_none() {
+                model = output.model;
+            }
+            if output.usage.is_some() {
+                let sum = usage.take().unwrap_or_else(empty_usage);
+                usage = Some(merge_usage(sum, output.usage));
+            }
+            translated.push(output.text);
+        }
+        Ok(ExecutionOutput {
+            text: text_chunks::stitch(text, &chunks, &translated),
+            model,
+            usage,
+        })
+    }
+
+    async fn exec_chunk(
+        &self,
+        text: &str,
+        chunk: &Chunk,
+        options: TranslateOptions,
+        system_prompt: &str,
+    ) -> Result<ExecutionOutput> {
+        let system_prompt = match chunk.context.clone() {
+            Some(context) => translations::render_chunk_system_prompt(
+                &options,
+                TOOL_NAME,
+                &self.settings,
+                &text[context],
+            )?,
+            None => system_prompt.to_string(),
+        };
+        let input = TranslationInput {
+            text: text[chunk.range.clone()].to_string(),
+            data: None,
+        };
+        self.exec_prompted(input, options, system_prompt, None)
+            .await
+    }
+
+    /// Like `exec_with_system_prompt`, but forwards the `translation` field to `on_text` as the
+    /// provider streams it. The returned output is still the fully parsed result, which can
+    /// differ from the streamed text (e.g. segment formatting for images).
+    pub async fn exec_streaming<F>(
+        &self,
+        input: TranslationInput,
+        options: TranslateOptions,
+        system_prompt: String,
+        on_text: F,
+    ) -> Result<ExecutionOutput>
+    where
+        F: Fn(&str) + Send + Sync + 'static,
+    {
+        let parser = Mutex::new(translations::TranslationStreamParser::default());
+        let sink = StreamSink::new(move |fragment| {
+            let text = match parser.lock() {
+                Ok(mut parser) => parser.push(fragment),
+                Err(_) => None,
+            };
+            if let Some(text) = text {
+                on_text(&text);
+            }
+        });
+        self.exec_prompted(input, options, system_prompt, Some(sink))
+            .await
+    }
+
+    async fn exec_prompted(
+        &self,
+        input: TranslationInput,
+        options: TranslateOptions,
+        system_prompt: String,
+        stream: Option<StreamSink>,
+    ) -> Result<ExecutionOutput> {
+        let memory_key = if input.data.is_none() {
+            self.memory_key(&input.text, &options, &system_prompt)
+        } else {
+            None
+        };
+        let Some(key) = memory_key else {
+            return self
+                .call_prompted(input, options, system_prompt, stream)
+                .await;
+        };
+
+        if let Some(text) = self.lookup_memory(&key).await {
+            let hit = CachedTranslation {
+                text,
+                model: self.memory_model.clone(),
+            };
+            return Ok(cached_output(hit, stream));
+        }
+
+        let leader = match response_cache::begin(&key) {
+            Flight::Leader(leader) => Some(leader),
+            Flight::Follower(receiver) => match response_cache::wait(receiver).await {
+                Some(Ok(hit)) => return Ok(cached_output(hit, stream)),
+                Some(Err(message)) => return Err(anyhow!(message)),
+                // The leading request was cancelled; make the call here instead.
+                None => None,
+            },
+        };
+        let result = self
+            .call_prompted(input, options, system_prompt, stream)
+            .await;
+        if let Ok(output) = result.as_ref() {
+            self.store_memory(&key, &output.text, output.model.clone());
+        }
+        if let Some(leader) = leader {
+            leader.finish(match result.as_ref() {
+                Ok(output) => Ok(CachedTranslation {
+                    text: output.text.clone(),
+                    model: output.model.clone(),
+                }),
+                Err(err) => Err(err.to_string()),
+            });
+        }
+        result
+    }
+
+    async fn call_prompted(
+        &self,
+        input: TranslationInput,
+        options: TranslateOptions,
+        system_prompt: String,
+        stream: Option<StreamSink>,
+    ) -> Result<ExecutionOutput> {
         let image_mode = input
             .data
             .as_ref()
             .map(|data| data.mime.starts_with("image/"))
             .unwrap_or(false);
-
         let mut provider = self
             .provider
             .clone()
-            .register_tool(tool)
+            .register_tool(tool_spec(TOOL_NAME))
             .append_system_input(system_prompt);
+        if let Some(stream) = stream {
+            provider = provider.with_stream(stream);
+        }
         if let Some(data) = input.data {
             provider = provider.append_user_data(data);
         }
@@ -134,4 +477,340 @@ impl<P: Provider + Clone> Translator<P> {
             usage: response.usage,
         })
     }
+
+    /// Translates many independent texts with as few provider calls as possible.
+    ///
+    /// Identical inputs are sent once, blank inputs are passed through, and the rest are packed
+    /// into `items` batches that share one rendered system prompt. A failed batch is split in
+    /// half and retried, and items the provider drops are retried one by one, so every input
+    /// gets its own result or error.
+    pub async fn exec_batch(
+        &self,
+        inputs: &[String],
+        options: TranslateOptions,
+    ) -> Result<BatchExecutionOutput> {
+        let mut unique: Vec<&str> = Vec::new();
+        let mut positions: HashMap<&str, usize> = HashMap::new();
+        let mut slots: Vec<Option<usize>> = Vec::with_capacity(inputs.len());
+        for input in inputs {
+            if input.trim().is_empty() {
+                slots.push(None);
+                continue;
+            }
+            let index = *positions.entry(input.as_str()).or_insert_with(|| {
+                unique.push(input.as_str());
+                unique.len() - 1
+            });
+            slots.push(Some(index));
+        }
+        info!(
+            "translate batch request (lang={}, items={}, unique={})",
+            options.lang,
+            inputs.len(),
+            unique.len()
+        );
+
+        let mut translated: Vec<Option<std::result::Result<String, String>>> =
+            vec![None; unique.len()];
+        let system_prompt =
+            translations::render_batch_system_prompt(&options, TOOL_NAME, &self.settings)?;
+        let memory_keys = unique
+            .iter()
+            .map(|text| self.memory_key(text, &options, &system_prompt))
+            .collect::<Vec<_>>();
+        let mut misses = Vec::with_capacity(unique.len());
+        for (index, key) in memory_keys.iter().enumerate() {
+            let hit = match key.as_deref() {
+                Some(key) => self.lookup_memory(key).await,
+                None => None,
+            };
+            match hit {
+                Some(text) => translated[index] = Some(Ok(text)),
+                None => misses.push(index),
+            }
+        }
+
+        let miss_texts = misses
+            .iter()
+            .map(|index| unique[*index])
+            .collect::<Vec<_>>();
+        let chunks = chunk_batch(&miss_texts).into_iter().map(|chunk| {
+            chunk
+                .into_iter()
+                .map(|offset| misses[offset])
+                .collect::<Vec<_>>()
+        });
+        let outputs: Vec<BatchChunkOutput> = stream::iter(chunks)
+            .map(|chunk| self.exec_batch_chunk(&unique, chunk, &options, &system_prompt))
+            .buffered(BATCH_CONCURRENCY)
+            .collect()
+            .await;
+
+        let mut model = if misses.len() < unique.len() {
+            self.memory_model.clone()
+        } else {
+            None
+        };
+        let mut usage: Option<ProviderUsage> = None;
+        for output in outputs {
+            if model.is_none() {
+                model = output.model;
+            }
+            if output.usage.is_some() {
+                usage = Some(match usage {
+                    Some(total) => merge_usage(total, output.usage),
+                    None => merge_usage(empty_usage(), output.usage),
+                });
+            }
+            for (index, result) in output.items {
+                if let (Ok(text), Some(key)) = (&result, memory_keys[index].as_deref()) {
+                    self.store_memory(key, text, self.memory_model.clone());
+                }
+                translated[index] = Some(result);
+            }
+        }
+
+        let items = inputs
+            .iter()
+            .zip(slots)
+            .map(|(input, slot)| match slot {
+                None => Ok(input.clone()),
+                Some(index) => translated[index]
+                    .clone()
+                    .unwrap_or_else(|| Err("translation missing".to_string())),
+            })
+            .collect();
+        Ok(BatchExecutionOutput {
+            items,
+            model,
+            usage,
+        })
+    }
+
+    /// One provider call for `chunk` (indices into `unique`). A call that fails is retried
+    /// as two halves, down to single items, so a bad item costs a few calls instead of one
+    /// per item. Items a successful reply leaves out are retried one by one, a few at a time.
+    fn exec_batch_chunk<'a>(
+        &'a self,
+        unique: &'a [&'a str],
+        chunk: Vec<usize>,
+        options: &'a TranslateOptions,
+        system_prompt: &'a str,
+    ) -> BoxFuture<'a, BatchChunkOutput> {
+        async move {
+            let texts = chunk.iter().map(|index| unique[*index]).collect::<Vec<_>>();
+            let mut output = BatchChunkOutput {
+                items: Vec::with_capacity(chunk.len()),
+                model: None,
+                usage: None,
+            };
+            let mut resolved: Vec<Option<String>> = vec![None; chunk.len()];
+            match self.call_batch(&texts, options, system_prompt).await {
+                Ok((items, model, usage)) => {
+                    output.model = model;
+                    output.usage = usage;
+                    for item in items {
+                        resolved[item.id] = Some(item.translated);
+                    }
+                }
+                Err(err) => {
+                    warn!("batch translation failed ({} items): {}", chunk.len(), err);
+                    if chunk.len() == 1 {
+                        output.items.push((chunk[0], Err(err.to_string())));
+                        return output;
+                    }
+                    let mut first = chunk;
+                    let second = first.split_off(first.len() / 2);
+                    let (first, second) = futures_util::join!(
+                        self.exec_batch_chunk(unique, first, options, system_prompt),
+                        self.exec_batch_chunk(unique, second, options, system_prompt)
+                    );
+                    output.merge(first);
+                    output.merge(second);
+                    return output;
+                }
+            }
+
+            let mut missing = Vec::new();
+            for (offset, index) in chunk.into_iter().enumerate() {
+                match resolved[offset].take() {
+                    Some(text) => output.items.push((index, Ok(text))),
+                    None => missing.push(index),
+                }
+            }
+            let retried: Vec<_> = stream::iter(missing)
+                .map(
+                    |index| async move { (index, self.exec(unique[index], options.clone()).await) },
+                )
+                .buffered(BATCH_CONCURRENCY)
+                .collect()
+                .await;
+            for (index, result) in retried {
+                match result {
+                    Ok(exec) => {
+                        output.merge(BatchChunkOutput {
+                            items: vec![(index, Ok(exec.text))],
+                            model: exec.model,
+                            usage: exec.usage,
+                        });
+                    }
+                    Err(err) => output.items.push((index, Err(err.to_string()))),
+                }
+            }
+            output
+        }
+        .boxed()
+    }
+
+    async fn call_batch(
+        &self,
+        texts: &[&str],
+        options: &TranslateOptions,
+        system_prompt: &str,
+    ) -> Result<(
+        Vec<translations::BatchItem>,
+        Option<String>,
+        Option<ProviderUsage>,
+    )> {
+        let user_input = translations::format_batch_input(texts)?;
+        let response = self
+            .provider
+            .clone()
+            .register_tool(batch_tool_spec(TOOL_NAME))
+            .append_system_input(system_prompt.to_string())
+            .append_user_input(user_input)
+            .call_tool(TOOL_NAME)
+            .await?;
+        let items = translations::parse_batch_tool_args(
+            response.args,
+            options,
+            &self.registry,
+            texts.len(),
+        )?;
+        Ok((items, response.model, response.usage))
+    }
+}
+
+/// A translation served without a provider call: no tokens were used for it.
+fn cached_output(hit: CachedTranslation, stream: Option<StreamSink>) -> ExecutionOutput {
+    if let Some(stream) = stream {
+        stream.send(&serde_json::json!({ "translation": hit.text }).to_string());
+    }
+    ExecutionOutput {
+        text: hit.text,
+        model: hit.model,
+        usage: Some(empty_usage()),
+    }
+}
+
+fn empty_usage() -> ProviderUsage {
+    ProviderUsage {
+        prompt_tokens: Some(0),
+        completion_tokens: Some(0),
+        total_tokens: Some(0),
+    }
+}
+
+fn chunk_batch(texts: &[&str]) -> Vec<Vec<usize>> {
+    let mut chunks = Vec::new();
+    let mut current = Vec::new();
+    let mut current_chars = 0usize;
+    for (index, text) in texts.iter().enumerate() {
+        let chars = text.chars().count();
+        if !current.is_empty()
+            && (current.len() >= BATCH_MAX_ITEMS || current_chars + chars > BATCH_MAX_CHARS)
+        {
+            chunks.push(std::mem::take(&mut current));
+            current_chars = 0;
+        }
+        current.push(index);
+        current_chars += chars;
+    }
+    if !current.is_empty() {
+        chunks.push(current);
+    }
+    chunks
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::bench_support::{MockProvider, mock_translator, options};
+
+    #[tokio::test]
+    async fn exec_batch_dedups_and_retries_dropped_items() {
+        let provider = MockProvider::new().skipping("drop me");
+        let translator = mock_translator(provider.clone()).expect("translator");
+        let inputs = ["Hello", "  ", "World", "Hello", "drop me"]
+            .iter()
+            .map(|value| value.to_string())
+            .collect::<Vec<_>>();
+
+        let output = translator
+            .exec_batch(&inputs, options())
+            .await
+            .expect("batch");
+
+        assert_eq!(
+            output.items,
+            vec![
+                Ok("tr:Hello".to_string()),
+                Ok("  ".to_string()),
+                Ok("tr:World".to_string()),
+                Ok("tr:Hello".to_string()),
+                Ok("tr:drop me".to_string()),
+            ]
+        );
+        assert_eq!(provider.calls(), 2);
+        assert_eq!(output.model.as_deref(), Some("mock"));
+    }
+
+    #[tokio::test]
+    async fn exec_splits_long_text_into_ordered_chunks() {
+        let provider = MockProvider::new();
+        let translator = mock_translator(provider.clone()).expect("translator");
+        // About 1000 estimated tokens per paragraph against the default 2048-token budget.
+        let paragraphs = ["first", "second", "third"]
+            .iter()
+            .map(|word| format!("{} ", word).repeat(4000 / (word.len() + 1)))
+            .map(|paragraph| paragraph.trim_end().to_string())
+            .collect::<Vec<_>>();
+        let text = format!("{}\n\n", paragraphs.join("\n\n"));
+
+        let output = translator.exec(&text, options()).await.expect("exec");
+
+        assert_eq!(provider.calls(), 2);
+        assert_eq!(
+            output.text,
+            format!(
+                "tr:{}\n\n{}\n\ntr:{}\n\n",
+                paragraphs[0], paragraphs[1], paragraphs[2]
+            )
+        );
+    }
+
+    #[tokio::test]
+    async fn failed_batches_are_bisected_instead_of_retried_item_by_item() {
+        let provider = MockProvider::new().failing("poison");
+        let translator = mock_translator(provider.clone()).expect("translator");
+        let mut inputs = (0..8)
+            .map(|index| format!("line {}", index))
+            .collect::<Vec<_>>();
+        inputs[5] = "poison".to_string();
+
+        let output = translator
+            .exec_batch(&inputs, options())
+            .await
+            .expect("batch");
+
+        for (index, item) in output.items.iter().enumerate() {
+            if index == 5 {
+                assert!(item.is_err());
+            } else {
+                assert_eq!(item.as_deref(), Ok(format!("tr:line {}", index).as_str()));
+            }
+        }
+        // 8 -> 4 + 4 -> 2 + 2 -> 1 + 1, rather than the batch plus one call per item.
+        assert_eq!(provider.calls(), 7);
+    }
 }
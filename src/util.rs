@@ -0,0 +1,10 @@
+use std::sync::{Mutex, MutexGuard};
+
+/// Locks `mutex`, carrying on with the guard if another thread panicked while holding it.
+/// Only used for caches, counters and queues that stay consistent between statements.
+pub(crate) fn lock<T>(mutex: &Mutex<T>) -> MutexGuard<'_, T> {
+    match mutex.lock() {
+        Ok(guard) => guard,
+        Err(poisoned) => poisoned.into_inner(),
+    }
+}